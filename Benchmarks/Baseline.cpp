@@ -0,0 +1,364 @@
+#include "Baseline.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+	//! Minimal JSON document tree, enough to read back what Harness::WriteJSON writes
+	struct JSONValue
+	{
+		enum class Type { Null, Boolean, Number, String, Array, Object };
+		Type type = Type::Null;
+		double number = 0.0;
+		std::string text;
+		std::vector<JSONValue> elements;
+		std::vector<std::pair<std::string, JSONValue>> members;
+
+		//! Returns the member with the given key or nullptr
+		const JSONValue* Find(const std::string& key) const
+		{
+			for (const auto& member : members)
+				if (member.first == key)
+					return &member.second;
+			return nullptr;
+		}
+	};
+
+	//! Recursive descent parser, fails on anything outside the JSON grammar
+	class JSONParser
+	{
+	public:
+		JSONParser(const std::string& text) : _text(text), _position(0) {}
+
+		bool Parse(JSONValue& value)
+		{
+			return ParseValue(value) && (SkipSpaces(), _position == _text.size());
+		}
+	private:
+		void SkipSpaces()
+		{
+			while (_position < _text.size() && std::isspace(static_cast<unsigned char>(_text[_position])))
+				++_position;
+		}
+
+		bool Consume(char character)
+		{
+			SkipSpaces();
+			if (_position >= _text.size() || _text[_position] != character)
+				return false;
+			++_position;
+			return true;
+		}
+
+		bool ParseValue(JSONValue& value)
+		{
+			SkipSpaces();
+			if (_position >= _text.size())
+				return false;
+
+			const char character = _text[_position];
+			if (character == '{')
+				return ParseObject(value);
+			if (character == '[')
+				return ParseArray(value);
+			if (character == '"')
+			{
+				value.type = JSONValue::Type::String;
+				return ParseString(value.text);
+			}
+			if (_text.compare(_position, 4, "true") == 0 || _text.compare(_position, 5, "false") == 0)
+			{
+				value.type = JSONValue::Type::Boolean;
+				value.number = character == 't' ? 1.0 : 0.0;
+				_position += character == 't' ? 4 : 5;
+				return true;
+			}
+			if (_text.compare(_position, 4, "null") == 0)
+			{
+				_position += 4;
+				return true;
+			}
+
+			const char* begin = _text.c_str() + _position;
+			char* end = nullptr;
+			value.type = JSONValue::Type::Number;
+			value.number = std::strtod(begin, &end);
+			_position += end - begin;
+			return end != begin;
+		}
+
+		bool ParseString(std::string& text)
+		{
+			if (!Consume('"'))
+				return false;
+			while (_position < _text.size() && _text[_position] != '"')
+			{
+				if (_text[_position] == '\\' && ++_position >= _text.size())
+					return false;
+				text += _text[_position++];
+			}
+			return Consume('"');
+		}
+
+		bool ParseArray(JSONValue& value)
+		{
+			value.type = JSONValue::Type::Array;
+			Consume('[');
+			if (Consume(']'))
+				return true;
+			do
+			{
+				value.elements.emplace_back();
+				if (!ParseValue(value.elements.back()))
+					return false;
+			} while (Consume(','));
+			return Consume(']');
+		}
+
+		bool ParseObject(JSONValue& value)
+		{
+			value.type = JSONValue::Type::Object;
+			Consume('{');
+			if (Consume('}'))
+				return true;
+			do
+			{
+				value.members.emplace_back();
+				SkipSpaces();
+				if (!ParseString(value.members.back().first) || !Consume(':') || !ParseValue(value.members.back().second))
+					return false;
+			} while (Consume(','));
+			return Consume('}');
+		}
+
+		const std::string& _text;
+		size_t _position;
+	};
+
+	std::string GetString(const JSONValue& object, const std::string& key)
+	{
+		const JSONValue* member = object.Find(key);
+		return member && member->type == JSONValue::Type::String ? member->text : std::string();
+	}
+
+	double GetNumber(const JSONValue& object, const std::string& key)
+	{
+		const JSONValue* member = object.Find(key);
+		return member && member->type == JSONValue::Type::Number ? member->number : 0.0;
+	}
+
+	std::string DetectCPUModel()
+	{
+		std::ifstream cpuInfo("/proc/cpuinfo");
+		std::string line;
+		while (std::getline(cpuInfo, line))
+		{
+			//! x86 reports "model name", most ARM kernels only "CPU part" and "Hardware"
+			if (line.compare(0, 10, "model name") == 0 || line.compare(0, 8, "Hardware") == 0)
+			{
+				const size_t colon = line.find(':');
+				if (colon != std::string::npos && colon + 2 <= line.size())
+					return line.substr(colon + 2);
+			}
+		}
+		return "unknown";
+	}
+
+	std::string DetectISA()
+	{
+		std::string isa;
+		auto append = [&isa](const char* name) { isa += isa.empty() ? name : std::string("+") + name; };
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("sse4.2")) append("sse4.2");
+		if (__builtin_cpu_supports("avx")) append("avx");
+		if (__builtin_cpu_supports("avx2")) append("avx2");
+		if (__builtin_cpu_supports("fma")) append("fma");
+		if (__builtin_cpu_supports("avx512f")) append("avx512f");
+#elif defined(__aarch64__)
+		append("neon");
+#endif
+		return isa.empty() ? "generic" : isa;
+	}
+
+	double SampleMedian(std::vector<double>& samples)
+	{
+		std::sort(samples.begin(), samples.end());
+		return Benchmark::Percentile(samples, 50.0);
+	}
+};
+
+namespace Benchmark {
+
+	std::string Fingerprint::GetKey() const
+	{
+		//! Lower case alphanumerics with single dashes, e.g. "intel-r-core-tm-i7-9700k-cpu-3-60ghz_8c_sse4.2+avx+avx2+fma"
+		std::string key;
+		for (char character : cpuModel)
+		{
+			if (std::isalnum(static_cast<unsigned char>(character)))
+				key += static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+			else if (!key.empty() && key.back() != '-')
+				key += '-';
+		}
+		while (!key.empty() && key.back() == '-')
+			key.pop_back();
+		return key + "_" + std::to_string(numCores) + "c_" + isa;
+	}
+
+	bool Fingerprint::operator==(const Fingerprint& other) const
+	{
+		return cpuModel == other.cpuModel && numCores == other.numCores && isa == other.isa;
+	}
+
+	Fingerprint Fingerprint::Detect()
+	{
+		return { DetectCPUModel(), std::thread::hardware_concurrency(), DetectISA() };
+	}
+
+	bool Baseline::Load(const std::string& path)
+	{
+		std::ifstream file(path);
+		if (!file.is_open())
+		{
+			std::cerr << "Failed to open " << path << std::endl;
+			return false;
+		}
+		std::stringstream stream;
+		stream << file.rdbuf();
+		const std::string text = stream.str();
+
+		JSONValue document;
+		if (!JSONParser(text).Parse(document) || document.type != JSONValue::Type::Object)
+		{
+			std::cerr << "Failed to parse " << path << std::endl;
+			return false;
+		}
+
+		version = static_cast<int>(GetNumber(document, "version"));
+		if (version != BASELINE_VERSION)
+		{
+			std::cerr << path << " is a version " << version << " baseline, expected version " << BASELINE_VERSION << std::endl;
+			return false;
+		}
+
+		if (const JSONValue* machine = document.Find("fingerprint"))
+			fingerprint = { GetString(*machine, "cpu"), static_cast<unsigned int>(GetNumber(*machine, "cores")), GetString(*machine, "isa") };
+
+		results.clear();
+		const JSONValue* benchmarks = document.Find("benchmarks");
+		if (!benchmarks || benchmarks->type != JSONValue::Type::Array)
+		{
+			std::cerr << path << " has no benchmarks" << std::endl;
+			return false;
+		}
+		for (const JSONValue& benchmark : benchmarks->elements)
+		{
+			Result result = {};
+			result.name = GetString(benchmark, "name");
+			result.numItems = static_cast<uint64_t>(GetNumber(benchmark, "items"));
+			result.median = GetNumber(benchmark, "median_ms");
+			if (const JSONValue* samples = benchmark.Find("samples_ms"))
+				for (const JSONValue& sample : samples->elements)
+					result.samples.push_back(sample.number);
+			if (result.name.empty() || result.samples.empty())
+			{
+				std::cerr << path << " has a benchmark without name or samples" << std::endl;
+				return false;
+			}
+			results.push_back(std::move(result));
+		}
+
+		return true;
+	}
+
+	std::vector<Comparison> Compare(const Baseline& baseline, const std::vector<Result>& results, const CompareOptions& options)
+	{
+		std::vector<Comparison> comparisons;
+		//! Fixed seed so the same two runs always give the same verdicts
+		std::mt19937 random(42);
+		std::vector<double> baselineResample, currentResample, ratios(options.numResamples);
+		const double alpha = (1.0 - options.confidence) * 50.0;
+
+		for (const Result& current : results)
+		{
+			auto found = std::find_if(baseline.results.begin(), baseline.results.end(), [&current](const Result& result) { return result.name == current.name; });
+			Comparison comparison = { current.name, 0.0, current.median, 1.0, 1.0, 1.0, Comparison::Verdict::New };
+			if (found == baseline.results.end() || current.samples.empty())
+			{
+				comparisons.push_back(comparison);
+				continue;
+			}
+
+			const std::vector<double>& before = found->samples;
+			const std::vector<double>& after = current.samples;
+			std::vector<double> sorted = before;
+			comparison.baselineMedian = SampleMedian(sorted);
+			comparison.ratio = comparison.baselineMedian > 0.0 ? comparison.currentMedian / comparison.baselineMedian : 1.0;
+
+			std::uniform_int_distribution<size_t> pickBefore(0, before.size() - 1), pickAfter(0, after.size() - 1);
+			baselineResample.resize(before.size());
+			currentResample.resize(after.size());
+			for (double& ratio : ratios)
+			{
+				for (double& sample : baselineResample)
+					sample = before[pickBefore(random)];
+				for (double& sample : currentResample)
+					sample = after[pickAfter(random)];
+				const double baselineMedian = SampleMedian(baselineResample);
+				ratio = baselineMedian > 0.0 ? SampleMedian(currentResample) / baselineMedian : 1.0;
+			}
+			std::sort(ratios.begin(), ratios.end());
+			comparison.lower = Percentile(ratios, alpha);
+			comparison.upper = Percentile(ratios, 100.0 - alpha);
+
+			if (comparison.lower > 1.0 + options.threshold)
+				comparison.verdict = Comparison::Verdict::Regressed;
+			else if (comparison.upper < 1.0 - options.threshold)
+				comparison.verdict = Comparison::Verdict::Improved;
+			else
+				comparison.verdict = Comparison::Verdict::Unchanged;
+			comparisons.push_back(comparison);
+		}
+
+		for (const Result& previous : baseline.results)
+		{
+			auto found = std::find_if(results.begin(), results.end(), [&previous](const Result& result) { return result.name == previous.name; });
+			if (found == results.end())
+				comparisons.push_back({ previous.name, previous.median, 0.0, 1.0, 1.0, 1.0, Comparison::Verdict::Missing });
+		}
+
+		return comparisons;
+	}
+
+	bool ReportComparisons(const std::vector<Comparison>& comparisons, std::ostream& stream)
+	{
+		static const char* VERDICTS[] = { "unchanged", "improved", "REGRESSED", "new", "missing" };
+
+		stream << std::left << std::setw(48) << "Benchmark" << std::right << std::setw(12) << "Baseline" << std::setw(12) << "Current"
+			   << std::setw(10) << "Ratio" << std::setw(20) << "Interval" << "  Verdict" << std::endl;
+
+		size_t numRegressions = 0;
+		for (const Comparison& comparison : comparisons)
+		{
+			stream << std::left << std::setw(48) << comparison.name << std::right << std::fixed << std::setprecision(3)
+				   << std::setw(12) << comparison.baselineMedian << std::setw(12) << comparison.currentMedian << std::setw(10) << comparison.ratio;
+			std::ostringstream interval;
+			interval << std::fixed << std::setprecision(3) << "[" << comparison.lower << ", " << comparison.upper << "]";
+			stream << std::setw(20) << interval.str() << "  " << VERDICTS[static_cast<int>(comparison.verdict)] << std::endl;
+			numRegressions += comparison.verdict == Comparison::Verdict::Regressed;
+		}
+
+		if (numRegressions > 0)
+			stream << numRegressions << " benchmark(s) regressed" << std::endl;
+		return numRegressions == 0;
+	}
+
+};
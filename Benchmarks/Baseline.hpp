@@ -0,0 +1,67 @@
+#ifndef BENCHMARK_BASELINE_HPP
+#define BENCHMARK_BASELINE_HPP
+
+#include "Harness.hpp"
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Benchmark {
+
+	//! Version of the JSON layout written by Harness::WriteJSON, bumped when old baselines can not be read anymore
+	constexpr int BASELINE_VERSION = 1;
+
+	//! Identity of the machine a baseline was recorded on, timings are only comparable on the same fingerprint
+	struct Fingerprint
+	{
+		std::string cpuModel;
+		unsigned int numCores;
+		//! Vector extensions the CPU supports, separated by '+'
+		std::string isa;
+		//! Returns the file name safe key the baselines of this machine are stored under
+		std::string GetKey() const;
+		bool operator==(const Fingerprint& other) const;
+		//! Detect the fingerprint of the running machine
+		static Fingerprint Detect();
+	};
+
+	//! Recorded run loaded back from the JSON written by Harness::WriteJSON
+	struct Baseline
+	{
+		int version;
+		Fingerprint fingerprint;
+		std::vector<Result> results;
+		//! Load the baseline at path, returns false when the file is missing, malformed or of another version
+		bool Load(const std::string& path);
+	};
+
+	//! Outcome of one benchmark against its baseline
+	struct Comparison
+	{
+		enum class Verdict { Unchanged, Improved, Regressed, New, Missing };
+		std::string name;
+		double baselineMedian, currentMedian;
+		//! Ratio of the current median to the baseline median and its bootstrap confidence interval
+		double ratio, lower, upper;
+		Verdict verdict;
+	};
+
+	//! Settings of the regression check
+	struct CompareOptions
+	{
+		//! Relative slowdown the whole confidence interval has to exceed to count as regression
+		double threshold = 0.05;
+		double confidence = 0.95;
+		size_t numResamples = 2000;
+	};
+
+	//! Compare the current results against the baseline.
+	//! Both sample sets are resampled with replacement and the ratio of the resampled medians gives the
+	//! confidence interval, so a benchmark only regresses when the interval lies above 1 + threshold.
+	std::vector<Comparison> Compare(const Baseline& baseline, const std::vector<Result>& results, const CompareOptions& options);
+	//! Print one line per comparison, returns false when any benchmark regressed
+	bool ReportComparisons(const std::vector<Comparison>& comparisons, std::ostream& stream);
+
+};
+
+#endif //! end of Baseline.hpp
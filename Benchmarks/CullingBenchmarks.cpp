@@ -0,0 +1,205 @@
+#include "Harness.hpp"
+#include <GL3/BVH.hpp>
+#include <GL3/ClusteredLighting.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/Mesh.hpp>
+#include <GL3/OcclusionCuller.hpp>
+#include <GL3/SoftwareRasterizer.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <memory>
+#include <random>
+
+namespace
+{
+	//! Camera inside the unit box looking along +x, the meshes are scaled to [-1, 1]
+	const glm::vec3 EYE(0.0f, -0.3f, 0.05f);
+
+	glm::mat4 GetView()
+	{
+		return glm::lookAt(EYE, EYE + glm::vec3(1.0f, 0.05f, 0.1f), glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+
+	glm::mat4 GetProjection()
+	{
+		return glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.01f, 10.0f);
+	}
+
+	std::shared_ptr<GL3::Mesh> LoadMesh(const std::string& path)
+	{
+		auto mesh = std::make_shared<GL3::Mesh>();
+		return mesh->LoadObj(path.c_str(), true, false) ? mesh : nullptr;
+	}
+
+	//! Random boxes of 0.02 to 0.16 units spread over the unit box
+	std::vector<GL3::BoundingBox> MakeBoxes(size_t numBoxes)
+	{
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> position(-1.0f, 1.0f), halfSize(0.01f, 0.08f);
+		std::vector<GL3::BoundingBox> boxes(numBoxes);
+		for (GL3::BoundingBox& box : boxes)
+		{
+			const glm::vec3 center(position(random), position(random) * 0.5f, position(random) * 0.5f);
+			const glm::vec3 extent(halfSize(random));
+			box.Merge(center - extent);
+			box.Merge(center + extent);
+		}
+		return boxes;
+	}
+
+	//! Ray of a query batch, direction not normalized
+	struct Ray
+	{
+		glm::vec3 origin, direction;
+	};
+
+	//! Rays traced per job of a query batch
+	constexpr size_t RAYS_PER_JOB = 1024;
+
+	//! Rays from random points on a sphere around the bounds to random points inside of them, so most of
+	//! them hit the mesh and some graze past it
+	std::vector<Ray> MakeRays(const GL3::BoundingBox& bounds, size_t numRays)
+	{
+		std::mt19937 random(11);
+		std::normal_distribution<float> normal(0.0f, 1.0f);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+		const glm::vec3 lower = bounds.GetLowerCorner(), upper = bounds.GetUpperCorner();
+		const glm::vec3 center = (lower + upper) * 0.5f;
+		const float radius = glm::length(upper - lower);
+		std::vector<Ray> rays(numRays);
+		for (Ray& ray : rays)
+		{
+			const glm::vec3 onSphere = glm::normalize(glm::vec3(normal(random), normal(random), normal(random)) + glm::vec3(1e-6f));
+			const glm::vec3 target = lower + (upper - lower) * glm::vec3(uniform(random), uniform(random), uniform(random));
+			ray.origin = center + onSphere * radius;
+			ray.direction = target - ray.origin;
+		}
+		return rays;
+	}
+
+	//! Random lights with radii from 0.5 to 4 units in a 40 unit cube in front of the camera
+	std::vector<GL3::PointLight> MakeLights(size_t numLights)
+	{
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> position(-20.0f, 20.0f), radius(0.5f, 4.0f);
+		std::vector<GL3::PointLight> lights(numLights);
+		for (GL3::PointLight& light : lights)
+			light = { glm::vec3(position(random), position(random), position(random) - 20.0f), radius(random), glm::vec3(1.0f, 0.5f, 0.2f), 4.0f };
+		return lights;
+	}
+};
+
+namespace Benchmark {
+
+	void RegisterCullingBenchmarks(Harness& harness, const std::string& resourcesDir)
+	{
+		for (const char* name : { "bunny", "dragon", "sponza" })
+		{
+			const std::string path = resourcesDir + "/objects/" + name + ".obj";
+
+			harness.Add(std::string("BVH::Build/") + name, [path](uint64_t& numItems) -> Harness::Body
+			{
+				auto mesh = LoadMesh(path);
+				if (!mesh)
+					return nullptr;
+				numItems = mesh->GetIndices().size() / 3;
+				auto bvh = std::make_shared<GL3::BVH>();
+				return [mesh, bvh]() { bvh->Build(*mesh); };
+			});
+
+			//! Ray throughput in rays per second, closest hits and any hits over batches spread on the workers.
+			for (bool bAnyHit : { false, true })
+			{
+				harness.Add(std::string(bAnyHit ? "BVH::IsOccluded/" : "BVH::Intersect/") + name, [path, bAnyHit](uint64_t& numItems) -> Harness::Body
+				{
+					auto mesh = LoadMesh(path);
+					auto bvh = std::make_shared<GL3::BVH>();
+					if (!mesh || !bvh->Build(*mesh))
+						return nullptr;
+					auto rays = std::make_shared< std::vector<Ray> >(MakeRays(bvh->GetBoundingBox(), 1 << 18));
+					auto hits = std::make_shared< std::vector<uint8_t> >(rays->size());
+					numItems = rays->size();
+					return [bvh, rays, hits, bAnyHit]()
+					{
+						GL3::JobSystem::GetInstance().ParallelFor((rays->size() + RAYS_PER_JOB - 1) / RAYS_PER_JOB, [&](size_t job)
+						{
+							const size_t end = std::min(rays->size(), (job + 1) * RAYS_PER_JOB);
+							for (size_t index = job * RAYS_PER_JOB; index < end; ++index)
+							{
+								const Ray& ray = (*rays)[index];
+								GL3::RayHit hit;
+								(*hits)[index] = bAnyHit ? bvh->IsOccluded(ray.origin, ray.direction, 1.0f) : bvh->Intersect(ray.origin, ray.direction, 1.0f, hit);
+							}
+						});
+					};
+				});
+			}
+
+			if (std::string(name) == "dragon")
+				continue;
+
+			harness.Add(std::string("OcclusionCuller::RenderOccluders/") + name, [path](uint64_t& numItems) -> Harness::Body
+			{
+				auto mesh = LoadMesh(path);
+				auto culler = std::make_shared<GL3::OcclusionCuller>();
+				if (!mesh || !culler->Initialize(320, 180))
+					return nullptr;
+				numItems = mesh->GetIndices().size() / 3;
+				return [mesh, culler]()
+				{
+					culler->BeginFrame(GetView(), GetProjection());
+					culler->AddOccluder(*mesh, glm::mat4(1.0f));
+					culler->RenderOccluders();
+				};
+			});
+
+			harness.Add(std::string("SoftwareRasterizer/") + name, [path](uint64_t& numItems) -> Harness::Body
+			{
+				auto mesh = LoadMesh(path);
+				auto rasterizer = std::make_shared<GL3::SoftwareRasterizer>();
+				if (!mesh || !rasterizer->Initialize(1280, 720))
+					return nullptr;
+				numItems = static_cast<uint64_t>(1280) * 720;
+				rasterizer->SetCamera(GetView(), GetProjection());
+				return [mesh, rasterizer]()
+				{
+					rasterizer->Clear(glm::vec4(0.0f, 0.0f, 0.8f, 1.0f));
+					rasterizer->DrawMesh(*mesh, glm::mat4(1.0f));
+					rasterizer->Flush();
+				};
+			});
+		}
+
+		for (size_t numBoxes : { 10000, 100000 })
+		{
+			const std::string path = resourcesDir + "/objects/sponza.obj";
+			harness.Add("OcclusionCuller::CullBoxes/" + std::to_string(numBoxes), [path, numBoxes](uint64_t& numItems) -> Harness::Body
+			{
+				auto mesh = LoadMesh(path);
+				auto culler = std::make_shared<GL3::OcclusionCuller>();
+				if (!mesh || !culler->Initialize(320, 180))
+					return nullptr;
+				culler->BeginFrame(GetView(), GetProjection());
+				culler->AddOccluder(*mesh, glm::mat4(1.0f));
+				culler->RenderOccluders();
+
+				numItems = numBoxes;
+				auto boxes = std::make_shared< std::vector<GL3::BoundingBox> >(MakeBoxes(numBoxes));
+				auto visibility = std::make_shared< std::vector<uint8_t> >();
+				return [culler, boxes, visibility]() { culler->CullBoxes(*boxes, *visibility); };
+			});
+		}
+
+		for (size_t numLights : { 256, 1024, 4096 })
+		{
+			harness.Add("ClusteredLightCuller::Cull/" + std::to_string(numLights), [numLights](uint64_t& numItems) -> Harness::Body
+			{
+				auto culler = std::make_shared<GL3::ClusteredLightCuller>();
+				culler->SetLights(MakeLights(numLights));
+				numItems = numLights;
+				const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+				return [culler, projection]() { culler->Cull(glm::mat4(1.0f), projection, 0.1f, 100.0f); };
+			});
+		}
+	}
+};
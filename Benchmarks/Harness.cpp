@@ -0,0 +1,262 @@
+#include "Harness.hpp"
+#include "Baseline.hpp"
+#include <GL3/Allocators.hpp>
+#include <GL3/JobSystem.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+namespace
+{
+	//! Escape the characters JSON strings can not hold verbatim
+	std::string EscapeJSON(const std::string& text)
+	{
+		std::string escaped;
+		for (char character : text)
+		{
+			if (character == '"' || character == '\\')
+				escaped += '\\';
+			escaped += character;
+		}
+		return escaped;
+	}
+
+	//! Print the scopes of a case indented under its line, the counter columns only where they were read
+	void PrintScopes(std::ostream& stream, const Benchmark::Result& result, size_t numRepetitions)
+	{
+		for (const auto& scope : result.scopes)
+		{
+			const GL3::ScopeStatistics& statistics = scope.second;
+			stream << "  " << std::left << std::setw(46) << scope.first << std::right << std::fixed << std::setprecision(3)
+				   << std::setw(10) << statistics.totalTime / numRepetitions << " ms" << std::setw(8) << statistics.numCalls / numRepetitions << " calls";
+			if (statistics.bHasCounters)
+			{
+				stream << std::setprecision(2) << std::setw(8) << statistics.GetIPC() << " IPC"
+					   << std::setw(12) << statistics.counters[static_cast<size_t>(GL3::HardwareCounter::CacheMisses)] / numRepetitions << " cache miss"
+					   << std::setw(12) << statistics.counters[static_cast<size_t>(GL3::HardwareCounter::BranchMisses)] / numRepetitions << " branch miss";
+				if (statistics.numCells)
+					stream << std::setw(8) << statistics.GetBytesPerCell() << " B/cell";
+			}
+			stream << std::endl;
+		}
+	}
+
+	//! JSON members of one counter set, per repetition like the timings
+	void WriteScopeJSON(std::ostream& file, const std::string& name, const GL3::ScopeStatistics& statistics, size_t numRepetitions)
+	{
+		const double repetitions = static_cast<double>(std::max<size_t>(numRepetitions, 1));
+		file << "{\"name\": \"" << EscapeJSON(name) << "\", \"calls\": " << statistics.numCalls / repetitions
+			 << ", \"total_ms\": " << statistics.totalTime / repetitions << ", \"max_ms\": " << statistics.maxTime
+			 << ", \"cells\": " << statistics.numCells / repetitions;
+		if (statistics.bHasCounters)
+		{
+			const char* COUNTER_NAMES[GL3::NUM_HARDWARE_COUNTERS] = { "cycles", "instructions", "cache_misses", "branch_misses" };
+			for (size_t counter = 0; counter < GL3::NUM_HARDWARE_COUNTERS; ++counter)
+				file << ", \"" << COUNTER_NAMES[counter] << "\": " << statistics.counters[counter] / repetitions;
+			file << ", \"ipc\": " << statistics.GetIPC() << ", \"bytes_per_cell\": " << statistics.GetBytesPerCell();
+		}
+		file << "}";
+	}
+};
+
+namespace Benchmark {
+
+	double Percentile(const std::vector<double>& sorted, double percentile)
+	{
+		if (sorted.empty())
+			return 0.0;
+		const double rank = percentile / 100.0 * static_cast<double>(sorted.size() - 1);
+		const size_t lower = static_cast<size_t>(rank);
+		const size_t upper = std::min(lower + 1, sorted.size() - 1);
+		return sorted[lower] + (sorted[upper] - sorted[lower]) * (rank - static_cast<double>(lower));
+	}
+
+	double Result::GetItemsPerSecond() const
+	{
+		return median > 0.0 ? static_cast<double>(numItems) * 1000.0 / median : 0.0;
+	}
+
+	Harness::Harness()
+	{
+		//! Do nothing
+	}
+
+	Harness::~Harness()
+	{
+		//! Do nothing
+	}
+
+	void Harness::Add(const std::string& name, const Prepare& prepare)
+	{
+		_cases.push_back({ name, prepare });
+	}
+
+	void Harness::List(std::ostream& stream) const
+	{
+		for (const Case& benchmarkCase : _cases)
+			stream << benchmarkCase.name << std::endl;
+	}
+
+	bool Harness::Run(const Options& options, std::ostream& stream)
+	{
+		bool bSucceeded = true;
+		_results.clear();
+
+		stream << std::left << std::setw(48) << "Benchmark" << std::right << std::setw(10) << "Median" << std::setw(10) << "P90"
+			   << std::setw(10) << "P99" << std::setw(10) << "Min" << std::setw(10) << "Stddev" << std::setw(14) << "Items/s" << std::endl;
+
+		auto& frameArena = GL3::FrameArena::GetInstance();
+		for (const Case& benchmarkCase : _cases)
+		{
+			if (!options.filter.empty() && benchmarkCase.name.find(options.filter) == std::string::npos)
+				continue;
+
+			uint64_t numItems = 0;
+			const Body body = benchmarkCase.prepare(numItems);
+			if (!body)
+			{
+				std::cerr << "Failed to prepare " << benchmarkCase.name << std::endl;
+				bSucceeded = false;
+				continue;
+			}
+
+			for (size_t warmup = 0; warmup < options.numWarmups; ++warmup)
+			{
+				body();
+				frameArena.EndFrame();
+			}
+
+			//! Only the timed repetitions count towards the scopes of the case
+			auto& profiler = GL3::Profiler::GetInstance();
+			if (options.bPerfCounters)
+				profiler.Reset();
+
+			Result result;
+			result.name = benchmarkCase.name;
+			result.numItems = numItems;
+			result.samples.reserve(options.numRepetitions);
+			for (size_t repetition = 0; repetition < options.numRepetitions; ++repetition)
+			{
+				const auto startTime = std::chrono::steady_clock::now();
+				body();
+				result.samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+				frameArena.EndFrame();
+			}
+			Summarize(result);
+			if (options.bPerfCounters)
+			{
+				const auto statistics = profiler.GetStatistics();
+				result.scopes.assign(statistics.begin(), statistics.end());
+				std::sort(result.scopes.begin(), result.scopes.end(), [](const auto& lhs, const auto& rhs) { return lhs.second.totalTime > rhs.second.totalTime; });
+			}
+
+			stream << std::left << std::setw(48) << result.name << std::right << std::fixed << std::setprecision(3)
+				   << std::setw(10) << result.median << std::setw(10) << result.p90 << std::setw(10) << result.p99
+				   << std::setw(10) << result.minimum << std::setw(10) << result.stddev << std::setprecision(0)
+				   << std::setw(14) << result.GetItemsPerSecond() << std::endl;
+			PrintScopes(stream, result, options.numRepetitions);
+			_results.push_back(std::move(result));
+		}
+
+		return bSucceeded;
+	}
+
+	void Harness::Summarize(Result& result)
+	{
+		std::vector<double> sorted = result.samples;
+		std::sort(sorted.begin(), sorted.end());
+
+		const double count = static_cast<double>(std::max<size_t>(sorted.size(), 1));
+		result.mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / count;
+		double variance = 0.0;
+		for (double sample : sorted)
+			variance += (sample - result.mean) * (sample - result.mean);
+		result.stddev = sorted.size() > 1 ? std::sqrt(variance / (count - 1.0)) : 0.0;
+		result.minimum = sorted.empty() ? 0.0 : sorted.front();
+		result.maximum = sorted.empty() ? 0.0 : sorted.back();
+		result.median = Percentile(sorted, 50.0);
+		result.p90 = Percentile(sorted, 90.0);
+		result.p99 = Percentile(sorted, 99.0);
+	}
+
+	bool Harness::WriteJSON(const std::string& path, const Options& options) const
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			std::cerr << "Failed to open " << path << std::endl;
+			return false;
+		}
+
+		const Fingerprint fingerprint = Fingerprint::Detect();
+		file << std::setprecision(6) << "{\n  \"version\": " << BASELINE_VERSION << ",\n  \"fingerprint\": {\"cpu\": \"" << EscapeJSON(fingerprint.cpuModel)
+			 << "\", \"cores\": " << fingerprint.numCores << ", \"isa\": \"" << EscapeJSON(fingerprint.isa) << "\", \"key\": \"" << fingerprint.GetKey()
+			 << "\"},\n  \"threads\": " << GL3::JobSystem::GetInstance().GetNumThreads()
+			 << ",\n  \"warmups\": " << options.numWarmups << ",\n  \"repetitions\": " << options.numRepetitions << ",\n  \"benchmarks\": [";
+		for (size_t index = 0; index < _results.size(); ++index)
+		{
+			const Result& result = _results[index];
+			file << (index ? ",\n" : "\n") << "    {\"name\": \"" << EscapeJSON(result.name) << "\", \"items\": " << result.numItems
+				 << ", \"mean_ms\": " << result.mean << ", \"stddev_ms\": " << result.stddev << ", \"min_ms\": " << result.minimum
+				 << ", \"median_ms\": " << result.median << ", \"p90_ms\": " << result.p90 << ", \"p99_ms\": " << result.p99
+				 << ", \"max_ms\": " << result.maximum << ", \"items_per_second\": " << result.GetItemsPerSecond() << ", \"samples_ms\": [";
+			for (size_t sample = 0; sample < result.samples.size(); ++sample)
+				file << (sample ? ", " : "") << result.samples[sample];
+			file << "]";
+			if (!result.scopes.empty())
+			{
+				file << ", \"scopes\": [";
+				for (size_t scope = 0; scope < result.scopes.size(); ++scope)
+				{
+					file << (scope ? ", " : "");
+					WriteScopeJSON(file, result.scopes[scope].first, result.scopes[scope].second, options.numRepetitions);
+				}
+				file << "]";
+			}
+			file << "}";
+		}
+		file << "\n  ]\n}\n";
+
+		return true;
+	}
+
+	ReportTable::ReportTable(std::ostream& stream, const std::vector<Column>& columns) : _stream(stream), _columns(columns)
+	{
+		std::vector<std::string> titles;
+		for (const Column& column : _columns)
+			titles.push_back(column.title);
+		AddRow(titles);
+	}
+
+	ReportTable::~ReportTable()
+	{
+		//! Do nothing
+	}
+
+	void ReportTable::AddRow(const std::vector<std::string>& cells)
+	{
+		for (size_t column = 0; column < _columns.size(); ++column)
+			_stream << (column == 0 ? std::left : std::right) << std::setw(_columns[column].width)
+					<< (column < cells.size() ? cells[column] : std::string());
+		_stream << std::right << std::endl;
+	}
+
+	std::string ReportTable::Fixed(double value, int precision)
+	{
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(precision) << value;
+		return stream.str();
+	}
+
+	std::string ReportTable::Scientific(double value, int precision)
+	{
+		std::ostringstream stream;
+		stream << std::scientific << std::setprecision(precision) << value;
+		return stream.str();
+	}
+};
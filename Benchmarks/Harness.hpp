@@ -0,0 +1,133 @@
+#ifndef BENCHMARK_HARNESS_HPP
+#define BENCHMARK_HARNESS_HPP
+
+#include <GL3/Profiler.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Benchmark {
+
+	//! Timings of one benchmark case in milliseconds
+	struct Result
+	{
+		std::string name;
+		//! Work items of one repetition (triangles, cells, boxes), zero when not meaningful
+		uint64_t numItems;
+		std::vector<double> samples;
+		double mean, stddev;
+		double minimum, median, p90, p99, maximum;
+		//! Profile scopes the timed repetitions entered, by descending total time, empty without perf counters
+		std::vector< std::pair<std::string, GL3::ScopeStatistics> > scopes;
+		//! Returns the items processed per second at the median time
+		double GetItemsPerSecond() const;
+	};
+
+	//! Repetition counts of a run
+	struct Options
+	{
+		size_t numWarmups;
+		size_t numRepetitions;
+		//! Only cases whose name contains the filter run, empty runs all
+		std::string filter;
+		//! Collect the profile scopes of every case with their hardware counters where available
+		bool bPerfCounters;
+	};
+
+	//! Minimal benchmark harness for the headless CPU hot paths.
+	//! A case is registered with a prepare function that builds its inputs outside the timing, stores the
+	//! work items of one repetition and returns the body of one repetition, or an empty function when the
+	//! inputs are not available. Prepare only runs when the case passes the filter.
+	//! The frame arena is recycled after every repetition, like the renderer does after every frame.
+	class Harness
+	{
+	public:
+		using Body = std::function<void()>;
+		using Prepare = std::function<Body(uint64_t& numItems)>;
+		//! Default constructor
+		Harness();
+		//! Default destructor
+		~Harness();
+		//! Register a case, the items prepare reports feed the throughput column
+		void Add(const std::string& name, const Prepare& prepare);
+		//! Print the registered case names
+		void List(std::ostream& stream) const;
+		//! Run the matching cases and print one line per case followed by its profile scopes with perf counters,
+		//! returns false when a case failed to prepare.
+		bool Run(const Options& options, std::ostream& stream);
+		//! Write the results of the last Run() as JSON, the samples and the machine fingerprint are included
+		//! so the file can be loaded back as Baseline.
+		bool WriteJSON(const std::string& path, const Options& options) const;
+		inline const std::vector<Result>& GetResults() const
+		{
+			return _results;
+		}
+	private:
+		//! Registered case
+		struct Case
+		{
+			std::string name;
+			Prepare prepare;
+		};
+		//! Fill the statistics of the result from its samples
+		static void Summarize(Result& result);
+
+		std::vector<Case> _cases;
+		std::vector<Result> _results;
+	};
+
+	//! Percentile of sorted samples with linear interpolation between the closest ranks
+	double Percentile(const std::vector<double>& sorted, double percentile);
+
+	//! Case registration of each benchmark file, resourcesDir is the Resources directory
+	void RegisterMeshBenchmarks(Harness& harness, const std::string& resourcesDir);
+	void RegisterCullingBenchmarks(Harness& harness, const std::string& resourcesDir);
+	void RegisterSimulationBenchmarks(Harness& harness);
+	void RegisterSceneBenchmarks(Harness& harness);
+	//! Print the names and descriptions of the reports RunReport() knows
+	void ListReports(std::ostream& stream);
+	//! Run the named report on the scenarios or inputs matching the filter, returns false for an unknown name.
+	//! crown: the canopy layer memory per km^2 and step cost next to the surface engine.
+	//! multirate: the tiled engine at full rate against the focus on the map center, the speedup and the
+	//! ignition delays the coarse tiles cause.
+	//! amr: the landscape grid, the grid refined to the finest adaptive level and adaptive refinement,
+	//! their timings, peak cells and burned area errors against the fine grid.
+	//! substep: FireSpread in fixed steps against stable steps of a few Courant numbers, and AdaptiveFireSpread
+	//! in fixed steps against subcycled tiles, the timings, substeps and burned area errors against steps
+	//! 16 times shorter.
+	//! weather: six hours of station weather from CSV and binary files with cached slices against
+	//! blending the stations at every update, the timings, window and slice counts and wind differences.
+	//! smoke: the smoke ray marcher on a transported plume with the empty bricks skipped and with every brick
+	//! marched, the occupied bricks, the density samples per pixel and the render time.
+	bool RunReport(const std::string& name, const std::string& filter, std::ostream& stream);
+
+	//! Fixed width text table of a report, the header is printed on construction, the first column is
+	//! left aligned and the others right aligned
+	class ReportTable
+	{
+	public:
+		struct Column
+		{
+			std::string title;
+			int width;
+		};
+		//! Print the header
+		ReportTable(std::ostream& stream, const std::vector<Column>& columns);
+		//! Default destructor
+		~ReportTable();
+		//! Print one row, missing cells stay empty
+		void AddRow(const std::vector<std::string>& cells);
+		//! Format a value with the given digits after the point
+		static std::string Fixed(double value, int precision);
+		static std::string Scientific(double value, int precision);
+	private:
+		std::ostream& _stream;
+		std::vector<Column> _columns;
+	};
+
+};
+
+#endif //! end of Harness.hpp
@@ -0,0 +1,162 @@
+#include "Harness.hpp"
+#include <GL3/Mesh.hpp>
+#include <GL3/MeshGraph.hpp>
+#include <Simulation/MeshFireSpread.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+
+namespace
+{
+	//! Inputs of the welding and normal cases, taken from the loaded mesh
+	struct MeshInputs
+	{
+		std::vector<GL3::PackedVertex> triangleVertices;
+		std::vector<glm::vec3> positions;
+		std::vector<unsigned int> indices;
+	};
+
+	//! Load the mesh on the CPU and expand it back into an unwelded triangle list
+	std::shared_ptr<MeshInputs> LoadInputs(const std::string& path)
+	{
+		GL3::Mesh mesh;
+		if (!mesh.LoadObj(path.c_str(), true, false))
+			return nullptr;
+
+		auto inputs = std::make_shared<MeshInputs>();
+		inputs->positions = mesh.GetPositions();
+		inputs->indices = mesh.GetIndices();
+		inputs->triangleVertices.reserve(inputs->indices.size());
+		for (unsigned int index : inputs->indices)
+			inputs->triangleVertices.emplace_back(mesh.GetPositions()[index], glm::vec2(0.0f), mesh.GetNormals()[index]);
+		return inputs;
+	}
+
+	//! Steps of one mesh fire run and the burn time in steps
+	constexpr int FIRE_STEPS = 400;
+	constexpr float FIRE_BURN_STEPS = 20.0f;
+
+	//! Mesh graph of an obj with a uniform spread rate crossing the mean edge in one step
+	struct MeshFireInputs
+	{
+		GL3::MeshGraph graph;
+		std::vector<float> spreadRates;
+		uint32_t ignition;
+	};
+
+	std::shared_ptr<MeshFireInputs> LoadFireInputs(const std::string& path)
+	{
+		auto inputs = LoadInputs(path);
+		auto fire = std::make_shared<MeshFireInputs>();
+		if (!inputs || !fire->graph.Build(inputs->positions, inputs->indices))
+			return nullptr;
+
+		const auto& lengths = fire->graph.GetLengths();
+		double totalLength = 0.0;
+		for (float length : lengths)
+			totalLength += length;
+		const float meanLength = lengths.empty() ? 1.0f : static_cast<float>(totalLength / lengths.size());
+		fire->spreadRates.assign(fire->graph.GetNumNodes(), meanLength);
+
+		//! Light the lowest node so the fire climbs the mesh.
+		const auto& positions = fire->graph.GetNodePositions();
+		fire->ignition = 0;
+		for (uint32_t node = 1; node < positions.size(); ++node)
+			if (positions[node].y < positions[fire->ignition].y)
+				fire->ignition = node;
+		return fire;
+	}
+};
+
+namespace Benchmark {
+
+	void RegisterMeshBenchmarks(Harness& harness, const std::string& resourcesDir)
+	{
+		std::vector<std::filesystem::path> objects;
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator(resourcesDir + "/objects", error))
+			if (entry.path().extension() == ".obj")
+				objects.push_back(entry.path());
+		std::sort(objects.begin(), objects.end());
+
+		for (const auto& object : objects)
+		{
+			const std::string path = object.string();
+			const std::string name = object.stem().string();
+
+			harness.Add("LoadObj/" + name, [path](uint64_t& numItems) -> Harness::Body
+			{
+				GL3::Mesh mesh;
+				if (!mesh.LoadObj(path.c_str(), true, false))
+					return nullptr;
+				numItems = mesh.GetIndices().size() / 3;
+				return [path]()
+				{
+					GL3::Mesh mesh;
+					mesh.LoadObj(path.c_str(), true, false);
+				};
+			});
+
+			harness.Add("WeldVertices/" + name, [path](uint64_t& numItems) -> Harness::Body
+			{
+				auto inputs = LoadInputs(path);
+				if (!inputs)
+					return nullptr;
+				numItems = inputs->indices.size() / 3;
+				return [inputs]()
+				{
+					std::vector<GL3::PackedVertex> vertices;
+					std::vector<unsigned int> indices;
+					GL3::WeldVertices(inputs->triangleVertices, vertices, indices);
+				};
+			});
+
+			harness.Add("ComputeVertexNormals/" + name, [path](uint64_t& numItems) -> Harness::Body
+			{
+				auto inputs = LoadInputs(path);
+				if (!inputs)
+					return nullptr;
+				numItems = inputs->indices.size() / 3;
+				auto normals = std::make_shared< std::vector<glm::vec3> >();
+				return [inputs, normals]()
+				{
+					GL3::ComputeVertexNormals(inputs->positions, inputs->indices, *normals);
+				};
+			});
+
+			harness.Add("MeshGraph::Build/" + name, [path](uint64_t& numItems) -> Harness::Body
+			{
+				auto inputs = LoadInputs(path);
+				if (!inputs)
+					return nullptr;
+				numItems = inputs->indices.size() / 3;
+				auto graph = std::make_shared<GL3::MeshGraph>();
+				return [inputs, graph]()
+				{
+					graph->Build(inputs->positions, inputs->indices);
+				};
+			});
+
+			//! Items are the nodes the fire reached, one second steps.
+			harness.Add("MeshFireSpread::Run/" + name, [path](uint64_t& numItems) -> Harness::Body
+			{
+				auto inputs = LoadFireInputs(path);
+				if (!inputs)
+					return nullptr;
+				auto fire = std::make_shared<Simulation::MeshFireSpread>();
+				auto colors = std::make_shared< std::vector<uint32_t> >(inputs->graph.GetVertexNodes().size());
+				auto run = [inputs, fire, colors]()
+				{
+					fire->Initialize(inputs->graph, inputs->spreadRates, FIRE_BURN_STEPS);
+					fire->Ignite(inputs->ignition);
+					for (int step = 0; step < FIRE_STEPS; ++step)
+						fire->Step(1.0f);
+					fire->WriteColors(colors->data());
+				};
+				run();
+				numItems = fire->GetNumBurning() + fire->GetNumBurned();
+				return run;
+			});
+		}
+	}
+};
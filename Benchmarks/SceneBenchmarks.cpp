@@ -0,0 +1,194 @@
+#include "Harness.hpp"
+#include <GL3/EntityStore.hpp>
+#include <GL3/SceneComponents.hpp>
+#include <GL3/TransformHierarchy.hpp>
+#include <functional>
+#include <memory>
+#include <random>
+
+namespace
+{
+	//! Object layout of the shared_ptr scene the entity store replaces
+	struct SceneObject
+	{
+		GL3::TransformComponent transform;
+		GL3::RenderMeshComponent renderMesh;
+		GL3::FireStateComponent fireState;
+		GL3::CullingComponent culling;
+	};
+
+	GL3::TransformComponent MakeTransform(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> position(-5000.0f, 5000.0f), scale(0.5f, 2.0f);
+		return { glm::vec3(position(random), 0.0f, position(random)), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(scale(random)) };
+	}
+
+	//! Bounds of a unit tree model placed by the transform
+	inline void UpdateBounds(const GL3::TransformComponent& transform, GL3::CullingComponent& culling)
+	{
+		const glm::vec3 halfExtent = transform.scale * glm::vec3(1.5f, 4.0f, 1.5f);
+		culling.lowerCorner = transform.position - halfExtent;
+		culling.upperCorner = transform.position + halfExtent;
+	}
+
+	//! Trees with transform, mesh and culling data, every fourth one also linked to the fire grid
+	std::shared_ptr<GL3::EntityStore> MakeForest(size_t numTrees)
+	{
+		std::mt19937 random(11);
+		auto store = std::make_shared<GL3::EntityStore>();
+		for (size_t tree = 0; tree < numTrees; ++tree)
+		{
+			const GL3::TransformComponent transform = MakeTransform(random);
+			const GL3::RenderMeshComponent renderMesh = { static_cast<uint32_t>(tree % 4), 0 };
+			if (tree % 4 == 0)
+				store->Create(transform, renderMesh, GL3::CullingComponent{}, GL3::FireStateComponent{ static_cast<uint32_t>(tree), 0.0f, 1 });
+			else
+				store->Create(transform, renderMesh, GL3::CullingComponent{});
+		}
+		return store;
+	}
+
+	//! Terrain tiles of 256 trees each, every tree carrying two branch nodes
+	std::shared_ptr<GL3::TransformHierarchy> MakeHierarchy(size_t numTrees)
+	{
+		std::mt19937 random(13);
+		auto hierarchy = std::make_shared<GL3::TransformHierarchy>();
+		const GL3::TransformComponent identity = { glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f) };
+		GL3::TransformHierarchy::Handle tile = 0;
+		for (size_t tree = 0; tree < numTrees; ++tree)
+		{
+			if (tree % 256 == 0)
+				tile = hierarchy->Add(identity);
+			const GL3::TransformHierarchy::Handle trunk = hierarchy->Add(MakeTransform(random), tile);
+			hierarchy->Add({ glm::vec3(0.0f, 2.0f, 0.0f), glm::angleAxis(0.5f, glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(0.5f) }, trunk);
+			hierarchy->Add({ glm::vec3(0.0f, 3.0f, 0.0f), glm::angleAxis(-0.5f, glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(0.4f) }, trunk);
+		}
+		hierarchy->Update();
+		return hierarchy;
+	}
+};
+
+namespace Benchmark {
+
+	void RegisterSceneBenchmarks(Harness& harness)
+	{
+		for (size_t numTrees : { 100000, 1000000 })
+		{
+			const std::string suffix = "/" + std::to_string(numTrees);
+
+			harness.Add("EntityStore::Create" + suffix, [numTrees](uint64_t& numItems) -> Harness::Body
+			{
+				numItems = numTrees;
+				return [numTrees]() { MakeForest(numTrees); };
+			});
+
+			harness.Add("EntityStore::ParallelForEach" + suffix, [numTrees](uint64_t& numItems) -> Harness::Body
+			{
+				numItems = numTrees;
+				auto store = MakeForest(numTrees);
+				return [store]()
+				{
+					store->ParallelForEach<GL3::TransformComponent, GL3::CullingComponent>(
+						[](GL3::Entity, const GL3::TransformComponent& transform, GL3::CullingComponent& culling) { UpdateBounds(transform, culling); });
+				};
+			});
+
+			harness.Add("EntityStore::ForEachChunk" + suffix, [numTrees](uint64_t& numItems) -> Harness::Body
+			{
+				numItems = numTrees;
+				auto store = MakeForest(numTrees);
+				return [store]()
+				{
+					store->ForEachChunk<GL3::TransformComponent, GL3::CullingComponent>(
+						[](size_t count, const GL3::Entity*, const GL3::TransformComponent* transforms, GL3::CullingComponent* culling)
+					{
+						for (size_t row = 0; row < count; ++row)
+							UpdateBounds(transforms[row], culling[row]);
+					});
+				};
+			});
+
+			harness.Add("TransformHierarchy::Update/all" + suffix, [numTrees](uint64_t& numItems) -> Harness::Body
+			{
+				auto hierarchy = MakeHierarchy(numTrees);
+				auto instances = std::make_shared< std::vector<glm::mat4> >(hierarchy->GetNumNodes());
+				numItems = hierarchy->GetNumNodes();
+				return [hierarchy, instances]()
+				{
+					//! Moving every tile root dirties the whole forest.
+					for (GL3::TransformHierarchy::Handle node = 0; node < hierarchy->GetNumNodes(); node += 256 * 3 + 1)
+						hierarchy->SetLocal(node, hierarchy->GetLocal(node));
+					hierarchy->Update(instances->data());
+				};
+			});
+
+			harness.Add("TransformHierarchy::Update/sparse" + suffix, [numTrees](uint64_t& numItems) -> Harness::Body
+			{
+				auto hierarchy = MakeHierarchy(numTrees);
+				auto instances = std::make_shared< std::vector<glm::mat4> >(hierarchy->GetNumNodes());
+				numItems = hierarchy->GetNumNodes();
+				return [hierarchy, instances]()
+				{
+					//! One node in a hundred sways, a trunk takes its two branches along. The tile roots, whose
+					//! handles are multiples of 256 * 3 + 1, are skipped so no whole tile goes dirty.
+					for (GL3::TransformHierarchy::Handle node = 1; node < hierarchy->GetNumNodes(); node += 100)
+						if (node % (256 * 3 + 1) != 0)
+							hierarchy->SetLocal(node, hierarchy->GetLocal(node));
+					hierarchy->Update(instances->data());
+				};
+			});
+
+			//! Reference: recursive world matrices over individually allocated nodes
+			harness.Add("SharedPtrHierarchy::Update" + suffix, [numTrees](uint64_t& numItems) -> Harness::Body
+			{
+				struct Node
+				{
+					GL3::TransformComponent local;
+					glm::mat4 world;
+					std::vector< std::shared_ptr<Node> > children;
+				};
+				std::mt19937 random(13);
+				auto roots = std::make_shared< std::vector< std::shared_ptr<Node> > >();
+				const GL3::TransformComponent identity = { glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f) };
+				for (size_t tree = 0; tree < numTrees; ++tree)
+				{
+					if (tree % 256 == 0)
+						roots->push_back(std::make_shared<Node>(Node{ identity, glm::mat4(1.0f), {} }));
+					auto trunk = std::make_shared<Node>(Node{ MakeTransform(random), glm::mat4(1.0f), {} });
+					trunk->children.push_back(std::make_shared<Node>(Node{ { glm::vec3(0.0f, 2.0f, 0.0f), glm::angleAxis(0.5f, glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(0.5f) }, glm::mat4(1.0f), {} }));
+					trunk->children.push_back(std::make_shared<Node>(Node{ { glm::vec3(0.0f, 3.0f, 0.0f), glm::angleAxis(-0.5f, glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(0.4f) }, glm::mat4(1.0f), {} }));
+					roots->back()->children.push_back(trunk);
+				}
+				numItems = numTrees * 3 + roots->size();
+				return [roots]()
+				{
+					std::function<void(Node&, const glm::mat4&)> update = [&update](Node& node, const glm::mat4& parent)
+					{
+						node.world = parent * node.local.GetMatrix();
+						for (const auto& child : node.children)
+							update(*child, node.world);
+					};
+					for (const auto& root : *roots)
+						update(*root, glm::mat4(1.0f));
+				};
+			});
+
+			//! Reference: the same update over individually allocated objects
+			harness.Add("SharedPtrScene::Update" + suffix, [numTrees](uint64_t& numItems) -> Harness::Body
+			{
+				numItems = numTrees;
+				std::mt19937 random(11);
+				auto objects = std::make_shared< std::vector< std::shared_ptr<SceneObject> > >();
+				for (size_t tree = 0; tree < numTrees; ++tree)
+					objects->push_back(std::make_shared<SceneObject>(SceneObject{ MakeTransform(random), {}, {}, {} }));
+				std::shuffle(objects->begin(), objects->end(), random);
+				return [objects]()
+				{
+					for (const auto& object : *objects)
+						UpdateBounds(object->transform, object->culling);
+				};
+			});
+		}
+	}
+
+};
@@ -0,0 +1,887 @@
+#include "Harness.hpp"
+#include <GL3/IsoSurface.hpp>
+#include <GL3/SmokeVolumeRenderer.hpp>
+#include <Simulation/AdaptiveFireSpread.hpp>
+#include <Simulation/CrownFire.hpp>
+#include <Simulation/FireSpread.hpp>
+#include <Simulation/PathFinder.hpp>
+#include <Simulation/RadiantHeat.hpp>
+#include <Simulation/ScenarioGenerator.hpp>
+#include <Simulation/SmokeTransport.hpp>
+#include <Simulation/SpatialHash.hpp>
+#include <Simulation/SuppressionAgents.hpp>
+#include <Simulation/TiledFireSpread.hpp>
+#include <Simulation/WeatherInput.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+
+namespace
+{
+	std::string FormatExtent(const glm::ivec3& extent)
+	{
+		std::string text = std::to_string(extent.x) + "x" + std::to_string(extent.y);
+		return extent.z > 1 ? text + "x" + std::to_string(extent.z) : text;
+	}
+
+	//! Fraction of the area of every landscape cell that is burning or burned in a fire on the landscape
+	//! refined factor times
+	std::vector<float> GetBurnedFraction(const Simulation::FireSpread& fire, int factor)
+	{
+		const int width = fire.GetWidth() / factor, height = fire.GetHeight() / factor;
+		std::vector<float> fraction(static_cast<size_t>(width) * height, 0.0f);
+		for (int y = 0; y < fire.GetHeight(); ++y)
+		{
+			for (int x = 0; x < fire.GetWidth(); ++x)
+			{
+				const uint8_t state = fire.GetState()[static_cast<size_t>(y) * fire.GetWidth() + x];
+				if (state == Simulation::FireSpread::Burning || state == Simulation::FireSpread::Burned)
+					fraction[static_cast<size_t>(y / factor) * width + x / factor] += 1.0f / (factor * factor);
+			}
+		}
+		return fraction;
+	}
+
+	//! Initialize the fire on the refined landscape and ignite the cells of the landscape cells the
+	//! adaptive fire ignited
+	bool IgniteRefined(const Simulation::Landscape& refined, int factor, const Simulation::AdaptiveFireSpread& adaptive, Simulation::FireSpread& fire)
+	{
+		std::vector<float> fraction;
+		adaptive.GetBurnedFraction(fraction);
+		if (!fire.Initialize(refined))
+			return false;
+		bool bIgnited = false;
+		for (int y = 0; y < refined.height; ++y)
+			for (int x = 0; x < refined.width; ++x)
+				if (fraction[static_cast<size_t>(y / factor) * adaptive.GetWidth() + x / factor] > 0.0f)
+					bIgnited |= fire.Ignite(x, y);
+		return bIgnited;
+	}
+
+	//! Two days of hourly records from 16 stations scattered over a square grid of size cells of 10 m,
+	//! each reporting at its own minute, written in the given format to the temp directory
+	std::string MakeWeatherFile(int size, bool bBinary)
+	{
+		std::mt19937 random(23);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+		const float extent = size * 10.0f;
+		std::vector<Simulation::WeatherStation> stations;
+		for (int station = 0; station < 16; ++station)
+			stations.push_back({ "station" + std::to_string(station), glm::vec2(uniform(random), uniform(random)) * extent });
+		std::vector<Simulation::WeatherRecord> records;
+		for (int hour = 0; hour < 48; ++hour)
+		{
+			for (uint32_t station = 0; station < stations.size(); ++station)
+			{
+				const float phase = 6.2831853f * hour / 24.0f + station * 0.3f;
+				records.push_back({ hour * 3600.0 + station * 225.0, station,
+									{ glm::vec2(6.0f + 3.0f * std::sin(phase), 2.0f * std::cos(phase)) + glm::vec2(uniform(random), uniform(random)),
+									  50.0f + 25.0f * std::cos(phase) + 5.0f * uniform(random), 18.0f - 8.0f * std::cos(phase) + uniform(random) } });
+			}
+		}
+
+		const std::string path = (std::filesystem::temp_directory_path() / ("gl3-bench-weather-" + std::to_string(size) + (bBinary ? ".bin" : ".csv"))).string();
+		const bool bWritten = bBinary ? Simulation::WeatherInput::WriteBinary(path, stations, records) : Simulation::WeatherInput::WriteCSV(path, stations, records);
+		return bWritten ? path : std::string();
+	}
+
+	//! Intensity field with 30% of the cells burning, the density the radiant heat crossover was tuned on
+	std::vector<float> MakeIntensity(int width, int height)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+		std::vector<float> intensity(static_cast<size_t>(width) * height, 0.0f);
+		for (float& value : intensity)
+			value = uniform(random) < 0.3f ? uniform(random) : 0.0f;
+		return intensity;
+	}
+
+	//! Smoke of a square emitter blown downwind for a few seconds, the volume SmokeVolumeRenderer marches
+	std::shared_ptr<Simulation::SmokeTransport> MakeSmokePlume(const glm::ivec3& extent)
+	{
+		auto smoke = std::make_shared<Simulation::SmokeTransport>();
+		if (!smoke->Initialize(extent.x, extent.y, extent.z, 10.0f))
+			return nullptr;
+		smoke->SetWind(glm::vec3(4.0f, 1.5f, 0.5f));
+		smoke->SetDiffusivity(5.0f);
+		std::vector<float> emission(static_cast<size_t>(extent.x) * extent.y, 0.0f);
+		for (int y = extent.y / 4; y < extent.y / 2; ++y)
+			for (int x = extent.x / 4; x < extent.x / 2; ++x)
+				emission[static_cast<size_t>(y) * extent.x + x] = 1.0f;
+		smoke->SetEmission(emission.data());
+		for (int step = 0; step < 20; ++step)
+			smoke->Step(1.0f);
+		return smoke;
+	}
+
+	//! Camera of the smoke renderer cases, the volume fills the default [-1, 1] bounds
+	const glm::mat4 SMOKE_VIEW = glm::lookAt(glm::vec3(0.5f, 1.0f, -3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const glm::mat4 SMOKE_PROJECTION = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+	constexpr int SMOKE_IMAGE_SIZE = 256;
+
+	//! Signed distance like field of a few overlapping spheres, positive inside
+	std::vector<float> MakeBlobField(const glm::ivec3& extent)
+	{
+		const glm::vec3 centers[3] = { glm::vec3(0.35f, 0.4f, 0.5f), glm::vec3(0.65f, 0.55f, 0.45f), glm::vec3(0.5f, 0.5f, 0.7f) };
+		std::vector<float> field(static_cast<size_t>(extent.x) * extent.y * extent.z);
+		size_t index = 0;
+		for (int z = 0; z < extent.z; ++z)
+		for (int y = 0; y < extent.y; ++y)
+		for (int x = 0; x < extent.x; ++x)
+		{
+			const glm::vec3 point = glm::vec3(x, y, z) / glm::vec3(extent - 1);
+			float value = 0.0f;
+			for (const glm::vec3& center : centers)
+				value += 0.02f / (glm::dot(point - center, point - center) + 1e-4f);
+			field[index++] = value;
+		}
+		return field;
+	}
+
+	//! Run the mosaic scenarios with the canopy layer and print its memory per km^2 and step cost next
+	//! to the surface engine
+	void ReportCrownFire(const std::string& filter, std::ostream& stream)
+	{
+		using Clock = std::chrono::steady_clock;
+		Benchmark::ReportTable table(stream, { { "Scenario", 28 }, { "Surface KB/km2", 16 }, { "Crown KB/km2", 14 }, { "Bricks", 10 },
+												{ "Surface ms/step", 17 }, { "Crown ms/step", 15 }, { "Ratio", 10 } });
+		for (const Simulation::Scenario& scenario : Simulation::ScenarioGenerator::GetStandardScenarios())
+		{
+			if (scenario.forestDensity > 0.0f || scenario.name.find(filter) == std::string::npos)
+				continue;
+
+			Simulation::Landscape landscape;
+			Simulation::Canopy canopy;
+			Simulation::FireSpread fire;
+			Simulation::CrownFire crownFire;
+			if (!Simulation::ScenarioGenerator::Generate(scenario, landscape))
+				continue;
+			Simulation::ScenarioGenerator::GenerateCanopy(landscape, scenario.seed, canopy);
+			if (!crownFire.Initialize(landscape, canopy) || !Simulation::ScenarioGenerator::Ignite(scenario, landscape, fire))
+				continue;
+
+			//! Time both layers of the coupled run separately, the crown layer also pays for torching.
+			Clock::duration surfaceTime(0), crownTime(0);
+			for (int step = 0; step < scenario.numSteps; ++step)
+			{
+				const Clock::time_point start = Clock::now();
+				fire.Step(scenario.dt);
+				const Clock::time_point middle = Clock::now();
+				crownFire.Step(fire, scenario.dt);
+				surfaceTime += middle - start;
+				crownTime += Clock::now() - middle;
+			}
+
+			const double squareKilometers = landscape.GetNumCells() * landscape.cellSize * landscape.cellSize * 1e-6;
+			const double surfaceMilliseconds = std::chrono::duration<double, std::milli>(surfaceTime).count() / scenario.numSteps;
+			const double crownMilliseconds = std::chrono::duration<double, std::milli>(crownTime).count() / scenario.numSteps;
+			table.AddRow({ scenario.name, Benchmark::ReportTable::Fixed(fire.GetMemoryBytes() / 1024.0 / squareKilometers, 1),
+						   Benchmark::ReportTable::Fixed(crownFire.GetMemoryBytes() / 1024.0 / squareKilometers, 1), std::to_string(crownFire.GetNumBricks()),
+						   Benchmark::ReportTable::Fixed(surfaceMilliseconds, 3), Benchmark::ReportTable::Fixed(crownMilliseconds, 3),
+						   Benchmark::ReportTable::Fixed(surfaceMilliseconds > 0.0 ? crownMilliseconds / surfaceMilliseconds : 0.0, 3) });
+		}
+	}
+
+	//! Run the tiled engine at full rate and with the focus on the map center, print the speedup and
+	//! the ignition delays the coarse tiles cause
+	void ReportMultiRate(const std::string& filter, std::ostream& stream)
+	{
+		using Clock = std::chrono::steady_clock;
+		Benchmark::ReportTable table(stream, { { "Scenario", 28 }, { "Full ms", 10 }, { "Focus ms", 10 }, { "Speedup", 9 }, { "Cell updates", 13 },
+												{ "Burned", 10 }, { "Missing", 9 }, { "Mean delay", 12 }, { "Max delay", 11 }, { "Earlier", 9 } });
+		for (const Simulation::Scenario& scenario : Simulation::ScenarioGenerator::GetStandardScenarios())
+		{
+			if (scenario.name.find(filter) == std::string::npos)
+				continue;
+
+			Simulation::Landscape landscape;
+			if (!Simulation::ScenarioGenerator::Generate(scenario, landscape))
+				continue;
+			Simulation::TiledFireSpread fires[2];
+			Clock::duration durations[2];
+			bool bIgnited = true;
+			for (int run = 0; run < 2; ++run)
+			{
+				bIgnited &= Simulation::ScenarioGenerator::Ignite(scenario, landscape, fires[run]);
+				if (run == 1)
+					fires[run].SetFocus(Simulation::ScenarioGenerator::GetFocusCenter(landscape), Simulation::ScenarioGenerator::GetFocusRadius(landscape));
+				const Clock::time_point start = Clock::now();
+				for (int step = 0; step < scenario.numSteps; ++step)
+					fires[run].Step(scenario.dt);
+				durations[run] = Clock::now() - start;
+			}
+			if (!bIgnited)
+				continue;
+
+			//! Ignition delays of the focus run against the full rate run, over the cells both ignited.
+			const std::vector<float>& fullTimes = fires[0].GetIgnitionTimes();
+			const std::vector<float>& focusTimes = fires[1].GetIgnitionTimes();
+			size_t numBurned = 0, numMissing = 0, numBoth = 0, numEarlier = 0;
+			double sumDelay = 0.0, maxDelay = 0.0;
+			for (size_t cell = 0; cell < fullTimes.size(); ++cell)
+			{
+				const bool bFull = std::isfinite(fullTimes[cell]), bFocus = std::isfinite(focusTimes[cell]);
+				numBurned += bFull;
+				numMissing += bFull && !bFocus;
+				if (!bFull || !bFocus)
+					continue;
+				const double delay = focusTimes[cell] - fullTimes[cell];
+				++numBoth;
+				sumDelay += delay;
+				maxDelay = std::max(maxDelay, delay);
+				numEarlier += delay < -1e-2;
+			}
+
+			const double fullMilliseconds = std::chrono::duration<double, std::milli>(durations[0]).count();
+			const double focusMilliseconds = std::chrono::duration<double, std::milli>(durations[1]).count();
+			table.AddRow({ scenario.name, Benchmark::ReportTable::Fixed(fullMilliseconds, 1), Benchmark::ReportTable::Fixed(focusMilliseconds, 1),
+						   Benchmark::ReportTable::Fixed(focusMilliseconds > 0.0 ? fullMilliseconds / focusMilliseconds : 0.0, 2),
+						   Benchmark::ReportTable::Fixed(static_cast<double>(fires[1].GetNumCellUpdates()) / std::max<uint64_t>(1, fires[0].GetNumCellUpdates()), 2),
+						   std::to_string(numBurned), std::to_string(numMissing), Benchmark::ReportTable::Fixed(numBoth ? sumDelay / numBoth : 0.0, 3),
+						   Benchmark::ReportTable::Fixed(maxDelay, 3), std::to_string(numEarlier) });
+		}
+	}
+
+	//! Run the landscape grid, the grid refined to the finest adaptive level and adaptive refinement,
+	//! print the timings, the peak cells and the burned area errors against the fine grid
+	void ReportAdaptive(const std::string& filter, std::ostream& stream)
+	{
+		using Clock = std::chrono::steady_clock;
+		const int factor = 1 << Simulation::AdaptiveFireSpread::MAX_LEVEL;
+		Benchmark::ReportTable table(stream, { { "Scenario", 28 }, { "Coarse ms", 11 }, { "Fine ms", 10 }, { "Adaptive ms", 13 }, { "Speedup", 9 },
+												{ "Peak cells", 12 }, { "Fine ha", 10 }, { "Coarse err %", 14 }, { "Adaptive err %", 16 } });
+		for (const Simulation::Scenario& scenario : Simulation::ScenarioGenerator::GetStandardScenarios())
+		{
+			if (scenario.name.find(filter) == std::string::npos)
+				continue;
+
+			Simulation::Landscape landscape, refined;
+			Simulation::FireSpread coarse, fine;
+			Simulation::AdaptiveFireSpread adaptive;
+			if (!Simulation::ScenarioGenerator::Generate(scenario, landscape) || !landscape.Refine(factor, refined) ||
+				!Simulation::ScenarioGenerator::Ignite(scenario, landscape, coarse) || !Simulation::ScenarioGenerator::Ignite(scenario, landscape, adaptive) ||
+				!IgniteRefined(refined, factor, adaptive, fine))
+				continue;
+
+			Clock::time_point start = Clock::now();
+			for (int step = 0; step < scenario.numSteps; ++step)
+				coarse.Step(scenario.dt);
+			const double coarseMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			start = Clock::now();
+			for (int step = 0; step < scenario.numSteps; ++step)
+				fine.Step(scenario.dt);
+			const double fineMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			size_t peakCells = 0;
+			Clock::duration adaptiveTime(0);
+			for (int step = 0; step < scenario.numSteps; ++step)
+			{
+				start = Clock::now();
+				adaptive.Step(scenario.dt);
+				adaptiveTime += Clock::now() - start;
+				peakCells = std::max(peakCells, adaptive.GetNumCells());
+			}
+			const double adaptiveMilliseconds = std::chrono::duration<double, std::milli>(adaptiveTime).count();
+
+			//! Burned area errors against the uniform fine grid, summed over the landscape cells.
+			std::vector<float> adaptiveFraction;
+			adaptive.GetBurnedFraction(adaptiveFraction);
+			const std::vector<float> fineFraction = GetBurnedFraction(fine, factor);
+			const std::vector<float> coarseFraction = GetBurnedFraction(coarse, 1);
+			double fineArea = 0.0, coarseError = 0.0, adaptiveError = 0.0;
+			for (size_t cell = 0; cell < fineFraction.size(); ++cell)
+			{
+				fineArea += fineFraction[cell];
+				coarseError += std::fabs(coarseFraction[cell] - fineFraction[cell]);
+				adaptiveError += std::fabs(adaptiveFraction[cell] - fineFraction[cell]);
+			}
+
+			const double cellArea = landscape.cellSize * landscape.cellSize;
+			table.AddRow({ scenario.name, Benchmark::ReportTable::Fixed(coarseMilliseconds, 1), Benchmark::ReportTable::Fixed(fineMilliseconds, 1),
+						   Benchmark::ReportTable::Fixed(adaptiveMilliseconds, 1),
+						   Benchmark::ReportTable::Fixed(adaptiveMilliseconds > 0.0 ? fineMilliseconds / adaptiveMilliseconds : 0.0, 2),
+						   Benchmark::ReportTable::Fixed(static_cast<double>(peakCells) / refined.GetNumCells(), 2),
+						   Benchmark::ReportTable::Fixed(fineArea * cellArea * 1e-4, 1),
+						   Benchmark::ReportTable::Fixed(fineArea > 0.0 ? 100.0 * coarseError / fineArea : 0.0, 2),
+						   Benchmark::ReportTable::Fixed(fineArea > 0.0 ? 100.0 * adaptiveError / fineArea : 0.0, 2) });
+		}
+	}
+
+	//! Run FireSpread in fixed steps, in steps 16 times shorter and in stable steps, then AdaptiveFireSpread
+	//! in fixed steps, in steps 4 and 16 times shorter and subcycled per tile, print the timings, the
+	//! substeps and the burned area errors against the 16 times shorter steps
+	void ReportSubstepping(const std::string& filter, std::ostream& stream)
+	{
+		using Clock = std::chrono::steady_clock;
+		const int numReferenceSubsteps = 16;
+		//! Fixed steps, the reference in steps 16 times shorter, then the stable steps of a few Courant
+		//! numbers with the fire handed a minute at a time, so the stable step both splits and lengthens.
+		const float courantNumbers[] = { 0.0f, 0.0f, 1.0f, 0.5f, 0.25f };
+		const int numRuns = 5;
+		Benchmark::ReportTable table(stream, { { "Scenario", 28 }, { "Steps", 12 }, { "ms", 10 }, { "Substeps", 10 }, { "Err %", 9 } });
+		for (const Simulation::Scenario& scenario : Simulation::ScenarioGenerator::GetStandardScenarios())
+		{
+			if (scenario.name.find(filter) == std::string::npos)
+				continue;
+
+			Simulation::Landscape landscape;
+			if (!Simulation::ScenarioGenerator::Generate(scenario, landscape))
+				continue;
+			const float duration = scenario.numSteps * scenario.dt;
+			Simulation::FireSpread fires[numRuns];
+			double milliseconds[numRuns];
+			std::vector<float> fractions[numRuns];
+			bool bIgnited = true;
+			for (int run = 0; run < numRuns; ++run)
+			{
+				bIgnited &= Simulation::ScenarioGenerator::Ignite(scenario, landscape, fires[run]);
+				fires[run].SetCourantNumber(courantNumbers[run]);
+				const int numSteps = run == 0 ? scenario.numSteps : (run == 1 ? scenario.numSteps * numReferenceSubsteps : static_cast<int>(std::ceil(duration / 60.0f)));
+				const float dt = run == 0 ? scenario.dt : (run == 1 ? scenario.dt / numReferenceSubsteps : 60.0f);
+				const Clock::time_point start = Clock::now();
+				for (int step = 0; step < numSteps; ++step)
+					fires[run].Step(std::min(dt, duration - step * dt));
+				milliseconds[run] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+				fractions[run] = GetBurnedFraction(fires[run], 1);
+			}
+			if (!bIgnited)
+				continue;
+
+			//! Burned area errors against the reference, summed over the landscape cells.
+			double referenceArea = 0.0;
+			for (float fraction : fractions[1])
+				referenceArea += fraction;
+			for (int run = 0; run < numRuns; ++run)
+			{
+				double error = 0.0;
+				for (size_t cell = 0; cell < fractions[1].size(); ++cell)
+					error += std::fabs(fractions[run][cell] - fractions[1][cell]);
+				const std::string steps = run == 0 ? "fixed" : (run == 1 ? "reference" : "courant " + std::to_string(courantNumbers[run]).substr(0, 4));
+				table.AddRow({ run == 0 ? scenario.name : std::string(), steps, Benchmark::ReportTable::Fixed(milliseconds[run], 1),
+							   std::to_string(fires[run].GetNumSubsteps()), Benchmark::ReportTable::Fixed(referenceArea > 0.0 ? 100.0 * error / referenceArea : 0.0, 2) });
+			}
+		}
+
+		//! The adaptive engine in fixed steps, in steps 4 and 16 times shorter everywhere and with the
+		//! substeps per tile, whose cost lies between the first two.
+		stream << std::endl;
+		const int adaptiveSubsteps[] = { 1, 4, numReferenceSubsteps, 1 };
+		const int numAdaptiveRuns = 4;
+		Benchmark::ReportTable adaptiveTable(stream, { { "Scenario", 28 }, { "Adaptive steps", 16 }, { "ms", 10 }, { "Tile steps", 12 }, { "Tile substeps", 15 },
+													   { "Min s", 9 }, { "Mean s", 9 }, { "Max s", 9 }, { "Err %", 9 } });
+		for (const Simulation::Scenario& scenario : Simulation::ScenarioGenerator::GetStandardScenarios())
+		{
+			if (scenario.name.find(filter) == std::string::npos)
+				continue;
+
+			Simulation::Landscape landscape;
+			if (!Simulation::ScenarioGenerator::Generate(scenario, landscape))
+				continue;
+			Simulation::AdaptiveFireSpread fires[numAdaptiveRuns];
+			double milliseconds[numAdaptiveRuns];
+			std::vector<float> fractions[numAdaptiveRuns];
+			bool bIgnited = true;
+			for (int run = 0; run < numAdaptiveRuns; ++run)
+			{
+				bIgnited &= Simulation::ScenarioGenerator::Ignite(scenario, landscape, fires[run]);
+				fires[run].SetSubcycling(run == numAdaptiveRuns - 1);
+				const float dt = scenario.dt / adaptiveSubsteps[run];
+				const Clock::time_point start = Clock::now();
+				for (int step = 0; step < scenario.numSteps * adaptiveSubsteps[run]; ++step)
+					fires[run].Step(dt);
+				milliseconds[run] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+				fires[run].GetBurnedFraction(fractions[run]);
+			}
+			if (!bIgnited)
+				continue;
+
+			double referenceArea = 0.0;
+			for (float fraction : fractions[2])
+				referenceArea += fraction;
+			for (int run = 0; run < numAdaptiveRuns; ++run)
+			{
+				double error = 0.0;
+				for (size_t cell = 0; cell < fractions[2].size(); ++cell)
+					error += std::fabs(fractions[run][cell] - fractions[2][cell]);
+				const Simulation::AdaptiveFireSpread::StepStatistics& statistics = fires[run].GetStepStatistics();
+				const std::string steps = run == numAdaptiveRuns - 1 ? "subcycled" : (run == 0 ? "fixed" : "dt / " + std::to_string(adaptiveSubsteps[run]));
+				adaptiveTable.AddRow({ run == 0 ? scenario.name : std::string(), steps, Benchmark::ReportTable::Fixed(milliseconds[run], 1),
+									   std::to_string(statistics.numTileSteps), std::to_string(statistics.numTileSubsteps),
+									   Benchmark::ReportTable::Fixed(statistics.minSubstep, 3),
+									   Benchmark::ReportTable::Fixed(statistics.numTileSubsteps ? statistics.sumSubsteps / statistics.numTileSubsteps : 0.0, 3),
+									   Benchmark::ReportTable::Fixed(statistics.maxSubstep, 3),
+									   Benchmark::ReportTable::Fixed(referenceArea > 0.0 ? 100.0 * error / referenceArea : 0.0, 2) });
+			}
+		}
+	}
+
+	//! Stream six hours of station weather with cached slices and with the stations blended at every
+	//! update, print the timings, the window and slice counts and the largest wind difference
+	void ReportWeather(const std::string& filter, std::ostream& stream)
+	{
+		using Clock = std::chrono::steady_clock;
+		Benchmark::ReportTable table(stream, { { "Input", 16 }, { "Updates", 10 }, { "Windows", 10 }, { "Slices", 10 }, { "Searches", 11 },
+												{ "Cached ms", 11 }, { "Uncached ms", 13 }, { "Speedup", 10 }, { "Max diff", 12 } });
+		for (int size : { 256, 1024 })
+		{
+			for (bool bBinary : { false, true })
+			{
+				const std::string name = std::to_string(size) + (bBinary ? "/binary" : "/csv");
+				if (name.find(filter) == std::string::npos)
+					continue;
+
+				//! Six hours in minute steps, with the cached slices and with the stations evaluated and
+				//! blended at every update.
+				const std::string path = MakeWeatherFile(size, bBinary);
+				Simulation::WeatherInput weathers[2];
+				double milliseconds[2] = { 0.0, 0.0 }, maxDifference = 0.0;
+				uint64_t numWindows = 0;
+				bool bValid = !path.empty();
+				for (int run = 0; run < 2 && bValid; ++run)
+					bValid = weathers[run].Initialize(size, size, 10.0f) && weathers[run].Open(path);
+				if (!bValid)
+					continue;
+				weathers[1].SetCaching(false);
+				const int numUpdates = 360;
+				for (int update = 0; update < numUpdates; ++update)
+				{
+					const double windowBegin = weathers[0].GetWindowBegin();
+					for (int run = 0; run < 2; ++run)
+					{
+						const Clock::time_point start = Clock::now();
+						weathers[run].Update(update * 60.0);
+						milliseconds[run] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+					}
+					numWindows += update == 0 || weathers[0].GetWindowBegin() != windowBegin;
+					for (size_t cell = 0; cell < weathers[0].GetWind().size(); ++cell)
+						maxDifference = std::max<double>(maxDifference, glm::length(weathers[0].GetWind()[cell] - weathers[1].GetWind()[cell]));
+				}
+
+				table.AddRow({ name, std::to_string(numUpdates), std::to_string(numWindows), std::to_string(weathers[0].GetNumSliceUpdates()),
+							   std::to_string(weathers[0].GetNumWeightUpdates()), Benchmark::ReportTable::Fixed(milliseconds[0], 1),
+							   Benchmark::ReportTable::Fixed(milliseconds[1], 1), Benchmark::ReportTable::Fixed(milliseconds[1] / std::max(1e-6, milliseconds[0]), 2),
+							   Benchmark::ReportTable::Scientific(maxDifference, 2) });
+			}
+		}
+	}
+
+	//! Ray march the smoke plume on the CPU with and without the empty brick skip, print the occupied
+	//! bricks, the density samples per pixel and the render time
+	void ReportSmoke(const std::string& filter, std::ostream& stream)
+	{
+		using Clock = std::chrono::steady_clock;
+		Benchmark::ReportTable table(stream, { { "Volume", 16 }, { "Mode", 8 }, { "Occupied %", 12 }, { "Samples/px", 12 }, { "ms", 10 } });
+		for (const glm::ivec3& extent : { glm::ivec3(64, 64, 64), glm::ivec3(128, 128, 64) })
+		{
+			const std::string name = FormatExtent(extent);
+			if (name.find(filter) == std::string::npos)
+				continue;
+			auto smoke = MakeSmokePlume(extent);
+			if (!smoke)
+				continue;
+
+			//! A negative threshold marks every brick occupied, so the rays sample the whole volume.
+			for (const bool bSkip : { true, false })
+			{
+				GL3::SmokeVolumeRenderer renderer;
+				renderer.SetDensityScale(1.0f, bSkip ? 1e-4f : -1.0f);
+				renderer.UpdateVolume(smoke->GetConcentration().data(), extent);
+				std::vector<unsigned char> pixels;
+				const int numRenders = 5;
+				const Clock::time_point start = Clock::now();
+				for (int render = 0; render < numRenders; ++render)
+					renderer.RenderCPU(SMOKE_VIEW, SMOKE_PROJECTION, SMOKE_IMAGE_SIZE, SMOKE_IMAGE_SIZE, pixels);
+				const double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / numRenders;
+
+				table.AddRow({ name, bSkip ? "skip" : "all", Benchmark::ReportTable::Fixed(renderer.GetOccupiedBrickRatio() * 100.0, 1),
+							   Benchmark::ReportTable::Fixed(renderer.GetSamplesPerPixel(), 1), Benchmark::ReportTable::Fixed(milliseconds, 2) });
+			}
+		}
+	}
+
+	//! Reports of RunReport() by name
+	struct Report
+	{
+		const char* name;
+		const char* description;
+		void (*run)(const std::string& filter, std::ostream& stream);
+	};
+
+	const Report REPORTS[] = {
+		{ "crown", "Canopy layer memory and step cost against the surface engine", ReportCrownFire },
+		{ "multirate", "Speedup and ignition delays of multi-rate tiles against full rate stepping", ReportMultiRate },
+		{ "amr", "Cost and burned area error of adaptive refinement against uniform coarse and fine grids", ReportAdaptive },
+		{ "substep", "Cost, substeps and burned area error of stable steps and per tile subcycling against fixed steps", ReportSubstepping },
+		{ "weather", "Cost of cached weather slices against blending the stations at every update", ReportWeather },
+		{ "smoke", "Occupied bricks, samples per pixel and cost of the smoke ray marcher with and without brick skipping", ReportSmoke },
+	};
+};
+
+namespace Benchmark {
+
+	void RegisterSimulationBenchmarks(Harness& harness)
+	{
+		for (const glm::ivec3& extent : { glm::ivec3(32, 32, 32), glm::ivec3(64, 64, 64), glm::ivec3(128, 128, 64) })
+		{
+			harness.Add("SmokeTransport::Step/" + FormatExtent(extent), [extent](uint64_t& numItems) -> Harness::Body
+			{
+				auto smoke = std::make_shared<Simulation::SmokeTransport>();
+				if (!smoke->Initialize(extent.x, extent.y, extent.z, 10.0f))
+					return nullptr;
+				smoke->SetWind(glm::vec3(4.0f, 1.5f, 0.5f));
+				smoke->SetDiffusivity(5.0f);
+				std::vector<float> emission(static_cast<size_t>(extent.x) * extent.y, 0.0f);
+				for (int y = extent.y / 4; y < extent.y / 2; ++y)
+					for (int x = extent.x / 4; x < extent.x / 2; ++x)
+						emission[static_cast<size_t>(y) * extent.x + x] = 1.0f;
+				smoke->SetEmission(emission.data());
+				numItems = static_cast<uint64_t>(extent.x) * extent.y * extent.z;
+				return [smoke]() { smoke->Step(1.0f); };
+			});
+		}
+
+		//! The items are the density samples of one render, so the throughput is samples per second.
+		for (const glm::ivec3& extent : { glm::ivec3(64, 64, 64), glm::ivec3(128, 128, 64) })
+		{
+			harness.Add("SmokeVolumeRenderer::RenderCPU/" + FormatExtent(extent), [extent](uint64_t& numItems) -> Harness::Body
+			{
+				auto smoke = MakeSmokePlume(extent);
+				if (!smoke)
+					return nullptr;
+				auto renderer = std::make_shared<GL3::SmokeVolumeRenderer>();
+				renderer->UpdateVolume(smoke->GetConcentration().data(), extent);
+				auto pixels = std::make_shared< std::vector<unsigned char> >();
+				renderer->RenderCPU(SMOKE_VIEW, SMOKE_PROJECTION, SMOKE_IMAGE_SIZE, SMOKE_IMAGE_SIZE, *pixels);
+				numItems = static_cast<uint64_t>(renderer->GetSamplesPerPixel() * SMOKE_IMAGE_SIZE * SMOKE_IMAGE_SIZE);
+				return [renderer, pixels]() { renderer->RenderCPU(SMOKE_VIEW, SMOKE_PROJECTION, SMOKE_IMAGE_SIZE, SMOKE_IMAGE_SIZE, *pixels); };
+			});
+		}
+
+		for (int size : { 256, 512, 1024 })
+		{
+			for (int radius : { 3, 8 })
+			{
+				harness.Add("RadiantHeat::Apply/" + std::to_string(size) + "/R" + std::to_string(radius), [size, radius](uint64_t& numItems) -> Harness::Body
+				{
+					auto radiantHeat = std::make_shared<Simulation::RadiantHeat>();
+					if (!radiantHeat->Initialize(size, size, radius, Simulation::RadiantHeat::InverseSquareProfile(2.0f)))
+						return nullptr;
+					auto intensity = std::make_shared< std::vector<float> >(MakeIntensity(size, size));
+					auto heat = std::make_shared< std::vector<float> >(intensity->size());
+					numItems = intensity->size();
+					return [radiantHeat, intensity, heat]() { radiantHeat->Apply(intensity->data(), heat->data()); };
+				});
+			}
+		}
+
+		//! Both paths on the same field per radius, FFT_CROSSOVER_RADIUS is the first radius where FFT wins.
+		for (int radius : { 3, 4, 5, 6, 8, 16, 32 })
+		{
+			for (const bool bFFT : { false, true })
+			{
+				harness.Add(std::string(bFFT ? "RadiantHeat::ApplyFFT" : "RadiantHeat::ApplyDirect") + "/512/R" + std::to_string(radius), [radius, bFFT](uint64_t& numItems) -> Harness::Body
+				{
+					constexpr int size = 512;
+					auto radiantHeat = std::make_shared<Simulation::RadiantHeat>();
+					if (!radiantHeat->Initialize(size, size, radius, Simulation::RadiantHeat::InverseSquareProfile(2.0f)))
+						return nullptr;
+					auto intensity = std::make_shared< std::vector<float> >(MakeIntensity(size, size));
+					auto heat = std::make_shared< std::vector<float> >(intensity->size());
+					numItems = intensity->size();
+					if (bFFT)
+						return [radiantHeat, intensity, heat]() { radiantHeat->ApplyFFT(intensity->data(), heat->data()); };
+					return [radiantHeat, intensity, heat]() { radiantHeat->ApplyDirect(intensity->data(), heat->data()); };
+				});
+			}
+		}
+
+		for (const Simulation::Scenario& scenario : Simulation::ScenarioGenerator::GetStandardScenarios())
+		{
+			harness.Add("ScenarioGenerator::Generate/" + scenario.name, [scenario](uint64_t& numItems) -> Harness::Body
+			{
+				numItems = static_cast<uint64_t>(scenario.size) * scenario.size;
+				auto landscape = std::make_shared<Simulation::Landscape>();
+				return [scenario, landscape]() { Simulation::ScenarioGenerator::Generate(scenario, *landscape); };
+			});
+
+			//! A repetition runs the whole scenario, the items are the cells times the steps.
+			harness.Add("FireSpread::Run/" + scenario.name, [scenario](uint64_t& numItems) -> Harness::Body
+			{
+				auto landscape = std::make_shared<Simulation::Landscape>();
+				if (!Simulation::ScenarioGenerator::Generate(scenario, *landscape))
+					return nullptr;
+				numItems = landscape->GetNumCells() * scenario.numSteps;
+				auto fire = std::make_shared<Simulation::FireSpread>();
+				return [scenario, landscape, fire]()
+				{
+					Simulation::ScenarioGenerator::Ignite(scenario, *landscape, *fire);
+					for (int step = 0; step < scenario.numSteps; ++step)
+						fire->Step(scenario.dt);
+				};
+			});
+
+			//! The same run with the station weather of every minute, the moisture scales the spread rates.
+			harness.Add("FireSpread::RunWeather/" + scenario.name, [scenario](uint64_t& numItems) -> Harness::Body
+			{
+				auto landscape = std::make_shared<Simulation::Landscape>();
+				if (!Simulation::ScenarioGenerator::Generate(scenario, *landscape) || landscape->width != landscape->height)
+					return nullptr;
+				const std::string path = MakeWeatherFile(landscape->width, true);
+				auto weather = std::make_shared<Simulation::WeatherInput>();
+				if (path.empty() || !weather->Initialize(landscape->width, landscape->height, landscape->cellSize))
+					return nullptr;
+				numItems = landscape->GetNumCells() * scenario.numSteps;
+				auto fire = std::make_shared<Simulation::FireSpread>();
+				return [scenario, landscape, path, weather, fire]()
+				{
+					Simulation::ScenarioGenerator::Ignite(scenario, *landscape, *fire);
+					weather->Open(path);
+					double minute = 0.0;
+					for (int step = 0; step < scenario.numSteps; ++step)
+					{
+						if (step * scenario.dt >= minute)
+						{
+							weather->Update(minute);
+							fire->SetWeather(*weather);
+							minute += 60.0;
+						}
+						fire->Step(scenario.dt);
+					}
+				};
+			});
+
+			//! The tiled engine at full rate and with the focus on the ignition, see ReportMultiRate().
+			for (bool bFocus : { false, true })
+			{
+				harness.Add("TiledFireSpread::Run/" + scenario.name + (bFocus ? "/focus" : "/full"), [scenario, bFocus](uint64_t& numItems) -> Harness::Body
+				{
+					auto landscape = std::make_shared<Simulation::Landscape>();
+					if (!Simulation::ScenarioGenerator::Generate(scenario, *landscape))
+						return nullptr;
+					numItems = landscape->GetNumCells() * scenario.numSteps;
+					auto fire = std::make_shared<Simulation::TiledFireSpread>();
+					return [scenario, landscape, fire, bFocus]()
+					{
+						Simulation::ScenarioGenerator::Ignite(scenario, *landscape, *fire);
+						if (bFocus)
+							fire->SetFocus(Simulation::ScenarioGenerator::GetFocusCenter(*landscape), Simulation::ScenarioGenerator::GetFocusRadius(*landscape));
+						for (int step = 0; step < scenario.numSteps; ++step)
+							fire->Step(scenario.dt);
+					};
+				});
+			}
+
+			//! Adaptive refinement around the front against the uniform grid it refines to, see ReportAdaptive().
+			harness.Add("AdaptiveFireSpread::Run/" + scenario.name, [scenario](uint64_t& numItems) -> Harness::Body
+			{
+				auto landscape = std::make_shared<Simulation::Landscape>();
+				if (!Simulation::ScenarioGenerator::Generate(scenario, *landscape))
+					return nullptr;
+				numItems = landscape->GetNumCells() * scenario.numSteps;
+				auto fire = std::make_shared<Simulation::AdaptiveFireSpread>();
+				return [scenario, landscape, fire]()
+				{
+					Simulation::ScenarioGenerator::Ignite(scenario, *landscape, *fire);
+					for (int step = 0; step < scenario.numSteps; ++step)
+						fire->Step(scenario.dt);
+				};
+			});
+			harness.Add("FireSpread::RunRefined/" + scenario.name, [scenario](uint64_t& numItems) -> Harness::Body
+			{
+				const int factor = 1 << Simulation::AdaptiveFireSpread::MAX_LEVEL;
+				Simulation::Landscape landscape;
+				Simulation::AdaptiveFireSpread adaptive;
+				auto refined = std::make_shared<Simulation::Landscape>();
+				auto fire = std::make_shared<Simulation::FireSpread>();
+				if (!Simulation::ScenarioGenerator::Generate(scenario, landscape) || !landscape.Refine(factor, *refined) ||
+					!Simulation::ScenarioGenerator::Ignite(scenario, landscape, adaptive) || !IgniteRefined(*refined, factor, adaptive, *fire))
+					return nullptr;
+				numItems = landscape.GetNumCells() * scenario.numSteps;
+				auto ignited = std::make_shared<Simulation::FireSpread>(*fire);
+				return [scenario, ignited, fire]()
+				{
+					*fire = *ignited;
+					for (int step = 0; step < scenario.numSteps; ++step)
+						fire->Step(scenario.dt);
+				};
+			});
+
+			//! The same run with the canopy layer on top, only the scenarios with timber stands.
+			if (scenario.forestDensity > 0.0f)
+				continue;
+			harness.Add("CrownFire::Run/" + scenario.name, [scenario](uint64_t& numItems) -> Harness::Body
+			{
+				auto landscape = std::make_shared<Simulation::Landscape>();
+				Simulation::Canopy canopy;
+				if (!Simulation::ScenarioGenerator::Generate(scenario, *landscape))
+					return nullptr;
+				Simulation::ScenarioGenerator::GenerateCanopy(*landscape, scenario.seed, canopy);
+				auto crownFire = std::make_shared<Simulation::CrownFire>();
+				if (!crownFire->Initialize(*landscape, canopy))
+					return nullptr;
+				numItems = landscape->GetNumCells() * scenario.numSteps;
+				auto fire = std::make_shared<Simulation::FireSpread>();
+				return [scenario, landscape, crownFire, fire]()
+				{
+					Simulation::CrownFire runCrownFire = *crownFire;
+					Simulation::ScenarioGenerator::Ignite(scenario, *landscape, *fire);
+					for (int step = 0; step < scenario.numSteps; ++step)
+					{
+						fire->Step(scenario.dt);
+						runCrownFire.Step(*fire, scenario.dt);
+					}
+				};
+			});
+		}
+
+		for (size_t numPoints : { 10000, 1000000 })
+		{
+			harness.Add("SpatialHash::Build/" + std::to_string(numPoints), [numPoints](uint64_t& numItems) -> Harness::Body
+			{
+				std::mt19937 random(5);
+				std::uniform_real_distribution<float> uniform(0.0f, 10240.0f);
+				auto x = std::make_shared< std::vector<float> >(numPoints), y = std::make_shared< std::vector<float> >(numPoints);
+				for (size_t point = 0; point < numPoints; ++point)
+				{
+					(*x)[point] = uniform(random);
+					(*y)[point] = uniform(random);
+				}
+				auto hash = std::make_shared<Simulation::SpatialHash>();
+				if (!hash->Initialize(glm::vec2(0.0f), glm::vec2(10240.0f), 80.0f))
+					return nullptr;
+				numItems = numPoints;
+				return [hash, x, y, numPoints]() { hash->Build(x->data(), y->data(), numPoints); };
+			});
+		}
+
+		//! Crews walking up to 1 km across the rough terrain of the mosaic scenario.
+		const Simulation::Scenario& terrainScenario = Simulation::ScenarioGenerator::GetStandardScenarios()[5];
+		harness.Add("PathFinder::FindPaths/" + terrainScenario.name + "/256", [terrainScenario](uint64_t& numItems) -> Harness::Body
+		{
+			Simulation::Landscape landscape;
+			auto pathFinder = std::make_shared<Simulation::PathFinder>();
+			if (!Simulation::ScenarioGenerator::Generate(terrainScenario, landscape) || !pathFinder->Initialize(landscape))
+				return nullptr;
+			std::mt19937 random(9);
+			std::uniform_int_distribution<int> position(100, landscape.width - 101), offset(-100, 100);
+			auto queries = std::make_shared< std::vector<Simulation::PathQuery> >();
+			for (int query = 0; query < 256; ++query)
+			{
+				const int x = position(random), y = position(random);
+				queries->push_back({ static_cast<uint32_t>(y * landscape.width + x),
+									 static_cast<uint32_t>((y + offset(random)) * landscape.width + x + offset(random)) });
+			}
+			auto paths = std::make_shared< std::vector<Simulation::Path> >();
+			numItems = queries->size();
+			return [pathFinder, queries, paths]() { pathFinder->FindPaths(*queries, *paths); };
+		});
+
+		//! A repetition suppresses a young fire for 5 minutes with agents staged within 1 km of the
+		//! ignition, the items are the agents times the steps.
+		for (int numAgents : { 500, 2000 })
+		{
+			const Simulation::Scenario& scenario = Simulation::ScenarioGenerator::GetStandardScenarios()[5];
+			harness.Add("SuppressionAgents::Run/" + scenario.name + "/" + std::to_string(numAgents), [scenario, numAgents](uint64_t& numItems) -> Harness::Body
+			{
+				auto landscape = std::make_shared<Simulation::Landscape>();
+				auto fire = std::make_shared<Simulation::FireSpread>();
+				if (!Simulation::ScenarioGenerator::Generate(scenario, *landscape) || !Simulation::ScenarioGenerator::Ignite(scenario, *landscape, *fire))
+					return nullptr;
+				for (int step = 0; step < 600; ++step)
+					fire->Step(scenario.dt);
+				auto agents = std::make_shared<Simulation::SuppressionAgents>();
+				if (!agents->Initialize(*landscape))
+					return nullptr;
+				std::mt19937 random(17);
+				std::uniform_real_distribution<float> offset(-1000.0f, 1000.0f);
+				const glm::vec2 center = glm::vec2(landscape->width, landscape->height) * (0.5f * landscape->cellSize);
+				for (int agent = 0; agent < numAgents; ++agent)
+				{
+					const Simulation::AgentType type = agent % 20 == 0 ? Simulation::Aircraft : (agent % 4 == 0 ? Simulation::Engine : Simulation::HandCrew);
+					agents->Add(type, center + glm::vec2(offset(random), offset(random)));
+				}
+				numItems = static_cast<uint64_t>(numAgents) * 300;
+				return [scenario, fire, agents]()
+				{
+					Simulation::FireSpread runFire = *fire;
+					Simulation::SuppressionAgents runAgents = *agents;
+					for (int step = 0; step < 300; ++step)
+					{
+						runAgents.Step(runFire, scenario.dt);
+						runFire.Step(scenario.dt);
+					}
+				};
+			});
+		}
+
+		//! Six hours of weather at the 10 s steps of the percolation scenarios, streamed from the file.
+		for (int size : { 256, 1024 })
+		{
+			for (bool bBinary : { false, true })
+			{
+				harness.Add("WeatherInput::Run/" + std::to_string(size) + (bBinary ? "/binary" : "/csv"), [size, bBinary](uint64_t& numItems) -> Harness::Body
+				{
+					const std::string path = MakeWeatherFile(size, bBinary);
+					auto weather = std::make_shared<Simulation::WeatherInput>();
+					if (path.empty() || !weather->Initialize(size, size, 10.0f))
+						return nullptr;
+					numItems = static_cast<uint64_t>(size) * size * 2160;
+					return [weather, path]()
+					{
+						weather->Open(path);
+						for (int step = 0; step < 2160; ++step)
+							weather->Update(step * 10.0);
+					};
+				});
+			}
+		}
+
+		for (int size : { 32, 64, 128 })
+		{
+			const glm::ivec3 extent(size);
+			harness.Add("IsoSurfaceExtractor::Extract/" + FormatExtent(extent), [extent](uint64_t& numItems) -> Harness::Body
+			{
+				auto extractor = std::make_shared<GL3::IsoSurfaceExtractor>();
+				if (!extractor->Initialize(extent, glm::vec3(0.0f), glm::vec3(1.0f / (extent.x - 1))))
+					return nullptr;
+				auto field = std::make_shared< std::vector<float> >(MakeBlobField(extent));
+				numItems = field->size();
+				//! Alternating iso values force the full extraction instead of the unchanged early out.
+				auto isoValue = std::make_shared<float>(1.0f);
+				return [extractor, field, isoValue]()
+				{
+					*isoValue = *isoValue == 1.0f ? 1.05f : 1.0f;
+					extractor->Extract(field->data(), *isoValue);
+				};
+			});
+		}
+	}
+
+	void ListReports(std::ostream& stream)
+	{
+		for (const Report& report : REPORTS)
+			stream << std::left << std::setw(12) << report.name << report.description << std::endl;
+		stream << std::right;
+	}
+
+	bool RunReport(const std::string& name, const std::string& filter, std::ostream& stream)
+	{
+		for (const Report& report : REPORTS)
+		{
+			if (name == report.name)
+			{
+				report.run(filter, stream);
+				return true;
+			}
+		}
+
+		std::cerr << "Unknown report " << name << ", the reports are:" << std::endl;
+		ListReports(std::cerr);
+		return false;
+	}
+};
@@ -0,0 +1,124 @@
+#include "Baseline.hpp"
+#include "Harness.hpp"
+#include <GL3/JobSystem.hpp>
+#include <GL3/Profiler.hpp>
+#include <Simulation/ScenarioGenerator.hpp>
+#include <cxxopts/cxxopts.hpp>
+#include <filesystem>
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+	cxxopts::Options options("gl3-bench", "Headless benchmarks of the GL3 and simulation CPU hot paths");
+
+	options.add_options()
+		("f,filter", "Only run the benchmarks whose name contains the filter", cxxopts::value<std::string>()->default_value(""))
+		("warmup", "Untimed repetitions before the measurement(default is 2)", cxxopts::value<size_t>()->default_value("2"))
+		("r,repetitions", "Timed repetitions per benchmark(default is 10)", cxxopts::value<size_t>()->default_value("10"))
+		("json", "Write the results with every sample into the given JSON file", cxxopts::value<std::string>())
+		("perf-counters", "Print and store the profile scopes of every benchmark with cycles, instructions, cache and branch misses (Linux perf_event_open)", cxxopts::value<bool>()->default_value("false"))
+		("resources", "Resources directory holding the objects", cxxopts::value<std::string>()->default_value(RESOURCES_DIR))
+		("baseline-dir", "Directory of the baselines, one file per machine fingerprint", cxxopts::value<std::string>()->default_value(BASELINES_DIR))
+		("baseline", "Baseline file to use instead of the one of this machine", cxxopts::value<std::string>())
+		("save-baseline", "Store the results as the baseline of this machine", cxxopts::value<bool>()->default_value("false"))
+		("compare", "Compare against the baseline and fail on significant regressions", cxxopts::value<bool>()->default_value("false"))
+		("threshold", "Slowdown in percent the confidence interval has to exceed(default is 5)", cxxopts::value<double>()->default_value("5"))
+		("resamples", "Bootstrap resamples of the comparison(default is 2000)", cxxopts::value<size_t>()->default_value("2000"))
+		("verify", "Run the standard fire scenarios matching the filter on every engine and check their digests and burned areas", cxxopts::value<bool>()->default_value("false"))
+		("report", "Run the named report on the scenarios matching the filter, see --list-reports", cxxopts::value<std::string>())
+		("list-reports", "Print the report names and exit", cxxopts::value<bool>()->default_value("false"))
+		("list", "Print the benchmark names and exit", cxxopts::value<bool>()->default_value("false"))
+		("help", "Print the options");
+
+	auto result = options.parse(argc, argv);
+
+	if (result.count("help"))
+	{
+		std::cout << options.help() << std::endl;
+		return EXIT_SUCCESS;
+	}
+
+	const std::string resourcesDir = result["resources"].as<std::string>();
+	Benchmark::Harness harness;
+	Benchmark::RegisterMeshBenchmarks(harness, resourcesDir);
+	Benchmark::RegisterCullingBenchmarks(harness, resourcesDir);
+	Benchmark::RegisterSimulationBenchmarks(harness);
+	Benchmark::RegisterSceneBenchmarks(harness);
+
+	if (result["list"].as<bool>())
+	{
+		harness.List(std::cout);
+		return EXIT_SUCCESS;
+	}
+
+	if (result["verify"].as<bool>())
+	{
+		bool bVerified = true;
+		const std::string filter = result["filter"].as<std::string>();
+		for (const Simulation::Scenario& scenario : Simulation::ScenarioGenerator::GetStandardScenarios())
+			if (scenario.name.find(filter) != std::string::npos)
+				bVerified &= Simulation::ScenarioGenerator::Verify(scenario, std::cout);
+		return bVerified ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (result["list-reports"].as<bool>())
+	{
+		Benchmark::ListReports(std::cout);
+		return EXIT_SUCCESS;
+	}
+
+	if (result.count("report"))
+		return Benchmark::RunReport(result["report"].as<std::string>(), result["filter"].as<std::string>(), std::cout) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+	Benchmark::Options benchmarkOptions;
+	benchmarkOptions.numWarmups = result["warmup"].as<size_t>();
+	benchmarkOptions.numRepetitions = std::max<size_t>(1, result["repetitions"].as<size_t>());
+	benchmarkOptions.filter = result["filter"].as<std::string>();
+	benchmarkOptions.bPerfCounters = result["perf-counters"].as<bool>();
+
+	//! The workers register with the profiler on start, so the job system comes up before the counters open.
+	if (benchmarkOptions.bPerfCounters)
+	{
+		GL3::JobSystem::GetInstance();
+		GL3::Profiler::GetInstance().EnableHardwareCounters();
+	}
+
+	const Benchmark::Fingerprint fingerprint = Benchmark::Fingerprint::Detect();
+	const std::string baselinePath = result.count("baseline") ? result["baseline"].as<std::string>()
+		: result["baseline-dir"].as<std::string>() + "/" + fingerprint.GetKey() + ".json";
+
+	//! Load the baseline up front so a missing one fails before the whole run
+	Benchmark::Baseline baseline;
+	if (result["compare"].as<bool>())
+	{
+		if (!baseline.Load(baselinePath))
+			return EXIT_FAILURE;
+		if (!(baseline.fingerprint == fingerprint))
+			std::cerr << "Warning: " << baselinePath << " was recorded on " << baseline.fingerprint.GetKey()
+					  << ", this machine is " << fingerprint.GetKey() << std::endl;
+	}
+
+	bool bSucceeded = harness.Run(benchmarkOptions, std::cout);
+	if (result.count("json") && !harness.WriteJSON(result["json"].as<std::string>(), benchmarkOptions))
+		return EXIT_FAILURE;
+
+	if (result["compare"].as<bool>())
+	{
+		Benchmark::CompareOptions compareOptions;
+		compareOptions.threshold = result["threshold"].as<double>() / 100.0;
+		compareOptions.numResamples = std::max<size_t>(1, result["resamples"].as<size_t>());
+		std::cout << std::endl << "Compared to " << baselinePath << std::endl;
+		bSucceeded &= Benchmark::ReportComparisons(Benchmark::Compare(baseline, harness.GetResults(), compareOptions), std::cout);
+	}
+
+	if (result["save-baseline"].as<bool>())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(baselinePath).parent_path(), error);
+		if (!harness.WriteJSON(baselinePath, benchmarkOptions))
+			return EXIT_FAILURE;
+		std::cout << "Saved baseline " << baselinePath << std::endl;
+	}
+
+	return bSucceeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -12,6 +12,9 @@ if(OSS_CPP_WARNINGS_AS_ERRORS)
 	endif()
 endif()
 
+# Set heap tracking flag, targets opt in by defining GL3_TRACK_HEAP
+option(GL3_TRACK_HEAP "Replace the global operator new to charge heap allocations to memory tags" ON)
+
 # Get upper case system name
 string(TOUPPER ${CMAKE_SYSTEM_NAME} SYSTEM_NAME_UPPER)
 
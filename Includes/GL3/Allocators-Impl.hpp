@@ -0,0 +1,51 @@
+#ifndef ALLOCATORS_IMPL_HPP
+#define ALLOCATORS_IMPL_HPP
+
+#include <new>
+#include <utility>
+
+namespace GL3 {
+
+	template <typename Type>
+	Type* FrameAllocator<Type>::allocate(size_t count)
+	{
+		return static_cast<Type*>(FrameArena::GetInstance().Allocate(sizeof(Type) * count, alignof(Type)));
+	}
+
+	template <typename Type>
+	ObjectPool<Type>::ObjectPool(size_t objectsPerChunk)
+		: _pool(sizeof(Type), objectsPerChunk)
+	{
+		//! Do nothing
+	}
+
+	template <typename Type>
+	template <typename... Args>
+	Type* ObjectPool<Type>::Create(Args&&... args)
+	{
+		return new (_pool.Allocate()) Type(std::forward<Args>(args)...);
+	}
+
+	template <typename Type>
+	void ObjectPool<Type>::Destroy(Type* object)
+	{
+		if (!object)
+			return;
+		object->~Type();
+		_pool.Deallocate(object);
+	}
+
+	template <typename Type>
+	Type* PoolAllocator<Type>::allocate(size_t count)
+	{
+		return static_cast<Type*>(_resource->Allocate(sizeof(Type) * count));
+	}
+
+	template <typename Type>
+	void PoolAllocator<Type>::deallocate(Type* pointer, size_t count)
+	{
+		_resource->Deallocate(pointer, sizeof(Type) * count);
+	}
+};
+
+#endif //! end of Allocators-Impl.hpp
@@ -0,0 +1,217 @@
+#ifndef ALLOCATORS_HPP
+#define ALLOCATORS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace GL3 {
+
+	//! Double-buffered linear arena for per frame temporaries.
+	//! Allocation is an atomic bump, so jobs may allocate too, and nothing is freed individually.
+	//! EndFrame() makes the other buffer current and drops its contents, so memory allocated during
+	//! a frame stays valid through the next one for lagged consumers (GPU uploads, queued readbacks).
+	//! EndFrame() must not overlap Allocate(), the frame loop owner calls it once per frame. Requests
+	//! that do not fit fall back to the heap and are released together with their buffer.
+	//! Only code running inside the renderer's frame loop may allocate here, kernels that can also run
+	//! outside of it (simulation, benchmarks, tools) reuse thread_local or member scratch vectors instead.
+	class FrameArena
+	{
+	public:
+		//! Bytes of each of the two buffers unless Initialize() picks another size
+		static constexpr size_t DEFAULT_CAPACITY = 8 << 20;
+		//! Returns the process-wide frame arena
+		static FrameArena& GetInstance();
+		//! Default destructor
+		~FrameArena();
+		//! Reallocate both buffers with the given capacity, every outstanding allocation is dropped.
+		void Initialize(size_t capacity);
+		//! Returns numBytes of storage aligned to alignment, valid until the second EndFrame() from now.
+		void* Allocate(size_t numBytes, size_t alignment = alignof(std::max_align_t));
+		//! Swap the buffers and reset the new current one
+		void EndFrame();
+		//! Returns the bytes used in the current buffer
+		inline size_t GetUsedBytes() const
+		{
+			return _buffers[_current].offset.load(std::memory_order_relaxed);
+		}
+		inline size_t GetCapacity() const
+		{
+			return _capacity;
+		}
+		//! Returns the largest buffer usage seen at EndFrame()
+		inline size_t GetPeakBytes() const
+		{
+			return _peakBytes;
+		}
+		//! Returns the requests the current buffer could not hold since the last EndFrame()
+		inline size_t GetNumOverflows() const
+		{
+			return _buffers[_current].overflow.size();
+		}
+	private:
+		//! One half of the double buffer
+		struct Buffer
+		{
+			std::unique_ptr<char[]> data;
+			std::atomic<size_t> offset;
+			//! Heap blocks of the requests that did not fit
+			std::vector<void*> overflow;
+		};
+		//! Default constructor
+		FrameArena();
+		//! Serve a request that does not fit into the current buffer from the heap
+		void* AllocateOverflow(Buffer& buffer, size_t numBytes, size_t alignment);
+		//! Drop the allocations and overflow blocks of the buffer
+		static void ResetBuffer(Buffer& buffer);
+
+		Buffer _buffers[2];
+		std::mutex _overflowMutex;
+		size_t _current;
+		size_t _capacity;
+		size_t _peakBytes;
+	};
+
+	//! STL allocator over the process-wide FrameArena, deallocation is a no-op.
+	//! Containers using it must not outlive the next frame, see FrameArena.
+	template <typename Type>
+	class FrameAllocator
+	{
+	public:
+		using value_type = Type;
+		using is_always_equal = std::true_type;
+		//! Default constructor
+		FrameAllocator() = default;
+		template <typename Other>
+		FrameAllocator(const FrameAllocator<Other>&) {};
+		Type* allocate(size_t count);
+		void deallocate(Type*, size_t) {};
+	};
+
+	template <typename Type, typename Other>
+	bool operator==(const FrameAllocator<Type>&, const FrameAllocator<Other>&) { return true; }
+	template <typename Type, typename Other>
+	bool operator!=(const FrameAllocator<Type>&, const FrameAllocator<Other>&) { return false; }
+
+	//! Vector of per frame temporaries, see FrameArena for its lifetime
+	template <typename Type>
+	using FrameVector = std::vector<Type, FrameAllocator<Type>>;
+
+	//! Free list of equally sized blocks carved from chunks, chunks are kept until destruction.
+	//! Not thread-safe, every pool has a single owner.
+	class FixedBlockPool
+	{
+	public:
+		//! Create the pool, blockSize is rounded up to keep every block max_align_t aligned.
+		explicit FixedBlockPool(size_t blockSize, size_t blocksPerChunk = 256);
+		//! Default destructor
+		~FixedBlockPool();
+		FixedBlockPool(const FixedBlockPool&) = delete;
+		FixedBlockPool& operator=(const FixedBlockPool&) = delete;
+		//! Returns one block, a new chunk is allocated when the free list is empty.
+		void* Allocate();
+		//! Return the block to the free list
+		void Deallocate(void* block);
+		inline size_t GetBlockSize() const
+		{
+			return _blockSize;
+		}
+		//! Returns the blocks handed out and not returned yet
+		inline size_t GetNumAllocated() const
+		{
+			return _numAllocated;
+		}
+		inline size_t GetNumChunks() const
+		{
+			return _chunks.size();
+		}
+	private:
+		//! Link stored inside the free blocks
+		struct FreeBlock
+		{
+			FreeBlock* next;
+		};
+
+		std::vector< std::unique_ptr<char[]> > _chunks;
+		FreeBlock* _freeList;
+		size_t _blockSize;
+		size_t _blocksPerChunk;
+		size_t _numAllocated;
+	};
+
+	//! Fixed size pool of constructed objects, Create() and Destroy() replace new and delete.
+	template <typename Type>
+	class ObjectPool
+	{
+	public:
+		static_assert(alignof(Type) <= alignof(std::max_align_t), "Over-aligned types are not supported");
+		//! Default constructor
+		explicit ObjectPool(size_t objectsPerChunk = 256);
+		//! Construct an object in a pooled block
+		template <typename... Args>
+		Type* Create(Args&&... args);
+		//! Destruct the object and return its block
+		void Destroy(Type* object);
+		//! Returns the live objects
+		inline size_t GetNumObjects() const
+		{
+			return _pool.GetNumAllocated();
+		}
+	private:
+		FixedBlockPool _pool;
+	};
+
+	//! Size class pools behind PoolAllocator, requests larger than MAX_BLOCK_SIZE go to the heap.
+	//! Not thread-safe, share one resource between containers of the same thread only.
+	class PoolResource
+	{
+	public:
+		//! Largest pooled request in bytes
+		static constexpr size_t MAX_BLOCK_SIZE = 256;
+		//! Pooled requests are rounded up to this granularity
+		static constexpr size_t SIZE_CLASS_GRANULARITY = alignof(std::max_align_t);
+		//! Default constructor
+		PoolResource();
+		//! Returns numBytes of storage from the matching size class
+		void* Allocate(size_t numBytes);
+		//! Return the storage of an Allocate(numBytes) call
+		void Deallocate(void* pointer, size_t numBytes);
+	private:
+		static constexpr size_t NUM_SIZE_CLASSES = MAX_BLOCK_SIZE / SIZE_CLASS_GRANULARITY;
+
+		std::array<std::unique_ptr<FixedBlockPool>, NUM_SIZE_CLASSES> _pools;
+	};
+
+	//! STL allocator over a PoolResource, meant for node based containers (lists, maps, sets).
+	template <typename Type>
+	class PoolAllocator
+	{
+	public:
+		using value_type = Type;
+		//! Allocate from the given resource, which must outlive the container
+		explicit PoolAllocator(PoolResource* resource) : _resource(resource) {};
+		template <typename Other>
+		PoolAllocator(const PoolAllocator<Other>& other) : _resource(other.GetResource()) {};
+		Type* allocate(size_t count);
+		void deallocate(Type* pointer, size_t count);
+		inline PoolResource* GetResource() const
+		{
+			return _resource;
+		}
+	private:
+		PoolResource* _resource;
+	};
+
+	template <typename Type, typename Other>
+	bool operator==(const PoolAllocator<Type>& lhs, const PoolAllocator<Other>& rhs) { return lhs.GetResource() == rhs.GetResource(); }
+	template <typename Type, typename Other>
+	bool operator!=(const PoolAllocator<Type>& lhs, const PoolAllocator<Other>& rhs) { return lhs.GetResource() != rhs.GetResource(); }
+
+};
+
+#include <GL3/Allocators-Impl.hpp>
+
+#endif //! end of Allocators.hpp
@@ -5,6 +5,8 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <GL3/EntityStore.hpp>
+#include <GL3/QualityController.hpp>
 #include <cxxopts/cxxopts.hpp>
 
 namespace GL3
@@ -37,6 +39,11 @@ namespace GL3
 		void ProcessInput(unsigned int key);
 		//!Process the mouse cursor positions
 		void ProcessCursorPos(double xpos, double ypos);
+		//! Take the particle budget and impostor distance chosen by the quality controller
+		void SetQualitySettings(const QualitySettings& settings);
+		//! Returns whether the application scales its work with the knob, the renderer pins the CPU
+		//! knobs no application uses at their maximum
+		virtual bool UsesQualityKnob(QualityKnob knob) const;
 	protected:
 		virtual bool OnInitialize(std::shared_ptr<GL3::Window> window, const cxxopts::ParseResult& configure) = 0;
 		virtual void OnCleanUp() = 0;
@@ -47,6 +54,12 @@ namespace GL3
 		std::vector< std::shared_ptr< GL3::Camera > > _cameras;
 		std::unordered_map< std::string, std::shared_ptr< GL3::Shader > > _shaders;
 		std::unordered_map< std::string, std::shared_ptr< GL3::Texture > > _textures;
+		//! Scene objects (trees, structures, crews) as components, see SceneComponents.hpp
+		EntityStore _scene;
+		QualitySettings _qualitySettings;
+	private:
+		//! Row of the application in the memory report, its calls charge the heap to it
+		size_t _memoryApplication;
 	};
 };
 
@@ -0,0 +1,97 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include <GL3/BoundingBox.hpp>
+#include <glm/vec3.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace GL3 {
+
+	class Mesh;
+
+	//! Closest hit of a ray query
+	struct RayHit
+	{
+		//! Distance along the ray in units of the direction length
+		float t;
+		//! Barycentric coordinates of the hit on the triangle
+		float u, v;
+		//! Index of the hit triangle in the source index buffer
+		unsigned int triangle;
+	};
+
+	//! Bounding volume hierarchy over triangle meshes for picking, visibility and ember landing queries.
+	//! Splits are chosen by a 16 bin surface area heuristic, the upper levels are split breadth first
+	//! and the resulting subtrees are built in parallel. The tree is flattened into 32 byte nodes with
+	//! both children next to each other and leaf triangles stored in traversal order.
+	class BVH
+	{
+	public:
+		//! Number of centroid bins per axis of the surface area heuristic
+		static constexpr int NUM_BINS = 16;
+		//! Leaves never get split below this triangle count
+		static constexpr int MIN_LEAF_TRIANGLES = 2;
+		//! Deepest node level, nodes at it stay leaves whatever their triangle count, which bounds the
+		//! traversal stack
+		static constexpr int MAX_DEPTH = 64;
+		//! Default constructor
+		BVH();
+		//! Default destructor
+		~BVH();
+		//! Build over the CPU side geometry of the mesh.
+		bool Build(const Mesh& mesh);
+		//! Build over indexed triangles, every three indices form one triangle.
+		bool Build(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices);
+		//! Find the closest hit within (0, tMax], returns false when the ray misses.
+		bool Intersect(const glm::vec3& origin, const glm::vec3& direction, float tMax, RayHit& hit) const;
+		//! Returns whether any triangle blocks the ray within (0, tMax], stops at the first hit found.
+		bool IsOccluded(const glm::vec3& origin, const glm::vec3& direction, float tMax) const;
+		//! Returns the bounds of the whole tree
+		BoundingBox GetBoundingBox() const;
+		//! Returns the number of flattened nodes
+		inline size_t GetNumNodes() const
+		{
+			return _nodes.size();
+		}
+	private:
+		//! Flattened node, leaves have a triangle count and interior nodes point at their left child
+		struct Node
+		{
+			float lower[3];
+			uint32_t leftOrFirst;
+			float upper[3];
+			uint32_t count;
+		};
+		//! Triangle prepared for Moller-Trumbore intersection
+		struct Triangle
+		{
+			glm::vec3 v0, edge1, edge2;
+		};
+		//! Range of the triangle order a pending subtree covers
+		struct BuildTask
+		{
+			uint32_t node;
+			uint32_t begin, end;
+			int depth;
+		};
+		//! Split the node at the given depth in place, returns false when it stays a leaf.
+		bool SplitNode(std::vector<Node>& nodes, uint32_t nodeIndex, int depth, bool bParallelBinning);
+		//! Build the whole subtree of a node at the given depth depth first.
+		void BuildSubtree(std::vector<Node>& nodes, uint32_t nodeIndex, int depth);
+		//! Shared traversal, anyHit stops at the first intersection.
+		bool Traverse(const glm::vec3& origin, const glm::vec3& direction, float tMax, bool bAnyHit, RayHit& hit) const;
+
+		std::vector<Node> _nodes;
+		std::vector<Triangle> _triangles;
+		std::vector<unsigned int> _triangleIds;
+		//! Build time per triangle data, indexed by the source triangle
+		std::vector<glm::vec3> _centroids;
+		std::vector<glm::vec3> _triangleLower;
+		std::vector<glm::vec3> _triangleUpper;
+		std::vector<uint32_t> _order;
+	};
+
+};
+
+#endif //! end of BVH.hpp
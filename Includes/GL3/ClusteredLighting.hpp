@@ -0,0 +1,112 @@
+#ifndef CLUSTERED_LIGHTING_HPP
+#define CLUSTERED_LIGHTING_HPP
+
+#include <GL3/GLTypes.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace GL3 {
+
+	class Shader;
+
+	//! Point light as laid out in the std430 light buffer
+	struct PointLight
+	{
+		glm::vec3 position;
+		float radius;
+		glm::vec3 color;
+		float intensity;
+	};
+
+	//! CPU light culling into view frustum clusters for forward shading.
+	//! The frustum is cut into screen tiles and exponential depth slices, every slice is culled by a
+	//! worker with four lights per sphere-box test, and the result is a compact per-cluster
+	//! (offset, count) table over one light index list that the fragment shader walks.
+	class ClusteredLightCuller
+	{
+	public:
+		//! Cluster grid, must match the constants in clustered_output.glsl
+		static constexpr int CLUSTER_X = 16;
+		static constexpr int CLUSTER_Y = 9;
+		static constexpr int CLUSTER_Z = 24;
+		//! Shader storage binding points of the light, cluster and index buffers
+		static constexpr GLuint LIGHT_BINDING = 1;
+		static constexpr GLuint CLUSTER_BINDING = 2;
+		static constexpr GLuint INDEX_BINDING = 3;
+		//! Default constructor
+		ClusteredLightCuller();
+		//! Default destructor
+		~ClusteredLightCuller();
+		//! Create the shader storage buffers, Cull() uploads into them afterwards.
+		bool InitializeGL();
+		//! Replace the light list
+		void SetLights(const std::vector<PointLight>& lights);
+		//! Returns the current light list
+		inline const std::vector<PointLight>& GetLights() const
+		{
+			return _lights;
+		}
+		//! Merge the burning cells of every tileSize x tileSize tile into one light at the intensity weighted
+		//! centroid. Grid x maps to world x and grid y to world z, the lights sit at lightHeight.
+		//! The radius is where the inverse square falloff drops under cutoffIntensity.
+		static void AggregateFireLights(const float* intensity, int width, int height, float cellSize, int tileSize,
+										float lightHeight, float cutoffIntensity, std::vector<PointLight>& lights);
+		//! Bin the lights into the clusters of the given camera and upload the lists when GL is initialized.
+		void Cull(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar);
+		//! Bind the buffers and send the cluster lookup parameters to the bound clustered_output.glsl program.
+		void BindBuffers(Shader& shader, int width, int height) const;
+		//! Returns the per cluster (offset, count) pairs, x fastest then y then depth slice
+		inline const std::vector<uint32_t>& GetClusterRecords() const
+		{
+			return _clusterRecords;
+		}
+		//! Returns the concatenated light indices of all clusters
+		inline const std::vector<uint32_t>& GetLightIndices() const
+		{
+			return _lightIndices;
+		}
+		//! Returns the near and far plane distances the clusters were built for
+		inline float GetZNear() const
+		{
+			return _zNear;
+		}
+		inline float GetZFar() const
+		{
+			return _zFar;
+		}
+		//! Returns the largest number of lights assigned to a single cluster
+		inline size_t GetMaxLightsPerCluster() const
+		{
+			return _maxLightsPerCluster;
+		}
+		//! Clean up the generated resources
+		void CleanUp();
+	private:
+		//! Rebuild the view space cluster boxes for a new projection.
+		void BuildClusterBounds(const glm::mat4& projection, float zNear, float zFar);
+
+		std::vector<PointLight> _lights;
+		//! View space cluster boxes, lower and upper corner per cluster
+		std::vector<glm::vec3> _clusterBounds;
+		std::vector<float> _sliceDepths;
+		//! View space light spheres as separate x, y, z, radius arrays
+		std::vector<float> _viewLights[4];
+		std::vector< std::vector<uint32_t> > _sliceIndices;
+		std::vector<uint32_t> _clusterCounts;
+		std::vector<uint32_t> _clusterRecords;
+		std::vector<uint32_t> _lightIndices;
+		glm::mat4 _projection;
+		float _zNear, _zFar;
+		size_t _maxLightsPerCluster;
+		GLuint _lightBuffer;
+		GLuint _clusterBuffer;
+		GLuint _indexBuffer;
+		size_t _gpuBytes;
+		bool _bGLInitialized;
+	};
+
+};
+
+#endif //! end of ClusteredLighting.hpp
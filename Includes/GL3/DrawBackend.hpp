@@ -0,0 +1,33 @@
+#ifndef DRAW_BACKEND_HPP
+#define DRAW_BACKEND_HPP
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+namespace GL3 {
+
+	class ClusteredLightCuller;
+	class Mesh;
+
+	//! Common drawing interface of the OpenGL and the software back ends, so a scene drawn through it
+	//! renders the same in a window and headless. Both shade like clustered_output.glsl.
+	class DrawBackend
+	{
+	public:
+		//! Default destructor
+		virtual ~DrawBackend() {};
+		//! Take the view and projection of the following draws
+		virtual void SetCamera(const glm::mat4& view, const glm::mat4& projection) = 0;
+		//! Shade with the cluster light lists of the culler, nullptr leaves the ambient term.
+		virtual void SetLighting(const ClusteredLightCuller* culler) = 0;
+		//! Clear the color and depth buffers
+		virtual void Clear(const glm::vec4& color, float depth = 1.0f) = 0;
+		//! Draw the mesh with the model matrix, the mesh must stay alive until Flush().
+		virtual void DrawMesh(const Mesh& mesh, const glm::mat4& model) = 0;
+		//! Finish the draws issued since the last Flush()
+		virtual void Flush() = 0;
+	};
+
+};
+
+#endif //! end of DrawBackend.hpp
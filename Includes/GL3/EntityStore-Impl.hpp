@@ -0,0 +1,122 @@
+#ifndef ENTITY_STORE_IMPL_HPP
+#define ENTITY_STORE_IMPL_HPP
+
+#include <GL3/JobSystem.hpp>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace GL3 {
+
+	template <typename Component>
+	uint32_t EntityStore::GetComponentID()
+	{
+		static_assert(std::is_trivially_copyable<Component>::value, "Components must be trivially copyable");
+		static_assert(alignof(Component) <= alignof(std::max_align_t), "Over-aligned components are not supported");
+		static const uint32_t id = RegisterComponent(sizeof(Component));
+		return id;
+	}
+
+	template <typename... Components>
+	Entity EntityStore::Create(const Components&... components)
+	{
+		const Signature signature = (Signature(0) | ... | (Signature(1) << GetComponentID<Components>()));
+		const Entity entity = AllocateEntity(GetArchetype(signature));
+		(std::memcpy(GetComponent(entity, GetComponentID<Components>()), &components, sizeof(Components)), ...);
+		return entity;
+	}
+
+	template <typename Component>
+	Component* EntityStore::Get(Entity entity)
+	{
+		return static_cast<Component*>(GetComponent(entity, GetComponentID<Component>()));
+	}
+
+	template <typename Component>
+	bool EntityStore::Has(Entity entity) const
+	{
+		return IsAlive(entity) && (_archetypes[_records[entity.index].archetype].signature & (Signature(1) << GetComponentID<Component>())) != 0;
+	}
+
+	template <typename Component>
+	bool EntityStore::Add(Entity entity, const Component& component)
+	{
+		if (!IsAlive(entity))
+			return false;
+
+		const uint32_t componentID = GetComponentID<Component>();
+		const Signature signature = _archetypes[_records[entity.index].archetype].signature;
+		if ((signature & (Signature(1) << componentID)) == 0)
+			MoveEntity(entity, signature | (Signature(1) << componentID));
+		std::memcpy(GetComponent(entity, componentID), &component, sizeof(Component));
+		return true;
+	}
+
+	template <typename Component>
+	bool EntityStore::Remove(Entity entity)
+	{
+		if (!Has<Component>(entity))
+			return false;
+
+		const Signature signature = _archetypes[_records[entity.index].archetype].signature;
+		MoveEntity(entity, signature & ~(Signature(1) << GetComponentID<Component>()));
+		return true;
+	}
+
+	template <typename... Components, typename Function>
+	void EntityStore::ForEachChunk(Function&& function)
+	{
+		std::vector<uint32_t> matches;
+		GetMatchingArchetypes((Signature(0) | ... | (Signature(1) << GetComponentID<Components>())), matches);
+		for (uint32_t index : matches)
+		{
+			Archetype& archetype = _archetypes[index];
+			if (archetype.entities.empty())
+				continue;
+			function(archetype.entities.size(), archetype.entities.data(),
+					 reinterpret_cast<Components*>(archetype.columns[archetype.columnIndex[GetComponentID<Components>()]].data.data())...);
+		}
+	}
+
+	template <typename... Components, typename Function>
+	void EntityStore::ForEach(Function&& function)
+	{
+		ForEachChunk<Components...>([&function](size_t count, const Entity* entities, Components*... columns)
+		{
+			for (size_t row = 0; row < count; ++row)
+				function(entities[row], columns[row]...);
+		});
+	}
+
+	template <typename... Components, typename Function>
+	void EntityStore::ParallelForEach(Function&& function)
+	{
+		//! Slice every matching archetype into jobs of at most ROWS_PER_JOB rows.
+		struct Slice
+		{
+			uint32_t archetype;
+			size_t begin, end;
+		};
+		std::vector<uint32_t> matches;
+		GetMatchingArchetypes((Signature(0) | ... | (Signature(1) << GetComponentID<Components>())), matches);
+		std::vector<Slice> slices;
+		for (uint32_t index : matches)
+			for (size_t begin = 0; begin < _archetypes[index].entities.size(); begin += ROWS_PER_JOB)
+				slices.push_back({ index, begin, std::min(begin + ROWS_PER_JOB, _archetypes[index].entities.size()) });
+
+		JobSystem::GetInstance().ParallelFor(slices.size(), [&](size_t job)
+		{
+			const Slice& slice = slices[job];
+			Archetype& archetype = _archetypes[slice.archetype];
+			auto run = [&](Components*... columns)
+			{
+				for (size_t row = slice.begin; row < slice.end; ++row)
+					function(archetype.entities[row], columns[row]...);
+			};
+			run(reinterpret_cast<Components*>(archetype.columns[archetype.columnIndex[GetComponentID<Components>()]].data.data())...);
+		});
+	}
+
+};
+
+#endif //! end of EntityStore-Impl.hpp
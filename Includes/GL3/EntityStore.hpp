@@ -0,0 +1,144 @@
+#ifndef ENTITY_STORE_HPP
+#define ENTITY_STORE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace GL3 {
+
+	//! Stable handle of an entity, the generation detects handles of destroyed entities
+	struct Entity
+	{
+		uint32_t index;
+		uint32_t generation;
+		inline bool operator==(const Entity& other) const
+		{
+			return index == other.index && generation == other.generation;
+		}
+		inline bool operator!=(const Entity& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	//! Archetype based entity component store.
+	//! Entities with the same set of component types share an archetype, which keeps one dense array
+	//! per component type (structure of arrays), so a query walks contiguous memory of exactly the
+	//! components it asks for. Adding or removing a component moves the entity to another archetype,
+	//! destroying one swaps the last row of its archetype into the hole, handles stay valid throughout.
+	//! Components must be trivially copyable. Structural changes (Create, Destroy, Add, Remove) must
+	//! not overlap each other or an iteration, component values may be written from the iteration.
+	class EntityStore
+	{
+	public:
+		//! Bit set of the component types of an archetype
+		using Signature = uint64_t;
+		//! Component types a program may register
+		static constexpr size_t MAX_COMPONENTS = 64;
+		//! Rows of one ParallelForEach job
+		static constexpr size_t ROWS_PER_JOB = 4096;
+		//! Handle that never refers to an entity
+		static constexpr Entity NULL_ENTITY = { 0xFFFFFFFFu, 0 };
+		//! Default constructor
+		EntityStore();
+		//! Default destructor
+		~EntityStore();
+		//! Create an entity with the given components
+		template <typename... Components>
+		Entity Create(const Components&... components);
+		//! Destroy the entity, returns false for a stale handle
+		bool Destroy(Entity entity);
+		//! Returns true when the handle refers to a live entity
+		bool IsAlive(Entity entity) const;
+		//! Returns the component of the entity or nullptr when it is stale or has none
+		template <typename Component>
+		Component* Get(Entity entity);
+		template <typename Component>
+		bool Has(Entity entity) const;
+		//! Add the component to the entity or overwrite the one it has, returns false for a stale handle
+		template <typename Component>
+		bool Add(Entity entity, const Component& component);
+		//! Remove the component from the entity, returns false for a stale handle or a missing component
+		template <typename Component>
+		bool Remove(Entity entity);
+		//! Call function(Entity, Components&...) for every entity having all the components
+		template <typename... Components, typename Function>
+		void ForEach(Function&& function);
+		//! ForEach() spread over the job system in ROWS_PER_JOB slices of the matching archetypes
+		template <typename... Components, typename Function>
+		void ParallelForEach(Function&& function);
+		//! Call function(size_t count, const Entity*, Components*...) once per matching archetype with its
+		//! dense arrays, the form for vectorized loops
+		template <typename... Components, typename Function>
+		void ForEachChunk(Function&& function);
+		//! Destroy every entity, the archetypes are kept for reuse
+		void Clear();
+		//! Returns the number of live entities
+		inline size_t GetNumEntities() const
+		{
+			return _numEntities;
+		}
+		inline size_t GetNumArchetypes() const
+		{
+			return _archetypes.size();
+		}
+		//! Returns the component bytes of the live entities
+		size_t GetComponentBytes() const;
+		//! Returns the process-wide id of a component type, registered on first use
+		template <typename Component>
+		static uint32_t GetComponentID();
+	private:
+		//! Dense array of one component type
+		struct Column
+		{
+			uint32_t componentID;
+			uint32_t elementSize;
+			std::vector<uint8_t> data;
+		};
+		//! Entities of one component set, row i of every column belongs to entities[i]
+		struct Archetype
+		{
+			Signature signature;
+			std::vector<Entity> entities;
+			std::vector<Column> columns;
+			//! Column of each component id, NO_COLUMN when the archetype does not have it
+			std::array<uint8_t, MAX_COMPONENTS> columnIndex;
+		};
+		//! Location of an entity, indexed by Entity::index
+		struct Record
+		{
+			uint32_t archetype;
+			uint32_t row;
+			uint32_t generation;
+		};
+		static constexpr uint8_t NO_COLUMN = 0xFF;
+		//! Assign the next component id to a type of the given size
+		static uint32_t RegisterComponent(size_t elementSize);
+		//! Returns the archetype with the signature, created on first use
+		uint32_t GetArchetype(Signature signature);
+		//! Returns the component storage of the entity or nullptr
+		void* GetComponent(Entity entity, uint32_t componentID);
+		//! Allocate a handle and an uninitialized row in the archetype
+		Entity AllocateEntity(uint32_t archetype);
+		//! Move the entity into the archetype of the signature, copying the components both have
+		void MoveEntity(Entity entity, Signature signature);
+		//! Swap-remove a row and patch the record of the entity moved into it
+		void RemoveRow(uint32_t archetype, uint32_t row);
+		//! Collect the archetypes having every component of the signature
+		void GetMatchingArchetypes(Signature signature, std::vector<uint32_t>& matches) const;
+
+		std::vector<Archetype> _archetypes;
+		std::unordered_map<Signature, uint32_t> _archetypeLookup;
+		std::vector<Record> _records;
+		std::vector<uint32_t> _freeIndices;
+		size_t _numEntities;
+	};
+
+};
+
+#include <GL3/EntityStore-Impl.hpp>
+
+#endif //! end of EntityStore.hpp
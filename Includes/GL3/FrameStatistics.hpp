@@ -0,0 +1,55 @@
+#ifndef FRAME_STATISTICS_HPP
+#define FRAME_STATISTICS_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace GL3 {
+
+	//! Per frame event counters bumped by the resource classes and the simulation.
+	//! Counting is a relaxed atomic add, so it is safe from the job system and cheap enough to stay on.
+	class FrameStatistics
+	{
+	public:
+		//! Counted events
+		enum Counter
+		{
+			DrawCalls = 0,
+			ShaderBinds = 1,
+			TextureBinds = 2,
+			BufferBinds = 3,
+			SimulationSteps = 4,
+			//! Allocations the frame arena and the pools served instead of the heap
+			PooledAllocations = 5,
+			//! Boxes OcclusionCuller tested and rejected
+			CullTested = 6,
+			CullRejected = 7,
+			//! Microseconds OcclusionCuller spent rasterizing, building the pyramid and testing
+			CullTime = 8,
+			NumCounters = 9,
+		};
+		//! Returns the process-wide statistics instance
+		static FrameStatistics& GetInstance();
+		//! Add amount events to the counter
+		inline void Increment(Counter counter, size_t amount = 1)
+		{
+			_counters[counter].fetch_add(amount, std::memory_order_relaxed);
+		}
+		//! Returns the events counted since the last reset
+		inline size_t Get(Counter counter) const
+		{
+			return _counters[counter].load(std::memory_order_relaxed);
+		}
+		//! Reset one or all of the counters
+		void Reset(Counter counter);
+		void Reset();
+	private:
+		//! Default constructor
+		FrameStatistics();
+
+		std::atomic<size_t> _counters[NumCounters];
+	};
+
+};
+
+#endif //! end of FrameStatistics.hpp
@@ -0,0 +1,50 @@
+#ifndef GL_DRAW_BACKEND_HPP
+#define GL_DRAW_BACKEND_HPP
+
+#include <GL3/DrawBackend.hpp>
+#include <GL3/GLTypes.hpp>
+#include <memory>
+
+namespace GL3 {
+
+	class InstanceBuffer;
+	class Shader;
+	class VertexColorBuffer;
+
+	//! DrawBackend over OpenGL. The program follows vertex.glsl, its CamMatrices block is fed from an
+	//! own uniform buffer at binding 0. The program, the camera and the light buffers are bound by the
+	//! first draw after Flush() or a state change, Flush() unbinds them again.
+	class GLDrawBackend : public DrawBackend
+	{
+	public:
+		//! Uniform buffer binding of the CamMatrices block
+		static constexpr GLuint CAMERA_BINDING = 0;
+		//! Default constructor
+		GLDrawBackend();
+		//! Default destructor
+		~GLDrawBackend();
+		//! Draw with the program, clustered_output.glsl reads the lights of SetLighting().
+		bool Initialize(std::shared_ptr<Shader> shader);
+		void SetCamera(const glm::mat4& view, const glm::mat4& projection) override;
+		void SetLighting(const ClusteredLightCuller* culler) override;
+		void Clear(const glm::vec4& color, float depth = 1.0f) override;
+		void DrawMesh(const Mesh& mesh, const glm::mat4& model) override;
+		//! Draws only the GL back end has, see Mesh::DrawColored() and Mesh::DrawInstanced()
+		void DrawColored(const Mesh& mesh, const glm::mat4& model, const VertexColorBuffer& colors);
+		void DrawInstanced(const Mesh& mesh, const InstanceBuffer& instances, size_t first, size_t count);
+		void Flush() override;
+		//! Clean up the generated resources
+		void CleanUp();
+	private:
+		//! Bind the program, camera and lights when needed and send the model matrix
+		void BindState(const glm::mat4& model);
+
+		std::shared_ptr<Shader> _shader;
+		const ClusteredLightCuller* _culler;
+		GLuint _cameraBuffer;
+		bool _bBound;
+	};
+
+};
+
+#endif //! end of GLDrawBackend.hpp
@@ -0,0 +1,49 @@
+#ifndef INSTANCE_BUFFER_HPP
+#define INSTANCE_BUFFER_HPP
+
+#include <GL3/MappedRingBuffer.hpp>
+#include <glm/mat4x4.hpp>
+
+namespace GL3 {
+
+	//! Persistently mapped buffer of per instance model matrices, bound to the vertex attributes
+	//! 3 to 6 by Mesh::DrawInstanced(). The CPU writes the matrices straight into the mapping,
+	//! e.g. through TransformHierarchy::Update(), and EndFrame() fences the draws reading them.
+	//! Every frame writes the next region of a MappedRingBuffer, so BeginWrite() only stalls when
+	//! the GPU is still MappedRingBuffer::NUM_REGIONS - 1 frames behind.
+	class InstanceBuffer
+	{
+	public:
+		//! Default constructor
+		InstanceBuffer();
+		//! Default destructor
+		~InstanceBuffer();
+		//! Create and map storage for capacity matrices per frame, replaces the previous buffer
+		bool Initialize(size_t capacity);
+		//! Wait until the GPU is done with the next region and returns its mapped matrices
+		glm::mat4* BeginWrite();
+		//! Fence the draws issued since BeginWrite()
+		void EndFrame();
+		//! Clean up the generated resources
+		void CleanUp();
+		inline GLuint GetBufferID() const
+		{
+			return _ring.GetBufferID();
+		}
+		//! Returns the byte offset of the matrices written by the last BeginWrite()
+		inline size_t GetOffset() const
+		{
+			return _ring.GetOffset();
+		}
+		inline size_t GetCapacity() const
+		{
+			return _capacity;
+		}
+	private:
+		MappedRingBuffer _ring;
+		size_t _capacity;
+	};
+
+};
+
+#endif //! end of InstanceBuffer.hpp
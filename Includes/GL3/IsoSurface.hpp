@@ -0,0 +1,87 @@
+#ifndef ISO_SURFACE_HPP
+#define ISO_SURFACE_HPP
+
+#include <GL3/Mesh.hpp>
+#include <glm/vec3.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace GL3 {
+
+	//! Block-parallel marching cubes over a point sampled scalar field.
+	//! Each block owns the grid edges starting at its points, so shared vertices are welded by
+	//! looking the edge up in the owning block's dense edge table instead of a global hash map.
+	//! Blocks whose min/max range excludes the iso value are skipped, and Extract() only redoes
+	//! blocks whose samples changed since the previous call.
+	class IsoSurfaceExtractor
+	{
+	public:
+		//! Cells per block edge
+		static constexpr int BLOCK_SIZE = 16;
+		//! Default constructor
+		IsoSurfaceExtractor();
+		//! Default destructor
+		~IsoSurfaceExtractor();
+		//! Set the sample grid extent and the world placement of sample (0, 0, 0) and its spacing.
+		bool Initialize(const glm::ivec3& extent, const glm::vec3& origin, const glm::vec3& spacing);
+		//! Extract the surface where the field crosses isoValue, samples >= isoValue are inside.
+		//! Returns the number of blocks re-extracted.
+		size_t Extract(const float* field, float isoValue);
+		//! Upload the current surface through the regular mesh draw path.
+		void UploadToMesh(Mesh& mesh) const;
+		//! Returns the welded vertices, normals point out of the inside region
+		inline const std::vector<PackedVertex>& GetVertices() const
+		{
+			return _vertices;
+		}
+		//! Returns the triangle indices, counter-clockwise seen from outside
+		inline const std::vector<unsigned int>& GetIndices() const
+		{
+			return _indices;
+		}
+		//! Returns the number of blocks skipped by their min/max range during the last Extract()
+		inline size_t GetNumSkippedBlocks() const
+		{
+			return _numSkippedBlocks;
+		}
+	private:
+		//! Triangle corner referring to a vertex owned by some block
+		struct VertexRef
+		{
+			uint32_t block;
+			uint32_t local;
+		};
+		struct Block
+		{
+			glm::ivec3 firstPoint;
+			glm::ivec3 numPoints;
+			std::vector<int32_t> edgeVertices;
+			std::vector<PackedVertex> vertices;
+			std::vector<VertexRef> triangles;
+			float minValue, maxValue;
+			bool bActive;
+		};
+		//! Returns the block owning the given sample point
+		size_t GetOwnerBlock(const glm::ivec3& point) const;
+		//! Create vertices on the crossing edges owned by the block.
+		void GenerateVertices(Block& block, const float* field, float isoValue) const;
+		//! Triangulate the cells of the block against the owners' edge tables.
+		void Triangulate(size_t blockIndex, const float* field, float isoValue);
+		//! Concatenate the per-block results into the shared vertex and index buffers.
+		void Assemble();
+
+		std::vector<Block> _blocks;
+		std::vector<float> _previousField;
+		std::vector<PackedVertex> _vertices;
+		std::vector<unsigned int> _indices;
+		glm::ivec3 _extent;
+		glm::ivec3 _numBlocks;
+		glm::vec3 _origin;
+		glm::vec3 _spacing;
+		float _previousIsoValue;
+		size_t _numSkippedBlocks;
+	};
+
+};
+
+#endif //! end of IsoSurface.hpp
@@ -0,0 +1,63 @@
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <GL3/MemoryTracker.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GL3 {
+
+	//! Persistent worker pool shared by the CPU-side subsystems.
+	//! One ParallelFor batch runs at a time and the calling thread participates in it,
+	//! nested ParallelFor calls issued from inside a job run inline on the calling worker.
+	//! Workers charge their allocations to the memory tag and application of the caller.
+	class JobSystem
+	{
+	public:
+		using Job = std::function<void(size_t)>;
+		//! Returns the process-wide job system instance
+		static JobSystem& GetInstance();
+		//! Default destructor
+		~JobSystem();
+		//! Invoke job(i) for every i in [0, count) and return when all of them finished.
+		void ParallelFor(size_t count, const Job& job);
+		//! Returns the number of threads taking part in ParallelFor (workers and the caller)
+		size_t GetNumThreads() const;
+		//! Returns the nanoseconds all threads spent running jobs, the occupancy is its growth over
+		//! wall time times GetNumThreads().
+		inline uint64_t GetBusyTime() const
+		{
+			return _busyTime.load(std::memory_order_relaxed);
+		}
+	private:
+		//! Spawn hardware_concurrency - 1 workers
+		JobSystem();
+		//! Worker thread main loop
+		void WorkerLoop();
+		//! Pull job indices from the current batch until it is exhausted.
+		void RunJobs(const Job& job, size_t count);
+
+		std::vector< std::thread > _workers;
+		std::mutex _dispatchMutex;
+		std::mutex _mutex;
+		std::condition_variable _wakeCondition;
+		std::condition_variable _doneCondition;
+		const Job* _job;
+		size_t _count;
+		MemoryTracker::Tag _memoryTag;
+		size_t _memoryApplication;
+		std::atomic<size_t> _next;
+		std::atomic<uint64_t> _busyTime;
+		size_t _generation;
+		size_t _activeWorkers;
+		bool _bExit;
+	};
+
+};
+
+#endif //! end of JobSystem.hpp
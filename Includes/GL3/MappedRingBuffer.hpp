@@ -0,0 +1,54 @@
+#ifndef MAPPED_RING_BUFFER_HPP
+#define MAPPED_RING_BUFFER_HPP
+
+#include <GL3/GLTypes.hpp>
+
+typedef struct __GLsync *GLsync;
+
+namespace GL3 {
+
+	//! Persistently mapped buffer split into NUM_REGIONS regions written round robin, one per frame.
+	//! BeginWrite() moves to the next region and only waits for its fence, which EndFrame() set
+	//! NUM_REGIONS - 1 frames earlier, so the CPU stalls only when the GPU falls that far behind.
+	//! Draws read the region of the last BeginWrite() at GetOffset().
+	class MappedRingBuffer
+	{
+	public:
+		//! Regions in flight, the frame being written and the frames the GPU may still read
+		static constexpr int NUM_REGIONS = 3;
+		//! Default constructor
+		MappedRingBuffer();
+		//! Default destructor
+		~MappedRingBuffer();
+		//! Create and map NUM_REGIONS regions of regionBytes each, replaces the previous buffer
+		bool Initialize(size_t regionBytes);
+		//! Move to the next region, wait for the draws fenced on it and returns its mapping
+		void* BeginWrite();
+		//! Fence the draws reading the current region
+		void EndFrame();
+		//! Clean up the generated resources
+		void CleanUp();
+		inline GLuint GetBufferID() const
+		{
+			return _bufferID;
+		}
+		//! Returns the byte offset of the region draws read
+		inline size_t GetOffset() const
+		{
+			return _region * _regionBytes;
+		}
+		inline size_t GetRegionBytes() const
+		{
+			return _regionBytes;
+		}
+	private:
+		GLuint _bufferID;
+		char* _mapped;
+		GLsync _fences[NUM_REGIONS];
+		size_t _regionBytes;
+		int _region;
+	};
+
+};
+
+#endif //! end of MappedRingBuffer.hpp
@@ -0,0 +1,127 @@
+#ifndef MEMORY_TRACKER_HPP
+#define MEMORY_TRACKER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace GL3 {
+
+	//! Tagged memory accounting of the CPU heap and the GL objects.
+	//! Every operator new is charged to the tag of the innermost MemoryScope on the calling thread and
+	//! credited back to the same tag on delete. GL buffers and textures are charged explicitly by the
+	//! resource classes with AllocateGPU() and ReleaseGPU(). Each tag keeps its high-water mark.
+	//! The heap and the assets are also charged to the application the scope names, everything outside
+	//! an application goes to the shared slot 0. JobSystem hands the tag and application of the caller
+	//! to its workers, so jobs need no scope of their own.
+	//! The heap is only tracked in targets built with GL3_TRACK_HEAP, elsewhere its counters stay zero.
+	class MemoryTracker
+	{
+	public:
+		//! Subsystems memory is charged to
+		enum Tag
+		{
+			Untagged = 0,
+			Mesh = 1,
+			Texture = 2,
+			Camera = 3,
+			Shader = 4,
+			Simulation = 5,
+			Rendering = 6,
+			NumTags = 7,
+		};
+		//! Applications the heap is charged to, including the shared slot 0
+		static constexpr size_t MAX_APPLICATIONS = 8;
+		//! Current usage and high-water marks of one tag in bytes
+		struct Usage
+		{
+			size_t heapBytes, heapPeak;
+			size_t numAllocations;
+			size_t gpuBytes, gpuPeak;
+		};
+		//! Heap traffic since the last BeginFrame()
+		struct FrameUsage
+		{
+			size_t numAllocations;
+			size_t allocatedBytes;
+			//! Largest total heap size reached during the frame
+			size_t heapPeak;
+		};
+		//! Returns the process-wide tracker instance
+		static MemoryTracker& GetInstance();
+		//! Returns the printable name of the tag
+		static const char* GetTagName(Tag tag);
+		//! Returns the tag and application charged by the calling thread
+		static Tag GetCurrentTag();
+		static size_t GetCurrentApplication();
+		//! Add a row to the per application table, returns its slot or the shared slot 0 once they run out.
+		size_t RegisterApplication(const std::string& name);
+		//! Charge or credit GL memory of the tag
+		void AllocateGPU(Tag tag, size_t bytes);
+		void ReleaseGPU(Tag tag, size_t bytes);
+		//! Record the CPU and GPU bytes of a named asset, owner identifies it for updates and removal.
+		void SetAsset(const void* owner, const std::string& name, Tag tag, size_t cpuBytes, size_t gpuBytes);
+		void RemoveAsset(const void* owner);
+		//! Start the per frame statistics
+		void BeginFrame();
+		//! Returns the usage of one tag
+		Usage GetUsage(Tag tag) const;
+		//! Returns the heap traffic of the running frame
+		FrameUsage GetFrameUsage() const;
+		//! Returns the tracked heap and GPU bytes over all tags
+		size_t GetTotalHeapBytes() const;
+		size_t GetTotalGPUBytes() const;
+		//! Returns the high-water marks over all tags
+		size_t GetTotalHeapPeak() const;
+		size_t GetTotalGPUPeak() const;
+		//! Returns a one line summary for the statistics output
+		std::string GetDescription() const;
+		//! Write the per application, per frame and per asset tables
+		void Report(std::ostream& stream) const;
+	private:
+		//! Tracked asset of the report
+		struct Asset
+		{
+			std::string name;
+			Tag tag;
+			size_t application;
+			size_t cpuBytes, gpuBytes;
+		};
+		//! Default constructor
+		MemoryTracker();
+
+		mutable std::mutex _mutex;
+		std::unordered_map<const void*, Asset> _assets;
+		std::vector<std::string> _applicationNames;
+		std::atomic<size_t> _gpuBytes[NumTags];
+		std::atomic<size_t> _gpuPeak[NumTags];
+		std::atomic<size_t> _totalGPUBytes;
+		std::atomic<size_t> _totalGPUPeak;
+		size_t _frameStartAllocations;
+		size_t _frameStartAllocatedBytes;
+	};
+
+	//! Charges the heap allocations of the calling thread to the tag until the scope ends.
+	class MemoryScope
+	{
+	public:
+		//! Make tag the current tag of the thread
+		explicit MemoryScope(MemoryTracker::Tag tag);
+		//! Make tag and the registered application current
+		MemoryScope(MemoryTracker::Tag tag, size_t application);
+		//! Restore the previous tag and application
+		~MemoryScope();
+		MemoryScope(const MemoryScope&) = delete;
+		MemoryScope& operator=(const MemoryScope&) = delete;
+	private:
+		MemoryTracker::Tag _previousTag;
+		size_t _previousApplication;
+	};
+
+};
+
+#endif //! end of MemoryTracker.hpp
@@ -1,29 +1,102 @@
 #ifndef MESH_HPP
 #define MESH_HPP
 
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <GL3/GLTypes.hpp>
 #include <GL3/BoundingBox.hpp>
+#include <string>
+#include <vector>
 
 namespace GL3 {
 
+	class InstanceBuffer;
+	class VertexColorBuffer;
+
+	//! Interleaved vertex layout of every mesh vertex buffer
+	struct PackedVertex
+	{
+		glm::vec3 position;
+		glm::vec2 texCoord;
+		glm::vec3 normal;
+
+		PackedVertex() = default;
+		PackedVertex(glm::vec3 pos, glm::vec2 uv, glm::vec3 n)
+			: position(pos), texCoord(uv), normal(n) {};
+	};
+
+	//! Merge equal vertices of a triangle list (three vertices per face), the unique vertices are
+	//! appended to vertices and one index per input vertex to indices. Positions closer than
+	//! positionTolerance on every axis are equal, texture coordinates within 0.1 and normals within 0.3.
+	void WeldVertices(const std::vector<PackedVertex>& triangleVertices, std::vector<PackedVertex>& vertices, std::vector<unsigned int>& indices,
+					  float positionTolerance = 0.001f);
+	//! Smooth vertex normals of indexed triangles, the normalized sum of the adjacent face normals.
+	void ComputeVertexNormals(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices, std::vector<glm::vec3>& normals);
+
 	class Mesh
 	{
 	public:
+		//! First of the four vertex attributes holding the columns of the instance matrix
+		static constexpr unsigned int INSTANCE_ATTRIBUTE = 3;
+		//! Vertex attribute of the per vertex colors, transparent unless drawn through DrawColored()
+		static constexpr unsigned int COLOR_ATTRIBUTE = 7;
 		//! Default constructor
 		Mesh();
 		//! Default destructor
 		~Mesh();
-		//! Load vertices data from the obj file.
-		bool LoadObj(const char* path, bool scaleToUnitBox = true);
+		//! Load vertices data from the obj file, headless users skip the GPU upload.
+		bool LoadObj(const char* path, bool scaleToUnitBox = true, bool uploadToGPU = true);
+		//! Keep vertices and triangle indices on the CPU only, no GL context is needed.
+		void SetGeometry(const std::vector<PackedVertex>& vertices, const std::vector<unsigned int>& indices);
+		//! Upload generated vertices and triangle indices, replaces the previous contents.
+		void UploadMesh(const std::vector<PackedVertex>& vertices, const std::vector<unsigned int>& indices);
 		//! Draw the loaded and generated mesh with given primitive mode
-		void DrawMesh(GLenum mode);
+		void DrawMesh(GLenum mode) const;
+		//! Draw count instances whose model matrices start at row first of the instance buffer
+		void DrawInstanced(GLenum mode, const InstanceBuffer& instances, size_t first, size_t count) const;
+		//! Draw the mesh with one color per vertex of the color buffer, blended over the material by its alpha
+		void DrawColored(GLenum mode, const VertexColorBuffer& colors) const;
+		//! Reset the instance matrix attributes to identity, so plain draws only use the model uniform
+		static void ResetInstanceAttributes();
+		//! Reset the vertex color attribute to transparent, so plain draws keep the material color
+		static void ResetVertexColors();
+		//! Returns the vertex positions kept on the CPU for ray queries
+		inline const std::vector<glm::vec3>& GetPositions() const
+		{
+			return _positions;
+		}
+		//! Returns the vertex normals matching GetPositions()
+		inline const std::vector<glm::vec3>& GetNormals() const
+		{
+			return _normals;
+		}
+		//! Returns the triangle indices into GetPositions()
+		inline const std::vector<unsigned int>& GetIndices() const
+		{
+			return _indices;
+		}
+		//! Returns the bounds of the uploaded positions
+		inline const BoundingBox& GetBoundingBox() const
+		{
+			return _boundingBox;
+		}
+		//! Returns the number of vertices, the colors DrawColored() reads
+		inline size_t GetNumVertices() const
+		{
+			return _positions.size();
+		}
 		//! Clean up the generated resources
 		void CleanUp();
 	private:
+		std::vector<glm::vec3> _positions;
+		std::vector<glm::vec3> _normals;
+		std::vector<unsigned int> _indices;
 		BoundingBox _boundingBox;
+		//! Asset name of the memory report, the obj path of loaded meshes
+		std::string _name;
 		GLuint _vao, _vbo, _ebo;
 		unsigned int _numVertices;
+		size_t _gpuBytes;
 	};
 
 }; 
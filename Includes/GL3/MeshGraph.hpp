@@ -0,0 +1,82 @@
+#ifndef MESH_GRAPH_HPP
+#define MESH_GRAPH_HPP
+
+#include <glm/vec3.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace GL3 {
+
+	class Mesh;
+
+	//! Vertex adjacency of a triangle mesh in compressed sparse row form.
+	//! Mesh vertices sharing a position, e.g. split along texture or normal seams by WeldVertices(),
+	//! collapse into one node, so the graph follows the surface across seams. The edges of node n
+	//! are GetNeighbors()[GetOffsets()[n] .. GetOffsets()[n + 1]), sorted by neighbor, and every edge
+	//! is stored in both directions with its length and the sine of its climb along the up axis.
+	//! Nodes keep the order of their first mesh vertex, the locality of the mesh index order.
+	class MeshGraph
+	{
+	public:
+		//! Nodes of one Build() job
+		static constexpr size_t NODES_PER_JOB = 4096;
+		//! Default constructor
+		MeshGraph();
+		//! Default destructor
+		~MeshGraph();
+		//! Build the graph of indexed triangles, positions closer than weldDistance on every axis
+		//! share a node. Degenerate triangles only add their distinct edges.
+		bool Build(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices,
+				   const glm::vec3& up = glm::vec3(0.0f, 1.0f, 0.0f), float weldDistance = 1e-5f);
+		//! Build the graph of the CPU geometry of a mesh
+		bool Build(const Mesh& mesh, const glm::vec3& up = glm::vec3(0.0f, 1.0f, 0.0f), float weldDistance = 1e-5f);
+		//! Returns the bytes of every graph array
+		size_t GetMemoryBytes() const;
+		inline size_t GetNumNodes() const
+		{
+			return _nodePositions.size();
+		}
+		//! Returns the number of directed edges, twice the number of mesh edges
+		inline size_t GetNumEdges() const
+		{
+			return _neighbors.size();
+		}
+		//! Returns the first edge of every node followed by the number of edges
+		inline const std::vector<uint32_t>& GetOffsets() const
+		{
+			return _offsets;
+		}
+		inline const std::vector<uint32_t>& GetNeighbors() const
+		{
+			return _neighbors;
+		}
+		//! Returns the length of every edge
+		inline const std::vector<float>& GetLengths() const
+		{
+			return _lengths;
+		}
+		//! Returns the rise of every edge towards its neighbor divided by its length, in [-1, 1]
+		inline const std::vector<float>& GetSlopes() const
+		{
+			return _slopes;
+		}
+		//! Returns the node of every mesh vertex
+		inline const std::vector<uint32_t>& GetVertexNodes() const
+		{
+			return _vertexNodes;
+		}
+		//! Returns the position of every node, the one of its first mesh vertex
+		inline const std::vector<glm::vec3>& GetNodePositions() const
+		{
+			return _nodePositions;
+		}
+	private:
+		std::vector<uint32_t> _offsets, _neighbors;
+		std::vector<float> _lengths, _slopes;
+		std::vector<uint32_t> _vertexNodes;
+		std::vector<glm::vec3> _nodePositions;
+	};
+
+};
+
+#endif //! end of MeshGraph.hpp
@@ -0,0 +1,120 @@
+#ifndef OCCLUSION_CULLER_HPP
+#define OCCLUSION_CULLER_HPP
+
+#include <GL3/BoundingBox.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace GL3 {
+
+	class Mesh;
+
+	//! Per frame counters of the occlusion culler
+	struct OcclusionStatistics
+	{
+		size_t numOccluders;
+		size_t numOccluderTriangles;
+		size_t numTested;
+		size_t numFrustumCulled;
+		size_t numOcclusionCulled;
+		//! Milliseconds spent in the occluder rasterization, the pyramid build and the box tests
+		double rasterizeTime;
+		double pyramidTime;
+		double testTime;
+		//! Returns the fraction of tested objects that were culled
+		inline double GetCulledRatio() const
+		{
+			return numTested ? static_cast<double>(numFrustumCulled + numOcclusionCulled) / numTested : 0.0;
+		}
+		//! Returns the total culling cost of the frame in milliseconds
+		inline double GetTotalTime() const
+		{
+			return rasterizeTime + pyramidTime + testTime;
+		}
+	};
+
+	//! Hierarchical-Z occlusion culling on the CPU.
+	//! A few simplified occluders (low poly proxies of walls, terrain and large buildings) are rasterized
+	//! with SIMD into a low resolution depth buffer that keeps the nearest occluder depth per pixel.
+	//! Every pyramid level then stores the farthest depth of its 2x2 children, so a box whose nearest
+	//! point is behind the pyramid texels covering its screen rectangle is hidden.
+	class OcclusionCuller
+	{
+	public:
+		//! Rows of the depth buffer rasterized by a single job
+		static constexpr int BAND_HEIGHT = 16;
+		//! Default constructor
+		OcclusionCuller();
+		//! Default destructor
+		~OcclusionCuller();
+		//! Allocate the depth pyramid, a quarter of the window resolution is usually enough.
+		bool Initialize(int width, int height);
+		//! Occluders covering less than minScreenArea of the screen are skipped, and no more occluders
+		//! are accepted once maxTriangles have been queued in a frame.
+		void SetOccluderBudget(size_t maxTriangles, float minScreenArea);
+		//! Start a new frame with the given camera, drops the occluders and the statistics.
+		void BeginFrame(const glm::mat4& view, const glm::mat4& projection);
+		//! Queue an occluder, returns false when the budget rejected it.
+		bool AddOccluder(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices, const glm::mat4& model);
+		bool AddOccluder(const Mesh& mesh, const glm::mat4& model);
+		//! Rasterize the queued occluders and build the depth pyramid.
+		void RenderOccluders();
+		//! Returns whether any part of the world space box may be visible.
+		bool IsVisible(const BoundingBox& box) const;
+		//! Test the world space boxes on the job system, visibility receives 1 for visible boxes.
+		//! Returns the number of culled boxes.
+		size_t CullBoxes(const std::vector<BoundingBox>& boxes, std::vector<uint8_t>& visibility);
+		//! Returns the counters of the current frame
+		inline const OcclusionStatistics& GetStatistics() const
+		{
+			return _statistics;
+		}
+		//! Returns the depth of the given pyramid level, level 0 has GetPitch() floats per row
+		inline const std::vector<float>& GetDepthLevel(size_t level) const
+		{
+			return _levels[level].depth;
+		}
+		inline size_t GetNumLevels() const
+		{
+			return _levels.size();
+		}
+		inline int GetPitch() const
+		{
+			return _levels.empty() ? 0 : _levels[0].pitch;
+		}
+	private:
+		//! One level of the depth pyramid
+		struct DepthLevel
+		{
+			std::vector<float> depth;
+			int width, height, pitch;
+		};
+		//! Screen space occluder triangle with edge functions positive inside and a depth plane
+		struct OccluderTriangle
+		{
+			float edgeA[3], edgeB[3], edgeC[3];
+			float depthA, depthB, depthC;
+			int minX, minY, maxX, maxY;
+		};
+		//! Rasterize the triangles overlapping rows [minY, maxY].
+		void RasterizeBand(int minY, int maxY);
+		//! Returns 0 when the box is visible, 1 when it is outside the frustum and 2 when it is occluded.
+		int TestBox(const BoundingBox& box) const;
+
+		std::vector<DepthLevel> _levels;
+		std::vector<OccluderTriangle> _triangles;
+		//! Scratch clip space positions of the occluder being added
+		std::vector<glm::vec4> _clipPositions;
+		glm::mat4 _viewProjection;
+		OcclusionStatistics _statistics;
+		size_t _maxOccluderTriangles;
+		float _minOccluderArea;
+		int _width, _height;
+	};
+
+};
+
+#endif //! end of OcclusionCuller.hpp
@@ -0,0 +1,87 @@
+#ifndef PERFORMANCE_OVERLAY_HPP
+#define PERFORMANCE_OVERLAY_HPP
+
+#include <GL3/FrameStatistics.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+struct GLFWwindow;
+
+namespace GL3 {
+
+	class QualityController;
+
+	//! In-app ImGui window with rolling graphs of the frame timings, simulation rate, draw and bind
+	//! counts, resident memory, job system occupancy and the occlusion culling ratio and cost. F1 toggles it.
+	//! Record() only writes one sample into fixed ring buffers, the ImGui frame and the memory query
+	//! are skipped while the overlay is hidden.
+	class PerformanceOverlay
+	{
+	public:
+		//! Number of frames kept in the rolling graphs
+		static constexpr size_t HISTORY_SIZE = 240;
+		//! Buckets of the frame time histogram
+		static constexpr size_t NUM_HISTOGRAM_BINS = 32;
+		//! Default constructor
+		PerformanceOverlay();
+		//! Default destructor
+		~PerformanceOverlay();
+		//! Create the ImGui context and the GLFW and OpenGL backends for the window.
+		bool Initialize(GLFWwindow* window);
+		//! Toggle the overlay on a F1 press, call once per frame before drawing.
+		void ProcessInput();
+		//! Store the timings in milliseconds and the frame counters of FrameStatistics.
+		void Record(double cpuFrameTime, double gpuFrameTime, double geometryTime);
+		//! Draw the overlay into the bound framebuffer when it is visible.
+		void Draw(const QualityController& qualityController);
+		//! Destroy the ImGui backends and context
+		void CleanUp();
+		inline void SetVisible(bool bVisible)
+		{
+			_bVisible = bVisible;
+		}
+		inline bool IsVisible() const
+		{
+			return _bVisible;
+		}
+	private:
+		//! Fixed size history of one metric, PlotLines reads it starting at the oldest sample
+		struct History
+		{
+			std::array<float, HISTORY_SIZE> values;
+			//! Statistics over the first count samples
+			float Average(size_t count) const;
+			float Maximum(size_t count) const;
+		};
+		enum Series
+		{
+			CPUFrameTime = 0,
+			GPUFrameTime = 1,
+			GeometryTime = 2,
+			SimulationRate = 3,
+			DrawCalls = 4,
+			Binds = 5,
+			ResidentMemory = 6,
+			JobOccupancy = 7,
+			PooledAllocations = 8,
+			CulledRatio = 9,
+			CullTime = 10,
+			NumSeries = 11,
+		};
+
+		std::array<History, NumSeries> _history;
+		std::chrono::steady_clock::time_point _lastRecordTime;
+		GLFWwindow* _window;
+		size_t _cursor;
+		size_t _numSamples;
+		uint64_t _lastBusyTime;
+		float _residentMemory;
+		bool _bInitialized;
+		bool _bVisible;
+		bool _bToggleKeyDown;
+	};
+
+};
+
+#endif //! end of PerformanceOverlay.hpp
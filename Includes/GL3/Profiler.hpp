@@ -0,0 +1,133 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace GL3 {
+
+	//! Hardware events sampled around profile scopes
+	enum class HardwareCounter
+	{
+		Cycles = 0,
+		Instructions = 1,
+		CacheMisses = 2,
+		BranchMisses = 3,
+	};
+	constexpr size_t NUM_HARDWARE_COUNTERS = 4;
+
+	//! Accumulated timings and counters of one named scope
+	struct ScopeStatistics
+	{
+		size_t numCalls;
+		//! Inclusive wall time in milliseconds
+		double totalTime;
+		double maxTime;
+		//! Work items (grid cells, pixels, triangles) the scope reported
+		uint64_t numCells;
+		uint64_t counters[NUM_HARDWARE_COUNTERS];
+		bool bHasCounters;
+		//! Returns instructions per cycle, zero without counters
+		double GetIPC() const;
+		//! Returns the last level cache miss traffic per work item in bytes, zero without counters or cells
+		double GetBytesPerCell() const;
+	};
+
+	//! Named scope timings with optional hardware counters through perf_event_open.
+	//! Counters are opened per registered thread (the caller of EnableHardwareCounters() and the job
+	//! system workers) and a scope on a non worker thread sums them over all threads, so the jobs it
+	//! dispatches are included. Scopes inside jobs only record time. Where the counters can not be
+	//! opened (other platforms, restricted kernels, virtual machines without a PMU) the scopes keep
+	//! timing and the reports leave the counter columns out.
+	class Profiler
+	{
+	public:
+		//! Cache line size used to turn misses into bytes
+		static constexpr size_t CACHE_LINE_SIZE = 64;
+		//! Returns the process-wide profiler instance
+		static Profiler& GetInstance();
+		//! Default destructor
+		~Profiler();
+		//! Open the counters for the registered threads, returns false when they are unavailable.
+		bool EnableHardwareCounters();
+		inline bool HasHardwareCounters() const
+		{
+			return _bCountersEnabled;
+		}
+		//! Make the calling thread part of the counter group sums, workers mark their scopes time only.
+		void RegisterCurrentThread(bool bWorker);
+		//! Keep every scope instance for WriteTrace()
+		void SetTracing(bool bTracing);
+		//! Write the recorded scope instances as a Chrome trace event file with the counters as arguments.
+		bool WriteTrace(const std::string& path) const;
+		//! Write the accumulated statistics of every scope as a table
+		void Report(std::ostream& stream) const;
+		//! Returns a copy of the accumulated statistics by scope name
+		std::unordered_map<std::string, ScopeStatistics> GetStatistics() const;
+		//! Drop the statistics and the trace
+		void Reset();
+	private:
+		friend class ProfileScope;
+		//! One recorded scope instance of the trace
+		struct TraceEvent
+		{
+			const char* name;
+			uint64_t threadId;
+			double startTime, duration;
+			uint64_t numCells;
+			uint64_t counters[NUM_HARDWARE_COUNTERS];
+			bool bHasCounters;
+		};
+		//! perf_event group of one thread, the leader counts cycles
+		struct CounterGroup
+		{
+			uint64_t threadId;
+			int fds[NUM_HARDWARE_COUNTERS];
+		};
+		//! Default constructor
+		Profiler();
+		//! Open the counter group of the thread, returns false when any event is refused.
+		bool OpenCounterGroup(CounterGroup& group);
+		//! Sum the counters of all groups, returns false when counters are disabled or on worker threads.
+		bool ReadCounters(uint64_t* values) const;
+		//! Accumulate one finished scope
+		void Record(const char* name, double startTime, double duration, uint64_t numCells, const uint64_t* counters, bool bHasCounters);
+
+		mutable std::mutex _mutex;
+		std::unordered_map<std::string, ScopeStatistics> _statistics;
+		std::vector<TraceEvent> _trace;
+		std::vector<CounterGroup> _groups;
+		std::vector<uint64_t> _registeredThreads;
+		std::chrono::steady_clock::time_point _startTime;
+		std::atomic<bool> _bCountersEnabled;
+		bool _bTracing;
+	};
+
+	//! Times the enclosing block under the given name, the name must outlive the profiler (a literal).
+	class ProfileScope
+	{
+	public:
+		//! Start the scope, numCells is the work handled for the bytes per cell metric
+		explicit ProfileScope(const char* name, uint64_t numCells = 0);
+		//! Finish and record the scope
+		~ProfileScope();
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	private:
+		const char* _name;
+		uint64_t _numCells;
+		std::chrono::steady_clock::time_point _startTime;
+		uint64_t _startCounters[NUM_HARDWARE_COUNTERS];
+		bool _bHasCounters;
+	};
+
+};
+
+#endif //! end of Profiler.hpp
@@ -0,0 +1,123 @@
+#ifndef QUALITY_CONTROLLER_HPP
+#define QUALITY_CONTROLLER_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace GL3 {
+
+	//! Scalable quality knobs the applications read every frame
+	struct QualitySettings
+	{
+		//! Offscreen render resolution as a fraction of the window extent per axis
+		float renderScale;
+		//! Fraction of the full particle budget that gets spawned
+		float particleScale;
+		//! Distance beyond which vegetation is drawn as impostors
+		float impostorDistance;
+	};
+
+	//! Knob changed by a controller decision
+	enum class QualityKnob
+	{
+		None = 0,
+		RenderScale = 1,
+		ParticleScale = 2,
+		ImpostorDistance = 3,
+	};
+
+	//! One step taken by the controller
+	struct QualityDecision
+	{
+		size_t frame;
+		QualityKnob knob;
+		float oldValue, newValue;
+		//! Smoothed CPU and GPU frame times in milliseconds that triggered the step
+		double cpuTime, gpuTime;
+	};
+
+	//! Holds a target frame time by trading quality for speed.
+	//! The CPU and GPU frame times are smoothed and the slower one decides which knob moves, the GPU
+	//! bound frames lower the render scale first and the CPU bound frames lower the particle count first.
+	//! The render scale does not relieve the CPU, so once the CPU knobs are exhausted the quality stays and
+	//! the controller reports the frames as CPU bound. Knobs with an equal minimum and maximum are pinned
+	//! and never step.
+	//! Oscillation is avoided by a dead band around the target, by requiring many more frames under
+	//! budget than over budget before stepping, by smaller upgrade steps and by a cool down after each step.
+	class QualityController
+	{
+	public:
+		//! Consecutive frames over or under budget needed before a step
+		static constexpr size_t DEGRADE_FRAMES = 8;
+		static constexpr size_t UPGRADE_FRAMES = 60;
+		//! Frames after a step during which the controller only observes
+		static constexpr size_t COOLDOWN_FRAMES = 30;
+		//! Default constructor
+		QualityController();
+		//! Default destructor
+		~QualityController();
+		//! Set the target frame time in milliseconds and the range of every knob, starts at maximum quality.
+		void Initialize(double targetFrameTime, const QualitySettings& minimum, const QualitySettings& maximum);
+		//! Disabled controllers keep the maximum quality
+		void SetEnabled(bool bEnabled);
+		inline bool IsEnabled() const
+		{
+			return _bEnabled;
+		}
+		//! Feed the timings of the last frame in milliseconds, returns true when the settings changed.
+		bool Update(double cpuTime, double gpuTime);
+		//! Returns the current settings
+		inline const QualitySettings& GetSettings() const
+		{
+			return _settings;
+		}
+		//! Returns the last step taken, knob is None before the first step
+		inline const QualityDecision& GetLastDecision() const
+		{
+			return _lastDecision;
+		}
+		inline size_t GetNumDecisions() const
+		{
+			return _numDecisions;
+		}
+		//! Returns true while the frames are over budget on the CPU and no CPU knob is left to degrade
+		inline bool IsCPUBound() const
+		{
+			return _bCPUBound;
+		}
+		//! Returns the smoothed timings in milliseconds
+		inline double GetSmoothedCPUTime() const
+		{
+			return _cpuTime;
+		}
+		inline double GetSmoothedGPUTime() const
+		{
+			return _gpuTime;
+		}
+		inline double GetTargetFrameTime() const
+		{
+			return _targetFrameTime;
+		}
+		//! Returns a one line summary of the settings and the last decision for the stats output
+		std::string GetDescription() const;
+	private:
+		//! Move one knob towards lower or higher quality, returns false when every candidate is at its limit.
+		bool Step(bool bDegrade, double frameTime);
+
+		QualitySettings _settings;
+		QualitySettings _minimum;
+		QualitySettings _maximum;
+		QualityDecision _lastDecision;
+		double _targetFrameTime;
+		double _cpuTime, _gpuTime;
+		size_t _frame;
+		size_t _overBudgetFrames, _underBudgetFrames;
+		size_t _cooldown;
+		size_t _numDecisions;
+		bool _bEnabled;
+		bool _bCPUBound;
+	};
+
+};
+
+#endif //! end of QualityController.hpp
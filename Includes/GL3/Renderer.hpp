@@ -6,6 +6,9 @@
 #include <string>
 #include <unordered_map>
 #include <GL3/GLTypes.hpp>
+#include <GL3/PerformanceOverlay.hpp>
+#include <GL3/QualityController.hpp>
+#include <glm/vec2.hpp>
 #include <cxxopts/cxxopts.hpp>
 
 namespace GL3
@@ -39,6 +42,11 @@ namespace GL3
 		//! Switch the current app to the next given application
 		void SwitchApplication(std::shared_ptr< GL3::Application > app);
 		void SwitchApplication(size_t index);
+		//! Returns the adaptive quality controller
+		inline QualityController& GetQualityController()
+		{
+			return _qualityController;
+		}
 	protected:
 		virtual bool OnInitialize(const cxxopts::ParseResult& configure) = 0;
 		virtual void OnCleanUp() = 0;
@@ -51,6 +59,11 @@ namespace GL3
 		void BeginGPUMeasure();
 		//! End of GPU Time measurement and returns elapsed time
 		size_t EndGPUMeasure();
+		//! Begin and end the GPU timing of the presented frame, read back one frame later without stalling.
+		void BeginFrameMeasure();
+		void EndFrameMeasure();
+		//! Resize the offscreen target the frame is rendered into when the render scale is below one.
+		bool ResizeOffscreenTarget(const glm::ivec2& extent);
 
 		std::weak_ptr< GL3::Application > _currentApp;
 		std::vector< std::shared_ptr< GL3::Application > > _applications;
@@ -62,7 +75,21 @@ namespace GL3
 		//!Process the mouse cursor positions
 		void ProcessCursorPos(double xpos, double ypos);
 
+		QualityController _qualityController;
+		PerformanceOverlay _overlay;
 		GLuint _queryID;
+		GLuint _frameQueryIDs[2];
+		GLuint _offscreenFramebuffer;
+		GLuint _offscreenColor;
+		GLuint _offscreenDepth;
+		glm::ivec2 _offscreenExtent;
+		size_t _offscreenBytes;
+		size_t _frameIndex;
+		//! Milliseconds of the last geometry pass, frame on the GPU and update plus draw on the CPU
+		double _geometryTime;
+		double _gpuFrameTime;
+		double _cpuUpdateTime;
+		double _cpuFrameTime;
 		bool _bMeasureGPUTime;
 	};
 };
@@ -0,0 +1,10 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+//! SSE2 is the baseline of every x64 target, the scalar paths stay for other architectures.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define GL3_USE_SSE2
+	#include <emmintrin.h>
+#endif
+
+#endif //! end of SIMD.hpp
@@ -0,0 +1,56 @@
+#ifndef SCENE_COMPONENTS_HPP
+#define SCENE_COMPONENTS_HPP
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdint>
+
+namespace GL3 {
+
+	//! Local placement of a scene object
+	struct TransformComponent
+	{
+		glm::vec3 position;
+		glm::quat rotation;
+		glm::vec3 scale;
+		//! Returns translation * rotation * scale
+		inline glm::mat4 GetMatrix() const
+		{
+			return glm::scale(glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(rotation), scale);
+		}
+	};
+
+	//! Mesh and material an object is drawn with, indices into the application resource tables
+	struct RenderMeshComponent
+	{
+		uint32_t mesh;
+		uint32_t material;
+	};
+
+	//! Link of an object (tree, structure) to its fire grid cell and the state mirrored from it
+	struct FireStateComponent
+	{
+		uint32_t cell;
+		float intensity;
+		uint8_t state;
+	};
+
+	//! Node of an object placed through a TransformHierarchy, which owns its local and world matrices
+	struct HierarchyComponent
+	{
+		uint32_t node;
+	};
+
+	//! World space bounds and the visibility the culling pass wrote last
+	struct CullingComponent
+	{
+		glm::vec3 lowerCorner;
+		glm::vec3 upperCorner;
+		uint8_t bVisible;
+	};
+
+};
+
+#endif //! end of SceneComponents.hpp
@@ -1,6 +1,10 @@
 #ifndef SHADER_IMPL_HPP
 #define SHADER_IMPL_HPP
 
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
 namespace GL3 {
 
 	template <typename Type>
@@ -8,6 +12,19 @@ namespace GL3 {
 	{
 		static_assert("No implementation exists");
 	}
+
+	//! Specializations implemented in Shader.cpp, declared here so other translation units
+	//! link against them instead of instantiating the empty primary template.
+	template <>
+	void Shader::SendUniformVariable(const std::string& name, int&& val);
+	template <>
+	void Shader::SendUniformVariable(const std::string& name, float&& val);
+	template <>
+	void Shader::SendUniformVariable(const std::string& name, glm::vec3&& val);
+	template <>
+	void Shader::SendUniformVariable(const std::string& name, glm::vec4&& val);
+	template <>
+	void Shader::SendUniformVariable(const std::string& name, glm::mat4&& val);
 };
 
 #endif //! end of Shader-Impl.hpp
\ No newline at end of file
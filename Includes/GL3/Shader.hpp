@@ -36,6 +36,7 @@ namespace GL3 {
 	private:
 		std::unordered_map<std::string, GLint> _uniformCache;
 		GLuint _programID;
+		size_t _programBytes;
 	};
 
 };
@@ -0,0 +1,86 @@
+#ifndef SMOKE_VOLUME_RENDERER_HPP
+#define SMOKE_VOLUME_RENDERER_HPP
+
+#include <GL3/GLTypes.hpp>
+#include <GL3/BoundingBox.hpp>
+#include <GL3/Texture.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <memory>
+#include <vector>
+
+typedef struct __GLsync *GLsync;
+
+namespace GL3 {
+
+	class Shader;
+
+	//! Emission-absorption ray marcher for the smoke concentration volume.
+	//! Every update builds a coarse brick grid of max concentrations, rays jump over empty bricks
+	//! and stop once the accumulated opacity saturates. The CPU path needs no GL context, only its
+	//! trilinear lookup of four samples is SSE2, the march itself is scalar per ray. RenderGL() is
+	//! not drawn by the sample yet, gl3-bench --report smoke measures the CPU path.
+	class SmokeVolumeRenderer
+	{
+	public:
+		//! Edge length of an occupancy brick in voxels
+		static constexpr int BRICK_SIZE = 8;
+		//! Sample counters in flight, RenderGL() reads a counter back once the GPU is done with it
+		static constexpr int NUM_STATS_BUFFERS = 3;
+		//! Default constructor
+		SmokeVolumeRenderer();
+		//! Default destructor
+		~SmokeVolumeRenderer();
+		//! Create the GL resources of the fragment path with the smoke_vertex / smoke_fragment program.
+		bool InitializeGL(std::shared_ptr<Shader> shader);
+		//! Set the world space box the volume is stretched over
+		void SetVolumeBounds(const BoundingBox& bounds);
+		//! Set the extinction per unit concentration per meter and the occupancy cutoff
+		void SetDensityScale(float densityScale, float occupancyThreshold);
+		//! Copy the concentration field, rebuild the occupancy bricks and upload both when GL is initialized.
+		void UpdateVolume(const float* density, const glm::ivec3& extent);
+		//! Ray march on the CPU into premultiplied RGBA8 pixels, rows top to bottom.
+		void RenderCPU(const glm::mat4& view, const glm::mat4& projection, int width, int height, std::vector<unsigned char>& pixels);
+		//! Ray march in the fragment shader over the current framebuffer with premultiplied blending.
+		void RenderGL(const glm::mat4& view, const glm::mat4& projection, int width, int height);
+		//! Returns the average number of density samples per pixel of the last render, on the GL path
+		//! of the last render whose counter the GPU finished, up to NUM_STATS_BUFFERS - 1 frames ago
+		inline float GetSamplesPerPixel() const
+		{
+			return _samplesPerPixel;
+		}
+		//! Returns the fraction of bricks that need sampling
+		float GetOccupiedBrickRatio() const;
+		//! Clean up the generated resources
+		void CleanUp();
+	private:
+		//! Ray march a single pixel, returns premultiplied RGBA and adds the taken samples.
+		glm::vec4 MarchRay(const glm::vec3& origin, const glm::vec3& direction, size_t& numSamples) const;
+		//! Trilinear density at four grid space positions
+		void SampleDensity4(const float* gx, const float* gy, const float* gz, float* result) const;
+
+		std::vector<float> _density;
+		std::vector<float> _brickMax;
+		std::shared_ptr<Shader> _shader;
+		Texture _densityTexture;
+		Texture _occupancyTexture;
+		BoundingBox _bounds;
+		glm::ivec3 _extent;
+		glm::ivec3 _brickExtent;
+		glm::vec3 _smokeAlbedo;
+		float _densityScale;
+		float _occupancyThreshold;
+		float _stepSize;
+		float _samplesPerPixel;
+		GLuint _vao;
+		//! Ring of sample counters with the fence of the render writing each and its pixel count
+		GLuint _statsBuffers[NUM_STATS_BUFFERS];
+		GLsync _statsFences[NUM_STATS_BUFFERS];
+		int _statsPixels[NUM_STATS_BUFFERS];
+		int _statsIndex;
+		bool _bGLInitialized;
+	};
+
+};
+
+#endif //! end of SmokeVolumeRenderer.hpp
@@ -0,0 +1,113 @@
+#ifndef SOFTWARE_RASTERIZER_HPP
+#define SOFTWARE_RASTERIZER_HPP
+
+#include <GL3/DrawBackend.hpp>
+#include <glm/vec3.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace GL3 {
+
+	class Camera;
+
+	//! Tile based CPU rasterizer for machines without a GPU.
+	//! DrawMesh() runs the vertex stage of vertex.glsl and bins the clipped triangles into screen tiles,
+	//! Flush() rasterizes every tile on the job system with SIMD edge functions and a depth test and
+	//! shades the fragments like clustered_output.glsl. The framebuffer follows the GL convention, row 0 is the bottom.
+	class SoftwareRasterizer : public DrawBackend
+	{
+	public:
+		//! Edge length of a screen tile in pixels
+		static constexpr int TILE_SIZE = 64;
+		//! Default constructor
+		SoftwareRasterizer();
+		//! Default destructor
+		~SoftwareRasterizer();
+		//! Allocate the color and depth buffers
+		bool Initialize(int width, int height);
+		//! Clear the color and depth buffers and drop the queued draws
+		void Clear(const glm::vec4& color, float depth = 1.0f) override;
+		//! Take the view and projection of the camera, UpdateMatrix() does not need a GL context.
+		void SetCamera(Camera& camera);
+		void SetCamera(const glm::mat4& view, const glm::mat4& projection) override;
+		//! Shade with the cluster light lists of the culler like clustered_output.glsl, nullptr leaves the ambient term.
+		void SetLighting(const ClusteredLightCuller* culler) override;
+		//! Transform, clip and bin the triangles of the mesh, the mesh must stay alive until Flush().
+		void DrawMesh(const Mesh& mesh, const glm::mat4& model) override;
+		//! Rasterize and shade the queued draws into the framebuffer.
+		void Flush() override;
+		//! Returns the RGBA8 color buffer, rows from bottom to top
+		inline const std::vector<uint8_t>& GetColorBuffer() const
+		{
+			return _color;
+		}
+		//! Returns the window space depth buffer with GetPitch() floats per row
+		inline const std::vector<float>& GetDepthBuffer() const
+		{
+			return _depth;
+		}
+		inline int GetPitch() const
+		{
+			return _pitch;
+		}
+		//! Returns the number of fragments shaded since the last Clear()
+		inline size_t GetNumShadedFragments() const
+		{
+			return _numShadedFragments;
+		}
+		//! Write the color buffer as an uncompressed 32 bit TGA image
+		bool WriteImage(const std::string& path) const;
+	private:
+		//! Clip space output of the vertex stage
+		struct ClipVertex
+		{
+			glm::vec4 position;
+			glm::vec3 worldPos;
+			glm::vec3 normal;
+		};
+		//! Screen space triangle ready for the edge function walk
+		struct SetupTriangle
+		{
+			//! Edge functions opposite each vertex as a * x + b * y + c, positive inside
+			float edgeA[3], edgeB[3], edgeC[3];
+			float inverseArea;
+			//! Window space depth and 1 / w per vertex
+			float depth[3];
+			float inverseW[3];
+			glm::vec3 worldPos[3];
+			glm::vec3 normal[3];
+			int minX, minY, maxX, maxY;
+		};
+		//! Triangles of one DrawMesh() call, binned per tile as offsets into tileTriangles
+		struct DrawBatch
+		{
+			std::vector<SetupTriangle> triangles;
+			std::vector<uint32_t> tileOffsets;
+			std::vector<uint32_t> tileTriangles;
+		};
+		//! Clip against the near plane and append the resulting screen space triangles.
+		void SetupTriangles(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, std::vector<SetupTriangle>& triangles) const;
+		//! Rasterize one triangle inside the tile bounds.
+		size_t RasterizeTriangle(const SetupTriangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+		//! Fragment stage of clustered_output.glsl
+		glm::vec3 ShadeFragment(const glm::vec3& worldPos, const glm::vec3& normal, float fragX, float fragY) const;
+
+		std::vector<uint8_t> _color;
+		std::vector<float> _depth;
+		std::vector<DrawBatch> _batches;
+		//! Scratch of DrawMesh() and Flush(), kept to reuse the capacity
+		std::vector<ClipVertex> _clipVertices;
+		std::vector<uint32_t> _tileCursor;
+		std::vector<size_t> _tileFragments;
+		glm::mat4 _view;
+		glm::mat4 _projection;
+		const ClusteredLightCuller* _culler;
+		int _width, _height, _pitch;
+		int _tilesX, _tilesY;
+		size_t _numShadedFragments;
+	};
+
+};
+
+#endif //! end of SoftwareRasterizer.hpp
@@ -17,15 +17,26 @@ namespace GL3 {
 		void Initialize(GLenum target);
 		//! Upload the texel data to the GPU memory
 		void UploadTexture(void* data, int width, int height, GLenum format, GLenum internalFormat, GLenum type);
+		//! Upload the volume texel data to the GPU memory
+		void UploadTexture3D(const void* data, int width, int height, int depth, GLenum format, GLenum internalFormat, GLenum type);
 		//! Bind generated texture.
 		void BindTexture(GLuint slot) const;
 		//! Unbind texture with current bound slot
 		void UnbindTexture() const;
+		//! Returns the GPU bytes of the uploaded texels including the mipmap chain
+		inline size_t GetNumBytes() const
+		{
+			return _numBytes;
+		}
 		//! Clean up the generated resources
 		void CleanUp();
 	private:
+		//! Replace the accounted GPU bytes with the new level zero extent
+		void AccountTexels(GLenum internalFormat, int width, int height, int depth);
+
 		GLenum _target;
 		GLuint _textureID;
+		size_t _numBytes;
 	};
 
 };
@@ -0,0 +1,83 @@
+#ifndef TRANSFORM_HIERARCHY_HPP
+#define TRANSFORM_HIERARCHY_HPP
+
+#include <GL3/SceneComponents.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace GL3 {
+
+	//! Scene graph flattened into breadth-first ordered arrays.
+	//! Nodes are stored level by level, so every parent precedes its children and a level can be
+	//! computed in parallel once the previous one is done. SetLocal() only flags the node, Update()
+	//! spreads the flags down the levels and recomputes the world matrices of the dirty subtrees in
+	//! gathered batches with SIMD products, optionally streaming them into a mapped instance buffer.
+	//! Handles stay valid when Add() reorders the arrays, the instance index of a node may change.
+	class TransformHierarchy
+	{
+	public:
+		using Handle = uint32_t;
+		static constexpr Handle NO_PARENT = 0xFFFFFFFFu;
+		//! Nodes of one Update() job
+		static constexpr size_t NODES_PER_JOB = 2048;
+		//! Default constructor
+		TransformHierarchy();
+		//! Default destructor
+		~TransformHierarchy();
+		//! Add a node below parent, or a root for NO_PARENT, the arrays are reordered on the next Update()
+		Handle Add(const TransformComponent& local, Handle parent = NO_PARENT);
+		//! Replace the local transform and flag the subtree for the next Update()
+		void SetLocal(Handle node, const TransformComponent& local);
+		//! Remove every node
+		void Clear();
+		//! Recompute the dirty subtrees, returns the number of recomputed nodes.
+		//! When instances is given every recomputed world matrix is also written to
+		//! instances[GetInstanceIndex(node)], all of them after a reorder, with streaming stores
+		//! when the destination is 16 byte aligned so write-combined mapped memory is not read back.
+		size_t Update(glm::mat4* instances = nullptr);
+		inline const TransformComponent& GetLocal(Handle node) const
+		{
+			return _local[_slots[node]];
+		}
+		//! Returns the world matrix of the last Update()
+		inline const glm::mat4& GetWorld(Handle node) const
+		{
+			return _world[_slots[node]];
+		}
+		//! Returns the breadth-first position of the node, its row in the instance buffer
+		inline uint32_t GetInstanceIndex(Handle node) const
+		{
+			return _slots[node];
+		}
+		inline size_t GetNumNodes() const
+		{
+			return _slots.size();
+		}
+		//! Returns the depth of the deepest node plus one
+		inline size_t GetNumLevels() const
+		{
+			return _levelBegin.empty() ? 0 : _levelBegin.size() - 1;
+		}
+	private:
+		//! Sort the nodes by depth, keeping the handle order within a level
+		void Reorder();
+
+		//! Per handle, the slot and parent handle and depth used by Reorder()
+		std::vector<uint32_t> _slots;
+		std::vector<Handle> _parentHandles;
+		std::vector<uint32_t> _depths;
+		//! Per slot in breadth-first order
+		std::vector<uint32_t> _parentSlots;
+		std::vector<TransformComponent> _local;
+		std::vector<glm::mat4> _world;
+		std::vector<uint8_t> _dirty;
+		//! First slot of every level, one more entry than levels
+		std::vector<uint32_t> _levelBegin;
+		//! Nodes flagged since the last Update(), zero skips the level walk
+		size_t _numDirty;
+		bool _bReorder;
+	};
+
+};
+
+#endif //! end of TransformHierarchy.hpp
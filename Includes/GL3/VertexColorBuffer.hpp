@@ -0,0 +1,49 @@
+#ifndef VERTEX_COLOR_BUFFER_HPP
+#define VERTEX_COLOR_BUFFER_HPP
+
+#include <GL3/MappedRingBuffer.hpp>
+#include <cstdint>
+
+namespace GL3 {
+
+	//! Persistently mapped buffer of per vertex RGBA8 colors, bound to the vertex attribute
+	//! Mesh::COLOR_ATTRIBUTE by Mesh::DrawColored(). Simulations write the colors of the mesh
+	//! vertices straight into the mapping every frame, e.g. through MeshFireSpread::WriteColors(),
+	//! and EndFrame() fences the draws reading them, ring buffered like InstanceBuffer.
+	class VertexColorBuffer
+	{
+	public:
+		//! Default constructor
+		VertexColorBuffer();
+		//! Default destructor
+		~VertexColorBuffer();
+		//! Create and map storage for capacity colors per frame, replaces the previous buffer
+		bool Initialize(size_t capacity);
+		//! Wait until the GPU is done with the next region and returns its mapped colors,
+		//! red in the lowest byte
+		uint32_t* BeginWrite();
+		//! Fence the draws issued since BeginWrite()
+		void EndFrame();
+		//! Clean up the generated resources
+		void CleanUp();
+		inline GLuint GetBufferID() const
+		{
+			return _ring.GetBufferID();
+		}
+		//! Returns the byte offset of the colors written by the last BeginWrite()
+		inline size_t GetOffset() const
+		{
+			return _ring.GetOffset();
+		}
+		inline size_t GetCapacity() const
+		{
+			return _capacity;
+		}
+	private:
+		MappedRingBuffer _ring;
+		size_t _capacity;
+	};
+
+};
+
+#endif //! end of VertexColorBuffer.hpp
@@ -2,6 +2,19 @@
 #define SAMPLE_APP_HPP
 
 #include <GL3/Application.hpp>
+#include <GL3/ClusteredLighting.hpp>
+#include <GL3/GLDrawBackend.hpp>
+#include <GL3/InstanceBuffer.hpp>
+#include <GL3/MeshGraph.hpp>
+#include <GL3/OcclusionCuller.hpp>
+#include <GL3/TransformHierarchy.hpp>
+#include <GL3/VertexColorBuffer.hpp>
+#include <Simulation/MeshFireSpread.hpp>
+
+namespace GL3
+{
+	class Mesh;
+};
 
 class SampleApp : public GL3::Application
 {
@@ -15,6 +28,8 @@ public:
 	{
 		return "Sample Application";
 	}
+	//! Fill lights with the point lights circling the bunny
+	static void CreateLights(std::vector<GL3::PointLight>& lights);
 protected:
 	bool OnInitialize(std::shared_ptr<GL3::Window> window, const cxxopts::ParseResult& configure) override;
 	void OnCleanUp() override;
@@ -23,6 +38,28 @@ protected:
 	void OnProcessInput(unsigned int key) override;
 
 private:
+	//! Meshes the RenderMeshComponent of the scene entities index
+	std::vector< std::shared_ptr<GL3::Mesh> > _meshes;
+	//! Fire spreading over the surface of the first mesh, shown through its vertex colors
+	GL3::Entity _fireEntity;
+	GL3::MeshGraph _meshGraph;
+	Simulation::MeshFireSpread _meshFire;
+	std::vector<float> _spreadRates;
+	GL3::VertexColorBuffer _fireColors;
+	//! Grove of trees below one spinning root, streamed into the instance buffer and drawn instanced
+	GL3::TransformHierarchy _hierarchy;
+	GL3::InstanceBuffer _instances;
+	GL3::TransformHierarchy::Handle _groveNode;
+	size_t _numTrees;
+	double _time;
+	//! The bunny occludes the trees behind it, visibility is indexed by the instance row after the root
+	GL3::OcclusionCuller _culler;
+	std::vector<GL3::BoundingBox> _treeBoxes;
+	std::vector<uint8_t> _treeVisibility;
+	//! Shades with clustered_output.glsl when --clustered-lights is given, the clusters are culled every update
+	GL3::GLDrawBackend _backend;
+	GL3::ClusteredLightCuller _lightCuller;
+	bool _bClusteredLights;
 };
 
 #endif //! end of SampleApp.hpp
\ No newline at end of file
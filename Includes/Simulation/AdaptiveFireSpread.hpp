@@ -0,0 +1,208 @@
+#ifndef ADAPTIVE_FIRE_SPREAD_HPP
+#define ADAPTIVE_FIRE_SPREAD_HPP
+
+#include <Simulation/Landscape.hpp>
+#include <Simulation/TiledFireSpread.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Simulation {
+
+	//! Surface fire spread on block structured adaptive grids over the landscape.
+	//! The landscape is split into the square tiles of TiledFireSpread, a tile of level L splits every
+	//! landscape cell into 2^L x 2^L cells and runs the FireSpread physics on them, with the elevation
+	//! interpolated by Landscape::GetRefinedElevation(). Tiles with fire in or next to them are at
+	//! MAX_LEVEL, neighbor tiles at most one level apart and the rest at level 0, so the fire only ever
+	//! spreads on the finest cells.
+	//! Refinement copies the fuel load and the ignition progress of a cell into its children, coarsening
+	//! averages them, so the fuel and the heat of a tile are kept across level changes. A tile only
+	//! coarsens as far as the children of every cell share their state, so a partly burned tile stays
+	//! refined and the burned area is never rounded away.
+	//! Cells next to a tile of another level see the burning fraction of the area of their neighbor.
+	//! With subcycling Step() splits dt per tile into 2^k substeps, the fewest that keep the ignition
+	//! progress any cell of the tile gains from its burning neighbors and the fuel fraction any of its
+	//! burning cells consumes per substep below COURANT_NUMBER, the bound of FireSpread::SetCourantNumber()
+	//! per tile. Tiles at a wind driven front take small steps, tiles only burning out or waiting for the
+	//! fire large ones. A tile of 2^k substeps advances in the middle round of each of them and reads the
+	//! states its neighbors committed so far. Without subcycling a run matches FireSpread on the refined
+	//! landscape.
+	class AdaptiveFireSpread
+	{
+	public:
+		enum CellState : uint8_t
+		{
+			Unburnable = 0,
+			Unburned,
+			Burning,
+			Burned
+		};
+		//! Edge length of a tile in landscape cells
+		static constexpr int TILE_SIZE = TiledFireSpread::TILE_SIZE;
+		//! Finest level, its cells are 2^MAX_LEVEL times smaller than the landscape cells
+		static constexpr int MAX_LEVEL = 2;
+		//! Most ignition progress a cell may gain from all its burning neighbors together in a substep
+		static constexpr float COURANT_NUMBER = 0.5f;
+		//! A tile splits a step into at most 2^MAX_SUBSTEP_LEVEL substeps
+		static constexpr int MAX_SUBSTEP_LEVEL = 4;
+		//! Substeps of the tile updates since Initialize()
+		struct StepStatistics
+		{
+			//! Step() calls with fire, tile steps and the tile substeps they took
+			uint64_t numSteps;
+			uint64_t numTileSteps;
+			uint64_t numTileSubsteps;
+			//! Tile steps per number of substeps, 2^k substeps count in numTileStepsBySubsteps[k]
+			uint64_t numTileStepsBySubsteps[MAX_SUBSTEP_LEVEL + 1];
+			//! Shortest, longest and summed substep in seconds
+			float minSubstep, maxSubstep;
+			double sumSubsteps;
+		};
+		//! Default constructor
+		AdaptiveFireSpread();
+		//! Default destructor
+		~AdaptiveFireSpread();
+		//! Copy the landscape and reset every tile to level 0
+		bool Initialize(const Landscape& landscape);
+		//! Set the uniform wind in m/s
+		void SetWind(const glm::vec2& wind);
+		//! Split the steps of fast tiles into substeps, off by default
+		void SetSubcycling(bool bEnabled);
+		//! Refine the tile of landscape cell x, y and ignite all the cells it splits into, returns false
+		//! when it is out of range or has no fuel
+		bool Ignite(int x, int y);
+		//! Regrid around the fire, then advance it by dt seconds on the tiles with fire in or next to them,
+		//! each in the substeps its spread rate needs
+		void Step(float dt);
+		//! Write the fraction of the area of every landscape cell that is burning or burned
+		void GetBurnedFraction(std::vector<float>& fraction) const;
+		//! Returns the hash of the tile levels and the cell states
+		uint64_t GetDigest() const;
+		//! Returns the hash of the cell states at MAX_LEVEL, a coarser cell repeating its state over the
+		//! cells it covers, equal to FireSpread::GetDigest() on the refined landscape when both burn alike
+		uint64_t GetRefinedDigest() const;
+		//! Returns the bytes of the landscape copy and every tile
+		size_t GetMemoryBytes() const;
+		//! Returns the level of every tile
+		inline const std::vector<uint8_t>& GetTileLevels() const
+		{
+			return _tileLevel;
+		}
+		inline int GetNumTilesX() const
+		{
+			return _tilesX;
+		}
+		inline int GetNumTilesY() const
+		{
+			return _tilesY;
+		}
+		inline size_t GetNumBurning() const
+		{
+			return _numBurning;
+		}
+		//! Returns the number of cells over all tiles at their current level
+		inline size_t GetNumCells() const
+		{
+			return _numCells;
+		}
+		//! Returns the number of cells Step() visited and of tile level changes since Initialize()
+		inline uint64_t GetNumCellUpdates() const
+		{
+			return _numCellUpdates;
+		}
+		inline uint64_t GetNumRegrids() const
+		{
+			return _numRegrids;
+		}
+		//! Returns the shortest stable step of the tiles the last Step() updated, infinite before the
+		//! first step and without subcycling
+		inline float GetStableTimeStep() const
+		{
+			return _stableTimeStep;
+		}
+		inline const StepStatistics& GetStepStatistics() const
+		{
+			return _statistics;
+		}
+		inline int GetWidth() const
+		{
+			return _landscape.width;
+		}
+		inline int GetHeight() const
+		{
+			return _landscape.height;
+		}
+		//! Returns the edge length of a landscape cell in meters
+		inline float GetCellSize() const
+		{
+			return _landscape.cellSize;
+		}
+		//! Returns the simulated time in seconds
+		inline double GetTime() const
+		{
+			return _time;
+		}
+	private:
+		//! Cells of one tile at its level, row major with x fastest
+		struct Tile
+		{
+			std::vector<uint8_t> state;
+			//! Remaining fuel load in kg/m^2, the full load until the cell burns
+			std::vector<float> fuelLoad;
+			//! Ignition progress, 1 once the cell caught fire
+			std::vector<float> ignition;
+			std::vector<float> elevation;
+			int numBurning;
+			//! Window of the burning cells in cells of the tile, empty (max < min) without burning cells
+			int burningMinX, burningMinY, burningMaxX, burningMaxY;
+			//! x range of the cells the current step visits per row, empty for the rows it skips
+			std::vector<int> rowMinX, rowMaxX;
+			//! Longest substep in seconds the cells in the row ranges take stably, see UpdateStableStep()
+			float stableStep;
+			//! The current step takes 2^substepLevel substeps
+			int substepLevel;
+			//! Coarsest level the cells merge to without mixing states, -1 until GetCoarsestLevel() finds it
+			int coarsestLevel;
+		};
+
+		//! Move a tile to a level, prolongating or restricting its cells
+		void SetTileLevel(int tile, int level);
+		//! Returns the coarsest level a tile restricts to without merging cells of different states
+		int GetCoarsestLevel(int tile);
+		//! Reassign the tile levels from the fire and collect the tiles Step() updates
+		void Regrid();
+		//! Burning fraction and elevation of cell x, y at level, which may lie in a tile of another level
+		float SampleNeighbor(int level, int x, int y, float& elevation) const;
+		//! Grow the burning windows of a tile and its neighbors by one cell into the row ranges of the
+		//! tile, returns the number of cells they cover
+		uint64_t UpdateWindow(int tile);
+		//! Ignition progress per second the burning neighbors give cell x, y of a tile, a neighbor in a
+		//! tile of another level weighted by its burning fraction
+		float GetSummedRate(int tile, int x, int y) const;
+		//! Find the stable step of a tile from its row ranges, COURANT_NUMBER times the shorter of the
+		//! inverse fastest summed rate of its unburned cells and the burn time of its burning cells
+		void UpdateStableStep(int tile);
+		//! Accumulate ignition progress and consume fuel in the row ranges of a tile from the previous states
+		void AdvanceTile(int tile, float dt);
+		//! Apply the ignitions and burnouts in the row ranges of a tile
+		void CommitTile(int tile);
+
+		Landscape _landscape;
+		std::vector<Tile> _tiles;
+		std::vector<uint8_t> _tileLevel, _targetLevel;
+		//! Tiles with fire in or next to them, the only ones Step() visits, the tiles changing level and
+		//! the tiles of a substep round
+		std::vector<int> _activeTiles, _regridTiles, _dueTiles;
+		//! Wind factor per direction, updated by SetWind()
+		float _windFactor[8];
+		StepStatistics _statistics;
+		float _stableTimeStep;
+		bool _bSubcycling;
+		double _time;
+		uint64_t _numCellUpdates, _numRegrids;
+		size_t _numBurning, _numCells;
+		int _tilesX, _tilesY;
+	};
+
+};
+
+#endif //! end of AdaptiveFireSpread.hpp
@@ -0,0 +1,116 @@
+#ifndef CROWN_FIRE_HPP
+#define CROWN_FIRE_HPP
+
+#include <Simulation/Landscape.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Simulation {
+
+	class FireSpread;
+
+	//! Tree crowns above the landscape cells, heights in meters above the ground
+	struct Canopy
+	{
+		//! Crown base and top height of every cell, cells with top <= base have no canopy
+		std::vector<float> baseHeight;
+		std::vector<float> topHeight;
+	};
+
+	//! Crown fire in a bit-packed voxel canopy layered above the surface grid.
+	//! Voxels are one surface cell wide and VOXEL_HEIGHT tall, grouped into bricks of 8x8x8 voxels
+	//! holding one 64-bit word per horizontal slice and per bit plane (fuel, burning, burned), and
+	//! only bricks with canopy are allocated. A surface cell torches the crown above it once its
+	//! intensity passes the Van Wagner critical intensity of the crown base height. A crown step
+	//! then spreads every burning voxel to its horizontal neighbors with 64-bit shifts, skipping the
+	//! upwind side in strong wind, and flames climb the crown above burning voxels within the step.
+	//! Burning voxels burn out after one step and ignite the surface below the crown base.
+	//! Steps run in parallel over the columns of bricks around the burning ones, columns without
+	//! canopy or fire are never visited.
+	class CrownFire
+	{
+	public:
+		//! Edge length of a brick in voxels
+		static constexpr int BRICK_SIZE = 8;
+		//! Voxel height in meters
+		static constexpr float VOXEL_HEIGHT = 2.0f;
+		//! Highest canopy level in voxels, taller crowns are cut
+		static constexpr int MAX_LEVELS = 64;
+		//! Foliar moisture content in percent of the critical intensity
+		static constexpr float FOLIAR_MOISTURE = 100.0f;
+		//! Active crown fire spread rate in m/s, a crown step moves the fire by one cell
+		static constexpr float CROWN_SPREAD_RATE = 0.5f;
+		//! Wind speed in m/s above which crowns no longer burn against the wind
+		static constexpr float UPWIND_LIMIT = 2.0f;
+		//! Default constructor
+		CrownFire();
+		//! Default destructor
+		~CrownFire();
+		//! Voxelize the canopy over the landscape cells and reset the fire
+		bool Initialize(const Landscape& landscape, const Canopy& canopy);
+		//! Set the uniform wind in m/s
+		void SetWind(const glm::vec2& wind);
+		//! Torch the crowns above intense surface fire, run the crown steps due within dt seconds and
+		//! ignite the surface below burning crown bases. Call once per surface step with the same dt.
+		void Step(FireSpread& fire, float dt);
+		//! Returns the hash of the burning and burned voxels
+		uint64_t GetDigest() const;
+		//! Returns the number of burning and burned voxels
+		size_t GetNumBurningVoxels() const;
+		size_t GetNumBurnedVoxels() const;
+		//! Returns whether the voxel at cell (x, y) and level z is burning
+		bool IsBurning(int x, int y, int z) const;
+		//! Returns the bytes of every canopy array
+		size_t GetMemoryBytes() const;
+		//! Returns the number of allocated bricks
+		inline size_t GetNumBricks() const
+		{
+			return _fuel.size() / BRICK_SIZE;
+		}
+		//! Returns the number of brick columns the last crown step visited
+		inline size_t GetNumActiveColumns() const
+		{
+			return _activeColumns.size();
+		}
+		//! Returns the simulated seconds between two crown steps
+		inline float GetStepInterval() const
+		{
+			return _stepInterval;
+		}
+	private:
+		//! Ignite the crown base above surface cells whose intensity reaches their torching intensity
+		void Torch(const FireSpread& fire);
+		//! One crown step over the columns next to burning ones
+		void SpreadCrowns(FireSpread& fire);
+		//! Returns the first slice word of a brick, or -1 when the brick is not allocated
+		inline int32_t GetBrick(int brickX, int brickY, int brickZ) const
+		{
+			if (brickX < 0 || brickY < 0 || brickX >= _bricksX || brickY >= _bricksY)
+				return -1;
+			return _brickIndex[(static_cast<size_t>(brickZ) * _bricksY + brickY) * _bricksX + brickX];
+		}
+
+		//! Bit planes of the allocated bricks, BRICK_SIZE slices each with bit ly * 8 + lx per voxel
+		std::vector<uint64_t> _fuel, _burning, _burned, _nextBurning;
+		//! Slice offset of every brick slot in the planes, -1 for bricks without canopy
+		std::vector<int32_t> _brickIndex;
+		//! Per brick column, the cells with canopy and whether any voxel burns
+		std::vector<uint64_t> _columnCanopy;
+		std::vector<uint8_t> _columnBurning;
+		//! Per brick column, the cells whose crown base burned this step
+		std::vector<uint64_t> _columnDrops;
+		std::vector<uint32_t> _activeColumns;
+		//! Per cell, the lowest canopy level and the surface intensity in kW/m^2 that torches it
+		std::vector<uint8_t> _baseLevel;
+		std::vector<float> _torchingIntensity;
+		//! Horizontal spread directions the wind allows: from west, east, south, north
+		bool _bSpread[4];
+		float _stepInterval;
+		float _timer;
+		int _width, _height;
+		int _bricksX, _bricksY, _bricksZ;
+	};
+
+};
+
+#endif //! end of CrownFire.hpp
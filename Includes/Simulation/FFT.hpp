@@ -0,0 +1,85 @@
+#ifndef FFT_HPP
+#define FFT_HPP
+
+#include <complex>
+#include <vector>
+
+namespace Simulation {
+
+	using Complex = std::complex<float>;
+
+	//! Iterative in-place radix-2 complex FFT for power-of-two sizes.
+	class FFT
+	{
+	public:
+		//! Default constructor
+		FFT();
+		//! Default destructor
+		~FFT();
+		//! Precompute the twiddle factors and the bit reversal permutation.
+		//! \param size : transform length, must be a power of two.
+		bool Initialize(size_t size);
+		//! Forward transform (e^-i convention), unscaled.
+		void Forward(Complex* data) const;
+		//! Inverse transform, scaled by 1 / size.
+		void Inverse(Complex* data) const;
+		//! Returns the transform length
+		inline size_t GetSize() const
+		{
+			return _size;
+		}
+	private:
+		//! Butterfly passes shared by both directions
+		void Transform(Complex* data, bool inverse) const;
+
+		std::vector<Complex> _twiddles;
+		std::vector<unsigned int> _bitReverse;
+		size_t _size;
+	};
+
+	//! Real-to-complex 2D FFT of a width x height real field.
+	//! The spectrum keeps only the non-redundant half, (width / 2 + 1) x height complex values row by row.
+	class RealFFT2D
+	{
+	public:
+		//! Default constructor
+		RealFFT2D();
+		//! Default destructor
+		~RealFFT2D();
+		//! Initialize the transforms, both extents must be powers of two and width at least 2.
+		bool Initialize(size_t width, size_t height);
+		//! Forward transform of width * height reals into the half spectrum.
+		void Forward(const float* input, Complex* spectrum) const;
+		//! Inverse transform of the half spectrum, the spectrum is used as scratch and destroyed.
+		void Inverse(Complex* spectrum, float* output) const;
+		//! Returns the number of complex values in the half spectrum
+		inline size_t GetSpectrumSize() const
+		{
+			return (_width / 2 + 1) * _height;
+		}
+	private:
+		FFT _rowFFT;
+		FFT _columnFFT;
+		//! e^(-2 pi i k / width) for k in [0, width / 2], used to split the packed real rows
+		std::vector<Complex> _realTwiddles;
+		size_t _width, _height;
+	};
+
+	//! Returns whether the given value is a power of two
+	inline bool IsPowerOfTwo(size_t value)
+	{
+		return value != 0 && (value & (value - 1)) == 0;
+	}
+
+	//! Returns the smallest power of two greater or equal to the given value
+	inline size_t NextPowerOfTwo(size_t value)
+	{
+		size_t result = 1;
+		while (result < value)
+			result <<= 1;
+		return result;
+	}
+
+};
+
+#endif //! end of FFT.hpp
@@ -0,0 +1,178 @@
+#ifndef FIRE_SPREAD_HPP
+#define FIRE_SPREAD_HPP
+
+#include <Simulation/Landscape.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Simulation {
+
+	class WeatherInput;
+
+	//! Effect of a suppression action on a cell
+	enum SuppressionType : uint8_t
+	{
+		//! Water or retardant, amount in kg/m^2
+		Wetting = 0,
+		//! Fuel removed down to mineral soil, amount unused
+		Firebreak
+	};
+
+	//! One suppression action queued by the agents for FireSpread::ApplySuppression()
+	struct Suppression
+	{
+		uint32_t cell;
+		uint8_t type;
+		float amount;
+	};
+
+	//! Surface fire spread on the landscape grid.
+	//! Every unburned cell accumulates ignition progress from its 8 burning neighbors at the rate
+	//! R / d, with R the fuel spread rate scaled by wind and upslope factors and d the center distance,
+	//! and ignites once the progress reaches 1. Burning cells consume their fuel over the residence
+	//! time and burn out. A step reads only the previous cell states, so the result does not depend on
+	//! the thread count and a state digest identifies a run.
+	//! By default a step advances by the dt it is given. With a Courant number set, Step() covers dt in
+	//! equal substeps no longer than the stable step, which keeps both the ignition progress a cell
+	//! gains from all its burning neighbors together and the fuel fraction a burning cell consumes
+	//! below the Courant number. A slow fire then takes the whole dt at once and a fast one splits it.
+	class FireSpread
+	{
+	public:
+		enum CellState : uint8_t
+		{
+			Unburnable = 0,
+			Unburned,
+			Burning,
+			Burned
+		};
+		//! Spread rate gain per m/s of wind component along the spread direction
+		static constexpr float WIND_COEFFICIENT = 0.5f;
+		//! Spread rate gain per squared upslope gradient
+		static constexpr float SLOPE_COEFFICIENT = 5.275f;
+		//! Water in kg/m^2 that offsets a full ignition of an unburned cell
+		static constexpr float WATER_PER_IGNITION = 0.5f;
+		//! Default constructor
+		FireSpread();
+		//! Default destructor
+		~FireSpread();
+		//! Copy the fuel, elevation and wind of the landscape and reset every cell
+		bool Initialize(const Landscape& landscape);
+		//! Set the uniform wind in m/s
+		void SetWind(const glm::vec2& wind);
+		//! Take the mean wind of the last WeatherInput::Update() and scale the spread rate of every cell by
+		//! GetMoistureFactor() of the fuel moisture of its humidity and temperature. Returns false when
+		//! the weather grid is not the one of the fire.
+		bool SetWeather(const WeatherInput& weather);
+		//! Ignite a cell, returns false when it is out of range or has no fuel
+		bool Ignite(int x, int y);
+		//! Split the steps into substeps no longer than the stable step of this Courant number, 0 (the
+		//! default) takes every step whole
+		void SetCourantNumber(float courant);
+		//! Advance the fire by dt seconds.
+		void Step(float dt);
+		//! Apply suppression actions in order, between two Step() calls.
+		//! Wetting sets back the ignition progress of unburned cells and quenches the same mass of fuel
+		//! on burning ones, a firebreak turns an unburned cell unburnable. Other cells are left as is.
+		void ApplySuppression(const std::vector<Suppression>& actions);
+		//! Returns the hash of the cell states, equal digests mean identical burn patterns
+		uint64_t GetDigest() const;
+		//! Returns the bytes of every grid array
+		size_t GetMemoryBytes() const;
+		//! Returns the CellState of every cell
+		inline const std::vector<uint8_t>& GetState() const
+		{
+			return _state;
+		}
+		//! Returns the fireline intensity of every cell in kW/m^2, zero unless burning
+		inline const std::vector<float>& GetIntensity() const
+		{
+			return _intensity;
+		}
+		//! Returns the number of burning cells
+		inline size_t GetNumBurning() const
+		{
+			return _numBurning;
+		}
+		//! Returns the stable step of the last substep in seconds, infinite without a Courant number
+		inline float GetStableTimeStep() const
+		{
+			return _stableTimeStep;
+		}
+		//! Returns the number of substeps with fire since Initialize(), one per step without a Courant number
+		inline uint64_t GetNumSubsteps() const
+		{
+			return _numSubsteps;
+		}
+		//! Returns the window of cells the next Step() visits, empty (max < min) without burning cells
+		inline void GetActiveWindow(int& minX, int& minY, int& maxX, int& maxY) const
+		{
+			minX = _activeMinX;
+			minY = _activeMinY;
+			maxX = _activeMaxX;
+			maxY = _activeMaxY;
+		}
+		inline int GetWidth() const
+		{
+			return _width;
+		}
+		inline int GetHeight() const
+		{
+			return _height;
+		}
+		//! Returns the edge length of a cell in meters
+		inline float GetCellSize() const
+		{
+			return _cellSize;
+		}
+		//! Returns the simulated time in seconds
+		inline double GetTime() const
+		{
+			return _time;
+		}
+	private:
+		//! Ignition progress per second a burning neighbor in the given direction gives the cell, R / d
+		float GetIgnitionRate(size_t cell, size_t neighbor, int direction) const;
+		//! Ignition progress per second the burning neighbors of cell x, y give it together
+		float GetSummedRate(int x, int y) const;
+		//! Accumulate and commit one step of dt seconds over the active window
+		void Advance(float dt);
+		//! Store the summed rate of every unburned cell of the active window, returns the stable step
+		float UpdateRates();
+		//! Advance and commit one substep of dt seconds at the stored rates
+		void AdvanceRates(float dt);
+		//! Apply the transitions of cells minX to maxX of row y and collect its burning cells
+		void CommitRow(int y, int minX, int maxX);
+		//! Grow the active window around the burning cells of rows minY to maxY
+		void UpdateActiveWindow(int minY, int maxY);
+
+		std::vector<uint8_t> _state;
+		std::vector<uint8_t> _fuel;
+		std::vector<float> _elevation;
+		//! Ignition progress of unburned cells, 1 ignites
+		std::vector<float> _ignition;
+		//! Remaining fuel load of burning cells in kg/m^2
+		std::vector<float> _fuelLoad;
+		//! Spread rate factor of the fuel moisture of every cell, 1 until SetWeather()
+		std::vector<float> _spreadFactor;
+		std::vector<float> _intensity;
+		//! Burning cells and the x range of them per row, feed the active window
+		std::vector<int> _rowBurning, _rowMinX, _rowMaxX;
+		//! Summed ignition rate of the unburned cells and stable step per row of the current substep
+		std::vector<float> _rate, _rowStableStep;
+		//! Wind factor per direction, updated by SetWind()
+		float _windFactor[8];
+		float _courantNumber;
+		float _stableTimeStep;
+		float _cellSize;
+		double _time;
+		uint64_t _numSubsteps;
+		size_t _numBurning;
+		int _width, _height;
+		//! Bounding window of the burning cells grown by one cell, the only cells a step touches
+		int _activeMinX, _activeMinY, _activeMaxX, _activeMaxY;
+	};
+
+};
+
+#endif //! end of FireSpread.hpp
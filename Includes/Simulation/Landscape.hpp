@@ -0,0 +1,80 @@
+#ifndef LANDSCAPE_HPP
+#define LANDSCAPE_HPP
+
+#include <glm/vec2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Simulation {
+
+	//! Fuel categories of a landscape cell, loosely following the Anderson fuel groups
+	enum FuelType : uint8_t
+	{
+		NonBurnable = 0,
+		Grass,
+		Shrub,
+		TimberLitter,
+		Slash,
+		NumFuelTypes
+	};
+
+	//! Burning behavior of a fuel type
+	struct FuelModel
+	{
+		const char* name;
+		//! Dry fuel load in kg/m^2
+		float load;
+		//! Spread rate on flat ground without wind in m/s, at 8% fine dead fuel moisture
+		float spreadRate;
+		//! Flaming residence time in seconds
+		float burnTime;
+		//! Heat of combustion in kJ/kg
+		float heatContent;
+	};
+
+	//! Returns the fuel model of a FuelType
+	const FuelModel& GetFuelModel(uint8_t fuel);
+	//! Returns the equilibrium moisture of fine dead fuel in percent of its dry weight at the relative
+	//! humidity in percent and the air temperature in degrees Celsius, after Simard (1968)
+	float GetFuelMoisture(float humidity, float temperature);
+	//! Returns the factor of the fuel model spread rates at a fine dead fuel moisture in percent,
+	//! Rothermel's moisture damping relative to the 8% the spread rates hold at, zero from 25% on
+	float GetMoistureFactor(float moisture);
+
+	//! 64-bit FNV-1a hash of raw bytes, chain calls by passing the previous hash
+	uint64_t HashBytes(const void* data, size_t numBytes, uint64_t hash = 14695981039346656037ull);
+
+	//! Static inputs of the fire engine on a regular grid, row major with x fastest
+	struct Landscape
+	{
+		int width = 0, height = 0;
+		//! Edge length of a cell in meters
+		float cellSize = 1.0f;
+		//! Terrain height in meters
+		std::vector<float> elevation;
+		//! FuelType of every cell
+		std::vector<uint8_t> fuel;
+		//! Uniform wind in m/s, x east and y along increasing rows
+		glm::vec2 wind = glm::vec2(0.0f);
+
+		//! Allocate a flat landscape without fuel
+		bool Initialize(int width, int height, float cellSize);
+		//! Returns the number of cells
+		inline size_t GetNumCells() const
+		{
+			return static_cast<size_t>(width) * height;
+		}
+		//! Returns the elevation at the center of cell x, y of the grid with factor x factor cells per
+		//! landscape cell, interpolated bilinearly between the landscape cell centers
+		float GetRefinedElevation(int factor, int x, int y) const;
+		//! Write the landscape with factor x factor cells per cell into refined, the cells keep the fuel
+		//! of the cell they split and take GetRefinedElevation()
+		bool Refine(int factor, Landscape& refined) const;
+		//! Returns the hash of the extent, elevation, fuel and wind
+		uint64_t GetDigest() const;
+	};
+
+};
+
+#endif //! end of Landscape.hpp
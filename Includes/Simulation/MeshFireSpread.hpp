@@ -0,0 +1,98 @@
+#ifndef MESH_FIRE_SPREAD_HPP
+#define MESH_FIRE_SPREAD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GL3 {
+	class MeshGraph;
+};
+
+namespace Simulation {
+
+	//! Fire spreading over the surface of a triangle mesh, on the nodes of its GL3::MeshGraph.
+	//! Every node records the time the fire reached it, a node catches fire once the earliest arrival
+	//! over its edges from burning neighbors has passed, with the spread rate of the node climbing the
+	//! edge slope like FireSpread. A node burns out burnTime seconds after it caught fire and only
+	//! spreads over edges the fire crosses before. Step() only visits the burning nodes and the
+	//! frontier, the unburned nodes next to them, and every job reads the graph and writes the
+	//! arrival of its own frontier nodes, so steps are race free and reproducible.
+	class MeshFireSpread
+	{
+	public:
+		enum State : uint8_t
+		{
+			Unburned = 0,
+			Burning,
+			Burned,
+			//! Nodes with a zero spread rate
+			Unburnable
+		};
+		//! Frontier or burning nodes of one Step() job
+		static constexpr size_t NODES_PER_JOB = 1024;
+		//! Steepest climb in rise over run the slope factor accounts for, walls spread as fast
+		static constexpr float MAX_GRADIENT = 2.0f;
+		//! Default constructor
+		MeshFireSpread();
+		//! Default destructor
+		~MeshFireSpread();
+		//! Reset the fire over the nodes of a graph with a spread rate in m/s per node, the graph
+		//! must outlive the simulation
+		bool Initialize(const GL3::MeshGraph& graph, const std::vector<float>& spreadRates, float burnTime);
+		//! Set the node on fire at the current time
+		void Ignite(uint32_t node);
+		//! Advance the fire by dt seconds. The fire crosses at most one edge per step, so arrival times
+		//! only match the shortest travel times while dt stays below the travel time of the edges.
+		void Step(float dt);
+		//! Write the RGBA8 color of every mesh vertex of the graph, e.g. into a mapped
+		//! GL3::VertexColorBuffer, unburned vertices are transparent
+		void WriteColors(uint32_t* colors) const;
+		//! Returns the hash of the node states
+		uint64_t GetDigest() const;
+		inline const std::vector<uint8_t>& GetStates() const
+		{
+			return _state;
+		}
+		//! Returns the time in seconds the fire reached every node, infinite for unreached nodes
+		inline const std::vector<float>& GetArrivalTimes() const
+		{
+			return _arrival;
+		}
+		inline size_t GetNumBurning() const
+		{
+			return _burningNodes.size();
+		}
+		inline size_t GetNumBurned() const
+		{
+			return _numBurned;
+		}
+		//! Returns the number of unburned nodes next to burning ones
+		inline size_t GetFrontierSize() const
+		{
+			return _frontier.size();
+		}
+		inline float GetTime() const
+		{
+			return _time;
+		}
+	private:
+		//! Collect the unburned nodes next to burning ones
+		void UpdateFrontier();
+
+		const GL3::MeshGraph* _graph;
+		std::vector<uint8_t> _state;
+		std::vector<float> _spreadRate;
+		std::vector<float> _arrival;
+		std::vector<uint32_t> _burningNodes, _frontier;
+		//! Per job lists of Step(), merged in job order
+		std::vector< std::vector<uint32_t> > _jobNodes;
+		std::vector<uint32_t> _scratch;
+		size_t _numBurned;
+		float _burnTime;
+		float _time;
+	};
+
+};
+
+#endif //! end of MeshFireSpread.hpp
@@ -0,0 +1,71 @@
+#ifndef PATH_FINDER_HPP
+#define PATH_FINDER_HPP
+
+#include <Simulation/Landscape.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Simulation {
+
+	//! Start and goal cell of one path query
+	struct PathQuery
+	{
+		uint32_t start;
+		uint32_t goal;
+	};
+
+	//! Cells from start to goal, empty when the goal is unreachable
+	struct Path
+	{
+		std::vector<uint32_t> cells;
+		//! Travel time in seconds at unit speed, i.e. the cost weighted length in meters
+		float cost = 0.0f;
+	};
+
+	//! A* searches on the 8-connected travel cost grid of a landscape.
+	//! The cost of a cell is the walking time multiplier of its fuel, raised by the terrain slope.
+	//! FindPaths() runs a batch of queries in parallel, each search on per-thread scratch arrays that
+	//! are stamped instead of cleared, so a query only touches the cells it expands.
+	class PathFinder
+	{
+	public:
+		//! Travel cost gain per unit of terrain gradient
+		static constexpr float SLOPE_PENALTY = 4.0f;
+		//! Searches give up with an empty path after expanding this many cells, e.g. for goals cut off by fire
+		static constexpr size_t MAX_EXPANDED_CELLS = 1 << 16;
+		//! Default constructor
+		PathFinder();
+		//! Default destructor
+		~PathFinder();
+		//! Build the travel cost grid of the landscape
+		bool Initialize(const Landscape& landscape);
+		//! Find the cheapest path of every query, paths receives one entry per query.
+		//! Cells whose state equals blockedState are impassable when state is given, e.g. the
+		//! FireSpread::Burning cells of FireSpread::GetState(). Start and goal are never blocked.
+		void FindPaths(const std::vector<PathQuery>& queries, std::vector<Path>& paths,
+					   const uint8_t* state = nullptr, uint8_t blockedState = 0) const;
+		//! Returns the travel time multiplier of a cell, at least 1
+		inline float GetCost(uint32_t cell) const
+		{
+			return _cost[cell];
+		}
+		inline int GetWidth() const
+		{
+			return _width;
+		}
+		inline int GetHeight() const
+		{
+			return _height;
+		}
+	private:
+		//! Single A* search with the calling thread's scratch arrays
+		void FindPath(const PathQuery& query, Path& path, const uint8_t* state, uint8_t blockedState) const;
+
+		std::vector<float> _cost;
+		float _cellSize;
+		int _width, _height;
+	};
+
+};
+
+#endif //! end of PathFinder.hpp
@@ -0,0 +1,111 @@
+#ifndef SCENARIO_GENERATOR_HPP
+#define SCENARIO_GENERATOR_HPP
+
+#include <Simulation/Landscape.hpp>
+#include <glm/vec3.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace GL3 {
+
+	class MeshGraph;
+
+};
+
+namespace Simulation {
+
+	class AdaptiveFireSpread;
+	class FireSpread;
+	class MeshFireSpread;
+	class TiledFireSpread;
+	struct Canopy;
+
+	//! Wind presets of the standard scenarios, blowing along +x
+	enum class WindPreset
+	{
+		Calm,
+		Breeze,
+		Strong,
+		Gale
+	};
+
+	//! Reproducible fire benchmark input, generated from its seed on every platform
+	struct Scenario
+	{
+		std::string name;
+		int size;
+		float cellSize;
+		uint64_t seed;
+		//! Tree cover probability of a percolation forest, zero uses a fuel mosaic instead
+		float forestDensity;
+		//! Peak to valley height of the fractal terrain in meters, zero is flat
+		float terrainRelief;
+		//! Mean fuel patch diameter of the mosaic in cells
+		float patchSize;
+		WindPreset wind;
+		//! Ignite the whole west column instead of the fuel closest to the center
+		bool bIgniteWestEdge;
+		int numSteps;
+		float dt;
+		//! Expected Landscape::GetDigest() after generation and FireSpread::GetDigest() after numSteps
+		uint64_t landscapeDigest;
+		uint64_t fireDigest;
+		//! Expected digests of the other engines after numSteps: TiledFireSpread at full rate and with
+		//! the focus, AdaptiveFireSpread in fixed steps and subcycled, CrownFire on top of FireSpread, zero
+		//! for the percolation forests that have no canopy, and MeshFireSpread on the terrain mesh
+		uint64_t tiledDigest, tiledFocusDigest;
+		uint64_t adaptiveDigest, subcycledDigest;
+		uint64_t crownDigest;
+		uint64_t meshDigest;
+	};
+
+	//! Seeded generators for synthetic landscapes and the standard benchmark scenarios.
+	//! Every random value comes from a counter based hash of (seed, x, y), never from the standard
+	//! library distributions, so a seed gives the same landscape with any compiler and thread count.
+	//! The expected digests assume plain IEEE single precision, builds that contract into FMA may differ.
+	class ScenarioGenerator
+	{
+	public:
+		//! Site percolation threshold of the 8-neighbor square lattice the fire spreads on
+		static constexpr float PERCOLATION_THRESHOLD = 0.407f;
+		//! Cover each cell with the given fuel with probability density, the rest is non-burnable
+		static void GeneratePercolationForest(Landscape& landscape, float density, uint64_t seed, uint8_t fuel = TimberLitter);
+		//! Fractional Brownian motion value noise terrain.
+		//! \param relief : peak to valley height in meters
+		//! \param roughness : amplitude ratio of successive octaves, higher is rougher
+		static void GenerateFractalTerrain(Landscape& landscape, float relief, float roughness, uint64_t seed);
+		//! Voronoi patches of random fuel types with some non-burnable patches (rock, roads, water)
+		static void GenerateFuelMosaic(Landscape& landscape, float patchSize, uint64_t seed);
+		//! Crowns over the TimberLitter cells, value noise stands with tops of 12 to 28 m and crown bases
+		//! of 1 to 7 m, the low bases standing for ladder fuels
+		static void GenerateCanopy(const Landscape& landscape, uint64_t seed, Canopy& canopy);
+		//! Returns the wind vector of a preset in m/s
+		static glm::vec2 GetWind(WindPreset preset);
+		//! Two triangles per square of four cell centers at their elevation, y up, one vertex per cell
+		//! in row major order
+		static void GenerateTerrainMesh(const Landscape& landscape, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices);
+		//! Returns the focus of the multi-rate runs, the map center with an eighth of its extent around it
+		static glm::vec2 GetFocusCenter(const Landscape& landscape);
+		static float GetFocusRadius(const Landscape& landscape);
+		//! Returns the standard scenarios with their expected digests
+		static const std::vector<Scenario>& GetStandardScenarios();
+		//! Generate the landscape of a scenario
+		static bool Generate(const Scenario& scenario, Landscape& landscape);
+		//! Initialize the fire on the landscape and ignite it as the scenario says
+		static bool Ignite(const Scenario& scenario, const Landscape& landscape, FireSpread& fire);
+		static bool Ignite(const Scenario& scenario, const Landscape& landscape, TiledFireSpread& fire);
+		static bool Ignite(const Scenario& scenario, const Landscape& landscape, AdaptiveFireSpread& fire);
+		//! Initialize the fire on the graph of the terrain mesh of the landscape with the spread rates of
+		//! the fuels and the longest burn time among them, and ignite the nodes of the scenario cells
+		static bool Ignite(const Scenario& scenario, const Landscape& landscape, const GL3::MeshGraph& graph, MeshFireSpread& fire);
+		//! Generate and run the scenario on every engine, compare the digests and print the outcome.
+		//! AdaptiveFireSpread in fixed steps also has to end cell for cell like FireSpread on the refined landscape, and
+		//! both TiledFireSpread runs have to burn the area of FireSpread in 16 times shorter steps within 2.5%.
+		//! Returns false on a mismatch.
+		static bool Verify(const Scenario& scenario, std::ostream& stream);
+	};
+
+};
+
+#endif //! end of ScenarioGenerator.hpp
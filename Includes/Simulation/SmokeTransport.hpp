@@ -0,0 +1,81 @@
+#ifndef SMOKE_TRANSPORT_HPP
+#define SMOKE_TRANSPORT_HPP
+
+#include <glm/vec3.hpp>
+#include <string>
+#include <vector>
+
+namespace GL3 {
+	class Texture;
+};
+
+namespace Simulation {
+
+	//! Eulerian smoke concentration transport on a regular grid driven by wind and fire emissions.
+	//! Each sub-step is operator split into 1D flux-limited (van Leer) advection sweeps per axis,
+	//! explicit diffusion and ground-level emission. The sweeps are monotone for CFL <= 1 in uniform wind,
+	//! in varying wind the outgoing fluxes of a cell are scaled down to its content, so the field stays
+	//! non-negative without adding mass.
+	class SmokeTransport
+	{
+	public:
+		//! Default constructor
+		SmokeTransport();
+		//! Default destructor
+		~SmokeTransport();
+		//! Allocate the concentration grid, depth 1 gives a 2D ground-level model.
+		//! \param cellSize : edge length of a cell in meters
+		bool Initialize(int width, int height, int depth, float cellSize);
+		//! Set a uniform wind in m/s for every cell
+		void SetWind(const glm::vec3& wind);
+		//! Set a per-cell wind field in m/s, width * height * depth values
+		bool SetWindField(const std::vector<glm::vec3>& wind);
+		//! Set the eddy diffusivity in m^2/s
+		void SetDiffusivity(float diffusivity);
+		//! Set the emission rate of every ground cell (width * height values) in concentration per second
+		void SetEmission(const float* emission);
+		//! Advance the concentration by dt seconds with as many sub-steps as stability requires.
+		void Step(float dt);
+		//! Clear the concentration field
+		void Reset();
+		//! Upload the concentration as a single channel float 3D texture (2D for depth 1).
+		void UploadTexture(GL3::Texture& texture) const;
+		//! Write the ground-level or column-integrated concentration as an ESRI ASCII grid raster.
+		bool WriteRaster(const std::string& path, bool columnIntegrated) const;
+		//! Returns the concentration values, x fastest then y then z
+		inline const std::vector<float>& GetConcentration() const
+		{
+			return _concentration;
+		}
+		//! Returns the number of sub-steps taken by the last Step()
+		inline int GetNumSubSteps() const
+		{
+			return _numSubSteps;
+		}
+		//! Returns the grid extent
+		inline glm::ivec3 GetExtent() const
+		{
+			return glm::ivec3(_width, _height, _depth);
+		}
+	private:
+		//! Flux-limited advection of every line along the given axis over dt.
+		void Advect(int axis, float dt);
+		//! Explicit diffusion over dt.
+		void Diffuse(float dt);
+
+		std::vector<float> _concentration;
+		std::vector<float> _scratch;
+		std::vector<glm::vec3> _wind;
+		std::vector<float> _emission;
+		float _cellSize;
+		float _diffusivity;
+		//! Largest wind component magnitude, bounds the Courant number of every sweep
+		float _maxWindComponent;
+		int _width, _height, _depth;
+		int _numSubSteps;
+		int _sweepParity;
+	};
+
+};
+
+#endif //! end of SmokeTransport.hpp
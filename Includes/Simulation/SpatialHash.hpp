@@ -0,0 +1,71 @@
+#ifndef SPATIAL_HASH_HPP
+#define SPATIAL_HASH_HPP
+
+#include <glm/vec2.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Simulation {
+
+	//! Uniform grid of buckets over 2D points, rebuilt from scratch whenever the points move.
+	//! Build() bins the points with a parallel counting sort: every job histograms the buckets of a
+	//! contiguous range of points, a scan over (bucket, job) gives each job its scatter offsets and the
+	//! jobs scatter without synchronization. The sort is stable, points keep their input order within a
+	//! bucket and query results do not depend on the thread count.
+	class SpatialHash
+	{
+	public:
+		static constexpr uint32_t NO_POINT = 0xFFFFFFFFu;
+		//! Points binned by one Build() job
+		static constexpr size_t POINTS_PER_JOB = 16384;
+		//! Default constructor
+		SpatialHash();
+		//! Default destructor
+		~SpatialHash();
+		//! Cover the rectangle with square buckets, points outside of it land in the border buckets
+		bool Initialize(const glm::vec2& lowerCorner, const glm::vec2& upperCorner, float bucketSize);
+		//! Bin count points given as separate x and y arrays, replaces the previous points
+		void Build(const float* x, const float* y, size_t count);
+		//! Append the indices of the points within radius of center, bucket by bucket
+		void QueryRadius(const glm::vec2& center, float radius, std::vector<uint32_t>& indices) const;
+		//! Returns the index of the closest point within maxRadius, the lowest index on ties, or NO_POINT
+		uint32_t FindNearest(const glm::vec2& center, float maxRadius) const;
+		//! Returns the number of points of the last Build()
+		inline size_t GetNumPoints() const
+		{
+			return _indices.size();
+		}
+		//! Returns the edge length of a bucket
+		inline float GetBucketSize() const
+		{
+			return _bucketSize;
+		}
+	private:
+		//! Returns the bucket coordinate of a position along x or y, clamped to the grid
+		inline int GetBucketX(float x) const
+		{
+			const int bucket = static_cast<int>((x - _lowerCorner.x) * _inverseBucketSize);
+			return bucket < 0 ? 0 : (bucket >= _width ? _width - 1 : bucket);
+		}
+		inline int GetBucketY(float y) const
+		{
+			const int bucket = static_cast<int>((y - _lowerCorner.y) * _inverseBucketSize);
+			return bucket < 0 ? 0 : (bucket >= _height ? _height - 1 : bucket);
+		}
+
+		glm::vec2 _lowerCorner;
+		float _bucketSize, _inverseBucketSize;
+		int _width, _height;
+		//! First sorted point of every bucket, one more entry than buckets
+		std::vector<uint32_t> _bucketBegin;
+		//! Point indices and positions sorted by bucket
+		std::vector<uint32_t> _indices;
+		std::vector<glm::vec2> _points;
+		//! Bucket of every input point and the per job histograms, later scatter offsets, of Build()
+		std::vector<uint32_t> _pointBuckets;
+		std::vector<uint32_t> _jobOffsets;
+	};
+
+};
+
+#endif //! end of SpatialHash.hpp
@@ -0,0 +1,41 @@
+#ifndef SPREAD_KERNEL_HPP
+#define SPREAD_KERNEL_HPP
+
+#include <Simulation/FireSpread.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+
+namespace Simulation {
+
+	//! The 8 neighbor stencil and the R / d ignition rate of the fire spread, shared by the grid
+	//! engines and every other walker of the landscape grid so they agree bit for bit.
+	namespace SpreadKernel {
+
+		//! Offsets of the 8 neighbors, spread runs from the neighbor towards the cell, i.e. along -offset
+		constexpr int OFFSET_X[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+		constexpr int OFFSET_Y[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+		//! Center distance of each neighbor in cells
+		constexpr float DISTANCE[8] = { 1.41421356f, 1.0f, 1.41421356f, 1.0f, 1.0f, 1.41421356f, 1.0f, 1.41421356f };
+
+		//! Returns the spread rate factor of the uniform wind in m/s for spread from the neighbor in the given direction
+		inline float GetWindFactor(const glm::vec2& wind, int direction)
+		{
+			const glm::vec2 spread = -glm::vec2(OFFSET_X[direction], OFFSET_Y[direction]) / DISTANCE[direction];
+			return 1.0f + FireSpread::WIND_COEFFICIENT * std::max(0.0f, glm::dot(wind, spread));
+		}
+
+		//! Returns the ignition progress per second a burning neighbor in the given direction gives a
+		//! cell, R / d with the upslope factor from the elevations in meters of the two cells
+		inline float GetIgnitionRate(float spreadRate, float windFactor, float elevation, float neighborElevation, float cellSize, int direction)
+		{
+			const float distance = cellSize * DISTANCE[direction];
+			const float gradient = (elevation - neighborElevation) / distance;
+			const float slopeFactor = gradient > 0.0f ? 1.0f + FireSpread::SLOPE_COEFFICIENT * gradient * gradient : 1.0f;
+			return spreadRate * windFactor * slopeFactor / distance;
+		}
+
+	};
+
+};
+
+#endif //! end of SpreadKernel.hpp
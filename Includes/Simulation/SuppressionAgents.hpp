@@ -0,0 +1,158 @@
+#ifndef SUPPRESSION_AGENTS_HPP
+#define SUPPRESSION_AGENTS_HPP
+
+#include <Simulation/FireSpread.hpp>
+#include <Simulation/PathFinder.hpp>
+#include <Simulation/SpatialHash.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Simulation {
+
+	//! Firefighting resource kinds
+	enum AgentType : uint8_t
+	{
+		//! Cuts firebreaks along the front, one cell at a time
+		HandCrew = 0,
+		//! Sprays water around the front cell it drove to until the tank is empty
+		Engine,
+		//! Flies straight to the front and drops its whole load of retardant at once
+		Aircraft,
+		NumAgentTypes
+	};
+
+	//! Capabilities of an AgentType
+	struct AgentModel
+	{
+		const char* name;
+		//! Travel speed in m/s on the cheapest ground, aircraft ignore the cost grid
+		float speed;
+		//! Seconds to cut one firebreak cell or to empty the load
+		float workTime;
+		//! Water or retardant carried in kg, zero for hand crews
+		float capacity;
+		//! Radius in cells of the disk one discharge wets
+		int workRadius;
+		//! Seconds to refill once the load is spent, aircraft include the flight back to their base
+		float reloadTime;
+	};
+
+	//! Returns the agent model of an AgentType
+	const AgentModel& GetAgentModel(uint8_t type);
+
+	//! Crews, engines and aircraft acting on a FireSpread grid, stored field by field.
+	//! Step() first updates every agent in parallel jobs that only read the fire grid and write the
+	//! slots of their own agents, queuing path queries and suppression actions in per job lists.
+	//! The path queries then run as one parallel batch on the landscape cost grid and the actions are
+	//! applied to the fire in agent order, so no job writes the grid and a run is reproducible.
+	//! Agents find the fire through a spatial hash over the front cells, aircraft hold their drop
+	//! while ground agents are inside the drop zone, found through a spatial hash over the agents.
+	class SuppressionAgents
+	{
+	public:
+		enum Task : uint8_t
+		{
+			//! Waiting for a target, or for the back-off timer after an unreachable one
+			Idle = 0,
+			Travel,
+			Work,
+			Reload
+		};
+		//! Agents updated by one Step() job
+		static constexpr size_t AGENTS_PER_JOB = 256;
+		//! Seconds between two scans of the fire front
+		static constexpr float FRONT_INTERVAL = 10.0f;
+		//! Bucket edge length of both spatial hashes in cells
+		static constexpr int BUCKET_CELLS = 8;
+		//! Ground agents whose goal was taken by the fire walk straight to a front cell this many cells
+		//! away, instead of queuing a new path query
+		static constexpr int RETARGET_CELLS = 4;
+		//! Default constructor
+		SuppressionAgents();
+		//! Default destructor
+		~SuppressionAgents();
+		//! Build the cost grid and spatial hashes of the landscape and remove every agent
+		bool Initialize(const Landscape& landscape);
+		//! Add an agent at a position in meters, which also becomes its base, returns its index
+		uint32_t Add(AgentType type, const glm::vec2& position);
+		//! Advance the agents by dt seconds and apply their suppression actions to the fire
+		void Step(FireSpread& fire, float dt);
+		//! Append the agents within radius meters of center, at their positions when the last Step() began
+		void FindNeighbors(const glm::vec2& center, float radius, std::vector<uint32_t>& agents) const;
+		inline size_t GetNumAgents() const
+		{
+			return _type.size();
+		}
+		//! Returns the positions in meters, x east and y along increasing rows
+		inline const std::vector<float>& GetPositionsX() const
+		{
+			return _positionX;
+		}
+		inline const std::vector<float>& GetPositionsY() const
+		{
+			return _positionY;
+		}
+		//! Returns the AgentType of every agent
+		inline const std::vector<uint8_t>& GetTypes() const
+		{
+			return _type;
+		}
+		//! Returns the Task of every agent
+		inline const std::vector<uint8_t>& GetTasks() const
+		{
+			return _task;
+		}
+		//! Returns the number of path queries of the last Step()
+		inline size_t GetNumPathQueries() const
+		{
+			return _queries.size();
+		}
+		//! Returns the suppression actions the last Step() applied
+		inline const std::vector<Suppression>& GetActions() const
+		{
+			return _actions;
+		}
+	private:
+		//! Collect the unburned cells next to burning ones and hash them
+		void UpdateFront(const FireSpread& fire);
+		//! Advance one agent, queuing its path query and actions
+		void StepAgent(uint32_t agent, const FireSpread& fire, float dt, std::vector<PathQuery>& queries,
+					   std::vector<uint32_t>& queryAgents, std::vector<Suppression>& actions);
+		//! Head for the closest front cell within RETARGET_CELLS, or go idle without one
+		void RetargetNearby(uint32_t agent, const FireSpread& fire, const glm::vec2& position);
+		//! Returns the cell containing a position
+		uint32_t GetCell(float x, float y) const;
+		//! Returns the center of a cell in meters
+		glm::vec2 GetCellCenter(uint32_t cell) const;
+
+		std::vector<float> _positionX, _positionY;
+		std::vector<float> _baseX, _baseY;
+		std::vector<uint8_t> _type, _task;
+		//! Remaining load in kg and the timer of the current task in seconds
+		std::vector<float> _load, _timer;
+		//! Target cell and the path towards it with the index of the last reached path cell
+		std::vector<uint32_t> _goal;
+		std::vector<Path> _paths;
+		std::vector<uint32_t> _pathStep;
+		SpatialHash _agentHash, _frontHash;
+		PathFinder _pathFinder;
+		//! Front cells and their centers fed to _frontHash
+		std::vector<uint32_t> _frontCells;
+		std::vector<float> _frontX, _frontY;
+		std::vector< std::vector<uint32_t> > _frontRows;
+		//! Per job queues of Step(), merged in job order
+		std::vector< std::vector<PathQuery> > _jobQueries;
+		std::vector< std::vector<uint32_t> > _jobQueryAgents;
+		std::vector< std::vector<Suppression> > _jobActions;
+		std::vector<PathQuery> _queries;
+		std::vector<uint32_t> _queryAgents;
+		std::vector<Path> _queryPaths;
+		std::vector<Suppression> _actions;
+		float _frontTimer;
+		float _cellSize;
+		int _width, _height;
+	};
+
+};
+
+#endif //! end of SuppressionAgents.hpp
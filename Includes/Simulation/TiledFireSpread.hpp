@@ -0,0 +1,184 @@
+#ifndef TILED_FIRE_SPREAD_HPP
+#define TILED_FIRE_SPREAD_HPP
+
+#include <Simulation/Landscape.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Simulation {
+
+	//! Surface fire spread on square tiles of the landscape grid, each tile stepped at its own rate.
+	//! The physics is the one of FireSpread in continuous time: a cell records when it caught fire and
+	//! when it burns out, and the ignition progress of an unburned cell is the exact integral of R / d
+	//! over the burning intervals of its neighbors. A tile update therefore catches up on any elapsed
+	//! time in one go, it ignites its cells in arrival order within the tile and dates every ignition
+	//! back to the moment the progress reached 1, so neighbor tiles that learn about it later still
+	//! integrate from that moment.
+	//! Tile level L updates every 2^L steps. The scheduler keeps the tiles of the front around the
+	//! focus at level 0, neighbor tiles at most one level apart, tiles without fire in or next to them
+	//! out of the schedule, and an update only reads states committed before it, so a tile never sees
+	//! a neighbor's future. A tile next to ignitions committed since its last update stays in the
+	//! schedule until it read them, even when they burned out within the same catch-up interval, so
+	//! fast fuels carry the fire across tile boundaries. Ignitions within a tile keep their exact
+	//! times, but a coarse tile learns about a neighbor's ignition up to 2^L - 1 steps late, so the
+	//! fire crossing into or out of it arrives late, which gl3-bench --report multirate measures as the
+	//! ignition delay.
+	class TiledFireSpread
+	{
+	public:
+		enum CellState : uint8_t
+		{
+			Unburnable = 0,
+			Unburned,
+			Burning,
+			Burned
+		};
+		//! Edge length of a tile in cells
+		static constexpr int TILE_SIZE = 32;
+		//! Coarsest tile level, updated every 2^MAX_LEVEL steps
+		static constexpr int MAX_LEVEL = 3;
+		//! Level of the tiles outside the schedule
+		static constexpr uint8_t INACTIVE_LEVEL = 0xFF;
+		//! Default constructor
+		TiledFireSpread();
+		//! Default destructor
+		~TiledFireSpread();
+		//! Copy the fuel, elevation and wind of the landscape and reset every cell
+		bool Initialize(const Landscape& landscape);
+		//! Set the uniform wind in m/s, the progress gained so far is kept
+		void SetWind(const glm::vec2& wind);
+		//! Ignite a cell at the current time, returns false when it is out of range or has no fuel
+		bool Ignite(int x, int y);
+		//! Run the front within radius meters of center at full rate and coarsen the other tiles with
+		//! their distance, one level per doubling
+		void SetFocus(const glm::vec2& center, float radius);
+		//! Run every tile with fire at full rate
+		void ClearFocus();
+		//! Advance the fire by dt seconds, updating the tiles whose level is due
+		void Step(float dt);
+		//! Returns the hash of the cell states
+		uint64_t GetDigest() const;
+		//! Returns the bytes of every grid and tile array
+		size_t GetMemoryBytes() const;
+		//! Returns the CellState of every cell as of the last update of its tile
+		inline const std::vector<uint8_t>& GetState() const
+		{
+			return _state;
+		}
+		//! Returns the fireline intensity of every cell in kW/m^2, zero unless burning
+		inline const std::vector<float>& GetIntensity() const
+		{
+			return _intensity;
+		}
+		//! Returns the time in seconds every cell caught fire, infinite for unburned cells
+		inline const std::vector<float>& GetIgnitionTimes() const
+		{
+			return _ignitionTime;
+		}
+		//! Returns the level of every tile, INACTIVE_LEVEL outside the schedule
+		inline const std::vector<uint8_t>& GetTileLevels() const
+		{
+			return _tileLevel;
+		}
+		inline int GetNumTilesX() const
+		{
+			return _tilesX;
+		}
+		inline int GetNumTilesY() const
+		{
+			return _tilesY;
+		}
+		inline size_t GetNumBurning() const
+		{
+			return _numBurning;
+		}
+		//! Returns the number of tile updates and of cells they visited since Initialize()
+		inline uint64_t GetNumTileUpdates() const
+		{
+			return _numTileUpdates;
+		}
+		inline uint64_t GetNumCellUpdates() const
+		{
+			return _numCellUpdates;
+		}
+		inline int GetWidth() const
+		{
+			return _width;
+		}
+		inline int GetHeight() const
+		{
+			return _height;
+		}
+		//! Returns the edge length of a cell in meters
+		inline float GetCellSize() const
+		{
+			return _cellSize;
+		}
+		//! Returns the simulated time in seconds
+		inline double GetTime() const
+		{
+			return _time;
+		}
+	private:
+		//! Burning interval of a neighbor clipped to [_epoch, time] and the progress per second it gives
+		struct Contribution
+		{
+			float begin, end, rate;
+		};
+		//! Ignitions and burnouts one tile update found, committed after every due tile was updated
+		struct TileResult
+		{
+			std::vector<uint32_t> cells;
+			std::vector<float> times;
+			std::vector<uint32_t> burnouts;
+			int numFront;
+		};
+
+		//! Ignition progress per second a burning neighbor in the given direction gives the cell, R / d
+		float GetIgnitionRate(size_t cell, size_t neighbor, int direction) const;
+		//! Collect the burning neighbors of an unburned cell up to time, returns their number. Neighbors
+		//! inside the tile at tileX, tileY take their ignition time from localTimes when it is finite.
+		int GatherContributions(int x, int y, float time, const float* localTimes, int tileX, int tileY, Contribution* contributions) const;
+		//! Find the ignitions and burnouts of a tile up to time from the committed states
+		void UpdateTile(int tile, float time, TileResult& result) const;
+		//! Apply the result of a tile update
+		void CommitTile(int tile, float time, const TileResult& result);
+		//! Reassign the tile levels from the fire and the focus
+		void UpdateLevels();
+
+		std::vector<uint8_t> _state;
+		std::vector<uint8_t> _fuel;
+		std::vector<float> _elevation;
+		//! Ignition progress at _epoch, the time the rates last changed
+		std::vector<float> _ignition;
+		std::vector<float> _ignitionTime, _burnoutTime;
+		std::vector<float> _intensity;
+		//! Per tile level, burning cells, unburned cells next to fire and the last update
+		std::vector<uint8_t> _tileLevel;
+		std::vector<int> _tileBurning, _tileFront;
+		std::vector<uint64_t> _tileLastStep;
+		//! Per tile the first step whose updates read its last committed ignitions, zero without any
+		std::vector<uint64_t> _tileIgnitionStep;
+		//! Due tiles of the current step and their results
+		std::vector<int> _dueTiles;
+		std::vector<TileResult> _results;
+		//! Wind factor per direction, updated by SetWind()
+		float _windFactor[8];
+		glm::vec2 _focusCenter;
+		float _focusRadius;
+		bool _bFocus;
+		bool _bLevelsDirty;
+		float _cellSize;
+		float _epoch;
+		double _time;
+		uint64_t _step;
+		uint64_t _numTileUpdates, _numCellUpdates;
+		size_t _numBurning;
+		size_t _numActiveTiles;
+		int _width, _height;
+		int _tilesX, _tilesY;
+	};
+
+};
+
+#endif //! end of TiledFireSpread.hpp
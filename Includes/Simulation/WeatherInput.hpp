@@ -0,0 +1,205 @@
+#ifndef WEATHER_INPUT_HPP
+#define WEATHER_INPUT_HPP
+
+#include <glm/vec2.hpp>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Simulation {
+
+	//! Weather observed by a station or interpolated onto a cell
+	struct WeatherSample
+	{
+		//! Wind in m/s, x east and y along increasing rows like Landscape::wind
+		glm::vec2 wind;
+		//! Relative humidity in percent
+		float humidity;
+		//! Air temperature in degrees Celsius
+		float temperature;
+	};
+
+	struct WeatherStation
+	{
+		std::string name;
+		//! Position in meters from the corner of the first landscape cell
+		glm::vec2 position;
+	};
+
+	//! One observation, records of a file are sorted by time
+	struct WeatherRecord
+	{
+		//! Seconds since the start of the scenario
+		double time;
+		uint32_t station;
+		WeatherSample sample;
+	};
+
+	//! Streams station time series from a file and interpolates them onto the landscape grid.
+	//! A station is linear in time between its records and holds its first and last value outside of
+	//! them, the grid weights the NUM_NEIGHBORS closest stations of every cell center by inverse squared
+	//! distance, found in a k-d tree of the stations. The record times of all stations split the time
+	//! line into windows in which every station is linear and the weights are fixed, so the fields are
+	//! exactly the blend of the two slices at the window ends. Update() only computes a slice when the
+	//! window advances, reusing the previous end slice as the new begin slice, and the neighbors and
+	//! weights only when stations join. Slices are computed in parallel over square tiles of the grid.
+	//! Files are read as far as the current window needs: until every station has a record after the
+	//! window end, or MAX_LOOKAHEAD seconds past it, after which a station holds its last value.
+	//! CSV files start with the header "station,x,y,time,wind_x,wind_y,humidity,temperature", the
+	//! first record of a station defines its position. Binary files start with BINARY_MAGIC,
+	//! BINARY_VERSION and the stations, see WriteBinary(). A station joins the fields at its first
+	//! record, before the first record of the file the fields hold their values at it.
+	//! FireSpread::SetWeather() takes the mean wind and the fuel moisture of the humidity and
+	//! temperature of every cell, the other engines only take a uniform wind from GetMeanSample().
+	class WeatherInput
+	{
+	public:
+		//! Edge length of a tile in cells
+		static constexpr int TILE_SIZE = 32;
+		//! Stations blended into every cell
+		static constexpr int NUM_NEIGHBORS = 4;
+		//! Seconds past the window end the file is read ahead for stations without a later record
+		static constexpr double MAX_LOOKAHEAD = 86400.0;
+		//! "GL3W" in little endian and the version of the binary format
+		static constexpr uint32_t BINARY_MAGIC = 0x57334C47u;
+		static constexpr uint32_t BINARY_VERSION = 1;
+		//! Longest station name in bytes a binary file may hold
+		static constexpr uint32_t MAX_NAME_LENGTH = 256;
+
+		//! Default constructor
+		WeatherInput();
+		//! Default destructor
+		~WeatherInput();
+		//! Size the fields to the landscape grid
+		bool Initialize(int width, int height, float cellSize);
+		//! Start streaming a file, CSV when the path ends in .csv and binary otherwise, returns false when
+		//! it can not be opened or has no records
+		bool Open(const std::string& path);
+		//! Interpolate the fields at time seconds, which never goes back. Returns false when the file
+		//! has a malformed or out of order record.
+		bool Update(double time);
+		//! Keep the slices and the weights across updates, on by default. Without caching every
+		//! Update() searches the neighbors and evaluates the stations at the exact time.
+		void SetCaching(bool bEnabled);
+		//! Write stations and time sorted records in either format
+		static bool WriteCSV(const std::string& path, const std::vector<WeatherStation>& stations, const std::vector<WeatherRecord>& records);
+		static bool WriteBinary(const std::string& path, const std::vector<WeatherStation>& stations, const std::vector<WeatherRecord>& records);
+		//! Returns the fields of the last Update(), row major with x fastest
+		inline const std::vector<glm::vec2>& GetWind() const
+		{
+			return _field.wind;
+		}
+		inline const std::vector<float>& GetHumidity() const
+		{
+			return _field.humidity;
+		}
+		inline const std::vector<float>& GetTemperature() const
+		{
+			return _field.temperature;
+		}
+		//! Returns the mean of the fields over the grid, e.g. for FireSpread::SetWind()
+		inline const WeatherSample& GetMeanSample() const
+		{
+			return _meanSample;
+		}
+		//! Returns the stations read so far
+		inline const std::vector<WeatherStation>& GetStations() const
+		{
+			return _stations;
+		}
+		//! Returns the time window of the cached slices
+		inline double GetWindowBegin() const
+		{
+			return _windowBegin;
+		}
+		inline double GetWindowEnd() const
+		{
+			return _windowEnd;
+		}
+		//! Returns the number of records read, slices and neighbor searches computed since Open()
+		inline uint64_t GetNumRecords() const
+		{
+			return _numRecords;
+		}
+		inline uint64_t GetNumSliceUpdates() const
+		{
+			return _numSliceUpdates;
+		}
+		inline uint64_t GetNumWeightUpdates() const
+		{
+			return _numWeightUpdates;
+		}
+		inline int GetWidth() const
+		{
+			return _width;
+		}
+		inline int GetHeight() const
+		{
+			return _height;
+		}
+	private:
+		//! Weather of every cell, row major with x fastest
+		struct Field
+		{
+			std::vector<glm::vec2> wind;
+			std::vector<float> humidity;
+			std::vector<float> temperature;
+		};
+
+		//! Read the next record into the history of its station, returns false at the end of the file
+		//! or on a malformed record
+		bool ReadRecord();
+		//! Read until a record after time or the end of the file
+		bool ReadPast(double time);
+		//! Interpolate a station at time from its history
+		WeatherSample EvaluateStation(uint32_t station, double time) const;
+		//! Build the k-d tree of the active stations over [begin, end) of _treeStations
+		void BuildTree(size_t begin, size_t end, int depth);
+		//! Find the NUM_NEIGHBORS closest active stations of a point, sorted by distance, returns their number
+		int FindNeighbors(const glm::vec2& point, uint32_t* neighbors, float* distances) const;
+		//! Search the neighbors and inverse distance weights of every cell
+		void UpdateWeights();
+		//! Blend the active stations evaluated at time into a field, returns its mean
+		WeatherSample UpdateSlice(double time, Field& field);
+		//! Blend the two slices into _field
+		void BlendSlices(float factor);
+
+		std::ifstream _file;
+		bool _bBinary;
+		bool _bEndOfFile;
+		bool _bFailed;
+		bool _bCaching;
+		bool _bSlicesValid;
+		std::vector<WeatherStation> _stations;
+		std::unordered_map<std::string, uint32_t> _stationIndices;
+		//! Records of every station from the last one at or before the window begin on
+		std::vector< std::deque<WeatherRecord> > _history;
+		//! Distinct record times from the window begin on
+		std::deque<double> _knots;
+		double _lastTime;
+		//! Stations with a record at or before the window begin, in k-d tree order with the split axis
+		//! alternating per depth starting at x
+		std::vector<uint32_t> _treeStations;
+		std::vector<glm::vec2> _treePositions;
+		//! Station values of the slice being computed and the share of the grid every station covers
+		std::vector<WeatherSample> _stationSamples;
+		std::vector<float> _stationCoverage;
+		//! NUM_NEIGHBORS tree positions and weights per cell, zero weights pad cells with fewer stations
+		std::vector<uint32_t> _neighbors;
+		std::vector<float> _weights;
+		Field _slices[2], _field;
+		WeatherSample _meanSlices[2], _meanSample;
+		double _windowBegin, _windowEnd;
+		double _time;
+		uint64_t _numRecords, _numSliceUpdates, _numWeightUpdates;
+		float _cellSize;
+		int _width, _height;
+		int _tilesX, _tilesY;
+	};
+
+};
+
+#endif //! end of WeatherInput.hpp
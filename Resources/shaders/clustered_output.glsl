@@ -0,0 +1,79 @@
+#version 450 core
+
+//! Forward shading with the lights of ClusteredLightCuller, which has to bind its buffers and send
+//! clusterParams through BindBuffers() before every draw with this shader.
+//! Cluster grid of ClusteredLightCuller
+const uint CLUSTER_X = 16;
+const uint CLUSTER_Y = 9;
+const uint CLUSTER_Z = 24;
+
+struct PointLight
+{
+	vec3 position;
+	float radius;
+	vec3 color;
+	float intensity;
+};
+
+in VSOUT
+{
+	vec3 worldPos;
+	vec3 normal;
+	vec2 texCoords;
+	vec4 color;
+} fs_in;
+
+layout(std140) uniform CamMatrices
+{
+	mat4 projection;
+	mat4 view;
+	mat4 viewProj;
+};
+
+layout(std430, binding = 1) readonly buffer Lights
+{
+	PointLight lights[];
+};
+
+layout(std430, binding = 2) readonly buffer Clusters
+{
+	uvec2 clusters[];
+};
+
+layout(std430, binding = 3) readonly buffer LightIndices
+{
+	uint lightIndices[];
+};
+
+//! Viewport width, height, near and far plane distance of the culled frustum
+uniform vec4 clusterParams;
+
+out vec4 fragColor;
+
+void main()
+{
+	//! Vertex colors replace the material color by their alpha.
+	vec3 albedo = mix(vec3(0.0f, 0.0f, 0.9f), fs_in.color.rgb, fs_in.color.a);
+	const vec3 ambient = vec3(0.1f);
+
+	//! Same exponential depth slicing as the CPU culler.
+	float depth = -(view * vec4(fs_in.worldPos, 1.0f)).z;
+	uint slice = uint(clamp(log(depth / clusterParams.z) / log(clusterParams.w / clusterParams.z) * float(CLUSTER_Z), 0.0f, float(CLUSTER_Z - 1)));
+	uvec2 tile = uvec2(clamp(gl_FragCoord.xy / clusterParams.xy * vec2(CLUSTER_X, CLUSTER_Y), vec2(0.0f), vec2(CLUSTER_X - 1, CLUSTER_Y - 1)));
+	uvec2 cluster = clusters[(slice * CLUSTER_Y + tile.y) * CLUSTER_X + tile.x];
+
+	vec3 normal = normalize(fs_in.normal);
+	vec3 radiance = albedo * ambient;
+	for (uint i = 0; i < cluster.y; ++i)
+	{
+		PointLight light = lights[lightIndices[cluster.x + i]];
+		vec3 toLight = light.position - fs_in.worldPos;
+		float distance = length(toLight);
+		//! Inverse square falloff windowed to reach zero at the culling radius.
+		float window = clamp(1.0f - pow(distance / light.radius, 4.0f), 0.0f, 1.0f);
+		float attenuation = light.intensity * window * window / (distance * distance + 1.0f);
+		radiance += albedo * light.color * attenuation * max(dot(normal, toLight / max(distance, 1e-4f)), 0.0f);
+	}
+
+	fragColor = vec4(radiance, 1.0f);
+}
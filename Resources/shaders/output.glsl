@@ -5,11 +5,13 @@ in VSOUT
 	vec3 worldPos;
 	vec3 normal;
 	vec2 texCoords;
+	vec4 color;
 } fs_in;
 
 out vec4 fragColor;
 
 void main()
 {
-	fragColor = vec4(vec3(0.0f, 0.0f, 0.9f), 1.0f);
+	//! Vertex colors replace the material color by their alpha.
+	fragColor = vec4(mix(vec3(0.0f, 0.0f, 0.9f), fs_in.color.rgb, fs_in.color.a), 1.0f);
 }
\ No newline at end of file
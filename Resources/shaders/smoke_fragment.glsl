@@ -0,0 +1,79 @@
+#version 450 core
+
+in vec2 ndcCoords;
+
+out vec4 fragColor;
+
+layout(std430, binding = 0) buffer SampleStats
+{
+	uint totalSamples;
+};
+
+uniform sampler3D densityTexture;
+uniform sampler3D occupancyTexture;
+uniform mat4 invViewProj;
+uniform vec3 volumeMin;
+uniform vec3 volumeMax;
+uniform vec3 gridExtent;
+uniform vec3 smokeAlbedo;
+uniform float stepSize;
+uniform float densityScale;
+uniform float occupancyThreshold;
+
+const float BRICK_SIZE = 8.0;
+const float MIN_TRANSMITTANCE = 0.01;
+
+void main()
+{
+	vec4 nearPoint = invViewProj * vec4(ndcCoords, -1.0, 1.0);
+	vec4 farPoint = invViewProj * vec4(ndcCoords, 1.0, 1.0);
+	vec3 origin = nearPoint.xyz / nearPoint.w;
+	vec3 direction = normalize(farPoint.xyz / farPoint.w - origin);
+
+	//! March in voxel units, the grid spans [0, gridExtent].
+	vec3 scale = gridExtent / (volumeMax - volumeMin);
+	vec3 gridOrigin = (origin - volumeMin) * scale;
+	vec3 gridDirection = direction * scale;
+	float voxelsPerMeter = length(gridDirection);
+	gridDirection /= voxelsPerMeter;
+
+	vec3 invDirection = 1.0 / gridDirection;
+	vec3 t0 = -gridOrigin * invDirection;
+	vec3 t1 = (gridExtent - gridOrigin) * invDirection;
+	vec3 tMin = min(t0, t1);
+	vec3 tMax = max(t0, t1);
+	float tNear = max(max(tMin.x, tMin.y), max(tMin.z, 0.0));
+	float tFar = min(min(tMax.x, tMax.y), tMax.z);
+	if (tNear >= tFar)
+		discard;
+
+	ivec3 brickExtent = textureSize(occupancyTexture, 0);
+	float opticalStep = densityScale * stepSize / voxelsPerMeter;
+	float transmittance = 1.0;
+	float radiance = 0.0;
+	uint numSamples = 0u;
+	float t = tNear;
+	while (t < tFar && transmittance > MIN_TRANSMITTANCE)
+	{
+		vec3 position = gridOrigin + gridDirection * t;
+		ivec3 brick = clamp(ivec3(position / BRICK_SIZE), ivec3(0), brickExtent - 1);
+		if (texelFetch(occupancyTexture, brick, 0).r <= occupancyThreshold)
+		{
+			//! Empty brick, jump to where the ray leaves it.
+			vec3 brickLower = vec3(brick) * BRICK_SIZE;
+			vec3 exits = (mix(brickLower, brickLower + BRICK_SIZE, greaterThan(gridDirection, vec3(0.0))) - position) * invDirection;
+			t += max(min(min(exits.x, exits.y), exits.z), 0.0) + 1e-3;
+			continue;
+		}
+
+		float density = textureLod(densityTexture, position / gridExtent, 0.0).r;
+		float alpha = 1.0 - exp(-opticalStep * density);
+		radiance += transmittance * alpha;
+		transmittance *= 1.0 - alpha;
+		t += stepSize;
+		++numSamples;
+	}
+
+	atomicAdd(totalSamples, numSamples);
+	fragColor = vec4(smokeAlbedo * radiance, 1.0 - transmittance);
+}
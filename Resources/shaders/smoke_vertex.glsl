@@ -0,0 +1,11 @@
+#version 450 core
+
+out vec2 ndcCoords;
+
+void main()
+{
+	//! Full screen triangle generated from the vertex index, no vertex buffer bound.
+	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+	ndcCoords = position;
+	gl_Position = vec4(position, 0.0, 1.0);
+}
@@ -1,8 +1,12 @@
 #version 450 core
 
 layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec2 texCoords;
+layout(location = 1) in vec2 texCoords;
+layout(location = 2) in vec3 normal;
+//! Identity unless drawn through Mesh::DrawInstanced()
+layout(location = 3) in mat4 instanceModel;
+//! Transparent unless drawn through Mesh::DrawColored()
+layout(location = 7) in vec4 vertexColor;
 
 layout(std140) uniform CamMatrices
 {
@@ -16,15 +20,18 @@ out VSOUT
 	vec3 worldPos;
 	vec3 normal;
 	vec2 texCoords;
+	vec4 color;
 } vs_out;
 
 uniform mat4 model;
 
 void main()
 {
-	vs_out.worldPos = (model * vec4(position, 1.0)).xyz;
-	vs_out.normal = normal;
+	mat4 world = model * instanceModel;
+	vs_out.worldPos = (world * vec4(position, 1.0)).xyz;
+	vs_out.normal = mat3(world) * normal;
 	vs_out.texCoords = texCoords;
+	vs_out.color = vertexColor;
 
 	gl_Position = viewProj * vec4(vs_out.worldPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include <GL3/Allocators.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+namespace
+{
+	//! Round value up to a multiple of the power of two alignment
+	inline size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+};
+
+namespace GL3 {
+
+	FrameArena& FrameArena::GetInstance()
+	{
+		static FrameArena instance;
+		return instance;
+	}
+
+	FrameArena::FrameArena()
+		: _current(0), _capacity(0), _peakBytes(0)
+	{
+		Initialize(DEFAULT_CAPACITY);
+	}
+
+	FrameArena::~FrameArena()
+	{
+		for (Buffer& buffer : _buffers)
+			ResetBuffer(buffer);
+	}
+
+	void FrameArena::Initialize(size_t capacity)
+	{
+		for (Buffer& buffer : _buffers)
+		{
+			ResetBuffer(buffer);
+			buffer.data.reset(new char[capacity]);
+		}
+		_capacity = capacity;
+		_current = 0;
+	}
+
+	void* FrameArena::Allocate(size_t numBytes, size_t alignment)
+	{
+		Buffer& buffer = _buffers[_current];
+		const uintptr_t base = reinterpret_cast<uintptr_t>(buffer.data.get());
+
+		//! Align the address rather than the offset, the buffer itself is only max_align_t aligned.
+		size_t offset = buffer.offset.load(std::memory_order_relaxed);
+		size_t begin, end;
+		do
+		{
+			begin = AlignUp(base + offset, alignment) - base;
+			end = begin + numBytes;
+			if (end > _capacity)
+				return AllocateOverflow(buffer, numBytes, alignment);
+		} while (!buffer.offset.compare_exchange_weak(offset, end, std::memory_order_relaxed));
+
+		FrameStatistics::GetInstance().Increment(FrameStatistics::PooledAllocations);
+		return buffer.data.get() + begin;
+	}
+
+	void* FrameArena::AllocateOverflow(Buffer& buffer, size_t numBytes, size_t alignment)
+	{
+		//! Over-allocate so any alignment fits, the block start is kept for the release.
+		char* block = new char[numBytes + alignment];
+		{
+			std::lock_guard<std::mutex> lock(_overflowMutex);
+			buffer.overflow.push_back(block);
+		}
+		const uintptr_t address = reinterpret_cast<uintptr_t>(block);
+		return block + (AlignUp(address, alignment) - address);
+	}
+
+	void FrameArena::EndFrame()
+	{
+		_peakBytes = std::max(_peakBytes, GetUsedBytes());
+		_current ^= 1;
+		ResetBuffer(_buffers[_current]);
+	}
+
+	void FrameArena::ResetBuffer(Buffer& buffer)
+	{
+		for (void* block : buffer.overflow)
+			delete[] static_cast<char*>(block);
+		buffer.overflow.clear();
+		buffer.offset.store(0, std::memory_order_relaxed);
+	}
+
+	FixedBlockPool::FixedBlockPool(size_t blockSize, size_t blocksPerChunk)
+		: _freeList(nullptr), _blockSize(AlignUp(std::max(blockSize, sizeof(FreeBlock)), alignof(std::max_align_t))),
+		  _blocksPerChunk(std::max<size_t>(blocksPerChunk, 1)), _numAllocated(0)
+	{
+		//! Do nothing
+	}
+
+	FixedBlockPool::~FixedBlockPool()
+	{
+		//! Do nothing
+	}
+
+	void* FixedBlockPool::Allocate()
+	{
+		if (!_freeList)
+		{
+			//! Thread the new chunk onto the free list in address order.
+			_chunks.emplace_back(new char[_blockSize * _blocksPerChunk]);
+			char* chunk = _chunks.back().get();
+			for (size_t block = _blocksPerChunk; block-- > 0;)
+			{
+				FreeBlock* freeBlock = reinterpret_cast<FreeBlock*>(chunk + block * _blockSize);
+				freeBlock->next = _freeList;
+				_freeList = freeBlock;
+			}
+		}
+
+		FreeBlock* block = _freeList;
+		_freeList = block->next;
+		++_numAllocated;
+		FrameStatistics::GetInstance().Increment(FrameStatistics::PooledAllocations);
+		return block;
+	}
+
+	void FixedBlockPool::Deallocate(void* block)
+	{
+		FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+		freeBlock->next = _freeList;
+		_freeList = freeBlock;
+		--_numAllocated;
+	}
+
+	PoolResource::PoolResource()
+	{
+		//! Do nothing
+	}
+
+	void* PoolResource::Allocate(size_t numBytes)
+	{
+		if (numBytes == 0 || numBytes > MAX_BLOCK_SIZE)
+			return ::operator new(std::max<size_t>(numBytes, 1));
+
+		const size_t sizeClass = (numBytes - 1) / SIZE_CLASS_GRANULARITY;
+		if (!_pools[sizeClass])
+			_pools[sizeClass].reset(new FixedBlockPool((sizeClass + 1) * SIZE_CLASS_GRANULARITY));
+		return _pools[sizeClass]->Allocate();
+	}
+
+	void PoolResource::Deallocate(void* pointer, size_t numBytes)
+	{
+		if (numBytes == 0 || numBytes > MAX_BLOCK_SIZE)
+		{
+			::operator delete(pointer);
+			return;
+		}
+		//! A size class without a pool never handed out this pointer, so there is nothing to return.
+		const std::unique_ptr<FixedBlockPool>& pool = _pools[(numBytes - 1) / SIZE_CLASS_GRANULARITY];
+		assert(pool);
+		if (pool)
+			pool->Deallocate(pointer);
+	}
+};
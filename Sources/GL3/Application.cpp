@@ -2,6 +2,7 @@
 #include <GL3/Camera.hpp>
 #include <GL3/PerspectiveCamera.hpp>
 #include <GL3/DebugUtils.hpp>
+#include <GL3/MemoryTracker.hpp>
 #include <GL3/Shader.hpp>
 #include <GL3/Window.hpp>
 #include <glad/glad.h>
@@ -10,6 +11,7 @@
 namespace GL3 {
 
 	Application::Application()
+		: _qualitySettings{ 1.0f, 1.0f, 0.0f }, _memoryApplication(0)
 	{
 		//! Do nothing
 	}
@@ -21,6 +23,8 @@ namespace GL3 {
 
 	bool Application::Initialize(std::shared_ptr<GL3::Window> window, const cxxopts::ParseResult& configure)
 	{
+		_memoryApplication = MemoryTracker::GetInstance().RegisterApplication(GetAppTitle());
+		MemoryScope memoryScope(MemoryTracker::GetCurrentTag(), _memoryApplication);
 		if (!OnInitialize(window, configure))
 			return false;
 
@@ -34,19 +38,23 @@ namespace GL3 {
 
 	void Application::Update(double dt)
 	{
+		MemoryScope memoryScope(MemoryTracker::GetCurrentTag(), _memoryApplication);
 		OnUpdate(dt);
 	}
 
 	void Application::Draw()
 	{
+		MemoryScope memoryScope(MemoryTracker::GetCurrentTag(), _memoryApplication);
 		OnDraw();
 	}
 
 	void Application::CleanUp()
 	{
+		MemoryScope memoryScope(MemoryTracker::GetCurrentTag(), _memoryApplication);
 		_shaders.clear();
 		_textures.clear();
 		_cameras.clear();
+		_scene.Clear();
 
 		OnCleanUp();
 	}
@@ -65,4 +73,15 @@ namespace GL3 {
 			camera->ProcessCursorPos(xpos, ypos);
 	}
 
+	void Application::SetQualitySettings(const QualitySettings& settings)
+	{
+		_qualitySettings = settings;
+	}
+
+	bool Application::UsesQualityKnob(QualityKnob knob) const
+	{
+		//! Every application renders through the scaled offscreen target
+		return knob == QualityKnob::RenderScale;
+	}
+
 };
\ No newline at end of file
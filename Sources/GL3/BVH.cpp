@@ -0,0 +1,521 @@
+#include <GL3/BVH.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/Profiler.hpp>
+#include <GL3/Mesh.hpp>
+#include <GL3/SIMD.hpp>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace
+{
+	//! Nodes with at least this many triangles are split before the parallel subtree builds,
+	//! with their bins filled by the workers.
+	constexpr uint32_t PARALLEL_SPLIT_TRIANGLES = 8192;
+	//! Triangles binned by a single job of the parallel binning
+	constexpr uint32_t BINNING_CHUNK = 16384;
+	//! Nodes up to this size become leaves when splitting does not lower the SAH cost
+	constexpr uint32_t MAX_LEAF_TRIANGLES = 8;
+	constexpr float INF = std::numeric_limits<float>::infinity();
+
+	struct Bin
+	{
+		glm::vec3 lower = glm::vec3(INF);
+		glm::vec3 upper = glm::vec3(-INF);
+		uint32_t count = 0;
+
+		void Merge(const glm::vec3& otherLower, const glm::vec3& otherUpper)
+		{
+			lower = glm::min(lower, otherLower);
+			upper = glm::max(upper, otherUpper);
+		}
+	};
+
+	//! Per-worker binning scratch, reused across the splits of a subtree build.
+	thread_local std::vector<glm::vec3> tChunkLower;
+	thread_local std::vector<glm::vec3> tChunkUpper;
+	thread_local std::vector<Bin> tChunkBins;
+
+	inline float HalfArea(const glm::vec3& lower, const glm::vec3& upper)
+	{
+		const glm::vec3 extent = upper - lower;
+		return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+	}
+
+	//! Run job(begin, end) over the range in BINNING_CHUNK pieces, spread over the workers when asked.
+	template <typename Function>
+	void ForEachChunk(uint32_t begin, uint32_t end, bool bParallel, const Function& job)
+	{
+		const uint32_t numChunks = bParallel ? (end - begin + BINNING_CHUNK - 1) / BINNING_CHUNK : 1;
+		if (numChunks <= 1)
+		{
+			job(0, begin, end);
+			return;
+		}
+		GL3::JobSystem::GetInstance().ParallelFor(numChunks, [&](size_t chunk)
+		{
+			const uint32_t chunkBegin = begin + static_cast<uint32_t>(chunk) * BINNING_CHUNK;
+			job(chunk, chunkBegin, std::min(end, chunkBegin + BINNING_CHUNK));
+		});
+	}
+};
+
+namespace GL3 {
+
+	BVH::BVH()
+	{
+		//! Do nothing
+	}
+
+	BVH::~BVH()
+	{
+		//! Do nothing
+	}
+
+	bool BVH::Build(const Mesh& mesh)
+	{
+		return Build(mesh.GetPositions(), mesh.GetIndices());
+	}
+
+	bool BVH::Build(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices)
+	{
+		ProfileScope scope("BVH::Build", indices.size() / 3);
+		_nodes.clear();
+		_triangles.clear();
+		_triangleIds.clear();
+
+		const uint32_t numTriangles = static_cast<uint32_t>(indices.size() / 3);
+		for (unsigned int index : indices)
+		{
+			if (index >= positions.size())
+			{
+				std::cerr << "BVH triangle index " << index << " exceeds " << positions.size() << " positions" << std::endl;
+				return false;
+			}
+		}
+		if (numTriangles == 0)
+			return true;
+
+		auto& jobSystem = JobSystem::GetInstance();
+		_centroids.resize(numTriangles);
+		_triangleLower.resize(numTriangles);
+		_triangleUpper.resize(numTriangles);
+		ForEachChunk(0, numTriangles, true, [&](size_t, uint32_t begin, uint32_t end)
+		{
+			for (uint32_t triangle = begin; triangle < end; ++triangle)
+			{
+				const glm::vec3& a = positions[indices[triangle * 3]];
+				const glm::vec3& b = positions[indices[triangle * 3 + 1]];
+				const glm::vec3& c = positions[indices[triangle * 3 + 2]];
+				_triangleLower[triangle] = glm::min(a, glm::min(b, c));
+				_triangleUpper[triangle] = glm::max(a, glm::max(b, c));
+				_centroids[triangle] = (a + b + c) / 3.0f;
+			}
+		});
+		_order.resize(numTriangles);
+		std::iota(_order.begin(), _order.end(), 0u);
+
+		Node root;
+		glm::vec3 lower(INF), upper(-INF);
+		for (uint32_t triangle = 0; triangle < numTriangles; ++triangle)
+		{
+			lower = glm::min(lower, _triangleLower[triangle]);
+			upper = glm::max(upper, _triangleUpper[triangle]);
+		}
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			root.lower[axis] = lower[axis];
+			root.upper[axis] = upper[axis];
+		}
+		root.leftOrFirst = 0;
+		root.count = numTriangles;
+		_nodes.push_back(root);
+
+		//! Split the upper levels breadth first with parallel binning until every pending node is small
+		//! enough to be built by a single worker.
+		std::vector<uint32_t> frontier = { 0 };
+		std::vector<BuildTask> tasks;
+		for (int depth = 0; !frontier.empty(); ++depth)
+		{
+			std::vector<uint32_t> nextFrontier;
+			for (uint32_t nodeIndex : frontier)
+			{
+				const Node node = _nodes[nodeIndex];
+				if (node.count >= PARALLEL_SPLIT_TRIANGLES && SplitNode(_nodes, nodeIndex, depth, true))
+				{
+					nextFrontier.push_back(_nodes[nodeIndex].leftOrFirst);
+					nextFrontier.push_back(_nodes[nodeIndex].leftOrFirst + 1);
+				}
+				else
+				{
+					tasks.push_back({ nodeIndex, node.leftOrFirst, node.leftOrFirst + node.count, depth });
+				}
+			}
+			frontier.swap(nextFrontier);
+		}
+
+		std::vector< std::vector<Node> > subtrees(tasks.size());
+		jobSystem.ParallelFor(tasks.size(), [&](size_t task)
+		{
+			subtrees[task].push_back(_nodes[tasks[task].node]);
+			BuildSubtree(subtrees[task], 0, tasks[task].depth);
+		});
+
+		//! Splice the subtrees in, their roots replace the pending nodes and the rest is appended.
+		for (size_t task = 0; task < tasks.size(); ++task)
+		{
+			std::vector<Node>& subtree = subtrees[task];
+			const uint32_t offset = static_cast<uint32_t>(_nodes.size());
+			for (Node& node : subtree)
+				if (node.count == 0)
+					node.leftOrFirst = offset + node.leftOrFirst - 1;
+			_nodes[tasks[task].node] = subtree.front();
+			_nodes.insert(_nodes.end(), subtree.begin() + 1, subtree.end());
+		}
+
+		//! Store the triangles in leaf order, ready for intersection.
+		_triangles.resize(numTriangles);
+		_triangleIds.resize(numTriangles);
+		ForEachChunk(0, numTriangles, true, [&](size_t, uint32_t begin, uint32_t end)
+		{
+			for (uint32_t slot = begin; slot < end; ++slot)
+			{
+				const uint32_t triangle = _order[slot];
+				const glm::vec3& a = positions[indices[triangle * 3]];
+				_triangles[slot].v0 = a;
+				_triangles[slot].edge1 = positions[indices[triangle * 3 + 1]] - a;
+				_triangles[slot].edge2 = positions[indices[triangle * 3 + 2]] - a;
+				_triangleIds[slot] = triangle;
+			}
+		});
+
+		_centroids.clear();
+		_centroids.shrink_to_fit();
+		_triangleLower.clear();
+		_triangleLower.shrink_to_fit();
+		_triangleUpper.clear();
+		_triangleUpper.shrink_to_fit();
+		_order.clear();
+		_order.shrink_to_fit();
+
+		return true;
+	}
+
+	bool BVH::SplitNode(std::vector<Node>& nodes, uint32_t nodeIndex, int depth, bool bParallelBinning)
+	{
+		const Node node = nodes[nodeIndex];
+		if (node.count <= static_cast<uint32_t>(MIN_LEAF_TRIANGLES) || depth >= MAX_DEPTH)
+			return false;
+
+		const uint32_t begin = node.leftOrFirst;
+		const uint32_t end = begin + node.count;
+		const size_t numChunks = bParallelBinning ? (node.count + BINNING_CHUNK - 1) / BINNING_CHUNK : 1;
+
+		//! Bins are spread over the centroid bounds, not the node bounds.
+		//! The scratch belongs to the splitting thread, the workers of a parallel split only write their chunk.
+		std::vector<glm::vec3>& chunkLower = tChunkLower;
+		std::vector<glm::vec3>& chunkUpper = tChunkUpper;
+		chunkLower.assign(numChunks, glm::vec3(INF));
+		chunkUpper.assign(numChunks, glm::vec3(-INF));
+		ForEachChunk(begin, end, bParallelBinning, [&](size_t chunk, uint32_t chunkBegin, uint32_t chunkEnd)
+		{
+			for (uint32_t slot = chunkBegin; slot < chunkEnd; ++slot)
+			{
+				chunkLower[chunk] = glm::min(chunkLower[chunk], _centroids[_order[slot]]);
+				chunkUpper[chunk] = glm::max(chunkUpper[chunk], _centroids[_order[slot]]);
+			}
+		});
+		glm::vec3 centroidLower(INF), centroidUpper(-INF);
+		for (size_t chunk = 0; chunk < numChunks; ++chunk)
+		{
+			centroidLower = glm::min(centroidLower, chunkLower[chunk]);
+			centroidUpper = glm::max(centroidUpper, chunkUpper[chunk]);
+		}
+		const glm::vec3 centroidExtent = centroidUpper - centroidLower;
+		if (centroidExtent.x <= 0.0f && centroidExtent.y <= 0.0f && centroidExtent.z <= 0.0f)
+			return false;
+
+		const glm::vec3 binScale = glm::vec3(static_cast<float>(NUM_BINS)) / glm::max(centroidExtent, glm::vec3(1e-30f));
+		auto BinIndex = [&](const glm::vec3& centroid, int axis)
+		{
+			return std::min(NUM_BINS - 1, static_cast<int>((centroid[axis] - centroidLower[axis]) * binScale[axis]));
+		};
+
+		std::vector<Bin>& chunkBins = tChunkBins;
+		chunkBins.assign(numChunks * 3 * NUM_BINS, Bin());
+		ForEachChunk(begin, end, bParallelBinning, [&](size_t chunk, uint32_t chunkBegin, uint32_t chunkEnd)
+		{
+			Bin* bins = chunkBins.data() + chunk * 3 * NUM_BINS;
+			for (uint32_t slot = chunkBegin; slot < chunkEnd; ++slot)
+			{
+				const uint32_t triangle = _order[slot];
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					Bin& bin = bins[axis * NUM_BINS + BinIndex(_centroids[triangle], axis)];
+					bin.Merge(_triangleLower[triangle], _triangleUpper[triangle]);
+					++bin.count;
+				}
+			}
+		});
+
+		Bin bins[3][NUM_BINS];
+		for (size_t chunk = 0; chunk < numChunks; ++chunk)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				for (int bin = 0; bin < NUM_BINS; ++bin)
+				{
+					const Bin& chunkBin = chunkBins[(chunk * 3 + axis) * NUM_BINS + bin];
+					bins[axis][bin].Merge(chunkBin.lower, chunkBin.upper);
+					bins[axis][bin].count += chunkBin.count;
+				}
+			}
+		}
+
+		//! Sweep the bin planes from both sides and keep the cheapest SAH split.
+		float bestCost = INF;
+		int bestAxis = -1, bestSplit = 0;
+		Bin bestLeft, bestRight;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (centroidExtent[axis] <= 0.0f)
+				continue;
+
+			Bin rightSweep[NUM_BINS];
+			Bin accumulated;
+			for (int bin = NUM_BINS - 1; bin > 0; --bin)
+			{
+				accumulated.Merge(bins[axis][bin].lower, bins[axis][bin].upper);
+				accumulated.count += bins[axis][bin].count;
+				rightSweep[bin] = accumulated;
+			}
+
+			Bin left;
+			for (int split = 1; split < NUM_BINS; ++split)
+			{
+				left.Merge(bins[axis][split - 1].lower, bins[axis][split - 1].upper);
+				left.count += bins[axis][split - 1].count;
+				const Bin& right = rightSweep[split];
+				if (left.count == 0 || right.count == 0)
+					continue;
+
+				const float cost = HalfArea(left.lower, left.upper) * left.count + HalfArea(right.lower, right.upper) * right.count;
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+					bestLeft = left;
+					bestRight = right;
+				}
+			}
+		}
+
+		if (bestAxis < 0)
+			return false;
+
+		const glm::vec3 nodeLower(node.lower[0], node.lower[1], node.lower[2]);
+		const glm::vec3 nodeUpper(node.upper[0], node.upper[1], node.upper[2]);
+		const float leafCost = HalfArea(nodeLower, nodeUpper) * node.count;
+		if (node.count <= MAX_LEAF_TRIANGLES && bestCost >= leafCost)
+			return false;
+
+		std::partition(_order.begin() + begin, _order.begin() + end, [&](uint32_t triangle)
+		{
+			return BinIndex(_centroids[triangle], bestAxis) < bestSplit;
+		});
+
+		Node children[2];
+		const Bin* childBins[2] = { &bestLeft, &bestRight };
+		for (int child = 0; child < 2; ++child)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				children[child].lower[axis] = childBins[child]->lower[axis];
+				children[child].upper[axis] = childBins[child]->upper[axis];
+			}
+		}
+		children[0].leftOrFirst = begin;
+		children[0].count = bestLeft.count;
+		children[1].leftOrFirst = begin + bestLeft.count;
+		children[1].count = bestRight.count;
+
+		nodes[nodeIndex].leftOrFirst = static_cast<uint32_t>(nodes.size());
+		nodes[nodeIndex].count = 0;
+		nodes.push_back(children[0]);
+		nodes.push_back(children[1]);
+
+		return true;
+	}
+
+	void BVH::BuildSubtree(std::vector<Node>& nodes, uint32_t nodeIndex, int depth)
+	{
+		std::vector< std::pair<uint32_t, int> > pending = { { nodeIndex, depth } };
+		while (!pending.empty())
+		{
+			const std::pair<uint32_t, int> current = pending.back();
+			pending.pop_back();
+			if (SplitNode(nodes, current.first, current.second, false))
+			{
+				//! Right child is pushed first so the left subtree directly follows its parent.
+				pending.push_back({ nodes[current.first].leftOrFirst + 1, current.second + 1 });
+				pending.push_back({ nodes[current.first].leftOrFirst, current.second + 1 });
+			}
+		}
+	}
+
+	BoundingBox BVH::GetBoundingBox() const
+	{
+		BoundingBox bounds;
+		if (!_nodes.empty())
+		{
+			bounds.Merge(glm::vec3(_nodes[0].lower[0], _nodes[0].lower[1], _nodes[0].lower[2]));
+			bounds.Merge(glm::vec3(_nodes[0].upper[0], _nodes[0].upper[1], _nodes[0].upper[2]));
+		}
+		return bounds;
+	}
+
+	bool BVH::Intersect(const glm::vec3& origin, const glm::vec3& direction, float tMax, RayHit& hit) const
+	{
+		return Traverse(origin, direction, tMax, false, hit);
+	}
+
+	bool BVH::IsOccluded(const glm::vec3& origin, const glm::vec3& direction, float tMax) const
+	{
+		RayHit hit;
+		return Traverse(origin, direction, tMax, true, hit);
+	}
+
+	bool BVH::Traverse(const glm::vec3& origin, const glm::vec3& direction, float tMax, bool bAnyHit, RayHit& hit) const
+	{
+		if (_nodes.empty())
+			return false;
+
+		const glm::vec3 inverseDirection = 1.0f / direction;
+#ifdef GL3_USE_SSE2
+		const __m128 rayOrigin = _mm_set_ps(0.0f, origin.z, origin.y, origin.x);
+		const __m128 rayInverse = _mm_set_ps(0.0f, inverseDirection.z, inverseDirection.y, inverseDirection.x);
+#endif
+		//! Slab test of a node, the fourth lane holds the child or count and is left out of the reduction.
+		auto IntersectBox = [&](const Node& node, float tFar, float& tNear)
+		{
+#ifdef GL3_USE_SSE2
+			const __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.lower), rayOrigin), rayInverse);
+			const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.upper), rayOrigin), rayInverse);
+			const __m128 entry = _mm_min_ps(t0, t1);
+			const __m128 exit = _mm_max_ps(t0, t1);
+			__m128 entryMax = _mm_max_ss(entry, _mm_shuffle_ps(entry, entry, _MM_SHUFFLE(3, 3, 3, 1)));
+			entryMax = _mm_max_ss(entryMax, _mm_shuffle_ps(entry, entry, _MM_SHUFFLE(3, 3, 3, 2)));
+			__m128 exitMin = _mm_min_ss(exit, _mm_shuffle_ps(exit, exit, _MM_SHUFFLE(3, 3, 3, 1)));
+			exitMin = _mm_min_ss(exitMin, _mm_shuffle_ps(exit, exit, _MM_SHUFFLE(3, 3, 3, 2)));
+			tNear = std::max(_mm_cvtss_f32(entryMax), 0.0f);
+			return tNear <= std::min(_mm_cvtss_f32(exitMin), tFar);
+#else
+			float entry = 0.0f, exit = tFar;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float t0 = (node.lower[axis] - origin[axis]) * inverseDirection[axis];
+				const float t1 = (node.upper[axis] - origin[axis]) * inverseDirection[axis];
+				entry = std::max(entry, std::min(t0, t1));
+				exit = std::min(exit, std::max(t0, t1));
+			}
+			tNear = entry;
+			return entry <= exit;
+#endif
+		};
+
+		float closest = tMax;
+		bool bHit = false;
+		float rootNear;
+		if (!IntersectBox(_nodes[0], closest, rootNear))
+			return false;
+
+		struct StackEntry
+		{
+			uint32_t node;
+			float tNear;
+		};
+		//! Every level above the current node holds at most one deferred sibling.
+		StackEntry stack[MAX_DEPTH];
+		int stackSize = 0;
+		uint32_t current = 0;
+		while (true)
+		{
+			const Node& node = _nodes[current];
+			if (node.count > 0)
+			{
+				for (uint32_t slot = node.leftOrFirst; slot < node.leftOrFirst + node.count; ++slot)
+				{
+					//! Moller-Trumbore, both faces count as hits.
+					const Triangle& triangle = _triangles[slot];
+					const glm::vec3 p = glm::cross(direction, triangle.edge2);
+					const float determinant = glm::dot(triangle.edge1, p);
+					if (std::fabs(determinant) < 1e-12f)
+						continue;
+					const float inverseDeterminant = 1.0f / determinant;
+					const glm::vec3 s = origin - triangle.v0;
+					const float u = glm::dot(s, p) * inverseDeterminant;
+					if (u < 0.0f || u > 1.0f)
+						continue;
+					const glm::vec3 q = glm::cross(s, triangle.edge1);
+					const float v = glm::dot(direction, q) * inverseDeterminant;
+					if (v < 0.0f || u + v > 1.0f)
+						continue;
+					const float t = glm::dot(triangle.edge2, q) * inverseDeterminant;
+					if (t <= 0.0f || t > closest)
+						continue;
+
+					closest = t;
+					hit.t = t;
+					hit.u = u;
+					hit.v = v;
+					hit.triangle = _triangleIds[slot];
+					bHit = true;
+					if (bAnyHit)
+						return true;
+				}
+			}
+			else
+			{
+				float tLeft, tRight;
+				const bool bLeft = IntersectBox(_nodes[node.leftOrFirst], closest, tLeft);
+				const bool bRight = IntersectBox(_nodes[node.leftOrFirst + 1], closest, tRight);
+				if (bLeft && bRight)
+				{
+					//! Visit the nearer child first, the farther one waits on the stack.
+					const bool bLeftFirst = tLeft <= tRight;
+					stack[stackSize++] = { node.leftOrFirst + (bLeftFirst ? 1u : 0u), bLeftFirst ? tRight : tLeft };
+					current = node.leftOrFirst + (bLeftFirst ? 0u : 1u);
+					continue;
+				}
+				if (bLeft || bRight)
+				{
+					current = node.leftOrFirst + (bLeft ? 0u : 1u);
+					continue;
+				}
+			}
+
+			//! Pop the next subtree that can still hold a closer hit.
+			bool bFound = false;
+			while (stackSize > 0)
+			{
+				const StackEntry entry = stack[--stackSize];
+				if (entry.tNear <= closest)
+				{
+					current = entry.node;
+					bFound = true;
+					break;
+				}
+			}
+			if (!bFound)
+				break;
+		}
+
+		return bHit;
+	}
+
+};
@@ -1,4 +1,5 @@
 #include <GL3/Camera.hpp>
+#include <GL3/MemoryTracker.hpp>
 #include <glad/glad.h>
 #include <glfw/glfw3.h>
 #include <glm/gtc/quaternion.hpp>
@@ -26,6 +27,7 @@ namespace GL3 {
 		glBindBuffer(GL_UNIFORM_BUFFER, _uniformBuffer);
 		glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::mat4) * 3, nullptr, GL_STATIC_DRAW);
 		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		MemoryTracker::GetInstance().AllocateGPU(MemoryTracker::Camera, sizeof(glm::mat4) * 3);
 
 		return true;
 	}
@@ -126,6 +128,11 @@ namespace GL3 {
 
 	void Camera::CleanUp()
 	{
-		if (_uniformBuffer) glDeleteBuffers(1, &_uniformBuffer);
+		if (_uniformBuffer)
+		{
+			glDeleteBuffers(1, &_uniformBuffer);
+			MemoryTracker::GetInstance().ReleaseGPU(MemoryTracker::Camera, sizeof(glm::mat4) * 3);
+		}
+		_uniformBuffer = 0;
 	}
 };
\ No newline at end of file
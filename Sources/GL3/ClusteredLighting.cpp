@@ -0,0 +1,343 @@
+#include <GL3/ClusteredLighting.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <GL3/Shader.hpp>
+#include <GL3/SIMD.hpp>
+#include <glad/glad.h>
+#include <glm/common.hpp>
+#include <glm/matrix.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	constexpr int NUM_CLUSTERS = GL3::ClusteredLightCuller::CLUSTER_X * GL3::ClusteredLightCuller::CLUSTER_Y * GL3::ClusteredLightCuller::CLUSTER_Z;
+	//! Emission color of the aggregated fire lights
+	const glm::vec3 FIRE_COLOR(1.0f, 0.45f, 0.15f);
+
+	//! Light spheres as separate coordinate arrays, padded to a multiple of four.
+	struct LightSet
+	{
+		std::vector<float> x, y, z, r;
+		std::vector<uint32_t> index;
+
+		void Clear()
+		{
+			x.clear(); y.clear(); z.clear(); r.clear(); index.clear();
+		}
+		void Push(float lx, float ly, float lz, float lr, uint32_t lightIndex)
+		{
+			x.push_back(lx); y.push_back(ly); z.push_back(lz); r.push_back(lr); index.push_back(lightIndex);
+		}
+		//! Padding spheres sit far away with zero radius and never overlap a cluster.
+		void Pad()
+		{
+			while (index.size() % 4 != 0)
+				Push(1e18f, 1e18f, 1e18f, 0.0f, std::numeric_limits<uint32_t>::max());
+		}
+	};
+
+	//! Per-worker candidate lists of the depth slice and of the tile row being culled.
+	thread_local LightSet tSliceLights;
+	thread_local LightSet tRowLights;
+
+	//! Returns a four bit mask of the spheres starting at offset that overlap the box.
+	inline int OverlapMask4(const LightSet& set, size_t offset, const glm::vec3& lower, const glm::vec3& upper)
+	{
+#ifdef GL3_USE_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		__m128 distance2 = zero;
+		const float* centers[3] = { set.x.data() + offset, set.y.data() + offset, set.z.data() + offset };
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const __m128 center = _mm_loadu_ps(centers[axis]);
+			//! At most one side of the box is positive, their sum is the distance to the slab.
+			const __m128 below = _mm_max_ps(_mm_sub_ps(_mm_set1_ps(lower[axis]), center), zero);
+			const __m128 above = _mm_max_ps(_mm_sub_ps(center, _mm_set1_ps(upper[axis])), zero);
+			const __m128 delta = _mm_add_ps(below, above);
+			distance2 = _mm_add_ps(distance2, _mm_mul_ps(delta, delta));
+		}
+		const __m128 radius = _mm_loadu_ps(set.r.data() + offset);
+		return _mm_movemask_ps(_mm_cmple_ps(distance2, _mm_mul_ps(radius, radius)));
+#else
+		int mask = 0;
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			const glm::vec3 center(set.x[offset + lane], set.y[offset + lane], set.z[offset + lane]);
+			const glm::vec3 delta = glm::max(lower - center, 0.0f) + glm::max(center - upper, 0.0f);
+			const float radius = set.r[offset + lane];
+			if (delta.x * delta.x + delta.y * delta.y + delta.z * delta.z <= radius * radius)
+				mask |= 1 << lane;
+		}
+		return mask;
+#endif
+	}
+
+	//! Upload the array into the shader storage buffer, empty arrays keep a single element. Returns the buffer size.
+	template <typename Type>
+	size_t UploadStorage(GLuint buffer, const std::vector<Type>& data)
+	{
+		const size_t numBytes = sizeof(Type) * std::max<size_t>(1, data.size());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, numBytes, nullptr, GL_DYNAMIC_DRAW);
+		if (!data.empty())
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Type) * data.size(), data.data());
+		return numBytes;
+	}
+};
+
+namespace GL3 {
+
+	ClusteredLightCuller::ClusteredLightCuller()
+		: _projection(0.0f), _zNear(0.0f), _zFar(0.0f), _maxLightsPerCluster(0),
+		  _lightBuffer(0), _clusterBuffer(0), _indexBuffer(0), _gpuBytes(0), _bGLInitialized(false)
+	{
+		//! Do nothing
+	}
+
+	ClusteredLightCuller::~ClusteredLightCuller()
+	{
+		CleanUp();
+	}
+
+	bool ClusteredLightCuller::InitializeGL()
+	{
+		glGenBuffers(1, &_lightBuffer);
+		glGenBuffers(1, &_clusterBuffer);
+		glGenBuffers(1, &_indexBuffer);
+		_bGLInitialized = true;
+
+		return true;
+	}
+
+	void ClusteredLightCuller::SetLights(const std::vector<PointLight>& lights)
+	{
+		_lights = lights;
+	}
+
+	void ClusteredLightCuller::AggregateFireLights(const float* intensity, int width, int height, float cellSize, int tileSize,
+												   float lightHeight, float cutoffIntensity, std::vector<PointLight>& lights)
+	{
+		lights.clear();
+		if (width <= 0 || height <= 0 || tileSize <= 0)
+			return;
+
+		const int tilesX = (width + tileSize - 1) / tileSize;
+		const int tilesY = (height + tileSize - 1) / tileSize;
+		const float cutoff = std::max(cutoffIntensity, 1e-6f);
+
+		//! Tile rows are merged into separate lists to keep the light order deterministic.
+		std::vector< std::vector<PointLight> > rowLights(tilesY);
+		JobSystem::GetInstance().ParallelFor(tilesY, [&](size_t tileY)
+		{
+			const int yBegin = static_cast<int>(tileY) * tileSize;
+			const int yEnd = std::min(height, yBegin + tileSize);
+			for (int tileX = 0; tileX < tilesX; ++tileX)
+			{
+				const int xBegin = tileX * tileSize;
+				const int xEnd = std::min(width, xBegin + tileSize);
+				float totalIntensity = 0.0f, weightedX = 0.0f, weightedY = 0.0f;
+				for (int y = yBegin; y < yEnd; ++y)
+				{
+					for (int x = xBegin; x < xEnd; ++x)
+					{
+						const float value = intensity[static_cast<size_t>(y) * width + x];
+						if (value <= 0.0f)
+							continue;
+						totalIntensity += value;
+						weightedX += value * (static_cast<float>(x) + 0.5f);
+						weightedY += value * (static_cast<float>(y) + 0.5f);
+					}
+				}
+				if (totalIntensity <= 0.0f)
+					continue;
+
+				PointLight light;
+				light.position = glm::vec3(weightedX / totalIntensity * cellSize, lightHeight, weightedY / totalIntensity * cellSize);
+				light.radius = std::sqrt(totalIntensity / cutoff);
+				light.color = FIRE_COLOR;
+				light.intensity = totalIntensity;
+				rowLights[tileY].push_back(light);
+			}
+		});
+
+		for (const auto& row : rowLights)
+			lights.insert(lights.end(), row.begin(), row.end());
+	}
+
+	void ClusteredLightCuller::BuildClusterBounds(const glm::mat4& projection, float zNear, float zFar)
+	{
+		_projection = projection;
+		_zNear = zNear;
+		_zFar = zFar;
+
+		_sliceDepths.resize(CLUSTER_Z + 1);
+		for (int slice = 0; slice <= CLUSTER_Z; ++slice)
+			_sliceDepths[slice] = zNear * std::pow(zFar / zNear, static_cast<float>(slice) / CLUSTER_Z);
+
+		//! Tile corners are unprojected onto the near plane and pushed along their view rays to the slice depths.
+		const glm::mat4 inverseProjection = glm::inverse(projection);
+		_clusterBounds.resize(NUM_CLUSTERS * 2);
+		for (int tileY = 0; tileY < CLUSTER_Y; ++tileY)
+		for (int tileX = 0; tileX < CLUSTER_X; ++tileX)
+		{
+			glm::vec3 corners[4];
+			for (int corner = 0; corner < 4; ++corner)
+			{
+				const float ndcX = -1.0f + 2.0f * static_cast<float>(tileX + (corner & 1)) / CLUSTER_X;
+				const float ndcY = -1.0f + 2.0f * static_cast<float>(tileY + (corner >> 1)) / CLUSTER_Y;
+				const glm::vec4 point = inverseProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+				corners[corner] = glm::vec3(point) / point.w;
+			}
+
+			for (int slice = 0; slice < CLUSTER_Z; ++slice)
+			{
+				glm::vec3 lower(std::numeric_limits<float>::max()), upper(-std::numeric_limits<float>::max());
+				for (const auto& corner : corners)
+				{
+					for (int end = 0; end < 2; ++end)
+					{
+						const glm::vec3 point = corner * (_sliceDepths[slice + end] / -corner.z);
+						lower = glm::min(lower, point);
+						upper = glm::max(upper, point);
+					}
+				}
+				const size_t cluster = (static_cast<size_t>(slice) * CLUSTER_Y + tileY) * CLUSTER_X + tileX;
+				_clusterBounds[cluster * 2] = lower;
+				_clusterBounds[cluster * 2 + 1] = upper;
+			}
+		}
+	}
+
+	void ClusteredLightCuller::Cull(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar)
+	{
+		ProfileScope scope("ClusteredLightCuller::Cull", _lights.size());
+		if (projection != _projection || zNear != _zNear || zFar != _zFar || _clusterBounds.empty())
+			BuildClusterBounds(projection, zNear, zFar);
+
+		for (auto& component : _viewLights)
+			component.resize(_lights.size());
+		for (size_t light = 0; light < _lights.size(); ++light)
+		{
+			const glm::vec4 position = view * glm::vec4(_lights[light].position, 1.0f);
+			_viewLights[0][light] = position.x;
+			_viewLights[1][light] = position.y;
+			_viewLights[2][light] = position.z;
+			_viewLights[3][light] = _lights[light].radius;
+		}
+
+		_sliceIndices.resize(CLUSTER_Z);
+		_clusterCounts.assign(NUM_CLUSTERS, 0);
+
+		//! Every slice narrows the lights down by depth, then by tile row, then tests the clusters of the row.
+		JobSystem::GetInstance().ParallelFor(CLUSTER_Z, [&](size_t slice)
+		{
+			auto& indices = _sliceIndices[slice];
+			indices.clear();
+
+			const float sliceNear = _sliceDepths[slice];
+			const float sliceFar = _sliceDepths[slice + 1];
+			tSliceLights.Clear();
+			for (size_t light = 0; light < _lights.size(); ++light)
+			{
+				const float depth = -_viewLights[2][light];
+				const float radius = _viewLights[3][light];
+				if (depth + radius >= sliceNear && depth - radius <= sliceFar)
+					tSliceLights.Push(_viewLights[0][light], _viewLights[1][light], _viewLights[2][light], radius, static_cast<uint32_t>(light));
+			}
+			if (tSliceLights.index.empty())
+				return;
+			tSliceLights.Pad();
+
+			for (int tileY = 0; tileY < CLUSTER_Y; ++tileY)
+			{
+				const size_t rowStart = (slice * CLUSTER_Y + tileY) * CLUSTER_X;
+				glm::vec3 rowLower = _clusterBounds[rowStart * 2], rowUpper = _clusterBounds[rowStart * 2 + 1];
+				for (int tileX = 1; tileX < CLUSTER_X; ++tileX)
+				{
+					rowLower = glm::min(rowLower, _clusterBounds[(rowStart + tileX) * 2]);
+					rowUpper = glm::max(rowUpper, _clusterBounds[(rowStart + tileX) * 2 + 1]);
+				}
+
+				tRowLights.Clear();
+				for (size_t offset = 0; offset < tSliceLights.index.size(); offset += 4)
+				{
+					const int mask = OverlapMask4(tSliceLights, offset, rowLower, rowUpper);
+					for (int lane = 0; mask && lane < 4; ++lane)
+					{
+						const size_t light = offset + lane;
+						if (mask & (1 << lane))
+							tRowLights.Push(tSliceLights.x[light], tSliceLights.y[light], tSliceLights.z[light], tSliceLights.r[light], tSliceLights.index[light]);
+					}
+				}
+				if (tRowLights.index.empty())
+					continue;
+				tRowLights.Pad();
+
+				for (int tileX = 0; tileX < CLUSTER_X; ++tileX)
+				{
+					const size_t cluster = rowStart + tileX;
+					const size_t numIndices = indices.size();
+					for (size_t offset = 0; offset < tRowLights.index.size(); offset += 4)
+					{
+						const int mask = OverlapMask4(tRowLights, offset, _clusterBounds[cluster * 2], _clusterBounds[cluster * 2 + 1]);
+						for (int lane = 0; mask && lane < 4; ++lane)
+							if (mask & (1 << lane))
+								indices.push_back(tRowLights.index[offset + lane]);
+					}
+					_clusterCounts[cluster] = static_cast<uint32_t>(indices.size() - numIndices);
+				}
+			}
+		});
+
+		//! Slices are stored back to back, so the cluster offsets are a running sum in cluster order.
+		_clusterRecords.resize(NUM_CLUSTERS * 2);
+		_lightIndices.clear();
+		_maxLightsPerCluster = 0;
+		uint32_t offset = 0;
+		for (int cluster = 0; cluster < NUM_CLUSTERS; ++cluster)
+		{
+			_clusterRecords[cluster * 2] = offset;
+			_clusterRecords[cluster * 2 + 1] = _clusterCounts[cluster];
+			offset += _clusterCounts[cluster];
+			_maxLightsPerCluster = std::max<size_t>(_maxLightsPerCluster, _clusterCounts[cluster]);
+		}
+		for (const auto& indices : _sliceIndices)
+			_lightIndices.insert(_lightIndices.end(), indices.begin(), indices.end());
+
+		if (_bGLInitialized)
+		{
+			auto& memoryTracker = MemoryTracker::GetInstance();
+			memoryTracker.ReleaseGPU(MemoryTracker::Rendering, _gpuBytes);
+			_gpuBytes = UploadStorage(_lightBuffer, _lights) + UploadStorage(_clusterBuffer, _clusterRecords) + UploadStorage(_indexBuffer, _lightIndices);
+			memoryTracker.AllocateGPU(MemoryTracker::Rendering, _gpuBytes);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		}
+	}
+
+	void ClusteredLightCuller::BindBuffers(Shader& shader, int width, int height) const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_BINDING, _lightBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_BINDING, _clusterBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INDEX_BINDING, _indexBuffer);
+		FrameStatistics::GetInstance().Increment(FrameStatistics::BufferBinds, 3);
+		shader.SendUniformVariable("clusterParams", glm::vec4(static_cast<float>(width), static_cast<float>(height), _zNear, _zFar));
+	}
+
+	void ClusteredLightCuller::CleanUp()
+	{
+		if (_lightBuffer) glDeleteBuffers(1, &_lightBuffer);
+		if (_clusterBuffer) glDeleteBuffers(1, &_clusterBuffer);
+		if (_indexBuffer) glDeleteBuffers(1, &_indexBuffer);
+		_lightBuffer = 0;
+		_clusterBuffer = 0;
+		_indexBuffer = 0;
+		MemoryTracker::GetInstance().ReleaseGPU(MemoryTracker::Rendering, _gpuBytes);
+		_gpuBytes = 0;
+		_bGLInitialized = false;
+	}
+
+};
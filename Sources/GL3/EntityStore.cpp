@@ -0,0 +1,191 @@
+#include <GL3/EntityStore.hpp>
+#include <GL3/DebugUtils.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	//! Element size of every registered component id
+	std::array<uint32_t, GL3::EntityStore::MAX_COMPONENTS> gComponentSizes;
+	std::atomic<uint32_t> gNumComponents(0);
+};
+
+namespace GL3 {
+
+	EntityStore::EntityStore()
+		: _numEntities(0)
+	{
+		//! Do nothing
+	}
+
+	EntityStore::~EntityStore()
+	{
+		//! Do nothing
+	}
+
+	uint32_t EntityStore::RegisterComponent(size_t elementSize)
+	{
+		const uint32_t id = gNumComponents.fetch_add(1);
+		if (id >= MAX_COMPONENTS)
+		{
+			std::cerr << "More than " << MAX_COMPONENTS << " component types registered" << std::endl;
+			StackTrace::PrintStack();
+			std::abort();
+		}
+		gComponentSizes[id] = static_cast<uint32_t>(elementSize);
+		return id;
+	}
+
+	bool EntityStore::IsAlive(Entity entity) const
+	{
+		return entity.index < _records.size() && _records[entity.index].generation == entity.generation &&
+			   _records[entity.index].archetype != NULL_ENTITY.index;
+	}
+
+	bool EntityStore::Destroy(Entity entity)
+	{
+		if (!IsAlive(entity))
+			return false;
+
+		Record& record = _records[entity.index];
+		RemoveRow(record.archetype, record.row);
+		record.archetype = NULL_ENTITY.index;
+		++record.generation;
+		_freeIndices.push_back(entity.index);
+		--_numEntities;
+
+		return true;
+	}
+
+	void EntityStore::Clear()
+	{
+		for (uint32_t index = 0; index < _records.size(); ++index)
+			if (_records[index].archetype != NULL_ENTITY.index)
+				Destroy({ index, _records[index].generation });
+	}
+
+	size_t EntityStore::GetComponentBytes() const
+	{
+		size_t numBytes = 0;
+		for (const Archetype& archetype : _archetypes)
+			for (const Column& column : archetype.columns)
+				numBytes += column.data.size();
+		return numBytes;
+	}
+
+	uint32_t EntityStore::GetArchetype(Signature signature)
+	{
+		auto iter = _archetypeLookup.find(signature);
+		if (iter != _archetypeLookup.end())
+			return iter->second;
+
+		Archetype archetype;
+		archetype.signature = signature;
+		archetype.columnIndex.fill(NO_COLUMN);
+		for (uint32_t componentID = 0; componentID < MAX_COMPONENTS; ++componentID)
+		{
+			if ((signature & (Signature(1) << componentID)) == 0)
+				continue;
+			archetype.columnIndex[componentID] = static_cast<uint8_t>(archetype.columns.size());
+			archetype.columns.push_back({ componentID, gComponentSizes[componentID], {} });
+		}
+
+		const uint32_t index = static_cast<uint32_t>(_archetypes.size());
+		_archetypes.push_back(std::move(archetype));
+		_archetypeLookup.emplace(signature, index);
+		return index;
+	}
+
+	void* EntityStore::GetComponent(Entity entity, uint32_t componentID)
+	{
+		if (!IsAlive(entity))
+			return nullptr;
+
+		const Record& record = _records[entity.index];
+		Archetype& archetype = _archetypes[record.archetype];
+		const uint8_t column = archetype.columnIndex[componentID];
+		if (column == NO_COLUMN)
+			return nullptr;
+		return archetype.columns[column].data.data() + static_cast<size_t>(record.row) * archetype.columns[column].elementSize;
+	}
+
+	Entity EntityStore::AllocateEntity(uint32_t archetype)
+	{
+		uint32_t index;
+		if (_freeIndices.empty())
+		{
+			index = static_cast<uint32_t>(_records.size());
+			_records.push_back({ NULL_ENTITY.index, 0, 0 });
+		}
+		else
+		{
+			index = _freeIndices.back();
+			_freeIndices.pop_back();
+		}
+
+		Archetype& target = _archetypes[archetype];
+		Record& record = _records[index];
+		record.archetype = archetype;
+		record.row = static_cast<uint32_t>(target.entities.size());
+		const Entity entity = { index, record.generation };
+		target.entities.push_back(entity);
+		for (Column& column : target.columns)
+			column.data.resize(column.data.size() + column.elementSize);
+		++_numEntities;
+
+		return entity;
+	}
+
+	void EntityStore::MoveEntity(Entity entity, Signature signature)
+	{
+		const uint32_t targetIndex = GetArchetype(signature);
+		Record& record = _records[entity.index];
+		const uint32_t sourceIndex = record.archetype, sourceRow = record.row;
+
+		Archetype& target = _archetypes[targetIndex];
+		const uint32_t targetRow = static_cast<uint32_t>(target.entities.size());
+		target.entities.push_back(entity);
+		for (Column& column : target.columns)
+		{
+			column.data.resize(column.data.size() + column.elementSize);
+			const uint8_t sourceColumn = _archetypes[sourceIndex].columnIndex[column.componentID];
+			if (sourceColumn != NO_COLUMN)
+				std::memcpy(column.data.data() + static_cast<size_t>(targetRow) * column.elementSize,
+							_archetypes[sourceIndex].columns[sourceColumn].data.data() + static_cast<size_t>(sourceRow) * column.elementSize,
+							column.elementSize);
+		}
+
+		RemoveRow(sourceIndex, sourceRow);
+		record.archetype = targetIndex;
+		record.row = targetRow;
+	}
+
+	void EntityStore::RemoveRow(uint32_t archetype, uint32_t row)
+	{
+		Archetype& source = _archetypes[archetype];
+		const uint32_t lastRow = static_cast<uint32_t>(source.entities.size() - 1);
+		if (row != lastRow)
+		{
+			const Entity moved = source.entities[lastRow];
+			source.entities[row] = moved;
+			for (Column& column : source.columns)
+				std::memcpy(column.data.data() + static_cast<size_t>(row) * column.elementSize,
+							column.data.data() + static_cast<size_t>(lastRow) * column.elementSize, column.elementSize);
+			_records[moved.index].row = row;
+		}
+
+		source.entities.pop_back();
+		for (Column& column : source.columns)
+			column.data.resize(column.data.size() - column.elementSize);
+	}
+
+	void EntityStore::GetMatchingArchetypes(Signature signature, std::vector<uint32_t>& matches) const
+	{
+		for (uint32_t index = 0; index < _archetypes.size(); ++index)
+			if ((_archetypes[index].signature & signature) == signature)
+				matches.push_back(index);
+	}
+
+};
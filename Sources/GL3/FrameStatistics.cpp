@@ -0,0 +1,26 @@
+#include <GL3/FrameStatistics.hpp>
+
+namespace GL3 {
+
+	FrameStatistics& FrameStatistics::GetInstance()
+	{
+		static FrameStatistics instance;
+		return instance;
+	}
+
+	FrameStatistics::FrameStatistics()
+	{
+		Reset();
+	}
+
+	void FrameStatistics::Reset(Counter counter)
+	{
+		_counters[counter].store(0, std::memory_order_relaxed);
+	}
+
+	void FrameStatistics::Reset()
+	{
+		for (int counter = 0; counter < NumCounters; ++counter)
+			Reset(static_cast<Counter>(counter));
+	}
+};
@@ -0,0 +1,125 @@
+#include <GL3/GLDrawBackend.hpp>
+#include <GL3/ClusteredLighting.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/InstanceBuffer.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Mesh.hpp>
+#include <GL3/Shader.hpp>
+#include <GL3/VertexColorBuffer.hpp>
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace GL3 {
+
+	GLDrawBackend::GLDrawBackend()
+		: _culler(nullptr), _cameraBuffer(0), _bBound(false)
+	{
+		//! Do nothing
+	}
+
+	GLDrawBackend::~GLDrawBackend()
+	{
+		CleanUp();
+	}
+
+	bool GLDrawBackend::Initialize(std::shared_ptr<Shader> shader)
+	{
+		CleanUp();
+		_shader = std::move(shader);
+		if (!_shader)
+			return false;
+		_shader->BindUniformBlock("CamMatrices", CAMERA_BINDING);
+
+		glGenBuffers(1, &_cameraBuffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, _cameraBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::mat4) * 3, nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		MemoryTracker::GetInstance().AllocateGPU(MemoryTracker::Camera, sizeof(glm::mat4) * 3);
+
+		return true;
+	}
+
+	void GLDrawBackend::SetCamera(const glm::mat4& view, const glm::mat4& projection)
+	{
+		//! Same layout as Camera::UpdateMatrix()
+		const glm::mat4 matrices[3] = { projection, view, projection * view };
+		glBindBuffer(GL_UNIFORM_BUFFER, _cameraBuffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(matrices), glm::value_ptr(matrices[0]));
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	void GLDrawBackend::SetLighting(const ClusteredLightCuller* culler)
+	{
+		_culler = culler;
+		_bBound = false;
+	}
+
+	void GLDrawBackend::Clear(const glm::vec4& color, float depth)
+	{
+		glClearColor(color.r, color.g, color.b, color.a);
+		glClearDepth(depth);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+
+	void GLDrawBackend::BindState(const glm::mat4& model)
+	{
+		if (!_bBound)
+		{
+			_shader->BindShaderProgram();
+			glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, _cameraBuffer);
+			FrameStatistics::GetInstance().Increment(FrameStatistics::BufferBinds);
+			//! The cluster tiles follow the bound viewport, which shrinks with the render scale.
+			if (_culler)
+			{
+				GLint viewport[4];
+				glGetIntegerv(GL_VIEWPORT, viewport);
+				_culler->BindBuffers(*_shader, viewport[2], viewport[3]);
+			}
+			glEnable(GL_DEPTH_TEST);
+			_bBound = true;
+		}
+		_shader->SendUniformVariable("model", model);
+	}
+
+	void GLDrawBackend::DrawMesh(const Mesh& mesh, const glm::mat4& model)
+	{
+		BindState(model);
+		mesh.DrawMesh(GL_TRIANGLES);
+	}
+
+	void GLDrawBackend::DrawColored(const Mesh& mesh, const glm::mat4& model, const VertexColorBuffer& colors)
+	{
+		BindState(model);
+		mesh.DrawColored(GL_TRIANGLES, colors);
+	}
+
+	void GLDrawBackend::DrawInstanced(const Mesh& mesh, const InstanceBuffer& instances, size_t first, size_t count)
+	{
+		BindState(glm::mat4(1.0f));
+		mesh.DrawInstanced(GL_TRIANGLES, instances, first, count);
+	}
+
+	void GLDrawBackend::Flush()
+	{
+		//! The draws are already queued on the context, only the bound state is dropped.
+		if (!_bBound)
+			return;
+		glDisable(GL_DEPTH_TEST);
+		Shader::UnbindShaderProgram();
+		_bBound = false;
+	}
+
+	void GLDrawBackend::CleanUp()
+	{
+		if (_cameraBuffer)
+		{
+			glDeleteBuffers(1, &_cameraBuffer);
+			MemoryTracker::GetInstance().ReleaseGPU(MemoryTracker::Camera, sizeof(glm::mat4) * 3);
+		}
+		_cameraBuffer = 0;
+		_shader.reset();
+		_culler = nullptr;
+		_bBound = false;
+	}
+
+};
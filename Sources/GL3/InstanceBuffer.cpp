@@ -0,0 +1,42 @@
+#include <GL3/InstanceBuffer.hpp>
+
+namespace GL3 {
+
+	InstanceBuffer::InstanceBuffer()
+		: _capacity(0)
+	{
+		//! Do nothing
+	}
+
+	InstanceBuffer::~InstanceBuffer()
+	{
+		//! Do nothing
+	}
+
+	bool InstanceBuffer::Initialize(size_t capacity)
+	{
+		CleanUp();
+		if (!_ring.Initialize(capacity * sizeof(glm::mat4)))
+			return false;
+
+		_capacity = capacity;
+		return true;
+	}
+
+	glm::mat4* InstanceBuffer::BeginWrite()
+	{
+		return static_cast<glm::mat4*>(_ring.BeginWrite());
+	}
+
+	void InstanceBuffer::EndFrame()
+	{
+		_ring.EndFrame();
+	}
+
+	void InstanceBuffer::CleanUp()
+	{
+		_ring.CleanUp();
+		_capacity = 0;
+	}
+
+};
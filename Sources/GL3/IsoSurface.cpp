@@ -0,0 +1,419 @@
+#include <GL3/IsoSurface.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/Profiler.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <array>
+#include <iostream>
+
+namespace
+{
+	//! Cube corner offsets, corner i is ((i ^ (i >> 1)) & 1, (i >> 1) & 1, (i >> 2) & 1).
+	constexpr int CORNERS[8][3] = {
+		{ 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 },
+		{ 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 },
+	};
+	//! Cube edges as corner pairs
+	constexpr int EDGES[12][2] = {
+		{ 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 },
+		{ 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 },
+		{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
+	};
+	//! Cube faces as corner loops, counter-clockwise seen from outside the cube
+	constexpr int FACES[6][4] = {
+		{ 0, 4, 7, 3 }, { 1, 2, 6, 5 },
+		{ 0, 1, 5, 4 }, { 3, 7, 6, 2 },
+		{ 0, 3, 2, 1 }, { 4, 5, 6, 7 },
+	};
+	//! At most 12 crossing edges in at least one loop of three or more
+	constexpr int MAX_TRIANGLE_EDGES = 30;
+
+	struct CaseTable
+	{
+		//! Triangle edge indices per corner configuration, terminated by -1
+		std::array<std::array<int8_t, MAX_TRIANGLE_EDGES + 1>, 256> triangles;
+		//! Lowest corner of the edge relative to the cell and its axis
+		int edgeOrigin[12][3];
+		int edgeAxis[12];
+
+		CaseTable()
+		{
+			for (int edge = 0; edge < 12; ++edge)
+			{
+				const int* a = CORNERS[EDGES[edge][0]];
+				const int* b = CORNERS[EDGES[edge][1]];
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					edgeOrigin[edge][axis] = std::min(a[axis], b[axis]);
+					if (a[axis] != b[axis])
+						edgeAxis[edge] = axis;
+				}
+			}
+
+			for (int config = 0; config < 256; ++config)
+				BuildCase(config);
+		}
+
+		static int FindEdge(int a, int b)
+		{
+			for (int edge = 0; edge < 12; ++edge)
+				if ((EDGES[edge][0] == a && EDGES[edge][1] == b) || (EDGES[edge][0] == b && EDGES[edge][1] == a))
+					return edge;
+			return -1;
+		}
+
+		//! Walk the surface polygons of a configuration over the cube faces and fan them into triangles.
+		//! Every face links the crossing entering a run of inside corners to the crossing leaving it,
+		//! which keeps diagonal inside corners apart and so matches the decision of the neighbor cell.
+		void BuildCase(int config)
+		{
+			int next[12];
+			std::fill(next, next + 12, -1);
+			for (const auto& face : FACES)
+			{
+				for (int i = 0; i < 4; ++i)
+				{
+					const int corner = face[i];
+					const int following = face[(i + 1) % 4];
+					const bool bInside = (config >> corner) & 1;
+					const bool bFollowingInside = (config >> following) & 1;
+					if (!bInside || bFollowingInside)
+						continue;
+
+					//! Walk back to the crossing where this run of inside corners starts.
+					int start = i;
+					while ((config >> face[(start + 3) % 4]) & 1)
+						start = (start + 3) % 4;
+					const int exitEdge = FindEdge(corner, following);
+					const int entryEdge = FindEdge(face[(start + 3) % 4], face[start]);
+					next[entryEdge] = exitEdge;
+				}
+			}
+
+			auto& triangleEdges = triangles[config];
+			int count = 0;
+			bool visited[12] = {};
+			for (int first = 0; first < 12; ++first)
+			{
+				if (next[first] < 0 || visited[first])
+					continue;
+
+				int loop[12];
+				int length = 0;
+				for (int edge = first; !visited[edge]; edge = next[edge])
+				{
+					visited[edge] = true;
+					loop[length++] = edge;
+				}
+
+				for (int i = 1; i + 1 < length; ++i)
+				{
+					triangleEdges[count++] = static_cast<int8_t>(loop[0]);
+					triangleEdges[count++] = static_cast<int8_t>(loop[i]);
+					triangleEdges[count++] = static_cast<int8_t>(loop[i + 1]);
+				}
+			}
+			triangleEdges[count] = -1;
+		}
+	};
+
+	const CaseTable& GetCaseTable()
+	{
+		static const CaseTable table;
+		return table;
+	}
+
+	inline size_t SampleIndex(const glm::ivec3& extent, int x, int y, int z)
+	{
+		return (static_cast<size_t>(z) * extent.y + y) * extent.x + x;
+	}
+
+	//! Central difference gradient in grid units, one-sided on the boundary
+	glm::vec3 Gradient(const float* field, const glm::ivec3& extent, const glm::ivec3& point)
+	{
+		glm::vec3 gradient;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			glm::ivec3 lower = point, upper = point;
+			lower[axis] = std::max(0, point[axis] - 1);
+			upper[axis] = std::min(extent[axis] - 1, point[axis] + 1);
+			const float distance = static_cast<float>(upper[axis] - lower[axis]);
+			gradient[axis] = (field[SampleIndex(extent, upper.x, upper.y, upper.z)] -
+							  field[SampleIndex(extent, lower.x, lower.y, lower.z)]) / distance;
+		}
+		return gradient;
+	}
+
+	//! Block flags, block lists and prefix sums of an extraction, reused by the calls of the thread
+	thread_local std::vector<char> tDirty, tRetriangulate;
+	thread_local std::vector<size_t> tDirtyBlocks, tTriangulateBlocks;
+	thread_local std::vector<size_t> tVertexOffsets, tIndexOffsets;
+};
+
+namespace GL3 {
+
+	IsoSurfaceExtractor::IsoSurfaceExtractor()
+		: _extent(0), _numBlocks(0), _origin(0.0f), _spacing(1.0f), _previousIsoValue(0.0f), _numSkippedBlocks(0)
+	{
+		//! Do nothing
+	}
+
+	IsoSurfaceExtractor::~IsoSurfaceExtractor()
+	{
+		//! Do nothing
+	}
+
+	bool IsoSurfaceExtractor::Initialize(const glm::ivec3& extent, const glm::vec3& origin, const glm::vec3& spacing)
+	{
+		if (extent.x < 2 || extent.y < 2 || extent.z < 2)
+		{
+			std::cerr << "Isosurface grid needs at least 2 samples per axis, got "
+					  << extent.x << "x" << extent.y << "x" << extent.z << std::endl;
+			return false;
+		}
+
+		_extent = extent;
+		_origin = origin;
+		_spacing = spacing;
+		_numBlocks = (extent - 1 + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+		_blocks.clear();
+		_blocks.resize(static_cast<size_t>(_numBlocks.x) * _numBlocks.y * _numBlocks.z);
+		for (int bz = 0; bz < _numBlocks.z; ++bz)
+		for (int by = 0; by < _numBlocks.y; ++by)
+		for (int bx = 0; bx < _numBlocks.x; ++bx)
+		{
+			const glm::ivec3 blockCoord(bx, by, bz);
+			Block& block = _blocks[(static_cast<size_t>(bz) * _numBlocks.y + by) * _numBlocks.x + bx];
+			block.firstPoint = blockCoord * BLOCK_SIZE;
+			//! The last block of an axis also owns the final sample plane.
+			for (int axis = 0; axis < 3; ++axis)
+				block.numPoints[axis] = blockCoord[axis] + 1 == _numBlocks[axis] ? _extent[axis] - block.firstPoint[axis] : BLOCK_SIZE;
+			block.edgeVertices.assign(static_cast<size_t>(block.numPoints.x) * block.numPoints.y * block.numPoints.z * 3, -1);
+			block.vertices.clear();
+			block.triangles.clear();
+			block.minValue = block.maxValue = 0.0f;
+			block.bActive = false;
+		}
+
+		_previousField.clear();
+		_vertices.clear();
+		_indices.clear();
+		_numSkippedBlocks = 0;
+
+		return true;
+	}
+
+	size_t IsoSurfaceExtractor::GetOwnerBlock(const glm::ivec3& point) const
+	{
+		const glm::ivec3 blockCoord = glm::min(point / BLOCK_SIZE, _numBlocks - 1);
+		return (static_cast<size_t>(blockCoord.z) * _numBlocks.y + blockCoord.y) * _numBlocks.x + blockCoord.x;
+	}
+
+	size_t IsoSurfaceExtractor::Extract(const float* field, float isoValue)
+	{
+		if (_blocks.empty())
+			return 0;
+
+		const size_t numSamples = static_cast<size_t>(_extent.x) * _extent.y * _extent.z;
+		ProfileScope scope("IsoSurfaceExtractor::Extract", numSamples);
+		const bool bFullExtract = _previousField.size() != numSamples || isoValue != _previousIsoValue;
+		auto& jobSystem = JobSystem::GetInstance();
+
+		//! A block is dirty when any sample its vertices read changed, including the gradient stencil.
+		std::vector<char>& dirty = tDirty;
+		dirty.assign(_blocks.size(), bFullExtract ? 1 : 0);
+		if (!bFullExtract)
+		{
+			jobSystem.ParallelFor(_blocks.size(), [&](size_t blockIndex)
+			{
+				const Block& block = _blocks[blockIndex];
+				const glm::ivec3 lower = glm::max(block.firstPoint - 1, glm::ivec3(0));
+				const glm::ivec3 upper = glm::min(block.firstPoint + block.numPoints + 1, _extent - 1);
+				for (int z = lower.z; z <= upper.z; ++z)
+				for (int y = lower.y; y <= upper.y; ++y)
+				{
+					const size_t row = SampleIndex(_extent, lower.x, y, z);
+					if (!std::equal(field + row, field + row + (upper.x - lower.x + 1), _previousField.begin() + row))
+					{
+						dirty[blockIndex] = 1;
+						return;
+					}
+				}
+			});
+		}
+
+		std::vector<size_t>& dirtyBlocks = tDirtyBlocks;
+		dirtyBlocks.clear();
+		for (size_t blockIndex = 0; blockIndex < _blocks.size(); ++blockIndex)
+			if (dirty[blockIndex])
+				dirtyBlocks.push_back(blockIndex);
+
+		if (dirtyBlocks.empty())
+			return 0;
+
+		//! Refresh the range summary and the owned vertices of the dirty blocks.
+		jobSystem.ParallelFor(dirtyBlocks.size(), [&](size_t job)
+		{
+			GenerateVertices(_blocks[dirtyBlocks[job]], field, isoValue);
+		});
+
+		//! Triangles reference vertices of the upper neighbors, so the lower neighbors of a dirty
+		//! block have to pick up its new local indices.
+		std::vector<char>& retriangulate = tRetriangulate;
+		retriangulate.assign(_blocks.size(), 0);
+		for (size_t blockIndex : dirtyBlocks)
+		{
+			const glm::ivec3 blockCoord(static_cast<int>(blockIndex % _numBlocks.x),
+										static_cast<int>((blockIndex / _numBlocks.x) % _numBlocks.y),
+										static_cast<int>(blockIndex / (static_cast<size_t>(_numBlocks.x) * _numBlocks.y)));
+			for (int dz = 0; dz <= 1; ++dz)
+			for (int dy = 0; dy <= 1; ++dy)
+			for (int dx = 0; dx <= 1; ++dx)
+			{
+				const glm::ivec3 neighbor = blockCoord - glm::ivec3(dx, dy, dz);
+				if (neighbor.x >= 0 && neighbor.y >= 0 && neighbor.z >= 0)
+					retriangulate[(static_cast<size_t>(neighbor.z) * _numBlocks.y + neighbor.y) * _numBlocks.x + neighbor.x] = 1;
+			}
+		}
+
+		std::vector<size_t>& triangulateBlocks = tTriangulateBlocks;
+		triangulateBlocks.clear();
+		for (size_t blockIndex = 0; blockIndex < _blocks.size(); ++blockIndex)
+			if (retriangulate[blockIndex])
+				triangulateBlocks.push_back(blockIndex);
+
+		jobSystem.ParallelFor(triangulateBlocks.size(), [&](size_t job)
+		{
+			Triangulate(triangulateBlocks[job], field, isoValue);
+		});
+
+		Assemble();
+
+		_previousField.assign(field, field + numSamples);
+		_previousIsoValue = isoValue;
+		_numSkippedBlocks = std::count_if(_blocks.begin(), _blocks.end(), [](const Block& block) { return !block.bActive; });
+
+		return dirtyBlocks.size();
+	}
+
+	void IsoSurfaceExtractor::GenerateVertices(Block& block, const float* field, float isoValue) const
+	{
+		block.vertices.clear();
+
+		//! Range over every sample touched by the cells of the block.
+		const glm::ivec3 cellEnd = glm::min(block.firstPoint + BLOCK_SIZE, _extent - 1);
+		block.minValue = block.maxValue = field[SampleIndex(_extent, block.firstPoint.x, block.firstPoint.y, block.firstPoint.z)];
+		for (int z = block.firstPoint.z; z <= cellEnd.z; ++z)
+		for (int y = block.firstPoint.y; y <= cellEnd.y; ++y)
+		{
+			const size_t row = SampleIndex(_extent, block.firstPoint.x, y, z);
+			const auto range = std::minmax_element(field + row, field + row + (cellEnd.x - block.firstPoint.x + 1));
+			block.minValue = std::min(block.minValue, *range.first);
+			block.maxValue = std::max(block.maxValue, *range.second);
+		}
+
+		//! Owned edges end inside the same range, so a block without a crossing creates no vertex
+		//! and no neighbor ever looks up its stale edge table.
+		block.bActive = block.minValue < isoValue && block.maxValue >= isoValue;
+		if (!block.bActive)
+			return;
+
+		size_t edgeIndex = 0;
+		for (int lz = 0; lz < block.numPoints.z; ++lz)
+		for (int ly = 0; ly < block.numPoints.y; ++ly)
+		for (int lx = 0; lx < block.numPoints.x; ++lx)
+		{
+			const glm::ivec3 point = block.firstPoint + glm::ivec3(lx, ly, lz);
+			const float value = field[SampleIndex(_extent, point.x, point.y, point.z)];
+			for (int axis = 0; axis < 3; ++axis, ++edgeIndex)
+			{
+				block.edgeVertices[edgeIndex] = -1;
+				glm::ivec3 end = point;
+				end[axis] += 1;
+				if (end[axis] >= _extent[axis])
+					continue;
+
+				const float endValue = field[SampleIndex(_extent, end.x, end.y, end.z)];
+				if ((value >= isoValue) == (endValue >= isoValue))
+					continue;
+
+				const float t = (isoValue - value) / (endValue - value);
+				glm::vec3 gridPosition(point);
+				gridPosition[axis] += t;
+
+				//! Normals face down the gradient, out of the region above the iso value.
+				const glm::vec3 gradient = glm::mix(Gradient(field, _extent, point), Gradient(field, _extent, end), t) / _spacing;
+				const float length = glm::length(gradient);
+				const glm::vec3 normal = length > 0.0f ? -gradient / length : glm::vec3(0.0f, 1.0f, 0.0f);
+
+				block.edgeVertices[edgeIndex] = static_cast<int32_t>(block.vertices.size());
+				block.vertices.emplace_back(_origin + gridPosition * _spacing, glm::vec2(t, 0.0f), normal);
+			}
+		}
+	}
+
+	void IsoSurfaceExtractor::Triangulate(size_t blockIndex, const float* field, float isoValue)
+	{
+		Block& block = _blocks[blockIndex];
+		block.triangles.clear();
+		if (!block.bActive)
+			return;
+
+		const CaseTable& table = GetCaseTable();
+		const glm::ivec3 cellEnd = glm::min(block.firstPoint + BLOCK_SIZE, _extent - 1);
+		for (int z = block.firstPoint.z; z < cellEnd.z; ++z)
+		for (int y = block.firstPoint.y; y < cellEnd.y; ++y)
+		for (int x = block.firstPoint.x; x < cellEnd.x; ++x)
+		{
+			int config = 0;
+			for (int corner = 0; corner < 8; ++corner)
+			{
+				const float value = field[SampleIndex(_extent, x + CORNERS[corner][0], y + CORNERS[corner][1], z + CORNERS[corner][2])];
+				config |= (value >= isoValue ? 1 : 0) << corner;
+			}
+			if (config == 0 || config == 255)
+				continue;
+
+			for (const int8_t* edge = table.triangles[config].data(); *edge >= 0; ++edge)
+			{
+				const glm::ivec3 origin = glm::ivec3(x, y, z) + glm::ivec3(table.edgeOrigin[*edge][0], table.edgeOrigin[*edge][1], table.edgeOrigin[*edge][2]);
+				const size_t owner = GetOwnerBlock(origin);
+				const Block& ownerBlock = _blocks[owner];
+				const glm::ivec3 local = origin - ownerBlock.firstPoint;
+				const size_t edgeIndex = ((static_cast<size_t>(local.z) * ownerBlock.numPoints.y + local.y) * ownerBlock.numPoints.x + local.x) * 3 + table.edgeAxis[*edge];
+				block.triangles.push_back({ static_cast<uint32_t>(owner), static_cast<uint32_t>(ownerBlock.edgeVertices[edgeIndex]) });
+			}
+		}
+	}
+
+	void IsoSurfaceExtractor::Assemble()
+	{
+		std::vector<size_t>& vertexOffsets = tVertexOffsets;
+		std::vector<size_t>& indexOffsets = tIndexOffsets;
+		vertexOffsets.assign(_blocks.size() + 1, 0);
+		indexOffsets.assign(_blocks.size() + 1, 0);
+		for (size_t blockIndex = 0; blockIndex < _blocks.size(); ++blockIndex)
+		{
+			vertexOffsets[blockIndex + 1] = vertexOffsets[blockIndex] + _blocks[blockIndex].vertices.size();
+			indexOffsets[blockIndex + 1] = indexOffsets[blockIndex] + _blocks[blockIndex].triangles.size();
+		}
+
+		_vertices.resize(vertexOffsets.back());
+		_indices.resize(indexOffsets.back());
+		JobSystem::GetInstance().ParallelFor(_blocks.size(), [&](size_t blockIndex)
+		{
+			const Block& block = _blocks[blockIndex];
+			std::copy(block.vertices.begin(), block.vertices.end(), _vertices.begin() + vertexOffsets[blockIndex]);
+			auto index = _indices.begin() + indexOffsets[blockIndex];
+			for (const VertexRef& ref : block.triangles)
+				*index++ = static_cast<unsigned int>(vertexOffsets[ref.block] + ref.local);
+		});
+	}
+
+	void IsoSurfaceExtractor::UploadToMesh(Mesh& mesh) const
+	{
+		mesh.UploadMesh(_vertices, _indices);
+	}
+
+};
@@ -0,0 +1,134 @@
+#include <GL3/JobSystem.hpp>
+#include <GL3/Profiler.hpp>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+	//! Set while the thread executes jobs so nested ParallelFor calls do not dead-lock.
+	thread_local bool tInsideJob = false;
+
+	inline uint64_t GetNanoseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+};
+
+namespace GL3 {
+
+	JobSystem& JobSystem::GetInstance()
+	{
+		static JobSystem instance;
+		return instance;
+	}
+
+	JobSystem::JobSystem()
+		: _job(nullptr), _count(0), _memoryTag(MemoryTracker::Untagged), _memoryApplication(0), _next(0), _busyTime(0), _generation(0), _activeWorkers(0), _bExit(false)
+	{
+		const unsigned int numCores = std::max(1u, std::thread::hardware_concurrency());
+		for (unsigned int i = 1; i < numCores; ++i)
+			_workers.emplace_back(&JobSystem::WorkerLoop, this);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_bExit = true;
+		}
+		_wakeCondition.notify_all();
+
+		for (auto& worker : _workers)
+			worker.join();
+	}
+
+	void JobSystem::ParallelFor(size_t count, const Job& job)
+	{
+		//! Small batches, single core machines and nested calls run inline.
+		if (count <= 1 || _workers.empty() || tInsideJob)
+		{
+			//! Nested calls are already counted by the job around them.
+			const uint64_t startTime = tInsideJob ? 0 : GetNanoseconds();
+			for (size_t i = 0; i < count; ++i)
+				job(i);
+			if (!tInsideJob)
+				_busyTime.fetch_add(GetNanoseconds() - startTime, std::memory_order_relaxed);
+			return;
+		}
+
+		std::lock_guard<std::mutex> dispatchLock(_dispatchMutex);
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_job = &job;
+			_count = count;
+			_memoryTag = MemoryTracker::GetCurrentTag();
+			_memoryApplication = MemoryTracker::GetCurrentApplication();
+			_next.store(0);
+			++_generation;
+		}
+		_wakeCondition.notify_all();
+
+		//! The calling thread works on the batch too.
+		tInsideJob = true;
+		RunJobs(job, count);
+		tInsideJob = false;
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		_doneCondition.wait(lock, [this] { return _activeWorkers == 0; });
+		_job = nullptr;
+		_count = 0;
+	}
+
+	size_t JobSystem::GetNumThreads() const
+	{
+		return _workers.size() + 1;
+	}
+
+	void JobSystem::WorkerLoop()
+	{
+		Profiler::GetInstance().RegisterCurrentThread(true);
+		tInsideJob = true;
+		size_t seenGeneration = 0;
+		while (true)
+		{
+			const Job* job = nullptr;
+			size_t count = 0;
+			MemoryTracker::Tag memoryTag = MemoryTracker::Untagged;
+			size_t memoryApplication = 0;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_wakeCondition.wait(lock, [&] { return _bExit || _generation != seenGeneration; });
+				if (_bExit)
+					return;
+				seenGeneration = _generation;
+				//! Snapshot the batch, it stays alive until _activeWorkers drops back to zero.
+				job = _job;
+				count = _count;
+				memoryTag = _memoryTag;
+				memoryApplication = _memoryApplication;
+				++_activeWorkers;
+			}
+
+			if (job)
+			{
+				MemoryScope memoryScope(memoryTag, memoryApplication);
+				RunJobs(*job, count);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				--_activeWorkers;
+			}
+			_doneCondition.notify_all();
+		}
+	}
+
+	void JobSystem::RunJobs(const Job& job, size_t count)
+	{
+		const uint64_t startTime = GetNanoseconds();
+		size_t index;
+		while ((index = _next.fetch_add(1)) < count)
+			job(index);
+		_busyTime.fetch_add(GetNanoseconds() - startTime, std::memory_order_relaxed);
+	}
+};
@@ -0,0 +1,92 @@
+#include <GL3/MappedRingBuffer.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <glad/glad.h>
+#include <iostream>
+
+namespace
+{
+	//! Regions start at multiples of this, enough for any vertex attribute or uniform buffer offset
+	constexpr size_t REGION_ALIGNMENT = 256;
+};
+
+namespace GL3 {
+
+	MappedRingBuffer::MappedRingBuffer()
+		: _bufferID(0), _mapped(nullptr), _fences{ nullptr, nullptr, nullptr }, _regionBytes(0), _region(0)
+	{
+		//! Do nothing
+	}
+
+	MappedRingBuffer::~MappedRingBuffer()
+	{
+		//! Do nothing
+	}
+
+	bool MappedRingBuffer::Initialize(size_t regionBytes)
+	{
+		CleanUp();
+
+		_regionBytes = (regionBytes + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT;
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		const GLsizeiptr numBytes = static_cast<GLsizeiptr>(_regionBytes * NUM_REGIONS);
+		glCreateBuffers(1, &_bufferID);
+		glNamedBufferStorage(_bufferID, numBytes, nullptr, flags);
+		_mapped = static_cast<char*>(glMapNamedBufferRange(_bufferID, 0, numBytes, flags));
+		if (!_mapped)
+		{
+			std::cerr << "Failed to map a ring buffer of " << NUM_REGIONS << " x " << _regionBytes << " bytes" << std::endl;
+			glDeleteBuffers(1, &_bufferID);
+			_bufferID = 0;
+			_regionBytes = 0;
+			return false;
+		}
+
+		//! The first BeginWrite() moves to region 0
+		_region = NUM_REGIONS - 1;
+		MemoryTracker::GetInstance().AllocateGPU(MemoryTracker::Rendering, _regionBytes * NUM_REGIONS);
+		return true;
+	}
+
+	void* MappedRingBuffer::BeginWrite()
+	{
+		_region = (_region + 1) % NUM_REGIONS;
+		GLsync& fence = _fences[_region];
+		if (fence)
+		{
+			//! Coherent mapping, the fence only has to tell that the draws of the region are done.
+			while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+		return _mapped + GetOffset();
+	}
+
+	void MappedRingBuffer::EndFrame()
+	{
+		GLsync& fence = _fences[_region];
+		if (fence)
+			glDeleteSync(fence);
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	void MappedRingBuffer::CleanUp()
+	{
+		for (GLsync& fence : _fences)
+		{
+			if (fence)
+				glDeleteSync(fence);
+			fence = nullptr;
+		}
+		if (_bufferID)
+		{
+			glUnmapNamedBuffer(_bufferID);
+			glDeleteBuffers(1, &_bufferID);
+			MemoryTracker::GetInstance().ReleaseGPU(MemoryTracker::Rendering, _regionBytes * NUM_REGIONS);
+		}
+		_bufferID = 0;
+		_mapped = nullptr;
+		_regionBytes = 0;
+		_region = 0;
+	}
+
+};
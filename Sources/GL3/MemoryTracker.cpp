@@ -0,0 +1,368 @@
+#include <GL3/MemoryTracker.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+	using GL3::MemoryTracker;
+
+	//! Prefix of every tracked allocation, padded so the returned block keeps the malloc alignment.
+	struct AllocationHeader
+	{
+		size_t size;
+		uint32_t tag;
+		uint32_t application;
+	};
+	constexpr size_t HEADER_SIZE = std::max(sizeof(AllocationHeader), alignof(std::max_align_t));
+
+	//! Tag charged by the allocations of the thread, set through MemoryScope.
+	thread_local MemoryTracker::Tag tCurrentTag = MemoryTracker::Untagged;
+	thread_local size_t tCurrentApplication = 0;
+
+	//! The heap counters are plain globals so they are zero before any static constructor allocates.
+	std::atomic<size_t> gHeapBytes[MemoryTracker::NumTags] = {};
+	std::atomic<size_t> gHeapPeak[MemoryTracker::NumTags] = {};
+	std::atomic<size_t> gNumAllocations[MemoryTracker::NumTags] = {};
+	std::atomic<size_t> gTotalHeapBytes(0);
+	std::atomic<size_t> gTotalHeapPeak(0);
+	std::atomic<size_t> gTotalAllocations(0);
+	std::atomic<size_t> gTotalAllocatedBytes(0);
+	std::atomic<size_t> gFrameHeapPeak(0);
+	std::atomic<size_t> gApplicationHeapBytes[MemoryTracker::MAX_APPLICATIONS] = {};
+	std::atomic<size_t> gApplicationHeapPeak[MemoryTracker::MAX_APPLICATIONS] = {};
+	std::atomic<size_t> gApplicationAllocations[MemoryTracker::MAX_APPLICATIONS] = {};
+
+	const char* TAG_NAMES[MemoryTracker::NumTags] = {
+		"Untagged", "Mesh", "Texture", "Camera", "Shader", "Simulation", "Rendering"
+	};
+
+	void RaisePeak(std::atomic<size_t>& peak, size_t value)
+	{
+		size_t current = peak.load(std::memory_order_relaxed);
+		while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed));
+	}
+
+	double ToMegabytes(size_t bytes)
+	{
+		return static_cast<double>(bytes) / (1024.0 * 1024.0);
+	}
+
+#ifdef GL3_TRACK_HEAP
+	void* TrackedAllocate(size_t size) noexcept
+	{
+		void* block = std::malloc(size + HEADER_SIZE);
+		if (!block)
+			return nullptr;
+
+		const size_t tag = tCurrentTag, application = tCurrentApplication;
+		AllocationHeader* header = static_cast<AllocationHeader*>(block);
+		header->size = size;
+		header->tag = static_cast<uint32_t>(tag);
+		header->application = static_cast<uint32_t>(application);
+
+		RaisePeak(gHeapPeak[tag], gHeapBytes[tag].fetch_add(size, std::memory_order_relaxed) + size);
+		RaisePeak(gApplicationHeapPeak[application], gApplicationHeapBytes[application].fetch_add(size, std::memory_order_relaxed) + size);
+		gApplicationAllocations[application].fetch_add(1, std::memory_order_relaxed);
+		const size_t totalBytes = gTotalHeapBytes.fetch_add(size, std::memory_order_relaxed) + size;
+		RaisePeak(gTotalHeapPeak, totalBytes);
+		RaisePeak(gFrameHeapPeak, totalBytes);
+		gNumAllocations[tag].fetch_add(1, std::memory_order_relaxed);
+		gTotalAllocations.fetch_add(1, std::memory_order_relaxed);
+		gTotalAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+		return static_cast<char*>(block) + HEADER_SIZE;
+	}
+
+	void TrackedFree(void* pointer) noexcept
+	{
+		if (!pointer)
+			return;
+
+		void* block = static_cast<char*>(pointer) - HEADER_SIZE;
+		const AllocationHeader* header = static_cast<const AllocationHeader*>(block);
+		gHeapBytes[header->tag].fetch_sub(header->size, std::memory_order_relaxed);
+		gApplicationHeapBytes[header->application].fetch_sub(header->size, std::memory_order_relaxed);
+		gTotalHeapBytes.fetch_sub(header->size, std::memory_order_relaxed);
+		std::free(block);
+	}
+
+	//! Throwing allocation with the standard new handler loop
+	void* AllocateOrThrow(size_t size)
+	{
+		if (size == 0)
+			size = 1;
+		for (;;)
+		{
+			if (void* pointer = TrackedAllocate(size))
+				return pointer;
+			std::new_handler handler = std::get_new_handler();
+			if (!handler)
+				throw std::bad_alloc();
+			handler();
+		}
+	}
+#endif
+};
+
+#ifdef GL3_TRACK_HEAP
+//! Replaceable global allocation functions, over-aligned allocations keep the default implementation untracked.
+void* operator new(std::size_t size)
+{
+	return AllocateOrThrow(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return AllocateOrThrow(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return TrackedAllocate(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return TrackedAllocate(size ? size : 1);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	TrackedFree(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	TrackedFree(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	TrackedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	TrackedFree(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	TrackedFree(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	TrackedFree(pointer);
+}
+#endif
+
+namespace GL3 {
+
+	MemoryTracker& MemoryTracker::GetInstance()
+	{
+		static MemoryTracker instance;
+		return instance;
+	}
+
+	MemoryTracker::MemoryTracker()
+		: _totalGPUBytes(0), _totalGPUPeak(0), _frameStartAllocations(0), _frameStartAllocatedBytes(0)
+	{
+		for (int tag = 0; tag < NumTags; ++tag)
+		{
+			_gpuBytes[tag].store(0, std::memory_order_relaxed);
+			_gpuPeak[tag].store(0, std::memory_order_relaxed);
+		}
+		_applicationNames.push_back("Shared");
+	}
+
+	const char* MemoryTracker::GetTagName(Tag tag)
+	{
+		return TAG_NAMES[tag];
+	}
+
+	MemoryTracker::Tag MemoryTracker::GetCurrentTag()
+	{
+		return tCurrentTag;
+	}
+
+	size_t MemoryTracker::GetCurrentApplication()
+	{
+		return tCurrentApplication;
+	}
+
+	size_t MemoryTracker::RegisterApplication(const std::string& name)
+	{
+		MemoryScope scope(Untagged, 0);
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_applicationNames.size() == MAX_APPLICATIONS)
+			return 0;
+		_applicationNames.push_back(name);
+		return _applicationNames.size() - 1;
+	}
+
+	void MemoryTracker::AllocateGPU(Tag tag, size_t bytes)
+	{
+		RaisePeak(_gpuPeak[tag], _gpuBytes[tag].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+		RaisePeak(_totalGPUPeak, _totalGPUBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+	}
+
+	void MemoryTracker::ReleaseGPU(Tag tag, size_t bytes)
+	{
+		_gpuBytes[tag].fetch_sub(bytes, std::memory_order_relaxed);
+		_totalGPUBytes.fetch_sub(bytes, std::memory_order_relaxed);
+	}
+
+	void MemoryTracker::SetAsset(const void* owner, const std::string& name, Tag tag, size_t cpuBytes, size_t gpuBytes)
+	{
+		//! The bookkeeping itself is not charged to the caller's subsystem.
+		const size_t application = tCurrentApplication;
+		MemoryScope scope(Untagged, 0);
+		std::lock_guard<std::mutex> lock(_mutex);
+		_assets[owner] = Asset{ name, tag, application, cpuBytes, gpuBytes };
+	}
+
+	void MemoryTracker::RemoveAsset(const void* owner)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_assets.erase(owner);
+	}
+
+	void MemoryTracker::BeginFrame()
+	{
+		_frameStartAllocations = gTotalAllocations.load(std::memory_order_relaxed);
+		_frameStartAllocatedBytes = gTotalAllocatedBytes.load(std::memory_order_relaxed);
+		gFrameHeapPeak.store(gTotalHeapBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+
+	MemoryTracker::Usage MemoryTracker::GetUsage(Tag tag) const
+	{
+		Usage usage;
+		usage.heapBytes = gHeapBytes[tag].load(std::memory_order_relaxed);
+		usage.heapPeak = gHeapPeak[tag].load(std::memory_order_relaxed);
+		usage.numAllocations = gNumAllocations[tag].load(std::memory_order_relaxed);
+		usage.gpuBytes = _gpuBytes[tag].load(std::memory_order_relaxed);
+		usage.gpuPeak = _gpuPeak[tag].load(std::memory_order_relaxed);
+		return usage;
+	}
+
+	MemoryTracker::FrameUsage MemoryTracker::GetFrameUsage() const
+	{
+		FrameUsage usage;
+		usage.numAllocations = gTotalAllocations.load(std::memory_order_relaxed) - _frameStartAllocations;
+		usage.allocatedBytes = gTotalAllocatedBytes.load(std::memory_order_relaxed) - _frameStartAllocatedBytes;
+		usage.heapPeak = gFrameHeapPeak.load(std::memory_order_relaxed);
+		return usage;
+	}
+
+	size_t MemoryTracker::GetTotalHeapBytes() const
+	{
+		return gTotalHeapBytes.load(std::memory_order_relaxed);
+	}
+
+	size_t MemoryTracker::GetTotalGPUBytes() const
+	{
+		return _totalGPUBytes.load(std::memory_order_relaxed);
+	}
+
+	size_t MemoryTracker::GetTotalHeapPeak() const
+	{
+		return gTotalHeapPeak.load(std::memory_order_relaxed);
+	}
+
+	size_t MemoryTracker::GetTotalGPUPeak() const
+	{
+		return _totalGPUPeak.load(std::memory_order_relaxed);
+	}
+
+	std::string MemoryTracker::GetDescription() const
+	{
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(1) << "Heap " << ToMegabytes(GetTotalHeapBytes()) << "/" << ToMegabytes(GetTotalHeapPeak())
+			   << "(MB) GPU " << ToMegabytes(GetTotalGPUBytes()) << "/" << ToMegabytes(GetTotalGPUPeak()) << "(MB) "
+			   << GetFrameUsage().numAllocations << " allocs";
+		return stream.str();
+	}
+
+	void MemoryTracker::Report(std::ostream& stream) const
+	{
+		const auto flags = stream.flags();
+		stream << std::left << std::setw(12) << "Memory" << std::right << std::setw(12) << "Heap(MB)" << std::setw(12) << "Heap peak"
+			   << std::setw(12) << "Allocs" << std::setw(12) << "GPU(MB)" << std::setw(12) << "GPU peak" << std::endl;
+		for (int tag = 0; tag < NumTags; ++tag)
+		{
+			const Usage usage = GetUsage(static_cast<Tag>(tag));
+			stream << std::left << std::setw(12) << TAG_NAMES[tag] << std::right << std::fixed << std::setprecision(2)
+				   << std::setw(12) << ToMegabytes(usage.heapBytes) << std::setw(12) << ToMegabytes(usage.heapPeak) << std::setw(12) << usage.numAllocations
+				   << std::setw(12) << ToMegabytes(usage.gpuBytes) << std::setw(12) << ToMegabytes(usage.gpuPeak) << std::endl;
+		}
+		stream << std::left << std::setw(12) << "Total" << std::right << std::setw(12) << ToMegabytes(GetTotalHeapBytes())
+			   << std::setw(12) << ToMegabytes(GetTotalHeapPeak()) << std::setw(12) << gTotalAllocations.load(std::memory_order_relaxed)
+			   << std::setw(12) << ToMegabytes(GetTotalGPUBytes()) << std::setw(12) << ToMegabytes(GetTotalGPUPeak()) << std::endl;
+
+		const FrameUsage frame = GetFrameUsage();
+		stream << "Last frame " << frame.numAllocations << " allocations, " << ToMegabytes(frame.allocatedBytes)
+			   << "(MB) allocated, heap peak " << ToMegabytes(frame.heapPeak) << "(MB)" << std::endl;
+
+		std::vector<Asset> assets;
+		std::vector<std::string> applicationNames;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			for (const auto& asset : _assets)
+				assets.push_back(asset.second);
+			applicationNames = _applicationNames;
+		}
+
+		//! The asset columns sum what the applications loaded, the heap columns everything they allocated.
+		stream << std::left << std::setw(24) << "Application" << std::right << std::setw(12) << "Heap(MB)" << std::setw(12) << "Heap peak"
+			   << std::setw(12) << "Allocs" << std::setw(12) << "Asset CPU" << std::setw(12) << "Asset GPU" << std::endl;
+		for (size_t application = 0; application < applicationNames.size(); ++application)
+		{
+			size_t assetCPUBytes = 0, assetGPUBytes = 0;
+			for (const Asset& asset : assets)
+				if (asset.application == application)
+				{
+					assetCPUBytes += asset.cpuBytes;
+					assetGPUBytes += asset.gpuBytes;
+				}
+			stream << std::left << std::setw(24) << applicationNames[application] << std::right
+				   << std::setw(12) << ToMegabytes(gApplicationHeapBytes[application].load(std::memory_order_relaxed))
+				   << std::setw(12) << ToMegabytes(gApplicationHeapPeak[application].load(std::memory_order_relaxed))
+				   << std::setw(12) << gApplicationAllocations[application].load(std::memory_order_relaxed)
+				   << std::setw(12) << ToMegabytes(assetCPUBytes) << std::setw(12) << ToMegabytes(assetGPUBytes) << std::endl;
+		}
+		if (!assets.empty())
+		{
+			std::sort(assets.begin(), assets.end(), [](const Asset& lhs, const Asset& rhs) { return lhs.cpuBytes + lhs.gpuBytes > rhs.cpuBytes + rhs.gpuBytes; });
+			stream << std::left << std::setw(48) << "Asset" << std::setw(12) << "Tag" << std::right << std::setw(12) << "CPU(MB)" << std::setw(12) << "GPU(MB)" << std::endl;
+			for (const Asset& asset : assets)
+				stream << std::left << std::setw(48) << asset.name << std::setw(12) << TAG_NAMES[asset.tag] << std::right
+					   << std::setw(12) << ToMegabytes(asset.cpuBytes) << std::setw(12) << ToMegabytes(asset.gpuBytes) << std::endl;
+		}
+		stream.flags(flags);
+	}
+
+	MemoryScope::MemoryScope(MemoryTracker::Tag tag)
+		: _previousTag(tCurrentTag), _previousApplication(tCurrentApplication)
+	{
+		tCurrentTag = tag;
+	}
+
+	MemoryScope::MemoryScope(MemoryTracker::Tag tag, size_t application)
+		: _previousTag(tCurrentTag), _previousApplication(tCurrentApplication)
+	{
+		tCurrentTag = tag;
+		tCurrentApplication = application < MemoryTracker::MAX_APPLICATIONS ? application : 0;
+	}
+
+	MemoryScope::~MemoryScope()
+	{
+		tCurrentTag = _previousTag;
+		tCurrentApplication = _previousApplication;
+	}
+};
@@ -1,5 +1,11 @@
 #include <GL3/Mesh.hpp>
+#include <GL3/Allocators.hpp>
 #include <GL3/DebugUtils.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/InstanceBuffer.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <GL3/VertexColorBuffer.hpp>
 #include <glad/glad.h>
 #include <iostream>
 #include <algorithm>
@@ -35,87 +41,81 @@ glm::vec3 CalculateNormal(const glm::vec3 v1, const glm::vec3 v2, const glm::vec
     return glm::normalize(glm::cross(edge1, edge2));
 }
 
-void ComputeSmoothingNormals(const tinyobj::attrib_t& attrib, const tinyobj::shape_t& shape, std::map<int, glm::vec3>& smoothVertexNormals)
-{
-    smoothVertexNormals.clear();
-    const auto& vertices = attrib.vertices;
-
-    for (size_t faceIndex = 0; faceIndex < shape.mesh.indices.size() / 3; faceIndex++)
-    {
-        // Get the three indexes of the face (all faces are triangular)
-        tinyobj::index_t idx0 = shape.mesh.indices[3 * faceIndex + 0];
-        tinyobj::index_t idx1 = shape.mesh.indices[3 * faceIndex + 1];
-        tinyobj::index_t idx2 = shape.mesh.indices[3 * faceIndex + 2];
-
-        // Get the three vertex indexes and coordinates
-        glm::vec3 position[3];  // coordinates
-
-        int f0 = idx0.vertex_index;
-        int f1 = idx1.vertex_index;
-        int f2 = idx2.vertex_index;
-        assert(f0 >= 0 && f1 >= 0 && f2 >= 0);
-
-        position[0] = glm::vec3(vertices[3 * f0], vertices[3 * f0 + 1], vertices[3 * f0 + 2]);
-        position[1] = glm::vec3(vertices[3 * f1], vertices[3 * f1 + 1], vertices[3 * f1 + 2]);
-        position[2] = glm::vec3(vertices[3 * f2], vertices[3 * f2 + 1], vertices[3 * f2 + 2]);
-
-        // Compute the normal of the face
-        glm::vec3 normal = CalculateNormal(position[0], position[1], position[2]);
-
-        // Add the normal to the three vertexes
-        int faces[3] = { f0, f1, f2 };
-        for (size_t i = 0; i < 3; ++i)
-        {
-            auto iter = smoothVertexNormals.find(faces[i]);
-            if (iter == smoothVertexNormals.end())
-            {
-                smoothVertexNormals[faces[i]] = normal;
-            }
-            else
-            {
-                iter->second += normal;
-            }
-        }
-
-    }  // f
-
-    // Normalize the normals, that is, make them unit vectors
-    for (auto& p : smoothVertexNormals)
-    {
-        p.second = glm::normalize(p.second);
-    }
-}
-
 constexpr float EPSILON = 1e-6f;
 
-struct PackedVertex
-{
-    glm::vec3 position;
-    glm::vec2 texCoord;
-    glm::vec3 normal;
+namespace GL3 {
 
-    PackedVertex(glm::vec3 pos, glm::vec2 uv, glm::vec3 n)
-        : position(pos), texCoord(uv), normal(n) {};
-};
+	//! lexicographically sorting vector, positions closer than the tolerance compare equal.
+	struct PackedVertexLess
+	{
+		float positionTolerance;
+
+		inline bool operator()(const PackedVertex& v1, const PackedVertex& v2) const
+		{
+			if (std::fabs(v1.position.x - v2.position.x) >= positionTolerance) return v1.position.x < v2.position.x;
+			if (std::fabs(v1.position.y - v2.position.y) >= positionTolerance) return v1.position.y < v2.position.y;
+			if (std::fabs(v1.position.z - v2.position.z) >= positionTolerance) return v1.position.z < v2.position.z;
+			if (std::fabs(v1.texCoord.x - v2.texCoord.x) >= 0.1f) return v1.texCoord.x < v2.texCoord.x;
+			if (std::fabs(v1.texCoord.y - v2.texCoord.y) >= 0.1f) return v1.texCoord.y < v2.texCoord.y;
+			if (std::fabs(v1.normal.x - v2.normal.x) >= 0.3f) return v1.normal.x < v2.normal.x;
+			if (std::fabs(v1.normal.y - v2.normal.y) >= 0.3f) return v1.normal.y < v2.normal.y;
+			if (std::fabs(v1.normal.z - v2.normal.z) >= 0.3f) return v1.normal.z < v2.normal.z;
+			return false;
+		}
+	};
 
-//! lexicographically sorting vector.
-inline bool operator<(const PackedVertex& v1, const PackedVertex& v2)
-{
-    if (std::fabs(v1.position.x - v2.position.x) >= 0.001f) return v1.position.x < v2.position.x;
-    if (std::fabs(v1.position.y - v2.position.y) >= 0.001f) return v1.position.y < v2.position.y;
-    if (std::fabs(v1.position.z - v2.position.z) >= 0.001f) return v1.position.z < v2.position.z;
-    if (std::fabs(v1.texCoord.x - v2.texCoord.x) >= 0.1f) return v1.texCoord.x < v2.texCoord.x;
-    if (std::fabs(v1.texCoord.y - v2.texCoord.y) >= 0.1f) return v1.texCoord.y < v2.texCoord.y;
-    if (std::fabs(v1.normal.x - v2.normal.x) >= 0.3f) return v1.normal.x < v2.normal.x;
-    if (std::fabs(v1.normal.y - v2.normal.y) >= 0.3f) return v1.normal.y < v2.normal.y;
-    if (std::fabs(v1.normal.z - v2.normal.z) >= 0.3f) return v1.normal.z < v2.normal.z;
-    return false;
-}
+};
 
 namespace GL3 {
 
+	void WeldVertices(const std::vector<PackedVertex>& triangleVertices, std::vector<PackedVertex>& vertices, std::vector<unsigned int>& indices,
+					  float positionTolerance)
+	{
+		//! Vertices within the comparison tolerances of PackedVertexLess collapse into the first one seen.
+		//! The map nodes come from a pool, one heap block per 256 vertices instead of one per vertex.
+		using PackedVertexMap = std::map<PackedVertex, unsigned int, PackedVertexLess, PoolAllocator<std::pair<const PackedVertex, unsigned int>>>;
+		PoolResource resource;
+		PackedVertexMap packedVerticesMap(PackedVertexLess{ positionTolerance }, PoolAllocator<std::pair<const PackedVertex, unsigned int>>(&resource));
+		indices.reserve(indices.size() + triangleVertices.size());
+		for (const PackedVertex& vertex : triangleVertices)
+		{
+			auto iter = packedVerticesMap.find(vertex);
+			if (iter == packedVerticesMap.end())
+			{
+				const unsigned int newIndex = static_cast<unsigned int>(vertices.size());
+				vertices.push_back(vertex);
+				indices.push_back(newIndex);
+				packedVerticesMap.emplace(vertex, newIndex);
+			}
+			else
+			{
+				indices.push_back(iter->second);
+			}
+		}
+	}
+
+	void ComputeVertexNormals(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices, std::vector<glm::vec3>& normals)
+	{
+		//! Sum of the unit face normals around each vertex, degenerate faces add nothing.
+		normals.assign(positions.size(), glm::vec3(0.0f));
+		for (size_t corner = 0; corner + 2 < indices.size(); corner += 3)
+		{
+			const unsigned int i0 = indices[corner], i1 = indices[corner + 1], i2 = indices[corner + 2];
+			const glm::vec3 normal = CalculateNormal(positions[i0], positions[i1], positions[i2]);
+			normals[i0] += normal;
+			normals[i1] += normal;
+			normals[i2] += normal;
+		}
+		//! Vertices only on degenerate faces keep a zero normal instead of a NaN.
+		for (glm::vec3& normal : normals)
+		{
+			const float length = glm::length(normal);
+			normal = length > EPSILON ? normal / length : glm::vec3(0.0f);
+		}
+	}
+
 	Mesh::Mesh()
-		: _vao(0), _vbo(0), _ebo(0), _numVertices(0)
+		: _name("Generated mesh"), _vao(0), _vbo(0), _ebo(0), _numVertices(0), _gpuBytes(0)
 	{
 		//! Do nothing
 	}
@@ -125,8 +125,11 @@ namespace GL3 {
 		CleanUp();
 	}
 
-	bool Mesh::LoadObj(const char* path, bool scaleToUnitBox)
+	bool Mesh::LoadObj(const char* path, bool scaleToUnitBox, bool uploadToGPU)
 	{
+		ProfileScope scope("Mesh::LoadObj");
+		MemoryScope memoryScope(MemoryTracker::Mesh);
+		_name = path;
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
         std::vector<tinyobj::material_t> materials;
@@ -150,15 +153,26 @@ namespace GL3 {
 
         std::vector<PackedVertex> vertices;
         std::vector<unsigned int> indices;
+        _boundingBox.Reset();
+        //! Shapes index into the shared position array, smoothing normals are computed over it per shape.
+        std::vector<glm::vec3> objPositions(attrib.vertices.size() / 3);
+        for (size_t i = 0; i < objPositions.size(); ++i)
+            objPositions[i] = glm::vec3(attrib.vertices[3 * i], attrib.vertices[3 * i + 1], attrib.vertices[3 * i + 2]);
+        std::vector<unsigned int> shapeIndices;
+        std::vector<glm::vec3> smoothVertexNormals;
         for (auto& shape : shapes)
         {
-            std::map<int, glm::vec3> smoothVertexNormals;
+            smoothVertexNormals.clear();
             if (HasSmoothingGroup(shape))
             {
-                ComputeSmoothingNormals(attrib, shape, smoothVertexNormals);
+                shapeIndices.resize(shape.mesh.indices.size());
+                for (size_t i = 0; i < shapeIndices.size(); ++i)
+                    shapeIndices[i] = static_cast<unsigned int>(shape.mesh.indices[i].vertex_index);
+                ComputeVertexNormals(objPositions, shapeIndices, smoothVertexNormals);
             }
             
-            std::map<PackedVertex, unsigned int> packedVerticesMap;
+            std::vector<PackedVertex> triangleVertices;
+            triangleVertices.reserve(shape.mesh.indices.size());
             BoundingBox boundingBox;
             for (size_t faceIndex = 0; faceIndex < shape.mesh.indices.size() / 3; ++faceIndex)
             {
@@ -192,9 +206,10 @@ namespace GL3 {
                     position[0][k] = attrib.vertices[3 * f0 + k];
                     position[1][k] = attrib.vertices[3 * f1 + k];
                     position[2][k] = attrib.vertices[3 * f2 + k];
-                    //! Merge the bounding box with new point
-                    boundingBox.Merge(position[k]);
                 }
+                //! Merge the bounding box with the completed points
+                for (int k = 0; k < 3; k++)
+                    boundingBox.Merge(position[k]);
 
                 bool invalidNormal = false;
                 if (attrib.normals.size() > 0)
@@ -279,24 +294,9 @@ namespace GL3 {
 
                 //! From now on, vertices in one face allocated.
                 for (unsigned int k = 0; k < 3; ++k)
-                {
-                    PackedVertex vertex(position[k], texCoord[k], normal[k]);
-
-                    auto iter = packedVerticesMap.find(vertex);
-
-                    if (iter == packedVerticesMap.end())
-                    {
-                        vertices.push_back(iter->first);
-                        unsigned int newIndex = static_cast<unsigned int>(vertices.size() - 1);
-                        indices.push_back(newIndex);
-                        packedVerticesMap[vertex] = newIndex;
-                    }
-                    else
-                    {
-                        indices.push_back(iter->second);
-                    }
-                }
+                    triangleVertices.emplace_back(position[k], texCoord[k], normal[k]);
             }
+            WeldVertices(triangleVertices, vertices, indices);
             _boundingBox.Merge(boundingBox);
         }
 
@@ -315,36 +315,148 @@ namespace GL3 {
             }
         }
 
-        glGenVertexArrays(1, &_vao);
-        glGenBuffers(1, &_vbo);
-        glGenBuffers(1, &_ebo);
+        if (uploadToGPU)
+            UploadMesh(vertices, indices);
+        else
+            SetGeometry(vertices, indices);
 
-        glBindVertexArray(_vao);
-        glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(PackedVertex)* vertices.size(), vertices.data(), GL_STATIC_DRAW);
+        return true;
+    }
 
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoord));
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+	void Mesh::UploadMesh(const std::vector<PackedVertex>& vertices, const std::vector<unsigned int>& indices)
+	{
+		MemoryScope memoryScope(MemoryTracker::Mesh);
+		//! Buffers are created once and respecified on later uploads.
+		if (!_vao)
+		{
+			glGenVertexArrays(1, &_vao);
+			glGenBuffers(1, &_vbo);
+			glGenBuffers(1, &_ebo);
+
+			glBindVertexArray(_vao);
+			glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoord));
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+		}
+		else
+		{
+			glBindVertexArray(_vao);
+			glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+		}
+
+		glBufferData(GL_ARRAY_BUFFER, sizeof(PackedVertex) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int)* indices.size(), indices.data(), GL_STATIC_DRAW);
-     
-        glBindVertexArray(0);
+		glBindVertexArray(0);
 
-        _numVertices = indices.size();
+		auto& memoryTracker = MemoryTracker::GetInstance();
+		memoryTracker.ReleaseGPU(MemoryTracker::Mesh, _gpuBytes);
+		_gpuBytes = sizeof(PackedVertex) * vertices.size() + sizeof(unsigned int) * indices.size();
+		memoryTracker.AllocateGPU(MemoryTracker::Mesh, _gpuBytes);
 
-        return true;
-    }
+		_numVertices = static_cast<unsigned int>(indices.size());
+
+		SetGeometry(vertices, indices);
+	}
+
+	void Mesh::SetGeometry(const std::vector<PackedVertex>& vertices, const std::vector<unsigned int>& indices)
+	{
+		MemoryScope memoryScope(MemoryTracker::Mesh);
+		//! Keep the geometry on the CPU side for ray queries and software rendering, and refresh the bounds.
+		_positions.resize(vertices.size());
+		_normals.resize(vertices.size());
+		_boundingBox.Reset();
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			_positions[i] = vertices[i].position;
+			_normals[i] = vertices[i].normal;
+			_boundingBox.Merge(_positions[i]);
+		}
+		_indices = indices;
+
+		const size_t cpuBytes = _positions.capacity() * sizeof(glm::vec3) + _normals.capacity() * sizeof(glm::vec3) + _indices.capacity() * sizeof(unsigned int);
+		MemoryTracker::GetInstance().SetAsset(this, _name, MemoryTracker::Mesh, cpuBytes, _gpuBytes);
+	}
 
-	void Mesh::DrawMesh(GLenum mode)
+	void Mesh::DrawMesh(GLenum mode) const
 	{
 		glBindVertexArray(_vao);
 		glDrawElements(mode, _numVertices, GL_UNSIGNED_INT, nullptr);
 		glBindVertexArray(0);
+		FrameStatistics::GetInstance().Increment(FrameStatistics::DrawCalls);
+		FrameStatistics::GetInstance().Increment(FrameStatistics::BufferBinds);
+	}
+
+	void Mesh::DrawInstanced(GLenum mode, const InstanceBuffer& instances, size_t first, size_t count) const
+	{
+		if (first > instances.GetCapacity() || count > instances.GetCapacity() - first)
+		{
+			std::cerr << "Instances " << first << " to " << first + count << " exceed the buffer capacity of " << instances.GetCapacity() << std::endl;
+			return;
+		}
+
+		//! One vec4 attribute per matrix column, advanced once per instance, read from the region written last.
+		glBindVertexArray(_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, instances.GetBufferID());
+		for (GLuint column = 0; column < 4; ++column)
+		{
+			const size_t offset = instances.GetOffset() + first * sizeof(glm::mat4) + column * sizeof(glm::vec4);
+			glEnableVertexAttribArray(INSTANCE_ATTRIBUTE + column);
+			glVertexAttribPointer(INSTANCE_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)offset);
+			glVertexAttribDivisor(INSTANCE_ATTRIBUTE + column, 1);
+		}
+		glDrawElementsInstanced(mode, _numVertices, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(count));
+		for (GLuint column = 0; column < 4; ++column)
+		{
+			glVertexAttribDivisor(INSTANCE_ATTRIBUTE + column, 0);
+			glDisableVertexAttribArray(INSTANCE_ATTRIBUTE + column);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+		ResetInstanceAttributes();
+		FrameStatistics::GetInstance().Increment(FrameStatistics::DrawCalls);
+		FrameStatistics::GetInstance().Increment(FrameStatistics::BufferBinds, 2);
+	}
+
+	void Mesh::DrawColored(GLenum mode, const VertexColorBuffer& colors) const
+	{
+		if (_positions.size() > colors.GetCapacity())
+		{
+			std::cerr << _name << " has " << _positions.size() << " vertices, more than the color buffer capacity of " << colors.GetCapacity() << std::endl;
+			return;
+		}
+
+		//! Normalized RGBA8, one color per vertex of the vertex buffer, read from the region written last.
+		glBindVertexArray(_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, colors.GetBufferID());
+		glEnableVertexAttribArray(COLOR_ATTRIBUTE);
+		glVertexAttribPointer(COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(uint32_t), (void*)colors.GetOffset());
+		glDrawElements(mode, _numVertices, GL_UNSIGNED_INT, nullptr);
+		glDisableVertexAttribArray(COLOR_ATTRIBUTE);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+		ResetVertexColors();
+		FrameStatistics::GetInstance().Increment(FrameStatistics::DrawCalls);
+		FrameStatistics::GetInstance().Increment(FrameStatistics::BufferBinds, 2);
+	}
+
+	void Mesh::ResetInstanceAttributes()
+	{
+		//! Disabled arrays read the current generic values, the identity columns.
+		glVertexAttrib4f(INSTANCE_ATTRIBUTE + 0, 1.0f, 0.0f, 0.0f, 0.0f);
+		glVertexAttrib4f(INSTANCE_ATTRIBUTE + 1, 0.0f, 1.0f, 0.0f, 0.0f);
+		glVertexAttrib4f(INSTANCE_ATTRIBUTE + 2, 0.0f, 0.0f, 1.0f, 0.0f);
+		glVertexAttrib4f(INSTANCE_ATTRIBUTE + 3, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	void Mesh::ResetVertexColors()
+	{
+		glVertexAttrib4f(COLOR_ATTRIBUTE, 0.0f, 0.0f, 0.0f, 0.0f);
 	}
 
 	void Mesh::CleanUp()
@@ -352,6 +464,10 @@ namespace GL3 {
 		if (_vao) glDeleteVertexArrays(1, &_vao);
 		if (_vbo) glDeleteBuffers(1, &_vbo);
 		if (_ebo) glDeleteBuffers(1, &_ebo);
+		_vao = _vbo = _ebo = 0;
+		MemoryTracker::GetInstance().ReleaseGPU(MemoryTracker::Mesh, _gpuBytes);
+		MemoryTracker::GetInstance().RemoveAsset(this);
+		_gpuBytes = 0;
 	}
 
 }; //! end of Mesh.cpp
\ No newline at end of file
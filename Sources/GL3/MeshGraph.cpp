@@ -0,0 +1,138 @@
+#include <GL3/MeshGraph.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Mesh.hpp>
+#include <GL3/Profiler.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace GL3 {
+
+	MeshGraph::MeshGraph()
+	{
+		//! Do nothing
+	}
+
+	MeshGraph::~MeshGraph()
+	{
+		//! Do nothing
+	}
+
+	bool MeshGraph::Build(const Mesh& mesh, const glm::vec3& up, float weldDistance)
+	{
+		return Build(mesh.GetPositions(), mesh.GetIndices(), up, weldDistance);
+	}
+
+	bool MeshGraph::Build(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices,
+						  const glm::vec3& up, float weldDistance)
+	{
+		ProfileScope scope("MeshGraph::Build", indices.size() / 3);
+		MemoryScope memoryScope(MemoryTracker::Mesh);
+
+		if (indices.size() % 3 != 0 || !(weldDistance > 0.0f) || glm::length(up) == 0.0f)
+		{
+			std::cerr << "Invalid mesh graph input, " << indices.size() << " indices and weld distance " << weldDistance << std::endl;
+			return false;
+		}
+		for (unsigned int index : indices)
+		{
+			if (index >= positions.size())
+			{
+				std::cerr << "Mesh graph index " << index << " out of " << positions.size() << " vertices" << std::endl;
+				return false;
+			}
+		}
+		const glm::vec3 upAxis = glm::normalize(up);
+		const size_t numVertices = positions.size();
+
+		//! Weld the positions alone, the unique vertices become the nodes in order of their first mesh vertex.
+		std::vector<PackedVertex> positionVertices(numVertices), nodeVertices;
+		for (size_t vertex = 0; vertex < numVertices; ++vertex)
+			positionVertices[vertex] = PackedVertex(positions[vertex], glm::vec2(0.0f), glm::vec3(0.0f));
+		_vertexNodes.clear();
+		WeldVertices(positionVertices, nodeVertices, _vertexNodes, weldDistance);
+		_nodePositions.resize(nodeVertices.size());
+		for (size_t node = 0; node < nodeVertices.size(); ++node)
+			_nodePositions[node] = nodeVertices[node].position;
+		const size_t numNodes = _nodePositions.size();
+
+		//! Count and scatter both directions of every triangle edge, duplicates included.
+		std::vector<uint32_t> rawOffsets(numNodes + 1, 0);
+		for (size_t corner = 0; corner < indices.size(); corner += 3)
+		{
+			for (size_t edge = 0; edge < 3; ++edge)
+			{
+				const uint32_t from = _vertexNodes[indices[corner + edge]], to = _vertexNodes[indices[corner + (edge + 1) % 3]];
+				if (from == to)
+					continue;
+				++rawOffsets[from + 1];
+				++rawOffsets[to + 1];
+			}
+		}
+		for (size_t node = 0; node < numNodes; ++node)
+			rawOffsets[node + 1] += rawOffsets[node];
+		std::vector<uint32_t> rawNeighbors(rawOffsets[numNodes]);
+		std::vector<uint32_t> cursors(rawOffsets.begin(), rawOffsets.end() - 1);
+		for (size_t corner = 0; corner < indices.size(); corner += 3)
+		{
+			for (size_t edge = 0; edge < 3; ++edge)
+			{
+				const uint32_t from = _vertexNodes[indices[corner + edge]], to = _vertexNodes[indices[corner + (edge + 1) % 3]];
+				if (from == to)
+					continue;
+				rawNeighbors[cursors[from]++] = to;
+				rawNeighbors[cursors[to]++] = from;
+			}
+		}
+
+		//! Sort and deduplicate every row in parallel, then compact the rows and measure the edges.
+		JobSystem& jobSystem = JobSystem::GetInstance();
+		const size_t numJobs = (numNodes + NODES_PER_JOB - 1) / NODES_PER_JOB;
+		_offsets.assign(numNodes + 1, 0);
+		jobSystem.ParallelFor(numJobs, [&](size_t job)
+		{
+			const size_t end = std::min(numNodes, (job + 1) * NODES_PER_JOB);
+			for (size_t node = job * NODES_PER_JOB; node < end; ++node)
+			{
+				const auto first = rawNeighbors.begin() + rawOffsets[node], last = rawNeighbors.begin() + rawOffsets[node + 1];
+				std::sort(first, last);
+				_offsets[node + 1] = static_cast<uint32_t>(std::unique(first, last) - first);
+			}
+		});
+		for (size_t node = 0; node < numNodes; ++node)
+			_offsets[node + 1] += _offsets[node];
+
+		const size_t numEdges = _offsets[numNodes];
+		_neighbors.resize(numEdges);
+		_lengths.resize(numEdges);
+		_slopes.resize(numEdges);
+		jobSystem.ParallelFor(numJobs, [&](size_t job)
+		{
+			const size_t end = std::min(numNodes, (job + 1) * NODES_PER_JOB);
+			for (size_t node = job * NODES_PER_JOB; node < end; ++node)
+			{
+				const glm::vec3 position = _nodePositions[node];
+				uint32_t source = rawOffsets[node];
+				for (uint32_t edge = _offsets[node]; edge < _offsets[node + 1]; ++edge, ++source)
+				{
+					const uint32_t neighbor = rawNeighbors[source];
+					const glm::vec3 delta = _nodePositions[neighbor] - position;
+					const float length = glm::length(delta);
+					_neighbors[edge] = neighbor;
+					_lengths[edge] = length;
+					_slopes[edge] = length > 0.0f ? glm::clamp(glm::dot(delta, upAxis) / length, -1.0f, 1.0f) : 0.0f;
+				}
+			}
+		});
+		return true;
+	}
+
+	size_t MeshGraph::GetMemoryBytes() const
+	{
+		return (_offsets.capacity() + _neighbors.capacity() + _vertexNodes.capacity()) * sizeof(uint32_t) +
+			   (_lengths.capacity() + _slopes.capacity()) * sizeof(float) + _nodePositions.capacity() * sizeof(glm::vec3);
+	}
+
+};
@@ -0,0 +1,418 @@
+#include <GL3/OcclusionCuller.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/Mesh.hpp>
+#include <GL3/Profiler.hpp>
+#include <GL3/SIMD.hpp>
+#include <glm/common.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+	//! Vertices transformed and boxes tested by a single job
+	constexpr size_t VERTEX_CHUNK = 4096;
+	constexpr size_t BOX_CHUNK = 256;
+	//! A pyramid texel range is narrowed to this many texels per axis before reading it
+	constexpr int MAX_TEST_TEXELS = 4;
+
+	inline size_t ElapsedMicroseconds(std::chrono::steady_clock::time_point startTime)
+	{
+		return static_cast<size_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count());
+	}
+
+	inline double ElapsedMilliseconds(std::chrono::steady_clock::time_point startTime)
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count() / 1000.0;
+	}
+};
+
+namespace GL3 {
+
+	OcclusionCuller::OcclusionCuller()
+		: _viewProjection(1.0f), _statistics(), _maxOccluderTriangles(std::numeric_limits<size_t>::max()),
+		  _minOccluderArea(0.0f), _width(0), _height(0)
+	{
+		//! Do nothing
+	}
+
+	OcclusionCuller::~OcclusionCuller()
+	{
+		//! Do nothing
+	}
+
+	bool OcclusionCuller::Initialize(int width, int height)
+	{
+		if (width <= 0 || height <= 0)
+		{
+			std::cerr << "Invalid occlusion buffer " << width << "x" << height << std::endl;
+			return false;
+		}
+
+		_width = width;
+		_height = height;
+		_levels.clear();
+
+		//! Level 0 rows are padded so the four wide rasterizer stores never leave the row.
+		int levelWidth = width, levelHeight = height;
+		while (true)
+		{
+			DepthLevel level;
+			level.width = levelWidth;
+			level.height = levelHeight;
+			level.pitch = _levels.empty() ? (levelWidth + 3) & ~3 : levelWidth;
+			level.depth.assign(static_cast<size_t>(level.pitch) * levelHeight, 1.0f);
+			_levels.push_back(std::move(level));
+
+			if (levelWidth == 1 && levelHeight == 1)
+				break;
+			levelWidth = std::max(1, (levelWidth + 1) / 2);
+			levelHeight = std::max(1, (levelHeight + 1) / 2);
+		}
+
+		return true;
+	}
+
+	void OcclusionCuller::SetOccluderBudget(size_t maxTriangles, float minScreenArea)
+	{
+		_maxOccluderTriangles = maxTriangles;
+		_minOccluderArea = minScreenArea;
+	}
+
+	void OcclusionCuller::BeginFrame(const glm::mat4& view, const glm::mat4& projection)
+	{
+		_viewProjection = projection * view;
+		_triangles.clear();
+		_statistics = OcclusionStatistics();
+		if (!_levels.empty())
+			std::fill(_levels[0].depth.begin(), _levels[0].depth.end(), 1.0f);
+	}
+
+	bool OcclusionCuller::AddOccluder(const Mesh& mesh, const glm::mat4& model)
+	{
+		return AddOccluder(mesh.GetPositions(), mesh.GetIndices(), model);
+	}
+
+	bool OcclusionCuller::AddOccluder(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices, const glm::mat4& model)
+	{
+		if (_levels.empty() || indices.empty())
+			return false;
+		if (_statistics.numOccluderTriangles + indices.size() / 3 > _maxOccluderTriangles)
+			return false;
+
+		auto startTime = std::chrono::steady_clock::now();
+
+		const glm::mat4 modelViewProjection = _viewProjection * model;
+		_clipPositions.resize(positions.size());
+		JobSystem::GetInstance().ParallelFor((positions.size() + VERTEX_CHUNK - 1) / VERTEX_CHUNK, [&](size_t chunk)
+		{
+			const size_t end = std::min(positions.size(), (chunk + 1) * VERTEX_CHUNK);
+			for (size_t vertex = chunk * VERTEX_CHUNK; vertex < end; ++vertex)
+				_clipPositions[vertex] = modelViewProjection * glm::vec4(positions[vertex], 1.0f);
+		});
+
+		//! Projected extent of the vertices in front of the near plane decides whether the occluder is worth drawing.
+		glm::vec2 lower(std::numeric_limits<float>::max()), upper(-std::numeric_limits<float>::max());
+		for (const glm::vec4& clip : _clipPositions)
+		{
+			if (clip.z < -clip.w)
+				continue;
+			const glm::vec2 ndc = glm::clamp(glm::vec2(clip) / clip.w, glm::vec2(-1.0f), glm::vec2(1.0f));
+			lower = glm::min(lower, ndc);
+			upper = glm::max(upper, ndc);
+		}
+		if (lower.x > upper.x || (upper.x - lower.x) * (upper.y - lower.y) * 0.25f < _minOccluderArea)
+		{
+			_statistics.rasterizeTime += ElapsedMilliseconds(startTime);
+			FrameStatistics::GetInstance().Increment(FrameStatistics::CullTime, ElapsedMicroseconds(startTime));
+			return false;
+		}
+
+		const size_t numTriangles = indices.size() / 3;
+		for (size_t triangle = 0; triangle < numTriangles; ++triangle)
+		{
+			glm::vec3 screen[3];
+			bool bClipped = false;
+			for (int i = 0; i < 3; ++i)
+			{
+				const glm::vec4& clip = _clipPositions[indices[triangle * 3 + i]];
+				//! Triangles crossing the near plane are dropped, fewer occluders never hide a visible object.
+				if (clip.z < -clip.w || clip.w <= 0.0f)
+				{
+					bClipped = true;
+					break;
+				}
+				const float inverseW = 1.0f / clip.w;
+				screen[i] = glm::vec3((clip.x * inverseW * 0.5f + 0.5f) * _width,
+									  (clip.y * inverseW * 0.5f + 0.5f) * _height,
+									  clip.z * inverseW * 0.5f + 0.5f);
+			}
+			if (bClipped)
+				continue;
+
+			const float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[1].y - screen[0].y) * (screen[2].x - screen[0].x);
+			if (area == 0.0f || !std::isfinite(area))
+				continue;
+
+			OccluderTriangle setup;
+			//! Pixels are covered when their center is inside, so the bounds snap inwards to centers.
+			setup.minX = std::max(0, static_cast<int>(std::ceil(std::min(screen[0].x, std::min(screen[1].x, screen[2].x)) - 0.5f)));
+			setup.minY = std::max(0, static_cast<int>(std::ceil(std::min(screen[0].y, std::min(screen[1].y, screen[2].y)) - 0.5f)));
+			setup.maxX = std::min(_width - 1, static_cast<int>(std::floor(std::max(screen[0].x, std::max(screen[1].x, screen[2].x)) - 0.5f)));
+			setup.maxY = std::min(_height - 1, static_cast<int>(std::floor(std::max(screen[0].y, std::max(screen[1].y, screen[2].y)) - 0.5f)));
+			if (setup.minX > setup.maxX || setup.minY > setup.maxY)
+				continue;
+
+			//! Both windings are drawn, the edge functions are flipped to be positive inside and the
+			//! depth plane is the barycentric interpolation folded into a * x + b * y + c.
+			const float sign = area > 0.0f ? 1.0f : -1.0f;
+			const float inverseArea = 1.0f / std::fabs(area);
+			setup.depthA = setup.depthB = setup.depthC = 0.0f;
+			for (int i = 0; i < 3; ++i)
+			{
+				const glm::vec3& a = screen[(i + 1) % 3];
+				const glm::vec3& b = screen[(i + 2) % 3];
+				setup.edgeA[i] = sign * (a.y - b.y);
+				setup.edgeB[i] = sign * (b.x - a.x);
+				setup.edgeC[i] = -(setup.edgeA[i] * a.x + setup.edgeB[i] * a.y);
+				setup.depthA += setup.edgeA[i] * screen[i].z * inverseArea;
+				setup.depthB += setup.edgeB[i] * screen[i].z * inverseArea;
+				setup.depthC += setup.edgeC[i] * screen[i].z * inverseArea;
+			}
+			_triangles.push_back(setup);
+		}
+
+		++_statistics.numOccluders;
+		_statistics.numOccluderTriangles += numTriangles;
+		_statistics.rasterizeTime += ElapsedMilliseconds(startTime);
+		FrameStatistics::GetInstance().Increment(FrameStatistics::CullTime, ElapsedMicroseconds(startTime));
+		return true;
+	}
+
+	void OcclusionCuller::RenderOccluders()
+	{
+		if (_levels.empty())
+			return;
+
+		ProfileScope scope("OcclusionCuller::RenderOccluders", static_cast<uint64_t>(_width) * _height);
+		auto& jobSystem = JobSystem::GetInstance();
+
+		//! Every band owns its rows, the workers never write the same memory.
+		const auto rasterizeStartTime = std::chrono::steady_clock::now();
+		auto startTime = rasterizeStartTime;
+		const int numBands = (_height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+		jobSystem.ParallelFor(static_cast<size_t>(numBands), [&](size_t band)
+		{
+			const int minY = static_cast<int>(band) * BAND_HEIGHT;
+			RasterizeBand(minY, std::min(_height, minY + BAND_HEIGHT) - 1);
+		});
+		_statistics.rasterizeTime += ElapsedMilliseconds(startTime);
+
+		//! Every texel keeps the farthest of its children, an odd edge reuses the last child.
+		startTime = std::chrono::steady_clock::now();
+		for (size_t levelIndex = 1; levelIndex < _levels.size(); ++levelIndex)
+		{
+			const DepthLevel& source = _levels[levelIndex - 1];
+			DepthLevel& target = _levels[levelIndex];
+			jobSystem.ParallelFor(static_cast<size_t>(target.height), [&](size_t row)
+			{
+				const int y = static_cast<int>(row);
+				const float* upperRow = source.depth.data() + static_cast<size_t>(std::min(2 * y, source.height - 1)) * source.pitch;
+				const float* lowerRow = source.depth.data() + static_cast<size_t>(std::min(2 * y + 1, source.height - 1)) * source.pitch;
+				float* targetRow = target.depth.data() + static_cast<size_t>(y) * target.pitch;
+				int x = 0;
+#ifdef GL3_USE_SSE2
+				for (; 2 * x + 7 < source.width; x += 4)
+				{
+					const __m128 left = _mm_max_ps(_mm_loadu_ps(upperRow + 2 * x), _mm_loadu_ps(lowerRow + 2 * x));
+					const __m128 right = _mm_max_ps(_mm_loadu_ps(upperRow + 2 * x + 4), _mm_loadu_ps(lowerRow + 2 * x + 4));
+					_mm_storeu_ps(targetRow + x, _mm_max_ps(_mm_shuffle_ps(left, right, _MM_SHUFFLE(2, 0, 2, 0)),
+															 _mm_shuffle_ps(left, right, _MM_SHUFFLE(3, 1, 3, 1))));
+				}
+#endif
+				for (; x < target.width; ++x)
+				{
+					const int x0 = std::min(2 * x, source.width - 1);
+					const int x1 = std::min(2 * x + 1, source.width - 1);
+					targetRow[x] = std::max(std::max(upperRow[x0], upperRow[x1]), std::max(lowerRow[x0], lowerRow[x1]));
+				}
+			});
+		}
+		_statistics.pyramidTime += ElapsedMilliseconds(startTime);
+		FrameStatistics::GetInstance().Increment(FrameStatistics::CullTime, ElapsedMicroseconds(rasterizeStartTime));
+	}
+
+	void OcclusionCuller::RasterizeBand(int bandMinY, int bandMaxY)
+	{
+		DepthLevel& level = _levels[0];
+
+#ifdef GL3_USE_SSE2
+		const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 zero = _mm_setzero_ps();
+#endif
+		for (const OccluderTriangle& triangle : _triangles)
+		{
+			const int minY = std::max(triangle.minY, bandMinY);
+			const int maxY = std::min(triangle.maxY, bandMaxY);
+			if (minY > maxY)
+				continue;
+
+			//! Lanes outside the triangle bounds fail the edge test, the padded row keeps the last group in memory.
+			const int minX = triangle.minX & ~3;
+#ifdef GL3_USE_SSE2
+			__m128 edgeStepX[3];
+			for (int i = 0; i < 3; ++i)
+				edgeStepX[i] = _mm_set1_ps(triangle.edgeA[i] * 4.0f);
+			const __m128 depthStepX = _mm_set1_ps(triangle.depthA * 4.0f);
+			const __m128 startX = _mm_add_ps(_mm_set1_ps(static_cast<float>(minX)), laneOffsets);
+#endif
+			for (int y = minY; y <= maxY; ++y)
+			{
+				const float centerY = static_cast<float>(y) + 0.5f;
+				float* depthRow = level.depth.data() + static_cast<size_t>(y) * level.pitch;
+#ifdef GL3_USE_SSE2
+				__m128 edge[3];
+				for (int i = 0; i < 3; ++i)
+					edge[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[i]), startX), _mm_set1_ps(triangle.edgeB[i] * centerY + triangle.edgeC[i]));
+				__m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.depthA), startX), _mm_set1_ps(triangle.depthB * centerY + triangle.depthC));
+
+				for (int x = minX; x <= triangle.maxX; x += 4)
+				{
+					const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge[0], zero), _mm_cmpge_ps(edge[1], zero)), _mm_cmpge_ps(edge[2], zero));
+					const __m128 current = _mm_loadu_ps(depthRow + x);
+					_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(inside, _mm_min_ps(current, depth)), _mm_andnot_ps(inside, current)));
+					for (int i = 0; i < 3; ++i)
+						edge[i] = _mm_add_ps(edge[i], edgeStepX[i]);
+					depth = _mm_add_ps(depth, depthStepX);
+				}
+#else
+				for (int x = minX; x <= triangle.maxX; ++x)
+				{
+					const float centerX = static_cast<float>(x) + 0.5f;
+					bool bInside = true;
+					for (int i = 0; i < 3; ++i)
+						bInside &= triangle.edgeA[i] * centerX + triangle.edgeB[i] * centerY + triangle.edgeC[i] >= 0.0f;
+					if (bInside)
+						depthRow[x] = std::min(depthRow[x], triangle.depthA * centerX + triangle.depthB * centerY + triangle.depthC);
+				}
+#endif
+			}
+		}
+	}
+
+	int OcclusionCuller::TestBox(const BoundingBox& box) const
+	{
+		//! Corners are the projected lower corner plus any combination of the projected box edges.
+		const glm::vec3 lower = box.GetLowerCorner();
+		const glm::vec3 extent = box.GetUpperCorner() - lower;
+		const glm::vec4 base = _viewProjection * glm::vec4(lower, 1.0f);
+		const glm::vec4 axes[3] = { _viewProjection[0] * extent.x, _viewProjection[1] * extent.y, _viewProjection[2] * extent.z };
+
+		glm::vec4 corners[8];
+		int outsideAll = 0x3f;
+		bool bCrossesNear = false;
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			glm::vec4 clip = base;
+			for (int axis = 0; axis < 3; ++axis)
+				if (corner & (1 << axis))
+					clip += axes[axis];
+			corners[corner] = clip;
+
+			const int outside = (clip.x < -clip.w) | ((clip.x > clip.w) << 1) | ((clip.y < -clip.w) << 2) |
+								((clip.y > clip.w) << 3) | ((clip.z < -clip.w) << 4) | ((clip.z > clip.w) << 5);
+			outsideAll &= outside;
+			bCrossesNear |= (outside & 0x10) != 0;
+		}
+		if (outsideAll)
+			return 1;
+		//! The projection of a box reaching behind the near plane is unbounded.
+		if (bCrossesNear)
+			return 0;
+
+		glm::vec3 screenLower(std::numeric_limits<float>::max()), screenUpper(-std::numeric_limits<float>::max());
+		for (const glm::vec4& clip : corners)
+		{
+			const glm::vec3 window = glm::vec3(clip) / clip.w * 0.5f + 0.5f;
+			screenLower = glm::min(screenLower, window);
+			screenUpper = glm::max(screenUpper, window);
+		}
+
+		//! Every pixel the rectangle touches is read, not only the covered pixel centers.
+		int minX = std::max(0, static_cast<int>(std::floor(screenLower.x * _width)));
+		int minY = std::max(0, static_cast<int>(std::floor(screenLower.y * _height)));
+		int maxX = std::min(_width - 1, static_cast<int>(std::floor(screenUpper.x * _width)));
+		int maxY = std::min(_height - 1, static_cast<int>(std::floor(screenUpper.y * _height)));
+
+		size_t levelIndex = 0;
+		while (levelIndex + 1 < _levels.size() && (maxX - minX >= MAX_TEST_TEXELS || maxY - minY >= MAX_TEST_TEXELS))
+		{
+			minX >>= 1;
+			minY >>= 1;
+			maxX >>= 1;
+			maxY >>= 1;
+			++levelIndex;
+		}
+
+		const DepthLevel& level = _levels[levelIndex];
+		for (int y = minY; y <= maxY; ++y)
+		{
+			const float* depthRow = level.depth.data() + static_cast<size_t>(y) * level.pitch;
+			for (int x = minX; x <= maxX; ++x)
+				if (depthRow[x] >= screenLower.z)
+					return 0;
+		}
+
+		return 2;
+	}
+
+	bool OcclusionCuller::IsVisible(const BoundingBox& box) const
+	{
+		return _levels.empty() || TestBox(box) == 0;
+	}
+
+	size_t OcclusionCuller::CullBoxes(const std::vector<BoundingBox>& boxes, std::vector<uint8_t>& visibility)
+	{
+		ProfileScope scope("OcclusionCuller::CullBoxes", boxes.size());
+		auto startTime = std::chrono::steady_clock::now();
+
+		visibility.assign(boxes.size(), 1);
+		if (_levels.empty())
+			return 0;
+
+		//! Every chunk adds its counts once, two atomic adds per BOX_CHUNK boxes.
+		const size_t numChunks = (boxes.size() + BOX_CHUNK - 1) / BOX_CHUNK;
+		std::atomic<size_t> frustumCulled(0), occlusionCulled(0);
+		JobSystem::GetInstance().ParallelFor(numChunks, [&](size_t chunk)
+		{
+			const size_t end = std::min(boxes.size(), (chunk + 1) * BOX_CHUNK);
+			size_t chunkFrustumCulled = 0, chunkOcclusionCulled = 0;
+			for (size_t index = chunk * BOX_CHUNK; index < end; ++index)
+			{
+				const int result = TestBox(boxes[index]);
+				visibility[index] = result == 0;
+				chunkFrustumCulled += result == 1;
+				chunkOcclusionCulled += result == 2;
+			}
+			frustumCulled.fetch_add(chunkFrustumCulled, std::memory_order_relaxed);
+			occlusionCulled.fetch_add(chunkOcclusionCulled, std::memory_order_relaxed);
+		});
+
+		const size_t numCulled = frustumCulled.load() + occlusionCulled.load();
+		_statistics.numFrustumCulled += frustumCulled.load();
+		_statistics.numOcclusionCulled += occlusionCulled.load();
+		_statistics.numTested += boxes.size();
+		_statistics.testTime += ElapsedMilliseconds(startTime);
+
+		auto& frameStatistics = FrameStatistics::GetInstance();
+		frameStatistics.Increment(FrameStatistics::CullTested, boxes.size());
+		frameStatistics.Increment(FrameStatistics::CullRejected, numCulled);
+		frameStatistics.Increment(FrameStatistics::CullTime, ElapsedMicroseconds(startTime));
+
+		return numCulled;
+	}
+};
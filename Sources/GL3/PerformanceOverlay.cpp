@@ -0,0 +1,211 @@
+#include <GL3/PerformanceOverlay.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/QualityController.hpp>
+#include <glad/glad.h>
+#include <glfw/glfw3.h>
+#include <imgui.h>
+#include <imgui_impl_glfw.h>
+#include <imgui_impl_opengl3.h>
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <iostream>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace
+{
+	//! Frames between two resident memory queries while the overlay is hidden
+	constexpr size_t HIDDEN_MEMORY_INTERVAL = 60;
+	//! Height of one graph in pixels
+	constexpr float GRAPH_HEIGHT = 48.0f;
+
+	//! Returns the resident set size of the process in megabytes, zero where it is not available.
+	float ReadResidentMemory()
+	{
+#ifdef __linux__
+		FILE* file = std::fopen("/proc/self/statm", "r");
+		if (!file)
+			return 0.0f;
+		unsigned long size = 0, resident = 0;
+		const int numRead = std::fscanf(file, "%lu %lu", &size, &resident);
+		std::fclose(file);
+		if (numRead != 2)
+			return 0.0f;
+		return static_cast<float>(static_cast<double>(resident) * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0));
+#else
+		return 0.0f;
+#endif
+	}
+};
+
+namespace GL3 {
+
+	PerformanceOverlay::PerformanceOverlay()
+		: _window(nullptr), _cursor(0), _numSamples(0), _lastBusyTime(0), _residentMemory(0.0f),
+		  _bInitialized(false), _bVisible(false), _bToggleKeyDown(false)
+	{
+		for (auto& history : _history)
+			history.values.fill(0.0f);
+	}
+
+	PerformanceOverlay::~PerformanceOverlay()
+	{
+		//! Do nothing
+	}
+
+	bool PerformanceOverlay::Initialize(GLFWwindow* window)
+	{
+		IMGUI_CHECKVERSION();
+		ImGui::CreateContext();
+		ImGui::StyleColorsDark();
+		//! No imgui.ini is written next to the executable.
+		ImGui::GetIO().IniFilename = nullptr;
+
+		if (!ImGui_ImplGlfw_InitForOpenGL(window, true) || !ImGui_ImplOpenGL3_Init("#version 450"))
+		{
+			std::cerr << "Failed to initialize the ImGui backends" << std::endl;
+			ImGui::DestroyContext();
+			return false;
+		}
+
+		_window = window;
+		_lastRecordTime = std::chrono::steady_clock::now();
+		_lastBusyTime = JobSystem::GetInstance().GetBusyTime();
+		_bInitialized = true;
+		return true;
+	}
+
+	void PerformanceOverlay::ProcessInput()
+	{
+		if (!_bInitialized)
+			return;
+
+		const bool bKeyDown = glfwGetKey(_window, GLFW_KEY_F1) == GLFW_PRESS;
+		if (bKeyDown && !_bToggleKeyDown)
+			_bVisible = !_bVisible;
+		_bToggleKeyDown = bKeyDown;
+	}
+
+	void PerformanceOverlay::Record(double cpuFrameTime, double gpuFrameTime, double geometryTime)
+	{
+		const auto nowTime = std::chrono::steady_clock::now();
+		const double interval = std::max(1e-6, std::chrono::duration<double>(nowTime - _lastRecordTime).count());
+		_lastRecordTime = nowTime;
+
+		auto& jobSystem = JobSystem::GetInstance();
+		const uint64_t busyTime = jobSystem.GetBusyTime();
+		const double occupancy = (busyTime - _lastBusyTime) * 1e-9 / (interval * jobSystem.GetNumThreads());
+		_lastBusyTime = busyTime;
+
+		if (_bVisible || _numSamples % HIDDEN_MEMORY_INTERVAL == 0)
+			_residentMemory = ReadResidentMemory();
+
+		const auto& statistics = FrameStatistics::GetInstance();
+		_history[CPUFrameTime].values[_cursor] = static_cast<float>(cpuFrameTime);
+		_history[GPUFrameTime].values[_cursor] = static_cast<float>(gpuFrameTime);
+		_history[GeometryTime].values[_cursor] = static_cast<float>(geometryTime);
+		_history[SimulationRate].values[_cursor] = static_cast<float>(statistics.Get(FrameStatistics::SimulationSteps) / interval);
+		_history[DrawCalls].values[_cursor] = static_cast<float>(statistics.Get(FrameStatistics::DrawCalls));
+		_history[Binds].values[_cursor] = static_cast<float>(statistics.Get(FrameStatistics::ShaderBinds) +
+															 statistics.Get(FrameStatistics::TextureBinds) +
+															 statistics.Get(FrameStatistics::BufferBinds));
+		_history[ResidentMemory].values[_cursor] = _residentMemory;
+		_history[JobOccupancy].values[_cursor] = static_cast<float>(std::min(1.0, occupancy) * 100.0);
+		_history[PooledAllocations].values[_cursor] = static_cast<float>(statistics.Get(FrameStatistics::PooledAllocations));
+		const size_t numTested = statistics.Get(FrameStatistics::CullTested);
+		_history[CulledRatio].values[_cursor] = numTested > 0 ? 100.0f * statistics.Get(FrameStatistics::CullRejected) / numTested : 0.0f;
+		_history[CullTime].values[_cursor] = static_cast<float>(statistics.Get(FrameStatistics::CullTime) / 1000.0);
+
+		_cursor = (_cursor + 1) % HISTORY_SIZE;
+		++_numSamples;
+	}
+
+	void PerformanceOverlay::Draw(const QualityController& qualityController)
+	{
+		if (!_bInitialized || !_bVisible)
+			return;
+
+		ImGui_ImplOpenGL3_NewFrame();
+		ImGui_ImplGlfw_NewFrame();
+		ImGui::NewFrame();
+
+		ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+		ImGui::SetNextWindowBgAlpha(0.8f);
+		ImGui::Begin("Performance (F1)", &_bVisible, ImGuiWindowFlags_AlwaysAutoResize);
+
+		//! Until the ring is full the samples are [0, _cursor), afterwards the oldest one sits at the cursor.
+		const size_t numFilled = std::min(_numSamples, HISTORY_SIZE);
+		const int offset = _numSamples >= HISTORY_SIZE ? static_cast<int>(_cursor) : 0;
+		const auto plot = [&](const char* label, Series series, const char* unit)
+		{
+			const History& history = _history[series];
+			const float maximum = history.Maximum(numFilled);
+			char overlay[64];
+			std::snprintf(overlay, sizeof(overlay), "avg %.2f max %.2f %s", history.Average(numFilled), maximum, unit);
+			ImGui::PlotLines(label, history.values.data(), static_cast<int>(numFilled), offset, overlay, 0.0f, std::max(1e-3f, maximum * 1.1f), ImVec2(320.0f, GRAPH_HEIGHT));
+		};
+
+		const float cpuAverage = _history[CPUFrameTime].Average(numFilled);
+		const float gpuAverage = _history[GPUFrameTime].Average(numFilled);
+		ImGui::Text("%.1f FPS, %.2f ms CPU, %.2f ms GPU", cpuAverage > 0.0f ? 1000.0f / std::max(cpuAverage, gpuAverage) : 0.0f, cpuAverage, gpuAverage);
+		plot("CPU frame", CPUFrameTime, "ms");
+		plot("GPU frame", GPUFrameTime, "ms");
+		plot("GPU geometry", GeometryTime, "ms");
+
+		//! Frame times from zero to twice the target, the last bucket also collects the slower frames.
+		float histogram[NUM_HISTOGRAM_BINS] = {};
+		const double histogramRange = qualityController.GetTargetFrameTime() * 2.0;
+		for (size_t sample = 0; sample < numFilled; ++sample)
+		{
+			const double frameTime = std::max(_history[CPUFrameTime].values[sample], _history[GPUFrameTime].values[sample]);
+			histogram[std::min(NUM_HISTOGRAM_BINS - 1, static_cast<size_t>(frameTime / histogramRange * NUM_HISTOGRAM_BINS))] += 1.0f;
+		}
+		char histogramLabel[64];
+		std::snprintf(histogramLabel, sizeof(histogramLabel), "0 - %.1f ms", histogramRange);
+		ImGui::PlotHistogram("Frame times", histogram, static_cast<int>(NUM_HISTOGRAM_BINS), 0, histogramLabel, 0.0f, FLT_MAX, ImVec2(320.0f, GRAPH_HEIGHT));
+
+		plot("Sim steps", SimulationRate, "/s");
+		plot("Draw calls", DrawCalls, "");
+		plot("Binds", Binds, "");
+		plot("Resident", ResidentMemory, "MB");
+		ImGui::TextUnformatted(MemoryTracker::GetInstance().GetDescription().c_str());
+		plot("Job occupancy", JobOccupancy, "%");
+		plot("Mallocs saved", PooledAllocations, "");
+		plot("Culled", CulledRatio, "%");
+		plot("Culling", CullTime, "ms");
+
+		ImGui::Separator();
+		ImGui::TextUnformatted(qualityController.GetDescription().c_str());
+
+		ImGui::End();
+		ImGui::Render();
+		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	}
+
+	void PerformanceOverlay::CleanUp()
+	{
+		if (!_bInitialized)
+			return;
+
+		ImGui_ImplOpenGL3_Shutdown();
+		ImGui_ImplGlfw_Shutdown();
+		ImGui::DestroyContext();
+		_bInitialized = false;
+	}
+
+	float PerformanceOverlay::History::Average(size_t count) const
+	{
+		float sum = 0.0f;
+		for (size_t sample = 0; sample < count; ++sample)
+			sum += values[sample];
+		return count ? sum / static_cast<float>(count) : 0.0f;
+	}
+
+	float PerformanceOverlay::History::Maximum(size_t count) const
+	{
+		return count ? *std::max_element(values.begin(), values.begin() + count) : 0.0f;
+	}
+};
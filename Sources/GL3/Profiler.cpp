@@ -0,0 +1,322 @@
+#include <GL3/Profiler.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	//! Set on job system workers, their scopes only record time.
+	thread_local bool tIsWorker = false;
+
+	uint64_t GetCurrentThreadId()
+	{
+#ifdef __linux__
+		return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+		return static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+	}
+
+#ifdef __linux__
+	//! perf_event configs in HardwareCounter order
+	const uint64_t EVENT_CONFIGS[GL3::NUM_HARDWARE_COUNTERS] = {
+		PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+	};
+
+	int OpenEvent(uint64_t config, pid_t threadId, int groupFd)
+	{
+		perf_event_attr attribute;
+		std::memset(&attribute, 0, sizeof(attribute));
+		attribute.type = PERF_TYPE_HARDWARE;
+		attribute.size = sizeof(attribute);
+		attribute.config = config;
+		attribute.disabled = groupFd == -1 ? 1 : 0;
+		attribute.exclude_kernel = 1;
+		attribute.exclude_hv = 1;
+		attribute.read_format = PERF_FORMAT_GROUP;
+		return static_cast<int>(syscall(__NR_perf_event_open, &attribute, threadId, -1, groupFd, 0));
+	}
+#endif
+};
+
+namespace GL3 {
+
+	double ScopeStatistics::GetIPC() const
+	{
+		const uint64_t cycles = counters[static_cast<size_t>(HardwareCounter::Cycles)];
+		return bHasCounters && cycles ? static_cast<double>(counters[static_cast<size_t>(HardwareCounter::Instructions)]) / cycles : 0.0;
+	}
+
+	double ScopeStatistics::GetBytesPerCell() const
+	{
+		return bHasCounters && numCells ? static_cast<double>(counters[static_cast<size_t>(HardwareCounter::CacheMisses)]) * Profiler::CACHE_LINE_SIZE / numCells : 0.0;
+	}
+
+	Profiler& Profiler::GetInstance()
+	{
+		static Profiler instance;
+		return instance;
+	}
+
+	Profiler::Profiler()
+		: _startTime(std::chrono::steady_clock::now()), _bCountersEnabled(false), _bTracing(false)
+	{
+		//! Do nothing
+	}
+
+	Profiler::~Profiler()
+	{
+#ifdef __linux__
+		for (const CounterGroup& group : _groups)
+			for (int fd : group.fds)
+				if (fd >= 0)
+					close(fd);
+#endif
+	}
+
+	bool Profiler::EnableHardwareCounters()
+	{
+		RegisterCurrentThread(false);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_bCountersEnabled)
+			return true;
+
+		for (uint64_t threadId : _registeredThreads)
+		{
+			CounterGroup group;
+			group.threadId = threadId;
+			if (!OpenCounterGroup(group))
+			{
+#ifdef __linux__
+				std::cerr << "Hardware counters unavailable (" << std::strerror(errno) << "), profiling wall time only" << std::endl;
+				for (const CounterGroup& opened : _groups)
+					for (int fd : opened.fds)
+						if (fd >= 0)
+							close(fd);
+#else
+				std::cerr << "Hardware counters are only supported on Linux, profiling wall time only" << std::endl;
+#endif
+				_groups.clear();
+				return false;
+			}
+			_groups.push_back(group);
+		}
+
+		_bCountersEnabled = true;
+		return true;
+	}
+
+	bool Profiler::OpenCounterGroup(CounterGroup& group)
+	{
+		std::fill(group.fds, group.fds + NUM_HARDWARE_COUNTERS, -1);
+#ifdef __linux__
+		for (size_t counter = 0; counter < NUM_HARDWARE_COUNTERS; ++counter)
+		{
+			group.fds[counter] = OpenEvent(EVENT_CONFIGS[counter], static_cast<pid_t>(group.threadId), counter == 0 ? -1 : group.fds[0]);
+			if (group.fds[counter] < 0)
+			{
+				const int error = errno;
+				for (size_t opened = 0; opened < counter; ++opened)
+					close(group.fds[opened]);
+				errno = error;
+				return false;
+			}
+		}
+		ioctl(group.fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(group.fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void Profiler::RegisterCurrentThread(bool bWorker)
+	{
+		tIsWorker = bWorker;
+		const uint64_t threadId = GetCurrentThreadId();
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (std::find(_registeredThreads.begin(), _registeredThreads.end(), threadId) != _registeredThreads.end())
+			return;
+		_registeredThreads.push_back(threadId);
+
+		//! Threads starting after the counters were enabled join the sums right away.
+		CounterGroup group;
+		group.threadId = threadId;
+		if (_bCountersEnabled && OpenCounterGroup(group))
+			_groups.push_back(group);
+	}
+
+	bool Profiler::ReadCounters(uint64_t* values) const
+	{
+		if (!_bCountersEnabled || tIsWorker)
+			return false;
+
+		std::fill(values, values + NUM_HARDWARE_COUNTERS, 0);
+#ifdef __linux__
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (const CounterGroup& group : _groups)
+		{
+			//! PERF_FORMAT_GROUP layout, the number of events followed by their values in open order.
+			uint64_t buffer[1 + NUM_HARDWARE_COUNTERS];
+			if (read(group.fds[0], buffer, sizeof(buffer)) != static_cast<ssize_t>(sizeof(buffer)))
+				continue;
+			for (size_t counter = 0; counter < NUM_HARDWARE_COUNTERS; ++counter)
+				values[counter] += buffer[1 + counter];
+		}
+#endif
+		return true;
+	}
+
+	void Profiler::Record(const char* name, double startTime, double duration, uint64_t numCells, const uint64_t* counters, bool bHasCounters)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto iter = _statistics.find(name);
+		if (iter == _statistics.end())
+			iter = _statistics.emplace(name, ScopeStatistics{}).first;
+
+		ScopeStatistics& statistics = iter->second;
+		++statistics.numCalls;
+		statistics.totalTime += duration;
+		statistics.maxTime = std::max(statistics.maxTime, duration);
+		statistics.numCells += numCells;
+		if (bHasCounters)
+		{
+			for (size_t counter = 0; counter < NUM_HARDWARE_COUNTERS; ++counter)
+				statistics.counters[counter] += counters[counter];
+			statistics.bHasCounters = true;
+		}
+
+		if (_bTracing)
+		{
+			TraceEvent event;
+			event.name = name;
+			event.threadId = GetCurrentThreadId();
+			event.startTime = startTime;
+			event.duration = duration;
+			event.numCells = numCells;
+			std::copy(counters, counters + NUM_HARDWARE_COUNTERS, event.counters);
+			event.bHasCounters = bHasCounters;
+			_trace.push_back(event);
+		}
+	}
+
+	void Profiler::SetTracing(bool bTracing)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_bTracing = bTracing;
+	}
+
+	bool Profiler::WriteTrace(const std::string& path) const
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			std::cerr << "Failed to open trace file " << path << std::endl;
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		file << "{\"traceEvents\":[";
+		for (size_t index = 0; index < _trace.size(); ++index)
+		{
+			const TraceEvent& event = _trace[index];
+			//! Trace timestamps and durations are in microseconds.
+			file << (index ? ",\n" : "\n") << std::fixed << std::setprecision(3)
+				 << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.threadId
+				 << ",\"ts\":" << event.startTime * 1000.0 << ",\"dur\":" << event.duration * 1000.0 << ",\"args\":{\"cells\":" << event.numCells;
+			if (event.bHasCounters)
+			{
+				ScopeStatistics statistics{};
+				statistics.numCells = event.numCells;
+				std::copy(event.counters, event.counters + NUM_HARDWARE_COUNTERS, statistics.counters);
+				statistics.bHasCounters = true;
+				file << ",\"cycles\":" << event.counters[0] << ",\"instructions\":" << event.counters[1]
+					 << ",\"cacheMisses\":" << event.counters[2] << ",\"branchMisses\":" << event.counters[3]
+					 << ",\"ipc\":" << statistics.GetIPC() << ",\"bytesPerCell\":" << statistics.GetBytesPerCell();
+			}
+			file << "}}";
+		}
+		file << "\n]}\n";
+
+		return true;
+	}
+
+	void Profiler::Report(std::ostream& stream) const
+	{
+		std::vector< std::pair<std::string, ScopeStatistics> > scopes;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			scopes.assign(_statistics.begin(), _statistics.end());
+		}
+		std::sort(scopes.begin(), scopes.end(), [](const auto& lhs, const auto& rhs) { return lhs.second.totalTime > rhs.second.totalTime; });
+
+		stream << std::left << std::setw(36) << "Scope" << std::right << std::setw(8) << "Calls" << std::setw(12) << "Total(ms)"
+			   << std::setw(10) << "Avg(ms)" << std::setw(10) << "Max(ms)";
+		if (_bCountersEnabled)
+			stream << std::setw(8) << "IPC" << std::setw(14) << "Cache miss" << std::setw(14) << "Branch miss" << std::setw(10) << "B/cell";
+		stream << std::endl;
+
+		for (const auto& scope : scopes)
+		{
+			const ScopeStatistics& statistics = scope.second;
+			stream << std::left << std::setw(36) << scope.first << std::right << std::setw(8) << statistics.numCalls << std::fixed << std::setprecision(3)
+				   << std::setw(12) << statistics.totalTime << std::setw(10) << statistics.totalTime / statistics.numCalls << std::setw(10) << statistics.maxTime;
+			if (_bCountersEnabled && statistics.bHasCounters)
+			{
+				stream << std::setprecision(2) << std::setw(8) << statistics.GetIPC()
+					   << std::setw(14) << statistics.counters[static_cast<size_t>(HardwareCounter::CacheMisses)]
+					   << std::setw(14) << statistics.counters[static_cast<size_t>(HardwareCounter::BranchMisses)];
+				if (statistics.numCells)
+					stream << std::setw(10) << statistics.GetBytesPerCell();
+			}
+			stream << std::endl;
+		}
+	}
+
+	std::unordered_map<std::string, ScopeStatistics> Profiler::GetStatistics() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _statistics;
+	}
+
+	void Profiler::Reset()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_statistics.clear();
+		_trace.clear();
+	}
+
+	ProfileScope::ProfileScope(const char* name, uint64_t numCells)
+		: _name(name), _numCells(numCells)
+	{
+		_bHasCounters = Profiler::GetInstance().ReadCounters(_startCounters);
+		_startTime = std::chrono::steady_clock::now();
+	}
+
+	ProfileScope::~ProfileScope()
+	{
+		const auto endTime = std::chrono::steady_clock::now();
+		Profiler& profiler = Profiler::GetInstance();
+
+		uint64_t counters[NUM_HARDWARE_COUNTERS] = {};
+		if (_bHasCounters && profiler.ReadCounters(counters))
+			for (size_t counter = 0; counter < NUM_HARDWARE_COUNTERS; ++counter)
+				counters[counter] -= _startCounters[counter];
+
+		profiler.Record(_name, std::chrono::duration<double, std::milli>(_startTime - profiler._startTime).count(),
+						std::chrono::duration<double, std::milli>(endTime - _startTime).count(), _numCells, counters, _bHasCounters);
+	}
+};
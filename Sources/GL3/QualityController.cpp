@@ -0,0 +1,200 @@
+#include <GL3/QualityController.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+	//! Weight of the newest frame in the smoothed timings
+	constexpr double SMOOTHING = 0.1;
+	//! Over budget above target * (1 + DEGRADE_MARGIN), under budget below target * (1 - UPGRADE_MARGIN)
+	constexpr double DEGRADE_MARGIN = 0.05;
+	constexpr double UPGRADE_MARGIN = 0.2;
+	//! Step limits of the render scale and the multiplicative steps of the other knobs
+	constexpr float MIN_SCALE_STEP = 0.05f;
+	constexpr float UPGRADE_SCALE_STEP = 0.05f;
+	constexpr float DEGRADE_FACTOR = 0.8f;
+	constexpr float UPGRADE_FACTOR = 1.1f;
+
+	//! Knobs tried in order when stepping, upgrades first spend the headroom of the side that is not the bottleneck.
+	//! The render scale only relieves the GPU, so CPU bound frames stop once the CPU knobs are at their limit or pinned.
+	const GL3::QualityKnob GPU_DEGRADE_ORDER[3] = { GL3::QualityKnob::RenderScale, GL3::QualityKnob::ImpostorDistance, GL3::QualityKnob::ParticleScale };
+	const GL3::QualityKnob CPU_DEGRADE_ORDER[3] = { GL3::QualityKnob::ParticleScale, GL3::QualityKnob::ImpostorDistance, GL3::QualityKnob::None };
+	const GL3::QualityKnob GPU_UPGRADE_ORDER[3] = { GL3::QualityKnob::ParticleScale, GL3::QualityKnob::ImpostorDistance, GL3::QualityKnob::RenderScale };
+	const GL3::QualityKnob CPU_UPGRADE_ORDER[3] = { GL3::QualityKnob::RenderScale, GL3::QualityKnob::ImpostorDistance, GL3::QualityKnob::ParticleScale };
+
+	float* GetKnobValue(GL3::QualitySettings& settings, GL3::QualityKnob knob)
+	{
+		switch (knob)
+		{
+		case GL3::QualityKnob::RenderScale:
+			return &settings.renderScale;
+		case GL3::QualityKnob::ParticleScale:
+			return &settings.particleScale;
+		default:
+			return &settings.impostorDistance;
+		}
+	}
+
+	const char* GetKnobName(GL3::QualityKnob knob)
+	{
+		switch (knob)
+		{
+		case GL3::QualityKnob::RenderScale:
+			return "render scale";
+		case GL3::QualityKnob::ParticleScale:
+			return "particles";
+		case GL3::QualityKnob::ImpostorDistance:
+			return "impostor distance";
+		default:
+			return "none";
+		}
+	}
+};
+
+namespace GL3 {
+
+	QualityController::QualityController()
+		: _settings{ 1.0f, 1.0f, 0.0f }, _minimum{ 1.0f, 1.0f, 0.0f }, _maximum{ 1.0f, 1.0f, 0.0f },
+		  _lastDecision{ 0, QualityKnob::None, 0.0f, 0.0f, 0.0, 0.0 }, _targetFrameTime(1000.0 / 60.0),
+		  _cpuTime(0.0), _gpuTime(0.0), _frame(0), _overBudgetFrames(0), _underBudgetFrames(0), _cooldown(0),
+		  _numDecisions(0), _bEnabled(true), _bCPUBound(false)
+	{
+		//! Do nothing
+	}
+
+	QualityController::~QualityController()
+	{
+		//! Do nothing
+	}
+
+	void QualityController::Initialize(double targetFrameTime, const QualitySettings& minimum, const QualitySettings& maximum)
+	{
+		_targetFrameTime = targetFrameTime;
+		_minimum = minimum;
+		_maximum = maximum;
+		_settings = maximum;
+		_lastDecision = QualityDecision{ 0, QualityKnob::None, 0.0f, 0.0f, 0.0, 0.0 };
+		_cpuTime = _gpuTime = 0.0;
+		_frame = _overBudgetFrames = _underBudgetFrames = _cooldown = _numDecisions = 0;
+		_bCPUBound = false;
+	}
+
+	void QualityController::SetEnabled(bool bEnabled)
+	{
+		_bEnabled = bEnabled;
+		if (!bEnabled)
+			_settings = _maximum;
+	}
+
+	bool QualityController::Update(double cpuTime, double gpuTime)
+	{
+		//! The first frame seeds the averages instead of blending with zero.
+		if (_frame++ == 0)
+		{
+			_cpuTime = cpuTime;
+			_gpuTime = gpuTime;
+		}
+		_cpuTime += (cpuTime - _cpuTime) * SMOOTHING;
+		_gpuTime += (gpuTime - _gpuTime) * SMOOTHING;
+
+		if (!_bEnabled)
+			return false;
+
+		const double frameTime = std::max(_cpuTime, _gpuTime);
+		if (frameTime > _targetFrameTime * (1.0 + DEGRADE_MARGIN))
+		{
+			++_overBudgetFrames;
+			_underBudgetFrames = 0;
+		}
+		else if (frameTime < _targetFrameTime * (1.0 - UPGRADE_MARGIN))
+		{
+			++_underBudgetFrames;
+			_overBudgetFrames = 0;
+			_bCPUBound = false;
+		}
+		else
+		{
+			_overBudgetFrames = _underBudgetFrames = 0;
+			_bCPUBound = false;
+		}
+
+		if (_cooldown > 0)
+		{
+			--_cooldown;
+			return false;
+		}
+
+		bool bChanged = false;
+		if (_overBudgetFrames >= DEGRADE_FRAMES)
+			bChanged = Step(true, frameTime);
+		else if (_underBudgetFrames >= UPGRADE_FRAMES)
+			bChanged = Step(false, frameTime);
+
+		if (bChanged)
+		{
+			_overBudgetFrames = _underBudgetFrames = 0;
+			_cooldown = COOLDOWN_FRAMES;
+			++_numDecisions;
+		}
+		return bChanged;
+	}
+
+	bool QualityController::Step(bool bDegrade, double frameTime)
+	{
+		//! The bottleneck picks the knob order, the render scale only relieves the GPU.
+		const bool bGPUBound = _gpuTime >= _cpuTime;
+		_bCPUBound = false;
+		const QualityKnob* order = bDegrade ? (bGPUBound ? GPU_DEGRADE_ORDER : CPU_DEGRADE_ORDER) : (bGPUBound ? GPU_UPGRADE_ORDER : CPU_UPGRADE_ORDER);
+		for (size_t index = 0; index < 3; ++index)
+		{
+			const QualityKnob knob = order[index];
+			if (knob == QualityKnob::None)
+				continue;
+
+			float* value = GetKnobValue(_settings, knob);
+			const float minimum = *GetKnobValue(_minimum, knob);
+			const float maximum = *GetKnobValue(_maximum, knob);
+			float newValue;
+			if (knob == QualityKnob::RenderScale)
+			{
+				//! Fill cost follows the pixel count, so the scale shrinks by the square root of the overshoot.
+				const float proportional = *value * static_cast<float>(std::sqrt(_targetFrameTime / frameTime));
+				newValue = bDegrade ? std::min(proportional, *value - MIN_SCALE_STEP) : *value + UPGRADE_SCALE_STEP;
+			}
+			else
+			{
+				newValue = *value * (bDegrade ? DEGRADE_FACTOR : UPGRADE_FACTOR);
+			}
+			newValue = std::min(std::max(newValue, minimum), maximum);
+			if (newValue == *value)
+				continue;
+
+			_lastDecision = QualityDecision{ _frame, knob, *value, newValue, _cpuTime, _gpuTime };
+			*value = newValue;
+			return true;
+		}
+
+		//! Nothing left to trade on the CPU side, the quality stays and the frame is reported as CPU bound.
+		_bCPUBound = bDegrade && !bGPUBound;
+		return false;
+	}
+
+	std::string QualityController::GetDescription() const
+	{
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(2)
+			   << "Quality scale " << _settings.renderScale << " particles " << _settings.particleScale
+			   << " impostors " << std::setprecision(0) << _settings.impostorDistance << std::setprecision(2);
+		if (!_bEnabled)
+			stream << " (fixed)";
+		else if (_lastDecision.knob != QualityKnob::None)
+			stream << " | frame " << _lastDecision.frame << " " << GetKnobName(_lastDecision.knob) << " "
+				   << _lastDecision.oldValue << " -> " << _lastDecision.newValue
+				   << " at CPU " << _lastDecision.cpuTime << " GPU " << _lastDecision.gpuTime << "(ms)";
+		if (_bCPUBound)
+			stream << " | CPU bound at CPU " << _cpuTime << " GPU " << _gpuTime << "(ms), quality kept";
+		return stream.str();
+	}
+};
@@ -1,14 +1,24 @@
 #include <GL3/Renderer.hpp>
+#include <GL3/Allocators.hpp>
 #include <GL3/Application.hpp>
 #include <GL3/Camera.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
 #include <GL3/Window.hpp>
 #include <glad/glad.h>
 #include <glfw/glfw3.h>
+#include <glm/common.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
 
 namespace GL3 {
 
 	Renderer::Renderer()
-		: _queryID(0), _bMeasureGPUTime(true)
+		: _queryID(0), _frameQueryIDs{ 0, 0 }, _offscreenFramebuffer(0), _offscreenColor(0), _offscreenDepth(0),
+		  _offscreenExtent(0), _offscreenBytes(0), _frameIndex(0), _geometryTime(0.0), _gpuFrameTime(0.0), _cpuUpdateTime(0.0),
+		  _cpuFrameTime(0.0), _bMeasureGPUTime(true)
 	{
 		//! Do nothing
 	}
@@ -35,10 +45,36 @@ namespace GL3 {
 		_mainWindow->operator+=(inputCallback);
 		_mainWindow->operator+=(cursorCallback);
 
+		//! Quality is traded for frame rate unless it is pinned to the maximum, the range opens once the
+		//! applications are known.
+		const double targetFrameTime = 1000.0 / configure["target-fps"].as<double>();
+		const QualitySettings maximum{ 1.0f, 1.0f, configure["impostor-distance"].as<float>() };
+		_qualityController.Initialize(targetFrameTime, maximum, maximum);
+		_qualityController.SetEnabled(!configure["fixed-quality"].as<bool>());
+
+		if (!_overlay.Initialize(_mainWindow->GetGLFWWindow()))
+			return false;
+		_overlay.SetVisible(configure["overlay"].as<bool>());
+
 		//! Initialize implementation parts
 		if (!OnInitialize(configure))
 			return false;
 
+		//! CPU knobs no application scales stay pinned, degrading them would change nothing. CPU bound
+		//! frames with every CPU knob pinned keep their quality and are reported as CPU bound.
+		QualitySettings minimum{ 0.5f, 0.25f, maximum.impostorDistance * 0.25f };
+		auto IsUsed = [this](QualityKnob knob)
+		{
+			return std::any_of(_applications.begin(), _applications.end(), [knob](const std::shared_ptr<Application>& app) { return app->UsesQualityKnob(knob); });
+		};
+		if (!IsUsed(QualityKnob::ParticleScale))
+			minimum.particleScale = maximum.particleScale;
+		if (!IsUsed(QualityKnob::ImpostorDistance))
+			minimum.impostorDistance = maximum.impostorDistance;
+		_qualityController.Initialize(targetFrameTime, minimum, maximum);
+		for (auto& app : _applications)
+			app->SetQualitySettings(_qualityController.GetSettings());
+
 		return true;
 	}
 
@@ -50,6 +86,7 @@ namespace GL3 {
 
 		//! Push new application to the list.
 		_applications.push_back(app);
+		app->SetQualitySettings(_qualityController.GetSettings());
 
 		//! Initialize the application and return it's result.
 		return app->Initialize(_mainWindow, configure);
@@ -57,8 +94,15 @@ namespace GL3 {
 
 	void Renderer::UpdateFrame(double dt)
 	{
+		ProfileScope scope("Renderer::UpdateFrame");
+		auto startTime = std::chrono::steady_clock::now();
+		FrameStatistics::GetInstance().Reset();
+		MemoryTracker::GetInstance().BeginFrame();
+		MemoryScope memoryScope(MemoryTracker::Rendering);
+
 		//! Do Input handling first
 		_mainWindow->ProcessInput();
+		_overlay.ProcessInput();
 
 		//! Get current application and it must be valid pointer
 		auto app = GetCurrentApplication();
@@ -69,10 +113,14 @@ namespace GL3 {
 
 		//! Update the rendeeer implementation part
 		OnUpdateFrame(dt);
+
+		_cpuUpdateTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count() / 1000.0;
 	}
 
 	void Renderer::DrawFrame()
 	{
+		ProfileScope scope("Renderer::DrawFrame");
+		MemoryScope memoryScope(MemoryTracker::Rendering);
 		//! Get current application and it must be valid pointer
 		auto app = GetCurrentApplication();
 		assert(app);
@@ -89,18 +137,64 @@ namespace GL3 {
 
 			app->Draw();
 
-			size_t elapsed_ms = EndGPUMeasure() / 1000000;
-			std::clog << '\r' << "Geometry Processing Measured " << elapsed_ms << "(ms)" << std::flush;
+			_geometryTime = EndGPUMeasure() / 1e6;
 
 			OnEndDraw();
 
 			glDisable(GL_RASTERIZER_DISCARD);
+
+			//! Only the presented pass counts towards the draw and bind statistics.
+			auto& statistics = FrameStatistics::GetInstance();
+			statistics.Reset(FrameStatistics::DrawCalls);
+			statistics.Reset(FrameStatistics::ShaderBinds);
+			statistics.Reset(FrameStatistics::TextureBinds);
+			statistics.Reset(FrameStatistics::BufferBinds);
+		}
+
+		//! Actual rendering part, into the offscreen target when the controller lowered the resolution.
+		auto startTime = std::chrono::steady_clock::now();
+		const glm::ivec2 windowExtent = _mainWindow->GetWindowExtent();
+		const float renderScale = _qualityController.GetSettings().renderScale;
+		bool bOffscreen = false;
+		if (renderScale < 1.0f)
+		{
+			const glm::ivec2 extent = glm::max(glm::ivec2(glm::vec2(windowExtent) * renderScale + 0.5f), glm::ivec2(1));
+			bOffscreen = ResizeOffscreenTarget(extent);
+			if (bOffscreen)
+			{
+				glBindFramebuffer(GL_FRAMEBUFFER, _offscreenFramebuffer);
+				glViewport(0, 0, extent.x, extent.y);
+			}
 		}
 
-		//! Actual rendering part.
+		BeginFrameMeasure();
 		OnBeginDraw();
 		app->Draw();
 		OnEndDraw();
+
+		if (bOffscreen)
+		{
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, _offscreenFramebuffer);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+			glBlitFramebuffer(0, 0, _offscreenExtent.x, _offscreenExtent.y, 0, 0, windowExtent.x, windowExtent.y, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glViewport(0, 0, windowExtent.x, windowExtent.y);
+		}
+		EndFrameMeasure();
+
+		_cpuFrameTime = _cpuUpdateTime + std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count() / 1000.0;
+		if (_qualityController.Update(_cpuFrameTime, _gpuFrameTime))
+			app->SetQualitySettings(_qualityController.GetSettings());
+
+		_overlay.Record(_cpuFrameTime, _gpuFrameTime, _geometryTime);
+		_overlay.Draw(_qualityController);
+
+		std::clog << '\r' << std::fixed << std::setprecision(2) << "Geometry Processing Measured " << _geometryTime << "(ms) | Frame CPU "
+				  << _cpuFrameTime << " GPU " << _gpuFrameTime << "(ms) | " << _qualityController.GetDescription() << " | "
+				  << MemoryTracker::GetInstance().GetDescription() << std::flush;
+
+		//! Temporaries of this frame stay valid through the next one.
+		FrameArena::GetInstance().EndFrame();
 	}
 
 	void Renderer::CleanUp()
@@ -110,6 +204,22 @@ namespace GL3 {
 		_applications.clear();
 		//! Renderer Implementation CleanUo
 		OnCleanUp();
+		_overlay.CleanUp();
+		if (_queryID)
+			glDeleteQueries(1, &_queryID);
+		if (_frameQueryIDs[0])
+			glDeleteQueries(2, _frameQueryIDs);
+		if (_offscreenFramebuffer)
+		{
+			glDeleteFramebuffers(1, &_offscreenFramebuffer);
+			glDeleteTextures(1, &_offscreenColor);
+			glDeleteRenderbuffers(1, &_offscreenDepth);
+		}
+		_queryID = _frameQueryIDs[0] = _frameQueryIDs[1] = 0;
+		_offscreenFramebuffer = _offscreenColor = _offscreenDepth = 0;
+		_offscreenExtent = glm::ivec2(0);
+		MemoryTracker::GetInstance().ReleaseGPU(MemoryTracker::Rendering, _offscreenBytes);
+		_offscreenBytes = 0;
 		//! Delete opengl context at last
 		//! Because opengl deletion calls must be called before context destructed.
 		_sharedWindows.clear();
@@ -141,6 +251,77 @@ namespace GL3 {
 		return elapsed;
 	}
 
+	void Renderer::BeginFrameMeasure()
+	{
+		if (!_frameQueryIDs[0])
+			glGenQueries(2, _frameQueryIDs);
+
+		//! The query issued last frame is read if the GPU finished it, otherwise the previous value stays.
+		if (_frameIndex > 0)
+		{
+			const GLuint previousQuery = _frameQueryIDs[(_frameIndex - 1) % 2];
+			GLint available = 0;
+			glGetQueryObjectiv(previousQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available)
+			{
+				GLuint64 elapsed = 0;
+				glGetQueryObjectui64v(previousQuery, GL_QUERY_RESULT, &elapsed);
+				_gpuFrameTime = elapsed / 1e6;
+			}
+		}
+		glBeginQuery(GL_TIME_ELAPSED, _frameQueryIDs[_frameIndex % 2]);
+	}
+
+	void Renderer::EndFrameMeasure()
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		++_frameIndex;
+	}
+
+	bool Renderer::ResizeOffscreenTarget(const glm::ivec2& extent)
+	{
+		if (_offscreenFramebuffer && extent == _offscreenExtent)
+			return true;
+
+		if (!_offscreenFramebuffer)
+		{
+			glGenFramebuffers(1, &_offscreenFramebuffer);
+			glGenTextures(1, &_offscreenColor);
+			glGenRenderbuffers(1, &_offscreenDepth);
+		}
+
+		glBindTexture(GL_TEXTURE_2D, _offscreenColor);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, extent.x, extent.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glBindRenderbuffer(GL_RENDERBUFFER, _offscreenDepth);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, extent.x, extent.y);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		//! RGBA8 color and packed depth stencil, four bytes each.
+		auto& memoryTracker = MemoryTracker::GetInstance();
+		memoryTracker.ReleaseGPU(MemoryTracker::Rendering, _offscreenBytes);
+		_offscreenBytes = static_cast<size_t>(extent.x) * extent.y * 8;
+		memoryTracker.AllocateGPU(MemoryTracker::Rendering, _offscreenBytes);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, _offscreenFramebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _offscreenColor, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _offscreenDepth);
+		const bool bComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		if (!bComplete)
+		{
+			std::cerr << "Incomplete offscreen framebuffer " << extent.x << "x" << extent.y << std::endl;
+			return false;
+		}
+
+		_offscreenExtent = extent;
+		return true;
+	}
+
 	std::shared_ptr<GL3::Application> Renderer::GetCurrentApplication() const
 	{
 		return _currentApp.expired() ? nullptr : _currentApp.lock();
@@ -1,8 +1,12 @@
 #include <GL3/Shader.hpp>
 #include <GL3/DebugUtils.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/MemoryTracker.hpp>
 #include <glad/glad.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <vector>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
@@ -53,7 +57,7 @@ std::string PreprocessShaderInclude(const std::string& path, std::string include
 namespace GL3 {
 
 	Shader::Shader()
-		: _programID(0)
+		: _programID(0), _programBytes(0)
 	{
 		//! Do nothing
 	}
@@ -118,12 +122,19 @@ namespace GL3 {
 			return false;
 		}
 
+		//! The linked binary is the closest estimate of the driver side program storage.
+		GLint binaryLength = 0;
+		glGetProgramiv(_programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		_programBytes = static_cast<size_t>(std::max(binaryLength, 0));
+		MemoryTracker::GetInstance().AllocateGPU(MemoryTracker::Shader, _programBytes);
+
 		return true;
 	}
 
 	void Shader::BindShaderProgram() const
 	{
 		glUseProgram(this->_programID);
+		FrameStatistics::GetInstance().Increment(FrameStatistics::ShaderBinds);
 	}
 	
 	void Shader::UnbindShaderProgram()
@@ -170,6 +181,9 @@ namespace GL3 {
 	{
 		if (_programID)
 			glDeleteProgram(_programID);
+		MemoryTracker::GetInstance().ReleaseGPU(MemoryTracker::Shader, _programBytes);
+		_programID = 0;
+		_programBytes = 0;
 	}
 
 	template <>
@@ -0,0 +1,391 @@
+#include <GL3/SmokeVolumeRenderer.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/Shader.hpp>
+#include <GL3/SIMD.hpp>
+#include <glad/glad.h>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace
+{
+	//! Rays stop once the remaining transmittance drops under this value.
+	constexpr float MIN_TRANSMITTANCE = 0.01f;
+
+	//! Samples marched per image row, reused by the calls of the thread
+	thread_local std::vector<size_t> tRowSamples;
+};
+
+namespace GL3 {
+
+	SmokeVolumeRenderer::SmokeVolumeRenderer()
+		: _extent(0), _brickExtent(0), _smokeAlbedo(0.55f, 0.53f, 0.5f), _densityScale(1.0f),
+		  _occupancyThreshold(1e-4f), _stepSize(0.5f), _samplesPerPixel(0.0f),
+		  _vao(0), _statsIndex(0), _bGLInitialized(false)
+	{
+		std::fill(_statsBuffers, _statsBuffers + NUM_STATS_BUFFERS, 0u);
+		std::fill(_statsFences, _statsFences + NUM_STATS_BUFFERS, nullptr);
+		std::fill(_statsPixels, _statsPixels + NUM_STATS_BUFFERS, 0);
+		_bounds.Merge(glm::vec3(-1.0f));
+		_bounds.Merge(glm::vec3(1.0f));
+	}
+
+	SmokeVolumeRenderer::~SmokeVolumeRenderer()
+	{
+		CleanUp();
+	}
+
+	bool SmokeVolumeRenderer::InitializeGL(std::shared_ptr<Shader> shader)
+	{
+		if (!shader)
+			return false;
+
+		_shader = std::move(shader);
+
+		//! The full screen triangle is generated from gl_VertexID, the VAO stays empty.
+		glGenVertexArrays(1, &_vao);
+
+		glGenBuffers(NUM_STATS_BUFFERS, _statsBuffers);
+		for (GLuint statsBuffer : _statsBuffers)
+		{
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, statsBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_READ);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		_statsIndex = 0;
+
+		_densityTexture.Initialize(GL_TEXTURE_3D);
+		_occupancyTexture.Initialize(GL_TEXTURE_3D);
+		_bGLInitialized = true;
+
+		return true;
+	}
+
+	void SmokeVolumeRenderer::SetVolumeBounds(const BoundingBox& bounds)
+	{
+		_bounds = bounds;
+	}
+
+	void SmokeVolumeRenderer::SetDensityScale(float densityScale, float occupancyThreshold)
+	{
+		_densityScale = densityScale;
+		_occupancyThreshold = occupancyThreshold;
+	}
+
+	void SmokeVolumeRenderer::UpdateVolume(const float* density, const glm::ivec3& extent)
+	{
+		_extent = extent;
+		_density.assign(density, density + static_cast<size_t>(extent.x) * extent.y * extent.z);
+
+		_brickExtent = (extent + BRICK_SIZE - 1) / BRICK_SIZE;
+		const size_t numBricks = static_cast<size_t>(_brickExtent.x) * _brickExtent.y * _brickExtent.z;
+		_brickMax.assign(numBricks, 0.0f);
+
+		//! Bricks are dilated by one voxel, trilinear samples near a face read the neighbor brick.
+		JobSystem::GetInstance().ParallelFor(numBricks, [&](size_t brick)
+		{
+			const glm::ivec3 coord(brick % _brickExtent.x, (brick / _brickExtent.x) % _brickExtent.y, brick / (_brickExtent.x * _brickExtent.y));
+			const glm::ivec3 lower = glm::max(coord * BRICK_SIZE - 1, glm::ivec3(0));
+			const glm::ivec3 upper = glm::min(coord * BRICK_SIZE + BRICK_SIZE + 1, _extent);
+
+			float maxDensity = 0.0f;
+			for (int z = lower.z; z < upper.z; ++z)
+				for (int y = lower.y; y < upper.y; ++y)
+				{
+					const float* row = _density.data() + (static_cast<size_t>(z) * _extent.y + y) * _extent.x;
+					for (int x = lower.x; x < upper.x; ++x)
+						maxDensity = std::max(maxDensity, row[x]);
+				}
+			_brickMax[brick] = maxDensity;
+		});
+
+		if (_bGLInitialized)
+		{
+			_densityTexture.BindTexture(0);
+			_densityTexture.UploadTexture3D(_density.data(), extent.x, extent.y, extent.z, GL_RED, GL_R32F, GL_FLOAT);
+			_occupancyTexture.BindTexture(1);
+			_occupancyTexture.UploadTexture3D(_brickMax.data(), _brickExtent.x, _brickExtent.y, _brickExtent.z, GL_RED, GL_R32F, GL_FLOAT);
+		}
+	}
+
+	void SmokeVolumeRenderer::RenderCPU(const glm::mat4& view, const glm::mat4& projection, int width, int height, std::vector<unsigned char>& pixels)
+	{
+		pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+		if (_density.empty() || width <= 0 || height <= 0)
+		{
+			_samplesPerPixel = 0.0f;
+			return;
+		}
+
+		const glm::mat4 invViewProj = glm::inverse(projection * view);
+		std::vector<size_t>& rowSamples = tRowSamples;
+		rowSamples.assign(height, 0);
+
+		JobSystem::GetInstance().ParallelFor(height, [&](size_t row)
+		{
+			const float ndcY = 1.0f - 2.0f * (static_cast<float>(row) + 0.5f) / static_cast<float>(height);
+			unsigned char* out = pixels.data() + row * width * 4;
+			size_t numSamples = 0;
+			for (int x = 0; x < width; ++x)
+			{
+				const float ndcX = 2.0f * (static_cast<float>(x) + 0.5f) / static_cast<float>(width) - 1.0f;
+				glm::vec4 nearPoint = invViewProj * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+				glm::vec4 farPoint = invViewProj * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+				const glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+				const glm::vec3 direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+
+				const glm::vec4 color = glm::clamp(MarchRay(origin, direction, numSamples), 0.0f, 1.0f);
+				for (int c = 0; c < 4; ++c)
+					out[x * 4 + c] = static_cast<unsigned char>(color[c] * 255.0f + 0.5f);
+			}
+			rowSamples[row] = numSamples;
+		});
+
+		size_t totalSamples = 0;
+		for (size_t samples : rowSamples)
+			totalSamples += samples;
+		_samplesPerPixel = static_cast<float>(totalSamples) / static_cast<float>(width * height);
+	}
+
+	void SmokeVolumeRenderer::RenderGL(const glm::mat4& view, const glm::mat4& projection, int width, int height)
+	{
+		if (!_bGLInitialized || _density.empty())
+			return;
+
+		//! The counter about to be reused was written NUM_STATS_BUFFERS renders ago, read it back only
+		//! when its fence has passed so the statistics never stall the pipeline.
+		const int index = _statsIndex;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _statsBuffers[index]);
+		if (_statsFences[index])
+		{
+			const GLenum status = glClientWaitSync(_statsFences[index], 0, 0);
+			if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+			{
+				GLuint totalSamples = 0;
+				glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &totalSamples);
+				_samplesPerPixel = static_cast<float>(totalSamples) / static_cast<float>(std::max(1, _statsPixels[index]));
+			}
+			glDeleteSync(_statsFences[index]);
+			_statsFences[index] = nullptr;
+		}
+
+		const GLuint zero = 0;
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _statsBuffers[index]);
+
+		_shader->BindShaderProgram();
+		_shader->SendUniformVariable("invViewProj", glm::inverse(projection * view));
+		_shader->SendUniformVariable("volumeMin", _bounds.GetLowerCorner());
+		_shader->SendUniformVariable("volumeMax", _bounds.GetUpperCorner());
+		_shader->SendUniformVariable("gridExtent", glm::vec3(_extent));
+		_shader->SendUniformVariable("smokeAlbedo", glm::vec3(_smokeAlbedo));
+		_shader->SendUniformVariable("stepSize", float(_stepSize));
+		_shader->SendUniformVariable("densityScale", float(_densityScale));
+		_shader->SendUniformVariable("occupancyThreshold", float(_occupancyThreshold));
+		_shader->SendUniformVariable("densityTexture", 0);
+		_shader->SendUniformVariable("occupancyTexture", 1);
+		_densityTexture.BindTexture(0);
+		_occupancyTexture.BindTexture(1);
+
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		glBindVertexArray(_vao);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glBindVertexArray(0);
+		FrameStatistics::GetInstance().Increment(FrameStatistics::DrawCalls);
+		glDisable(GL_BLEND);
+		Shader::UnbindShaderProgram();
+
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		_statsFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		_statsPixels[index] = width * height;
+		_statsIndex = (index + 1) % NUM_STATS_BUFFERS;
+	}
+
+	float SmokeVolumeRenderer::GetOccupiedBrickRatio() const
+	{
+		if (_brickMax.empty())
+			return 0.0f;
+
+		const size_t numOccupied = std::count_if(_brickMax.begin(), _brickMax.end(), [this](float value) { return value > _occupancyThreshold; });
+		return static_cast<float>(numOccupied) / static_cast<float>(_brickMax.size());
+	}
+
+	glm::vec4 SmokeVolumeRenderer::MarchRay(const glm::vec3& origin, const glm::vec3& direction, size_t& numSamples) const
+	{
+		//! March in voxel units, the grid spans [0, extent] on every axis.
+		const glm::vec3 lower = _bounds.GetLowerCorner();
+		const glm::vec3 scale = glm::vec3(_extent) / (_bounds.GetUpperCorner() - lower);
+		const glm::vec3 gridOrigin = (origin - lower) * scale;
+		glm::vec3 gridDirection = direction * scale;
+		const float voxelsPerMeter = glm::length(gridDirection);
+		gridDirection /= voxelsPerMeter;
+
+		float tNear = 0.0f;
+		float tFar = std::numeric_limits<float>::max();
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (std::fabs(gridDirection[axis]) < 1e-8f)
+			{
+				if (gridOrigin[axis] < 0.0f || gridOrigin[axis] > static_cast<float>(_extent[axis]))
+					return glm::vec4(0.0f);
+				continue;
+			}
+			float t0 = -gridOrigin[axis] / gridDirection[axis];
+			float t1 = (static_cast<float>(_extent[axis]) - gridOrigin[axis]) / gridDirection[axis];
+			if (t0 > t1)
+				std::swap(t0, t1);
+			tNear = std::max(tNear, t0);
+			tFar = std::min(tFar, t1);
+		}
+		if (tNear >= tFar)
+			return glm::vec4(0.0f);
+
+		const float opticalStep = _densityScale * _stepSize / voxelsPerMeter;
+		float transmittance = 1.0f;
+		float radiance = 0.0f;
+		float t = tNear;
+		while (t < tFar && transmittance > MIN_TRANSMITTANCE)
+		{
+			const glm::vec3 position = gridOrigin + gridDirection * t;
+			const glm::ivec3 brick = glm::clamp(glm::ivec3(position) / BRICK_SIZE, glm::ivec3(0), _brickExtent - 1);
+			const size_t brickIndex = (static_cast<size_t>(brick.z) * _brickExtent.y + brick.y) * _brickExtent.x + brick.x;
+
+			if (_brickMax[brickIndex] <= _occupancyThreshold)
+			{
+				//! Empty brick, jump to where the ray leaves it.
+				float tExit = std::numeric_limits<float>::max();
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					if (gridDirection[axis] > 1e-8f)
+						tExit = std::min(tExit, (static_cast<float>((brick[axis] + 1) * BRICK_SIZE) - position[axis]) / gridDirection[axis]);
+					else if (gridDirection[axis] < -1e-8f)
+						tExit = std::min(tExit, (static_cast<float>(brick[axis] * BRICK_SIZE) - position[axis]) / gridDirection[axis]);
+				}
+				t += std::max(tExit, 0.0f) + 1e-3f;
+				continue;
+			}
+
+			float gx[4], gy[4], gz[4], density[4];
+			for (int k = 0; k < 4; ++k)
+			{
+				const glm::vec3 sample = position + gridDirection * (_stepSize * static_cast<float>(k));
+				gx[k] = sample.x;
+				gy[k] = sample.y;
+				gz[k] = sample.z;
+			}
+			SampleDensity4(gx, gy, gz, density);
+
+			for (int k = 0; k < 4 && t < tFar; ++k)
+			{
+				const float alpha = 1.0f - std::exp(-opticalStep * density[k]);
+				radiance += transmittance * alpha;
+				transmittance *= 1.0f - alpha;
+				t += _stepSize;
+				++numSamples;
+			}
+		}
+
+		return glm::vec4(_smokeAlbedo * radiance, 1.0f - transmittance);
+	}
+
+	void SmokeVolumeRenderer::SampleDensity4(const float* gx, const float* gy, const float* gz, float* result) const
+	{
+		const size_t rowStride = static_cast<size_t>(_extent.x);
+		const size_t sliceStride = rowStride * _extent.y;
+		alignas(16) int ix[4], iy[4], iz[4];
+		alignas(16) float fx[4], fy[4], fz[4];
+
+#if defined(GL3_USE_SSE2)
+		//! Voxel centers sit at i + 0.5, clamp to the edge voxels before truncating.
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 x = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(gx), half), zero), _mm_set1_ps(static_cast<float>(_extent.x - 1)));
+		const __m128 y = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(gy), half), zero), _mm_set1_ps(static_cast<float>(_extent.y - 1)));
+		const __m128 z = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(gz), half), zero), _mm_set1_ps(static_cast<float>(_extent.z - 1)));
+		const __m128i cellX = _mm_cvttps_epi32(x);
+		const __m128i cellY = _mm_cvttps_epi32(y);
+		const __m128i cellZ = _mm_cvttps_epi32(z);
+		_mm_store_si128(reinterpret_cast<__m128i*>(ix), cellX);
+		_mm_store_si128(reinterpret_cast<__m128i*>(iy), cellY);
+		_mm_store_si128(reinterpret_cast<__m128i*>(iz), cellZ);
+		const __m128 weightX = _mm_sub_ps(x, _mm_cvtepi32_ps(cellX));
+		const __m128 weightY = _mm_sub_ps(y, _mm_cvtepi32_ps(cellY));
+		const __m128 weightZ = _mm_sub_ps(z, _mm_cvtepi32_ps(cellZ));
+		_mm_store_ps(fx, weightX);
+		_mm_store_ps(fy, weightY);
+		_mm_store_ps(fz, weightZ);
+
+		alignas(16) float corners[8][4];
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			const size_t base = iz[lane] * sliceStride + iy[lane] * rowStride + ix[lane];
+			const size_t dx = ix[lane] + 1 < _extent.x ? 1 : 0;
+			const size_t dy = iy[lane] + 1 < _extent.y ? rowStride : 0;
+			const size_t dz = iz[lane] + 1 < _extent.z ? sliceStride : 0;
+			corners[0][lane] = _density[base];
+			corners[1][lane] = _density[base + dx];
+			corners[2][lane] = _density[base + dy];
+			corners[3][lane] = _density[base + dy + dx];
+			corners[4][lane] = _density[base + dz];
+			corners[5][lane] = _density[base + dz + dx];
+			corners[6][lane] = _density[base + dz + dy];
+			corners[7][lane] = _density[base + dz + dy + dx];
+		}
+
+		auto lerp = [](__m128 a, __m128 b, __m128 w) { return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), w)); };
+		const __m128 c00 = lerp(_mm_load_ps(corners[0]), _mm_load_ps(corners[1]), weightX);
+		const __m128 c10 = lerp(_mm_load_ps(corners[2]), _mm_load_ps(corners[3]), weightX);
+		const __m128 c01 = lerp(_mm_load_ps(corners[4]), _mm_load_ps(corners[5]), weightX);
+		const __m128 c11 = lerp(_mm_load_ps(corners[6]), _mm_load_ps(corners[7]), weightX);
+		const __m128 c0 = lerp(c00, c10, weightY);
+		const __m128 c1 = lerp(c01, c11, weightY);
+		_mm_storeu_ps(result, lerp(c0, c1, weightZ));
+#else
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			const float x = glm::clamp(gx[lane] - 0.5f, 0.0f, static_cast<float>(_extent.x - 1));
+			const float y = glm::clamp(gy[lane] - 0.5f, 0.0f, static_cast<float>(_extent.y - 1));
+			const float z = glm::clamp(gz[lane] - 0.5f, 0.0f, static_cast<float>(_extent.z - 1));
+			ix[lane] = static_cast<int>(x);
+			iy[lane] = static_cast<int>(y);
+			iz[lane] = static_cast<int>(z);
+			fx[lane] = x - ix[lane];
+			fy[lane] = y - iy[lane];
+			fz[lane] = z - iz[lane];
+
+			const size_t base = iz[lane] * sliceStride + iy[lane] * rowStride + ix[lane];
+			const size_t dx = ix[lane] + 1 < _extent.x ? 1 : 0;
+			const size_t dy = iy[lane] + 1 < _extent.y ? rowStride : 0;
+			const size_t dz = iz[lane] + 1 < _extent.z ? sliceStride : 0;
+			const float c00 = glm::mix(_density[base], _density[base + dx], fx[lane]);
+			const float c10 = glm::mix(_density[base + dy], _density[base + dy + dx], fx[lane]);
+			const float c01 = glm::mix(_density[base + dz], _density[base + dz + dx], fx[lane]);
+			const float c11 = glm::mix(_density[base + dz + dy], _density[base + dz + dy + dx], fx[lane]);
+			result[lane] = glm::mix(glm::mix(c00, c10, fy[lane]), glm::mix(c01, c11, fy[lane]), fz[lane]);
+		}
+#endif
+	}
+
+	void SmokeVolumeRenderer::CleanUp()
+	{
+		if (_vao) glDeleteVertexArrays(1, &_vao);
+		for (int index = 0; index < NUM_STATS_BUFFERS; ++index)
+		{
+			if (_statsFences[index]) glDeleteSync(_statsFences[index]);
+			if (_statsBuffers[index]) glDeleteBuffers(1, &_statsBuffers[index]);
+			_statsFences[index] = nullptr;
+			_statsBuffers[index] = 0;
+		}
+		_vao = 0;
+		_densityTexture.CleanUp();
+		_occupancyTexture.CleanUp();
+		_bGLInitialized = false;
+	}
+
+};
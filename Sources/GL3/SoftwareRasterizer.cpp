@@ -0,0 +1,408 @@
+#include <GL3/SoftwareRasterizer.hpp>
+#include <GL3/Camera.hpp>
+#include <GL3/ClusteredLighting.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/Mesh.hpp>
+#include <GL3/Profiler.hpp>
+#include <GL3/SIMD.hpp>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	//! Vertices and triangles processed by a single job of the geometry stages
+	constexpr size_t GEOMETRY_CHUNK = 4096;
+
+	//! Constants of clustered_output.glsl
+	const glm::vec3 ALBEDO(0.0f, 0.0f, 0.9f);
+	const glm::vec3 AMBIENT(0.1f);
+
+	inline uint8_t ToUnorm8(float value)
+	{
+		return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+};
+
+namespace GL3 {
+
+	SoftwareRasterizer::SoftwareRasterizer()
+		: _view(1.0f), _projection(1.0f), _culler(nullptr), _width(0), _height(0), _pitch(0),
+		  _tilesX(0), _tilesY(0), _numShadedFragments(0)
+	{
+		//! Do nothing
+	}
+
+	SoftwareRasterizer::~SoftwareRasterizer()
+	{
+		//! Do nothing
+	}
+
+	bool SoftwareRasterizer::Initialize(int width, int height)
+	{
+		if (width <= 0 || height <= 0)
+		{
+			std::cerr << "Invalid software framebuffer " << width << "x" << height << std::endl;
+			return false;
+		}
+
+		_width = width;
+		_height = height;
+		//! Rows are padded so the four wide depth loads never leave the row.
+		_pitch = (width + 3) & ~3;
+		_tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+		_tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+		_color.assign(static_cast<size_t>(width) * height * 4, 0);
+		_depth.assign(static_cast<size_t>(_pitch) * height, 1.0f);
+		_batches.clear();
+
+		return true;
+	}
+
+	void SoftwareRasterizer::Clear(const glm::vec4& color, float depth)
+	{
+		const uint8_t clearColor[4] = { ToUnorm8(color.r), ToUnorm8(color.g), ToUnorm8(color.b), ToUnorm8(color.a) };
+		for (size_t pixel = 0; pixel < _color.size(); pixel += 4)
+			std::copy(clearColor, clearColor + 4, _color.begin() + pixel);
+		std::fill(_depth.begin(), _depth.end(), depth);
+		_batches.clear();
+		_numShadedFragments = 0;
+	}
+
+	void SoftwareRasterizer::SetCamera(Camera& camera)
+	{
+		SetCamera(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+	}
+
+	void SoftwareRasterizer::SetCamera(const glm::mat4& view, const glm::mat4& projection)
+	{
+		_view = view;
+		_projection = projection;
+	}
+
+	void SoftwareRasterizer::SetLighting(const ClusteredLightCuller* culler)
+	{
+		_culler = culler;
+	}
+
+	void SoftwareRasterizer::DrawMesh(const Mesh& mesh, const glm::mat4& model)
+	{
+		const auto& positions = mesh.GetPositions();
+		const auto& normals = mesh.GetNormals();
+		const auto& indices = mesh.GetIndices();
+		if (indices.empty() || _color.empty())
+			return;
+
+		auto& jobSystem = JobSystem::GetInstance();
+
+		//! Vertex stage of vertex.glsl
+		const glm::mat4 viewProjection = _projection * _view;
+		const glm::mat3 normalMatrix(model);
+		std::vector<ClipVertex>& vertices = _clipVertices;
+		vertices.resize(positions.size());
+		jobSystem.ParallelFor((positions.size() + GEOMETRY_CHUNK - 1) / GEOMETRY_CHUNK, [&](size_t chunk)
+		{
+			const size_t end = std::min(positions.size(), (chunk + 1) * GEOMETRY_CHUNK);
+			for (size_t vertex = chunk * GEOMETRY_CHUNK; vertex < end; ++vertex)
+			{
+				const glm::vec4 worldPos = model * glm::vec4(positions[vertex], 1.0f);
+				vertices[vertex].worldPos = glm::vec3(worldPos);
+				vertices[vertex].normal = normalMatrix * normals[vertex];
+				vertices[vertex].position = viewProjection * worldPos;
+			}
+		});
+
+		//! Triangle setup per chunk, concatenated in submission order.
+		const size_t numTriangles = indices.size() / 3;
+		const size_t numChunks = (numTriangles + GEOMETRY_CHUNK - 1) / GEOMETRY_CHUNK;
+		std::vector< std::vector<SetupTriangle> > chunkTriangles(numChunks);
+		jobSystem.ParallelFor(numChunks, [&](size_t chunk)
+		{
+			const size_t end = std::min(numTriangles, (chunk + 1) * GEOMETRY_CHUNK);
+			for (size_t triangle = chunk * GEOMETRY_CHUNK; triangle < end; ++triangle)
+				SetupTriangles(vertices[indices[triangle * 3]], vertices[indices[triangle * 3 + 1]], vertices[indices[triangle * 3 + 2]], chunkTriangles[chunk]);
+		});
+
+		_batches.emplace_back();
+		DrawBatch& batch = _batches.back();
+		for (const auto& triangles : chunkTriangles)
+			batch.triangles.insert(batch.triangles.end(), triangles.begin(), triangles.end());
+
+		//! Counting sort of the triangles into every tile their bounds touch, keeping submission order per tile.
+		const size_t numTiles = static_cast<size_t>(_tilesX) * _tilesY;
+		batch.tileOffsets.assign(numTiles + 1, 0);
+		for (const SetupTriangle& triangle : batch.triangles)
+			for (int tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; ++tileY)
+				for (int tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; ++tileX)
+					++batch.tileOffsets[tileY * _tilesX + tileX + 1];
+		for (size_t tile = 0; tile < numTiles; ++tile)
+			batch.tileOffsets[tile + 1] += batch.tileOffsets[tile];
+
+		std::vector<uint32_t>& cursor = _tileCursor;
+		cursor.assign(batch.tileOffsets.begin(), batch.tileOffsets.end() - 1);
+		batch.tileTriangles.resize(batch.tileOffsets.back());
+		for (uint32_t index = 0; index < batch.triangles.size(); ++index)
+		{
+			const SetupTriangle& triangle = batch.triangles[index];
+			for (int tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; ++tileY)
+				for (int tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; ++tileX)
+					batch.tileTriangles[cursor[tileY * _tilesX + tileX]++] = index;
+		}
+	}
+
+	void SoftwareRasterizer::SetupTriangles(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, std::vector<SetupTriangle>& triangles) const
+	{
+		//! Clip the polygon against the near plane z = -w, the other planes are handled by the
+		//! viewport clamp and the depth test.
+		ClipVertex input[3] = { v0, v1, v2 };
+		ClipVertex polygon[4];
+		int numVertices = 0;
+		for (int i = 0; i < 3; ++i)
+		{
+			const ClipVertex& current = input[i];
+			const ClipVertex& next = input[(i + 1) % 3];
+			const float currentDistance = current.position.z + current.position.w;
+			const float nextDistance = next.position.z + next.position.w;
+			if (currentDistance >= 0.0f)
+				polygon[numVertices++] = current;
+			if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+			{
+				const float t = currentDistance / (currentDistance - nextDistance);
+				ClipVertex& clipped = polygon[numVertices++];
+				clipped.position = glm::mix(current.position, next.position, t);
+				clipped.worldPos = glm::mix(current.worldPos, next.worldPos, t);
+				clipped.normal = glm::mix(current.normal, next.normal, t);
+			}
+		}
+
+		for (int fan = 1; fan + 1 < numVertices; ++fan)
+		{
+			const ClipVertex* corners[3] = { &polygon[0], &polygon[fan], &polygon[fan + 1] };
+			SetupTriangle triangle;
+			glm::vec2 screen[3];
+			for (int i = 0; i < 3; ++i)
+			{
+				const glm::vec4& clip = corners[i]->position;
+				triangle.inverseW[i] = 1.0f / clip.w;
+				screen[i] = glm::vec2((clip.x * triangle.inverseW[i] * 0.5f + 0.5f) * _width,
+									  (clip.y * triangle.inverseW[i] * 0.5f + 0.5f) * _height);
+				triangle.depth[i] = clip.z * triangle.inverseW[i] * 0.5f + 0.5f;
+				triangle.worldPos[i] = corners[i]->worldPos;
+				triangle.normal[i] = corners[i]->normal;
+			}
+
+			float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[1].y - screen[0].y) * (screen[2].x - screen[0].x);
+			if (area == 0.0f || !std::isfinite(area))
+				continue;
+
+			//! Both windings are drawn, the edge functions are flipped to be positive inside.
+			const float sign = area > 0.0f ? 1.0f : -1.0f;
+			for (int i = 0; i < 3; ++i)
+			{
+				const glm::vec2& a = screen[(i + 1) % 3];
+				const glm::vec2& b = screen[(i + 2) % 3];
+				triangle.edgeA[i] = sign * (a.y - b.y);
+				triangle.edgeB[i] = sign * (b.x - a.x);
+				triangle.edgeC[i] = -(triangle.edgeA[i] * a.x + triangle.edgeB[i] * a.y);
+			}
+			triangle.inverseArea = 1.0f / std::fabs(area);
+
+			const glm::vec2 lower = glm::min(screen[0], glm::min(screen[1], screen[2]));
+			const glm::vec2 upper = glm::max(screen[0], glm::max(screen[1], screen[2]));
+			triangle.minX = std::max(0, static_cast<int>(std::floor(lower.x)));
+			triangle.minY = std::max(0, static_cast<int>(std::floor(lower.y)));
+			triangle.maxX = std::min(_width - 1, static_cast<int>(std::ceil(upper.x)));
+			triangle.maxY = std::min(_height - 1, static_cast<int>(std::ceil(upper.y)));
+			if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+				continue;
+
+			triangles.push_back(triangle);
+		}
+	}
+
+	void SoftwareRasterizer::Flush()
+	{
+		ProfileScope scope("SoftwareRasterizer::Flush", static_cast<uint64_t>(_width) * _height);
+		const size_t numTiles = static_cast<size_t>(_tilesX) * _tilesY;
+		std::vector<size_t>& tileFragments = _tileFragments;
+		tileFragments.assign(numTiles, 0);
+
+		//! Every tile owns its pixels, the workers never write the same memory.
+		JobSystem::GetInstance().ParallelFor(numTiles, [&](size_t tile)
+		{
+			const int tileMinX = static_cast<int>(tile % _tilesX) * TILE_SIZE;
+			const int tileMinY = static_cast<int>(tile / _tilesX) * TILE_SIZE;
+			const int tileMaxX = std::min(_width, tileMinX + TILE_SIZE) - 1;
+			const int tileMaxY = std::min(_height, tileMinY + TILE_SIZE) - 1;
+			for (const DrawBatch& batch : _batches)
+				for (uint32_t entry = batch.tileOffsets[tile]; entry < batch.tileOffsets[tile + 1]; ++entry)
+					tileFragments[tile] += RasterizeTriangle(batch.triangles[batch.tileTriangles[entry]], tileMinX, tileMinY, tileMaxX, tileMaxY);
+		});
+
+		for (size_t fragments : tileFragments)
+			_numShadedFragments += fragments;
+		_batches.clear();
+	}
+
+	size_t SoftwareRasterizer::RasterizeTriangle(const SetupTriangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY)
+	{
+		//! Columns are walked in groups of four starting on a multiple of four, lanes outside
+		//! [firstX, maxX] are masked off.
+		const int firstX = std::max(triangle.minX, tileMinX);
+		const int minX = firstX & ~3;
+		const int maxX = std::min(triangle.maxX, tileMaxX);
+		const int minY = std::max(triangle.minY, tileMinY);
+		const int maxY = std::min(triangle.maxY, tileMaxY);
+		size_t numFragments = 0;
+
+#ifdef GL3_USE_SSE2
+		const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 zero = _mm_setzero_ps();
+		__m128 edgeA[3], edgeStepX[3], depthWeights[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			edgeA[i] = _mm_set1_ps(triangle.edgeA[i]);
+			edgeStepX[i] = _mm_set1_ps(triangle.edgeA[i] * 4.0f);
+			//! Depth is affine in screen space, interpolated from the unnormalized edge values.
+			depthWeights[i] = _mm_set1_ps(triangle.depth[i] * triangle.inverseArea);
+		}
+#endif
+		for (int y = minY; y <= maxY; ++y)
+		{
+			const float centerY = static_cast<float>(y) + 0.5f;
+			float* depthRow = _depth.data() + static_cast<size_t>(y) * _pitch;
+#ifdef GL3_USE_SSE2
+			__m128 edge[3];
+			for (int i = 0; i < 3; ++i)
+				edge[i] = _mm_add_ps(_mm_mul_ps(edgeA[i], _mm_add_ps(_mm_set1_ps(static_cast<float>(minX)), laneOffsets)),
+									 _mm_set1_ps(triangle.edgeB[i] * centerY + triangle.edgeC[i]));
+#endif
+			for (int x = minX; x <= maxX; x += 4)
+			{
+				float weights[3][4], depthValues[4];
+				int mask = 0;
+#ifdef GL3_USE_SSE2
+				const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge[0], zero), _mm_cmpge_ps(edge[1], zero)), _mm_cmpge_ps(edge[2], zero));
+				mask = _mm_movemask_ps(inside);
+				if (mask)
+				{
+					const __m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge[0], depthWeights[0]), _mm_mul_ps(edge[1], depthWeights[1])),
+													_mm_mul_ps(edge[2], depthWeights[2]));
+					mask &= _mm_movemask_ps(_mm_cmplt_ps(depth, _mm_loadu_ps(depthRow + x)));
+					_mm_storeu_ps(depthValues, depth);
+					for (int i = 0; i < 3; ++i)
+						_mm_storeu_ps(weights[i], edge[i]);
+				}
+				for (int i = 0; i < 3; ++i)
+					edge[i] = _mm_add_ps(edge[i], edgeStepX[i]);
+#else
+				for (int lane = 0; lane < 4; ++lane)
+				{
+					const float centerX = static_cast<float>(x + lane) + 0.5f;
+					for (int i = 0; i < 3; ++i)
+						weights[i][lane] = triangle.edgeA[i] * centerX + triangle.edgeB[i] * centerY + triangle.edgeC[i];
+					depthValues[lane] = (weights[0][lane] * triangle.depth[0] + weights[1][lane] * triangle.depth[1] + weights[2][lane] * triangle.depth[2]) * triangle.inverseArea;
+					if (weights[0][lane] >= 0.0f && weights[1][lane] >= 0.0f && weights[2][lane] >= 0.0f && depthValues[lane] < depthRow[x + lane])
+						mask |= 1 << lane;
+				}
+#endif
+				for (int lane = 0; mask && lane < 4; ++lane)
+				{
+					const int pixelX = x + lane;
+					if (!(mask & (1 << lane)) || pixelX < firstX || pixelX > maxX)
+						continue;
+
+					//! Perspective correct attributes from the screen space weights.
+					const float perspective[3] = { weights[0][lane] * triangle.inverseW[0], weights[1][lane] * triangle.inverseW[1], weights[2][lane] * triangle.inverseW[2] };
+					const float normalization = 1.0f / (perspective[0] + perspective[1] + perspective[2]);
+					const glm::vec3 worldPos = (triangle.worldPos[0] * perspective[0] + triangle.worldPos[1] * perspective[1] + triangle.worldPos[2] * perspective[2]) * normalization;
+					const glm::vec3 normal = (triangle.normal[0] * perspective[0] + triangle.normal[1] * perspective[1] + triangle.normal[2] * perspective[2]) * normalization;
+					const glm::vec3 color = ShadeFragment(worldPos, normal, static_cast<float>(pixelX) + 0.5f, centerY);
+
+					depthRow[pixelX] = depthValues[lane];
+					uint8_t* pixel = _color.data() + (static_cast<size_t>(y) * _width + pixelX) * 4;
+					pixel[0] = ToUnorm8(color.r);
+					pixel[1] = ToUnorm8(color.g);
+					pixel[2] = ToUnorm8(color.b);
+					pixel[3] = 255;
+					++numFragments;
+				}
+			}
+		}
+
+		return numFragments;
+	}
+
+	glm::vec3 SoftwareRasterizer::ShadeFragment(const glm::vec3& worldPos, const glm::vec3& normal, float fragX, float fragY) const
+	{
+		glm::vec3 radiance = ALBEDO * AMBIENT;
+		if (!_culler || _culler->GetClusterRecords().empty())
+			return radiance;
+
+		//! Same cluster lookup as clustered_output.glsl
+		constexpr int CLUSTER_X = ClusteredLightCuller::CLUSTER_X;
+		constexpr int CLUSTER_Y = ClusteredLightCuller::CLUSTER_Y;
+		constexpr int CLUSTER_Z = ClusteredLightCuller::CLUSTER_Z;
+		const float zNear = _culler->GetZNear();
+		const float zFar = _culler->GetZFar();
+		const float depth = -(_view * glm::vec4(worldPos, 1.0f)).z;
+		const int slice = static_cast<int>(glm::clamp(std::log(depth / zNear) / std::log(zFar / zNear) * CLUSTER_Z, 0.0f, CLUSTER_Z - 1.0f));
+		const int tileX = static_cast<int>(glm::clamp(fragX / _width * CLUSTER_X, 0.0f, CLUSTER_X - 1.0f));
+		const int tileY = static_cast<int>(glm::clamp(fragY / _height * CLUSTER_Y, 0.0f, CLUSTER_Y - 1.0f));
+		const size_t cluster = (static_cast<size_t>(slice) * CLUSTER_Y + tileY) * CLUSTER_X + tileX;
+		const uint32_t offset = _culler->GetClusterRecords()[cluster * 2];
+		const uint32_t count = _culler->GetClusterRecords()[cluster * 2 + 1];
+
+		const glm::vec3 unitNormal = glm::normalize(normal);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const PointLight& light = _culler->GetLights()[_culler->GetLightIndices()[offset + i]];
+			const glm::vec3 toLight = light.position - worldPos;
+			const float distance = glm::length(toLight);
+			const float ratio2 = distance * distance / (light.radius * light.radius);
+			const float window = glm::clamp(1.0f - ratio2 * ratio2, 0.0f, 1.0f);
+			const float attenuation = light.intensity * window * window / (distance * distance + 1.0f);
+			radiance += ALBEDO * light.color * attenuation * std::max(glm::dot(unitNormal, toLight / std::max(distance, 1e-4f)), 0.0f);
+		}
+
+		return radiance;
+	}
+
+	bool SoftwareRasterizer::WriteImage(const std::string& path) const
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (!file.is_open())
+		{
+			std::cerr << "Failed to open image " << path << std::endl;
+			return false;
+		}
+
+		//! Uncompressed true color with alpha, origin at the bottom left like the framebuffer.
+		uint8_t header[18] = {};
+		header[2] = 2;
+		header[12] = static_cast<uint8_t>(_width & 0xFF);
+		header[13] = static_cast<uint8_t>(_width >> 8);
+		header[14] = static_cast<uint8_t>(_height & 0xFF);
+		header[15] = static_cast<uint8_t>(_height >> 8);
+		header[16] = 32;
+		header[17] = 8;
+		file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+		std::vector<uint8_t> bgra(_color.size());
+		for (size_t pixel = 0; pixel < _color.size(); pixel += 4)
+		{
+			bgra[pixel] = _color[pixel + 2];
+			bgra[pixel + 1] = _color[pixel + 1];
+			bgra[pixel + 2] = _color[pixel];
+			bgra[pixel + 3] = _color[pixel + 3];
+		}
+		file.write(reinterpret_cast<const char*>(bgra.data()), static_cast<std::streamsize>(bgra.size()));
+
+		return static_cast<bool>(file);
+	}
+
+};
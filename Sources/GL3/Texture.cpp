@@ -1,12 +1,48 @@
 #include <GL3/Texture.hpp>
 #include <GL3/DebugUtils.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/MemoryTracker.hpp>
 #include <glad/glad.h>
 #include <iostream>
+#include <string>
+
+namespace
+{
+	//! Returns the bytes of one texel of the sized internal formats used by the renderer, 4 for the rest.
+	size_t GetTexelSize(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_R8:
+			return 1;
+		case GL_RG8:
+		case GL_R16F:
+			return 2;
+		case GL_RGB8:
+			return 3;
+		case GL_RG16F:
+		case GL_R32F:
+		case GL_RGBA8:
+			return 4;
+		case GL_RGB16F:
+			return 6;
+		case GL_RG32F:
+		case GL_RGBA16F:
+			return 8;
+		case GL_RGB32F:
+			return 12;
+		case GL_RGBA32F:
+			return 16;
+		default:
+			return 4;
+		}
+	}
+};
 
 namespace GL3 {
 
 	Texture::Texture()
-		: _target(GL_TEXTURE_2D), _textureID(0)
+		: _target(GL_TEXTURE_2D), _textureID(0), _numBytes(0)
 	{
 		//! Do nothing
 	}
@@ -24,6 +60,7 @@ namespace GL3 {
 		glBindTexture(_target, _textureID);
 		glTexParameteri(_target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameteri(_target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(_target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 		glTexParameteri(_target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTexParameteri(_target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	}
@@ -32,12 +69,21 @@ namespace GL3 {
 	{
 		glTexImage2D(_target, 0, internalFormat, width, height, 0, format, type, data);
 		glGenerateMipmap(_target);
+		AccountTexels(internalFormat, width, height, 1);
+	}
+
+	void Texture::UploadTexture3D(const void* data, int width, int height, int depth, GLenum format, GLenum internalFormat, GLenum type)
+	{
+		glTexImage3D(_target, 0, internalFormat, width, height, depth, 0, format, type, data);
+		glGenerateMipmap(_target);
+		AccountTexels(internalFormat, width, height, depth);
 	}
 
 	void Texture::BindTexture(GLuint slot) const
 	{
 		glActiveTexture(GL_TEXTURE0 + slot);
 		glBindTexture(_target, _textureID);
+		FrameStatistics::GetInstance().Increment(FrameStatistics::TextureBinds);
 	}
 
 	void Texture::UnbindTexture() const
@@ -45,9 +91,33 @@ namespace GL3 {
 		glBindTexture(_target, 0);
 	}
 
+	void Texture::AccountTexels(GLenum internalFormat, int width, int height, int depth)
+	{
+		//! The mipmap chain adds a third of level zero in 2D and a seventh in 3D.
+		const size_t levelBytes = GetTexelSize(internalFormat) * width * height * depth;
+		const size_t numBytes = depth > 1 ? levelBytes * 8 / 7 : levelBytes * 4 / 3;
+		if (numBytes == _numBytes)
+			return;
+
+		auto& memoryTracker = MemoryTracker::GetInstance();
+		memoryTracker.ReleaseGPU(MemoryTracker::Texture, _numBytes);
+		memoryTracker.AllocateGPU(MemoryTracker::Texture, numBytes);
+		_numBytes = numBytes;
+
+		memoryTracker.SetAsset(this, (depth > 1 ? "Texture3D " : "Texture2D ") + std::to_string(width) + "x" + std::to_string(height) +
+							   (depth > 1 ? "x" + std::to_string(depth) : std::string()), MemoryTracker::Texture, 0, _numBytes);
+	}
+
 	void Texture::CleanUp()
 	{
 		if (_textureID) glDeleteTextures(1, &_textureID);
+		_textureID = 0;
+		if (_numBytes)
+		{
+			MemoryTracker::GetInstance().ReleaseGPU(MemoryTracker::Texture, _numBytes);
+			MemoryTracker::GetInstance().RemoveAsset(this);
+		}
+		_numBytes = 0;
 	}
 
 };
\ No newline at end of file
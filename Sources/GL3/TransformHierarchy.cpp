@@ -0,0 +1,235 @@
+#include <GL3/TransformHierarchy.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/Profiler.hpp>
+#include <GL3/SIMD.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+namespace
+{
+	//! World matrices gathered before one batch of products
+	constexpr size_t BATCH_SIZE = 64;
+
+	//! out = parent * local, one column of the product per SSE register
+	inline void Multiply(const glm::mat4& parent, const glm::mat4& local, glm::mat4& out)
+	{
+#ifdef GL3_USE_SSE2
+		const float* columns = &parent[0][0];
+		const __m128 column0 = _mm_loadu_ps(columns);
+		const __m128 column1 = _mm_loadu_ps(columns + 4);
+		const __m128 column2 = _mm_loadu_ps(columns + 8);
+		const __m128 column3 = _mm_loadu_ps(columns + 12);
+		for (int column = 0; column < 4; ++column)
+		{
+			const float* weights = &local[column][0];
+			__m128 result = _mm_mul_ps(column0, _mm_set1_ps(weights[0]));
+			result = _mm_add_ps(result, _mm_mul_ps(column1, _mm_set1_ps(weights[1])));
+			result = _mm_add_ps(result, _mm_mul_ps(column2, _mm_set1_ps(weights[2])));
+			result = _mm_add_ps(result, _mm_mul_ps(column3, _mm_set1_ps(weights[3])));
+			_mm_storeu_ps(&out[column][0], result);
+		}
+#else
+		out = parent * local;
+#endif
+	}
+
+	//! Copy a matrix into the instance buffer, bypassing the cache when the destination allows it
+	inline void Store(const glm::mat4& matrix, glm::mat4* destination, bool bStreaming)
+	{
+#ifdef GL3_USE_SSE2
+		const float* source = &matrix[0][0];
+		float* target = &(*destination)[0][0];
+		for (int offset = 0; offset < 16; offset += 4)
+		{
+			const __m128 column = _mm_loadu_ps(source + offset);
+			if (bStreaming)
+				_mm_stream_ps(target + offset, column);
+			else
+				_mm_storeu_ps(target + offset, column);
+		}
+#else
+		(void)bStreaming;
+		*destination = matrix;
+#endif
+	}
+};
+
+namespace GL3 {
+
+	TransformHierarchy::TransformHierarchy()
+		: _numDirty(0), _bReorder(false)
+	{
+		//! Do nothing
+	}
+
+	TransformHierarchy::~TransformHierarchy()
+	{
+		//! Do nothing
+	}
+
+	TransformHierarchy::Handle TransformHierarchy::Add(const TransformComponent& local, Handle parent)
+	{
+		const Handle node = static_cast<Handle>(_slots.size());
+		const uint32_t depth = parent == NO_PARENT ? 0 : _depths[parent] + 1;
+		const uint32_t slot = static_cast<uint32_t>(_local.size());
+
+		_slots.push_back(slot);
+		_parentHandles.push_back(parent);
+		_depths.push_back(depth);
+		_parentSlots.push_back(parent == NO_PARENT ? NO_PARENT : _slots[parent]);
+		_local.push_back(local);
+		_world.emplace_back(1.0f);
+		_dirty.push_back(1);
+		++_numDirty;
+
+		//! Appending to the deepest level or starting the next one keeps the breadth-first order.
+		if (_bReorder)
+			return node;
+		if (_levelBegin.empty() && depth == 0)
+			_levelBegin = { 0, 1 };
+		else if (!_levelBegin.empty() && depth + 1 == GetNumLevels())
+			++_levelBegin.back();
+		else if (!_levelBegin.empty() && depth == GetNumLevels())
+			_levelBegin.push_back(_levelBegin.back() + 1);
+		else
+			_bReorder = true;
+
+		return node;
+	}
+
+	void TransformHierarchy::SetLocal(Handle node, const TransformComponent& local)
+	{
+		const uint32_t slot = _slots[node];
+		_local[slot] = local;
+		if (!_dirty[slot])
+		{
+			_dirty[slot] = 1;
+			++_numDirty;
+		}
+	}
+
+	void TransformHierarchy::Clear()
+	{
+		_slots.clear();
+		_parentHandles.clear();
+		_depths.clear();
+		_parentSlots.clear();
+		_local.clear();
+		_world.clear();
+		_dirty.clear();
+		_levelBegin.clear();
+		_numDirty = 0;
+		_bReorder = false;
+	}
+
+	void TransformHierarchy::Reorder()
+	{
+		//! Counting sort of the handles by depth.
+		const uint32_t numLevels = *std::max_element(_depths.begin(), _depths.end()) + 1;
+		_levelBegin.assign(numLevels + 1, 0);
+		for (uint32_t depth : _depths)
+			++_levelBegin[depth + 1];
+		for (uint32_t level = 0; level < numLevels; ++level)
+			_levelBegin[level + 1] += _levelBegin[level];
+
+		std::vector<uint32_t> cursor(_levelBegin.begin(), _levelBegin.end() - 1);
+		std::vector<uint32_t> slots(_slots.size());
+		for (Handle node = 0; node < _slots.size(); ++node)
+			slots[node] = cursor[_depths[node]]++;
+
+		std::vector<uint32_t> parentSlots(_slots.size());
+		std::vector<TransformComponent> local(_slots.size());
+		std::vector<glm::mat4> world(_slots.size());
+		std::vector<uint8_t> dirty(_slots.size());
+		for (Handle node = 0; node < _slots.size(); ++node)
+		{
+			const uint32_t slot = slots[node];
+			parentSlots[slot] = _parentHandles[node] == NO_PARENT ? NO_PARENT : slots[_parentHandles[node]];
+			local[slot] = _local[_slots[node]];
+			world[slot] = _world[_slots[node]];
+			dirty[slot] = _dirty[_slots[node]];
+		}
+
+		_slots.swap(slots);
+		_parentSlots.swap(parentSlots);
+		_local.swap(local);
+		_world.swap(world);
+		_dirty.swap(dirty);
+		_bReorder = false;
+	}
+
+	size_t TransformHierarchy::Update(glm::mat4* instances)
+	{
+		const bool bWriteAll = _bReorder && instances != nullptr;
+		if (_bReorder)
+			Reorder();
+		if (_numDirty == 0 && !bWriteAll)
+			return 0;
+
+		ProfileScope scope("TransformHierarchy::Update", _slots.size());
+		const bool bStreaming = (reinterpret_cast<uintptr_t>(instances) & 15) == 0;
+		std::atomic<size_t> numUpdated(0);
+		auto& jobSystem = JobSystem::GetInstance();
+
+		//! Level by level, the parents of a level are final before its children read them.
+		for (size_t level = 0; level < GetNumLevels(); ++level)
+		{
+			const uint32_t levelBegin = _levelBegin[level], levelEnd = _levelBegin[level + 1];
+			const size_t numJobs = (levelEnd - levelBegin + NODES_PER_JOB - 1) / NODES_PER_JOB;
+			jobSystem.ParallelFor(numJobs, [&](size_t job)
+			{
+				const uint32_t begin = levelBegin + static_cast<uint32_t>(job * NODES_PER_JOB);
+				const uint32_t end = std::min<uint32_t>(levelEnd, begin + static_cast<uint32_t>(NODES_PER_JOB));
+				uint32_t batchSlots[BATCH_SIZE];
+				glm::mat4 batchLocals[BATCH_SIZE];
+				size_t batchSize = 0, numJobUpdated = 0;
+
+				auto flush = [&]()
+				{
+					for (size_t i = 0; i < batchSize; ++i)
+					{
+						const uint32_t slot = batchSlots[i];
+						if (_parentSlots[slot] == NO_PARENT)
+							_world[slot] = batchLocals[i];
+						else
+							Multiply(_world[_parentSlots[slot]], batchLocals[i], _world[slot]);
+						if (instances)
+							Store(_world[slot], instances + slot, bStreaming);
+					}
+					numJobUpdated += batchSize;
+					batchSize = 0;
+				};
+
+				for (uint32_t slot = begin; slot < end; ++slot)
+				{
+					if (_parentSlots[slot] != NO_PARENT && _dirty[_parentSlots[slot]])
+						_dirty[slot] = 1;
+					if (!_dirty[slot])
+					{
+						if (bWriteAll)
+							Store(_world[slot], instances + slot, bStreaming);
+						continue;
+					}
+
+					batchSlots[batchSize] = slot;
+					batchLocals[batchSize] = _local[slot].GetMatrix();
+					if (++batchSize == BATCH_SIZE)
+						flush();
+				}
+				flush();
+				numUpdated.fetch_add(numJobUpdated, std::memory_order_relaxed);
+			});
+		}
+
+#ifdef GL3_USE_SSE2
+		if (instances && bStreaming)
+			_mm_sfence();
+#endif
+		std::fill(_dirty.begin(), _dirty.end(), 0);
+		_numDirty = 0;
+
+		return numUpdated.load();
+	}
+
+};
@@ -0,0 +1,42 @@
+#include <GL3/VertexColorBuffer.hpp>
+
+namespace GL3 {
+
+	VertexColorBuffer::VertexColorBuffer()
+		: _capacity(0)
+	{
+		//! Do nothing
+	}
+
+	VertexColorBuffer::~VertexColorBuffer()
+	{
+		//! Do nothing
+	}
+
+	bool VertexColorBuffer::Initialize(size_t capacity)
+	{
+		CleanUp();
+		if (!_ring.Initialize(capacity * sizeof(uint32_t)))
+			return false;
+
+		_capacity = capacity;
+		return true;
+	}
+
+	uint32_t* VertexColorBuffer::BeginWrite()
+	{
+		return static_cast<uint32_t*>(_ring.BeginWrite());
+	}
+
+	void VertexColorBuffer::EndFrame()
+	{
+		_ring.EndFrame();
+	}
+
+	void VertexColorBuffer::CleanUp()
+	{
+		_ring.CleanUp();
+		_capacity = 0;
+	}
+
+};
@@ -1,5 +1,6 @@
 #include <GL3/Window.hpp>
 #include <GL3/DebugUtils.hpp>
+#include <GL3/Mesh.hpp>
 #include <glad/glad.h>
 #include <glfw/glfw3.h>
 #include <iostream>
@@ -92,6 +93,8 @@ namespace GL3
 		glDebugMessageControl(GL_DEBUG_SOURCE_THIRD_PARTY, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, true);
 		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_LOW, 0, NULL, false);
 		glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_OTHER, GL_DONT_CARE, 0, NULL, false);
+		Mesh::ResetInstanceAttributes();
+		Mesh::ResetVertexColors();
 		
 		glfwSetInputMode(this->_window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
 		glfwSetCursorPosCallback(this->_window, ::CursorPosCallback);
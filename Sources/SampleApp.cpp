@@ -1,15 +1,47 @@
 #include <SampleApp.hpp>
+#include <GL3/Allocators.hpp>
 #include <GL3/Window.hpp>
+#include <GL3/Mesh.hpp>
 #include <GL3/PerspectiveCamera.hpp>
 #include <GL3/Shader.hpp>
+#include <GL3/SceneComponents.hpp>
 #include <GL3/Texture.hpp>
 #include <glad/glad.h>
 #include <glfw/glfw3.h>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image/stb_image.h>
 
+namespace
+{
+	//! Seconds the fire takes to cross a mean mesh edge and a vertex burns
+	constexpr float FIRE_EDGE_TIME = 0.05f;
+	constexpr float FIRE_BURN_TIME = 2.0f;
+	//! Index of the burning mesh and the tree mesh in the mesh table
+	constexpr uint32_t FIRE_MESH = 0;
+	constexpr uint32_t TREE_MESH = 1;
+	//! Trees per side of the grove, their spacing and scale in the unit box of the bunny, and the spin in radians per second
+	constexpr int GROVE_SIZE = 24;
+	constexpr float GROVE_SPACING = 0.5f;
+	constexpr float GROVE_CLEARING = 1.3f;
+	const glm::vec3 TREE_SCALE(0.1f, 0.3f, 0.1f);
+	constexpr float GROVE_SPIN = 0.1f;
+	//! Clip planes of the camera, also the depth range of the light clusters
+	constexpr float CAMERA_NEAR = 0.1f;
+	constexpr float CAMERA_FAR = 100.0f;
+	//! Ring of lights around the bunny, their height, reach and peak intensity
+	constexpr int NUM_LIGHTS = 8;
+	constexpr float LIGHT_RING_RADIUS = 1.5f;
+	constexpr float LIGHT_HEIGHT = 0.5f;
+	constexpr float LIGHT_RADIUS = 3.0f;
+	constexpr float LIGHT_INTENSITY = 1.5f;
+};
+
 SampleApp::SampleApp()
+	: _fireEntity(GL3::EntityStore::NULL_ENTITY), _groveNode(0), _numTrees(0), _time(0.0), _bClusteredLights(false)
 {
 	//! Do nothing
 }
@@ -19,31 +51,95 @@ SampleApp::~SampleApp()
 	//! Do nothing
 }
 
-bool SampleApp::OnInitialize(std::shared_ptr<GL3::Window> window, const cxxopts::ParseResult& configure)
+void SampleApp::CreateLights(std::vector<GL3::PointLight>& lights)
 {
-	(void)configure;
+	//! Warm and cool lights alternate around the ring.
+	lights.resize(NUM_LIGHTS);
+	for (int i = 0; i < NUM_LIGHTS; ++i)
+	{
+		const float angle = 2.0f * glm::pi<float>() * i / NUM_LIGHTS;
+		lights[i].position = glm::vec3(std::cos(angle) * LIGHT_RING_RADIUS, LIGHT_HEIGHT, std::sin(angle) * LIGHT_RING_RADIUS);
+		lights[i].radius = LIGHT_RADIUS;
+		lights[i].color = i % 2 ? glm::vec3(1.0f, 0.6f, 0.3f) : glm::vec3(0.4f, 0.7f, 1.0f);
+		lights[i].intensity = LIGHT_INTENSITY;
+	}
+}
 
+bool SampleApp::OnInitialize(std::shared_ptr<GL3::Window> window, const cxxopts::ParseResult& configure)
+{
+	//! GLDrawBackend feeds CamMatrices from its own buffer, the camera only keeps the matrices.
 	auto defaultCam = std::make_shared<GL3::PerspectiveCamera>();
-
-	if (!defaultCam->SetupUniformBuffer())
-		return false;
-
 	defaultCam->SetupCamera(glm::vec3(0.0f, 0.0f, -5.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-	defaultCam->SetProperties(window->GetAspectRatio(), 60.0f, 0.1f, 100.0f);
+	defaultCam->SetProperties(window->GetAspectRatio(), 60.0f, CAMERA_NEAR, CAMERA_FAR);
 	defaultCam->UpdateMatrix();
 
 	AddCamera(std::move(defaultCam));
 
-	auto defaultShader = std::make_shared<GL3::Shader>();
-	if (!defaultShader->Initialize({ {GL_VERTEX_SHADER, RESOURCES_DIR "/shaders/vertex.glsl"},
-									 {GL_FRAGMENT_SHADER, RESOURCES_DIR "/shaders/output.glsl"} }))
+	//! Unlit by default, with --clustered-lights the fragments walk the light lists of the clusters.
+	_bClusteredLights = configure["clustered-lights"].as<bool>();
+	auto shader = std::make_shared<GL3::Shader>();
+	if (!shader->Initialize({ {GL_VERTEX_SHADER, RESOURCES_DIR "/shaders/vertex.glsl"},
+							  {GL_FRAGMENT_SHADER, _bClusteredLights ? RESOURCES_DIR "/shaders/clustered_output.glsl" : RESOURCES_DIR "/shaders/output.glsl"} }))
+		return false;
+	if (!_backend.Initialize(shader))
 		return false;
+	_shaders.emplace(_bClusteredLights ? "clustered" : "default", std::move(shader));
 
-	defaultShader->BindUniformBlock("CamMatrices", 0);
-	_shaders.emplace("default", std::move(defaultShader));
+	if (_bClusteredLights)
+	{
+		std::vector<GL3::PointLight> lights;
+		CreateLights(lights);
+		if (!_lightCuller.InitializeGL())
+			return false;
+		_lightCuller.SetLights(lights);
+		_backend.SetLighting(&_lightCuller);
+	}
 
 	stbi_set_flip_vertically_on_load(true);
 
+	//! Uniform spread rate crossing the mean edge in FIRE_EDGE_TIME seconds
+	auto mesh = std::make_shared<GL3::Mesh>();
+	if (!mesh->LoadObj(RESOURCES_DIR "/objects/bunny.obj") || !_meshGraph.Build(*mesh))
+		return false;
+	_meshes.push_back(std::move(mesh));
+	_fireEntity = _scene.Create(GL3::TransformComponent{ glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f) },
+								GL3::RenderMeshComponent{ FIRE_MESH, 0 });
+	const auto& lengths = _meshGraph.GetLengths();
+	double totalLength = 0.0;
+	for (float length : lengths)
+		totalLength += length;
+	const float meanLength = lengths.empty() ? 1.0f : static_cast<float>(totalLength / lengths.size());
+	_spreadRates.assign(_meshGraph.GetNumNodes(), meanLength / FIRE_EDGE_TIME);
+	if (!_meshFire.Initialize(_meshGraph, _spreadRates, FIRE_BURN_TIME) || !_fireColors.Initialize(_meshes[FIRE_MESH]->GetPositions().size()))
+		return false;
+	_meshFire.Ignite(0);
+
+	//! The trees stand on the ground of the bunny's unit box around a clearing, one hierarchy level below the
+	//! grove root, so breadth-first they take the instance rows right after it.
+	auto tree = std::make_shared<GL3::Mesh>();
+	if (!tree->LoadObj(RESOURCES_DIR "/objects/sphere.obj"))
+		return false;
+	_meshes.push_back(std::move(tree));
+	const glm::quat identity(1.0f, 0.0f, 0.0f, 0.0f);
+	_groveNode = _hierarchy.Add(GL3::TransformComponent{ glm::vec3(0.0f), identity, glm::vec3(1.0f) });
+	for (int z = 0; z < GROVE_SIZE; ++z)
+		for (int x = 0; x < GROVE_SIZE; ++x)
+		{
+			const glm::vec3 position((x - (GROVE_SIZE - 1) * 0.5f) * GROVE_SPACING, TREE_SCALE.y - 1.0f, (z - (GROVE_SIZE - 1) * 0.5f) * GROVE_SPACING);
+			if (glm::length(glm::vec2(position.x, position.z)) < GROVE_CLEARING)
+				continue;
+			const GL3::TransformHierarchy::Handle node = _hierarchy.Add(GL3::TransformComponent{ position, identity, TREE_SCALE }, _groveNode);
+			_scene.Create(GL3::RenderMeshComponent{ TREE_MESH, 0 }, GL3::HierarchyComponent{ node });
+			++_numTrees;
+		}
+	if (!_instances.Initialize(_hierarchy.GetNumNodes()))
+		return false;
+	const glm::ivec2 extent = window->GetWindowExtent();
+	if (!_culler.Initialize(std::max(1, extent.x / 4), std::max(1, extent.y / 4)))
+		return false;
+	_treeBoxes.resize(_numTrees);
+	_treeVisibility.assign(_numTrees, 1);
+
 	/*int width, height, numChannels;
 	unsigned char* data = stbi_load(path.c_str(), &width, &height, &numChannels);
 
@@ -61,18 +157,98 @@ bool SampleApp::OnInitialize(std::shared_ptr<GL3::Window> window, const cxxopts:
 
 void SampleApp::OnCleanUp()
 {
-	//! Do nothing
+	_fireColors.CleanUp();
+	_instances.CleanUp();
+	_hierarchy.Clear();
+	_numTrees = 0;
+	_treeBoxes.clear();
+	_treeVisibility.clear();
+	_backend.CleanUp();
+	_lightCuller.CleanUp();
+	_meshes.clear();
+	_fireEntity = GL3::EntityStore::NULL_ENTITY;
 }
 
 void SampleApp::OnUpdate(double dt)
 {
-	(void)dt;
+	//! OnDraw() runs more than once per frame, so the colors are written once here. The fence
+	//! covers the draws of the previous frame, which all read the region written last.
+	_fireColors.EndFrame();
+
+	//! The fire crosses at most one edge per step, restart it once it burned out.
+	_meshFire.Step(std::min(static_cast<float>(dt), FIRE_EDGE_TIME));
+	if (_meshFire.GetNumBurning() == 0)
+	{
+		_meshFire.Initialize(_meshGraph, _spreadRates, FIRE_BURN_TIME);
+		_meshFire.Ignite(0);
+	}
+	_meshFire.WriteColors(_fireColors.BeginWrite());
+
+	//! The spinning root dirties every tree, so Update() fills the whole region of this frame.
+	_time += dt;
+	_instances.EndFrame();
+	_hierarchy.SetLocal(_groveNode, GL3::TransformComponent{ glm::vec3(0.0f), glm::angleAxis(static_cast<float>(_time) * GROVE_SPIN, glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(1.0f) });
+	_hierarchy.Update(_instances.BeginWrite());
+
+	//! Culled here rather than in OnDraw(), which the GPU measurement runs twice. The culler adds
+	//! its tested and culled counts and its cost to FrameStatistics for the overlay.
+	auto& camera = _cameras.front();
+	_culler.BeginFrame(camera->GetViewMatrix(), camera->GetProjectionMatrix());
+	_scene.ForEach<GL3::TransformComponent, GL3::RenderMeshComponent>([&](GL3::Entity, GL3::TransformComponent& transform, GL3::RenderMeshComponent& render)
+	{
+		_culler.AddOccluder(*_meshes[render.mesh], transform.GetMatrix());
+	});
+	_culler.RenderOccluders();
+
+	const GL3::BoundingBox& treeBox = _meshes[TREE_MESH]->GetBoundingBox();
+	const glm::vec3 lower = treeBox.GetLowerCorner(), upper = treeBox.GetUpperCorner();
+	_scene.ForEach<GL3::HierarchyComponent>([&](GL3::Entity, GL3::HierarchyComponent& hierarchy)
+	{
+		const glm::mat4& world = _hierarchy.GetWorld(hierarchy.node);
+		GL3::BoundingBox& box = _treeBoxes[_hierarchy.GetInstanceIndex(hierarchy.node) - 1];
+		box.Reset();
+		for (int corner = 0; corner < 8; ++corner)
+			box.Merge(glm::vec3(world * glm::vec4(corner & 1 ? upper.x : lower.x, corner & 2 ? upper.y : lower.y, corner & 4 ? upper.z : lower.z, 1.0f)));
+	});
+	_culler.CullBoxes(_treeBoxes, _treeVisibility);
+
+	//! Cull() uploads the light, cluster and index buffers of this frame.
+	if (_bClusteredLights)
+		_lightCuller.Cull(camera->GetViewMatrix(), camera->GetProjectionMatrix(), CAMERA_NEAR, CAMERA_FAR);
 }
 
 void SampleApp::OnDraw()
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glClearColor(0.0f, 0.0f, 0.8f, 1.0f);
+	auto& camera = _cameras.front();
+	_backend.SetCamera(camera->GetViewMatrix(), camera->GetProjectionMatrix());
+	_backend.Clear(glm::vec4(0.0f, 0.0f, 0.8f, 1.0f));
+	_scene.ForEach<GL3::TransformComponent, GL3::RenderMeshComponent>([&](GL3::Entity entity, GL3::TransformComponent& transform, GL3::RenderMeshComponent& render)
+	{
+		if (entity == _fireEntity)
+			_backend.DrawColored(*_meshes[render.mesh], transform.GetMatrix(), _fireColors);
+		else
+			_backend.DrawMesh(*_meshes[render.mesh], transform.GetMatrix());
+	});
+
+	//! Every run of visible neighbouring rows is one instanced draw, the runs live in the frame arena.
+	GL3::FrameVector<std::pair<size_t, size_t>> runs;
+	runs.reserve(_numTrees / 2 + 1);
+	for (size_t first = 0; first < _numTrees;)
+	{
+		if (!_treeVisibility[first])
+		{
+			++first;
+			continue;
+		}
+		size_t last = first;
+		while (last < _numTrees && _treeVisibility[last])
+			++last;
+		runs.emplace_back(1 + first, last - first);
+		first = last;
+	}
+	for (const auto& run : runs)
+		_backend.DrawInstanced(*_meshes[TREE_MESH], _instances, run.first, run.second);
+	_backend.Flush();
 }
 
 void SampleApp::OnProcessInput(unsigned int key)
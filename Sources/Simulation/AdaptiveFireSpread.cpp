@@ -0,0 +1,660 @@
+#include <Simulation/AdaptiveFireSpread.hpp>
+#include <Simulation/FireSpread.hpp>
+#include <Simulation/SpreadKernel.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+	using Simulation::SpreadKernel::OFFSET_X;
+	using Simulation::SpreadKernel::OFFSET_Y;
+	using Simulation::SpreadKernel::DISTANCE;
+	using Simulation::SpreadKernel::GetIgnitionRate;
+};
+
+namespace Simulation {
+
+	AdaptiveFireSpread::AdaptiveFireSpread()
+		: _statistics(), _stableTimeStep(std::numeric_limits<float>::infinity()), _bSubcycling(false), _time(0.0),
+		  _numCellUpdates(0), _numRegrids(0), _numBurning(0), _numCells(0), _tilesX(0), _tilesY(0)
+	{
+		std::fill(_windFactor, _windFactor + 8, 1.0f);
+	}
+
+	AdaptiveFireSpread::~AdaptiveFireSpread()
+	{
+		//! Do nothing
+	}
+
+	bool AdaptiveFireSpread::Initialize(const Landscape& landscape)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (landscape.width <= 0 || landscape.height <= 0 || landscape.fuel.size() != landscape.GetNumCells() ||
+			landscape.elevation.size() != landscape.GetNumCells())
+		{
+			std::cerr << "Invalid landscape " << landscape.width << "x" << landscape.height << " for the adaptive fire spread" << std::endl;
+			return false;
+		}
+
+		_landscape = landscape;
+		_tilesX = (landscape.width + TILE_SIZE - 1) / TILE_SIZE;
+		_tilesY = (landscape.height + TILE_SIZE - 1) / TILE_SIZE;
+		const size_t numTiles = static_cast<size_t>(_tilesX) * _tilesY;
+		_tiles.assign(numTiles, Tile());
+		_tileLevel.assign(numTiles, 0);
+		_targetLevel.assign(numTiles, 0);
+		_activeTiles.clear();
+
+		//! Level 0 tiles are the landscape cells, the ones past its edge are unburnable.
+		GL3::JobSystem::GetInstance().ParallelFor(numTiles, [&](size_t index)
+		{
+			Tile& tile = _tiles[index];
+			const int tileX = static_cast<int>(index % _tilesX) * TILE_SIZE, tileY = static_cast<int>(index / _tilesX) * TILE_SIZE;
+			tile.state.assign(TILE_SIZE * TILE_SIZE, Unburnable);
+			tile.fuelLoad.assign(TILE_SIZE * TILE_SIZE, 0.0f);
+			tile.ignition.assign(TILE_SIZE * TILE_SIZE, 0.0f);
+			tile.elevation.assign(TILE_SIZE * TILE_SIZE, 0.0f);
+			tile.numBurning = 0;
+			tile.burningMinX = tile.burningMinY = TILE_SIZE;
+			tile.burningMaxX = tile.burningMaxY = -1;
+			tile.coarsestLevel = 0;
+			for (int y = tileY; y < std::min(tileY + TILE_SIZE, landscape.height); ++y)
+			{
+				for (int x = tileX; x < std::min(tileX + TILE_SIZE, landscape.width); ++x)
+				{
+					const size_t cell = static_cast<size_t>(y) * landscape.width + x;
+					const int local = (y - tileY) * TILE_SIZE + (x - tileX);
+					tile.state[local] = landscape.fuel[cell] == NonBurnable ? Unburnable : Unburned;
+					tile.fuelLoad[local] = GetFuelModel(landscape.fuel[cell]).load;
+					tile.elevation[local] = landscape.elevation[cell];
+				}
+			}
+		});
+
+		_time = 0.0;
+		_numCellUpdates = _numRegrids = 0;
+		_numBurning = 0;
+		_statistics = StepStatistics();
+		_statistics.minSubstep = std::numeric_limits<float>::infinity();
+		_stableTimeStep = std::numeric_limits<float>::infinity();
+		_numCells = numTiles * TILE_SIZE * TILE_SIZE;
+		SetWind(landscape.wind);
+
+		return true;
+	}
+
+	void AdaptiveFireSpread::SetWind(const glm::vec2& wind)
+	{
+		for (int direction = 0; direction < 8; ++direction)
+			_windFactor[direction] = SpreadKernel::GetWindFactor(wind, direction);
+	}
+
+	void AdaptiveFireSpread::SetSubcycling(bool bEnabled)
+	{
+		_bSubcycling = bEnabled;
+	}
+
+	bool AdaptiveFireSpread::Ignite(int x, int y)
+	{
+		if (x < 0 || y < 0 || x >= _landscape.width || y >= _landscape.height)
+			return false;
+
+		const int index = (y / TILE_SIZE) * _tilesX + x / TILE_SIZE;
+		if (_tileLevel[index] != MAX_LEVEL)
+		{
+			GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+			const size_t numCells = _tiles[index].state.size();
+			SetTileLevel(index, MAX_LEVEL);
+			_numCells += _tiles[index].state.size() - numCells;
+			++_numRegrids;
+		}
+
+		Tile& tile = _tiles[index];
+		tile.coarsestLevel = -1;
+		const int factor = 1 << MAX_LEVEL, size = TILE_SIZE << MAX_LEVEL;
+		const int localX = (x % TILE_SIZE) * factor, localY = (y % TILE_SIZE) * factor;
+		bool bIgnited = false;
+		for (int j = 0; j < factor; ++j)
+		{
+			for (int i = 0; i < factor; ++i)
+			{
+				const int local = (localY + j) * size + localX + i;
+				if (tile.state[local] != Unburned)
+					continue;
+				tile.state[local] = Burning;
+				tile.ignition[local] = 1.0f;
+				++tile.numBurning;
+				++_numBurning;
+				tile.burningMinX = std::min(tile.burningMinX, localX + i);
+				tile.burningMaxX = std::max(tile.burningMaxX, localX + i);
+				tile.burningMinY = std::min(tile.burningMinY, localY + j);
+				tile.burningMaxY = std::max(tile.burningMaxY, localY + j);
+				bIgnited = true;
+			}
+		}
+		return bIgnited;
+	}
+
+	void AdaptiveFireSpread::SetTileLevel(int index, int level)
+	{
+		Tile& tile = _tiles[index];
+		const int previousLevel = _tileLevel[index];
+		const int previousSize = TILE_SIZE << previousLevel, size = TILE_SIZE << level;
+		const int originX = (index % _tilesX) * TILE_SIZE, originY = (index / _tilesX) * TILE_SIZE;
+		const int width = _landscape.width, height = _landscape.height;
+
+		Tile refined;
+		refined.state.resize(static_cast<size_t>(size) * size);
+		refined.fuelLoad.resize(refined.state.size());
+		refined.ignition.resize(refined.state.size());
+		refined.elevation.resize(refined.state.size());
+		refined.numBurning = 0;
+		refined.burningMinX = refined.burningMinY = size;
+		refined.burningMaxX = refined.burningMaxY = -1;
+		refined.coarsestLevel = -1;
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				const int local = y * size + x;
+				const int landscapeX = originX + (x >> level), landscapeY = originY + (y >> level);
+				if (landscapeX >= width || landscapeY >= height)
+				{
+					refined.state[local] = Unburnable;
+					refined.fuelLoad[local] = refined.ignition[local] = refined.elevation[local] = 0.0f;
+					continue;
+				}
+				refined.elevation[local] = _landscape.GetRefinedElevation(1 << level, (originX << level) + x, (originY << level) + y);
+
+				if (level >= previousLevel)
+				{
+					//! Prolongation, the children hold the state, fuel and heat of their parent.
+					const int shift = level - previousLevel;
+					const int parent = (y >> shift) * previousSize + (x >> shift);
+					refined.state[local] = tile.state[parent];
+					refined.fuelLoad[local] = tile.fuelLoad[parent];
+					refined.ignition[local] = tile.ignition[parent];
+				}
+				else
+				{
+					//! Restriction, Regrid() only coarsens as far as the children of a cell share their state,
+					//! so the cell takes it over with the mean fuel load and heat of the children.
+					const int factor = 1 << (previousLevel - level);
+					float fuelLoad = 0.0f, ignition = 0.0f;
+					for (int j = 0; j < factor; ++j)
+					{
+						for (int i = 0; i < factor; ++i)
+						{
+							const int child = (y * factor + j) * previousSize + x * factor + i;
+							fuelLoad += tile.fuelLoad[child];
+							ignition += std::min(tile.ignition[child], 1.0f);
+						}
+					}
+					const float area = static_cast<float>(factor * factor);
+					refined.state[local] = tile.state[(y * factor) * previousSize + x * factor];
+					refined.fuelLoad[local] = fuelLoad / area;
+					refined.ignition[local] = ignition / area;
+				}
+				if (refined.state[local] != Burning)
+					continue;
+				++refined.numBurning;
+				refined.burningMinX = std::min(refined.burningMinX, x);
+				refined.burningMaxX = std::max(refined.burningMaxX, x);
+				refined.burningMinY = std::min(refined.burningMinY, y);
+				refined.burningMaxY = std::max(refined.burningMaxY, y);
+			}
+		}
+
+		tile = std::move(refined);
+		_tileLevel[index] = static_cast<uint8_t>(level);
+	}
+
+	float AdaptiveFireSpread::GetSummedRate(int index, int x, int y) const
+	{
+		const Tile& tile = _tiles[index];
+		const int level = _tileLevel[index];
+		const int size = TILE_SIZE << level;
+		const int originX = ((index % _tilesX) * TILE_SIZE) << level, originY = ((index / _tilesX) * TILE_SIZE) << level;
+		const int width = _landscape.width << level, height = _landscape.height << level;
+		const float cellSize = _landscape.cellSize / (1 << level);
+		const int local = y * size + x;
+		const float spreadRate = GetFuelModel(_landscape.fuel[static_cast<size_t>((originY + y) >> level) * _landscape.width + ((originX + x) >> level)]).spreadRate;
+
+		float rate = 0.0f;
+		for (int direction = 0; direction < 8; ++direction)
+		{
+			const int neighborX = x + OFFSET_X[direction], neighborY = y + OFFSET_Y[direction];
+			if (neighborX >= 0 && neighborY >= 0 && neighborX < size && neighborY < size)
+			{
+				const int neighbor = neighborY * size + neighborX;
+				if (tile.state[neighbor] == Burning)
+					rate += GetIgnitionRate(spreadRate, _windFactor[direction], tile.elevation[local], tile.elevation[neighbor], cellSize, direction);
+				continue;
+			}
+			const int globalX = originX + neighborX, globalY = originY + neighborY;
+			if (globalX < 0 || globalY < 0 || globalX >= width || globalY >= height)
+				continue;
+			float elevation = 0.0f;
+			const float fraction = SampleNeighbor(level, globalX, globalY, elevation);
+			if (fraction > 0.0f)
+				rate += fraction * GetIgnitionRate(spreadRate, _windFactor[direction], tile.elevation[local], elevation, cellSize, direction);
+		}
+		return rate;
+	}
+
+	void AdaptiveFireSpread::UpdateStableStep(int index)
+	{
+		//! Like FireSpread::UpdateRates(), no cell may gain more than the Courant number in progress or
+		//! burn more than that fraction of its fuel in a substep.
+		Tile& tile = _tiles[index];
+		const int level = _tileLevel[index];
+		const int size = TILE_SIZE << level;
+		const int originX = ((index % _tilesX) * TILE_SIZE) << level, originY = ((index / _tilesX) * TILE_SIZE) << level;
+		float maxRate = 0.0f, minBurnTime = std::numeric_limits<float>::infinity();
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = tile.rowMinX[y]; x <= tile.rowMaxX[y]; ++x)
+			{
+				const int local = y * size + x;
+				if (tile.state[local] == Unburned)
+					maxRate = std::max(maxRate, GetSummedRate(index, x, y));
+				else if (tile.state[local] == Burning)
+					minBurnTime = std::min(minBurnTime, GetFuelModel(_landscape.fuel[static_cast<size_t>((originY + y) >> level) * _landscape.width + ((originX + x) >> level)]).burnTime);
+			}
+		}
+		tile.stableStep = COURANT_NUMBER * std::min(minBurnTime, maxRate > 0.0f ? 1.0f / maxRate : std::numeric_limits<float>::infinity());
+	}
+
+	int AdaptiveFireSpread::GetCoarsestLevel(int index)
+	{
+		Tile& tile = _tiles[index];
+		if (tile.coarsestLevel >= 0)
+			return tile.coarsestLevel;
+
+		//! A level merges the blocks of factor x factor cells, once they are all uniform so are the
+		//! blocks of every finer level.
+		const int level = _tileLevel[index];
+		const int size = TILE_SIZE << level;
+		int coarsest = 0;
+		for (; coarsest < level; ++coarsest)
+		{
+			const int mask = ~((1 << (level - coarsest)) - 1);
+			bool bUniform = true;
+			for (int y = 0; y < size && bUniform; ++y)
+				for (int x = 0; x < size && bUniform; ++x)
+					bUniform = tile.state[y * size + x] == tile.state[(y & mask) * size + (x & mask)];
+			if (bUniform)
+				break;
+		}
+		tile.coarsestLevel = coarsest;
+		return coarsest;
+	}
+
+	void AdaptiveFireSpread::Regrid()
+	{
+		//! The finest level on the tiles with fire in or next to them, the rest coarsens towards level 0
+		//! as far as its cells merge without mixing states, so partly burned tiles stay refined.
+		_activeTiles.clear();
+		for (int tileY = 0; tileY < _tilesY; ++tileY)
+		{
+			for (int tileX = 0; tileX < _tilesX; ++tileX)
+			{
+				bool bActive = false;
+				for (int y = std::max(0, tileY - 1); y <= std::min(_tilesY - 1, tileY + 1) && !bActive; ++y)
+					for (int x = std::max(0, tileX - 1); x <= std::min(_tilesX - 1, tileX + 1) && !bActive; ++x)
+						bActive = _tiles[static_cast<size_t>(y) * _tilesX + x].numBurning > 0;
+				const int tile = tileY * _tilesX + tileX;
+				int level = bActive ? MAX_LEVEL : 0;
+				if (level < _tileLevel[tile])
+					level = std::max(level, GetCoarsestLevel(tile));
+				_targetLevel[tile] = static_cast<uint8_t>(level);
+				if (bActive)
+					_activeTiles.push_back(tile);
+			}
+		}
+
+		//! Neighbor tiles at most one level apart.
+		for (int pass = 1; pass < MAX_LEVEL; ++pass)
+		{
+			for (int tileY = 0; tileY < _tilesY; ++tileY)
+			{
+				for (int tileX = 0; tileX < _tilesX; ++tileX)
+				{
+					uint8_t& level = _targetLevel[static_cast<size_t>(tileY) * _tilesX + tileX];
+					for (int y = std::max(0, tileY - 1); y <= std::min(_tilesY - 1, tileY + 1); ++y)
+						for (int x = std::max(0, tileX - 1); x <= std::min(_tilesX - 1, tileX + 1); ++x)
+							level = static_cast<uint8_t>(std::max<int>(level, _targetLevel[static_cast<size_t>(y) * _tilesX + x] - 1));
+				}
+			}
+		}
+
+		_regridTiles.clear();
+		for (size_t tile = 0; tile < _tileLevel.size(); ++tile)
+			if (_tileLevel[tile] != _targetLevel[tile])
+				_regridTiles.push_back(static_cast<int>(tile));
+		if (_regridTiles.empty())
+			return;
+
+		GL3::JobSystem::GetInstance().ParallelFor(_regridTiles.size(), [&](size_t job)
+		{
+			const int tile = _regridTiles[job];
+			SetTileLevel(tile, _targetLevel[tile]);
+		});
+		_numRegrids += _regridTiles.size();
+		_numCells = 0;
+		for (const Tile& tile : _tiles)
+			_numCells += tile.state.size();
+	}
+
+	float AdaptiveFireSpread::SampleNeighbor(int level, int x, int y, float& elevation) const
+	{
+		const int landscapeX = x >> level, landscapeY = y >> level;
+		const int index = (landscapeY / TILE_SIZE) * _tilesX + landscapeX / TILE_SIZE;
+		const Tile& tile = _tiles[index];
+		const int tileLevel = _tileLevel[index];
+		const int size = TILE_SIZE << tileLevel;
+		const int originX = (landscapeX / TILE_SIZE * TILE_SIZE) << tileLevel, originY = (landscapeY / TILE_SIZE * TILE_SIZE) << tileLevel;
+
+		float fraction = 0.0f;
+		if (tileLevel <= level)
+		{
+			//! A coarser or equal cell covers the whole neighbor.
+			const int shift = level - tileLevel;
+			const int local = ((y >> shift) - originY) * size + (x >> shift) - originX;
+			if (tile.state[local] != Burning)
+				return 0.0f;
+			if (shift == 0)
+			{
+				elevation = tile.elevation[local];
+				return 1.0f;
+			}
+			fraction = 1.0f;
+		}
+		else
+		{
+			const int factor = 1 << (tileLevel - level);
+			const int localX = x * factor - originX, localY = y * factor - originY;
+			int numBurning = 0;
+			for (int j = 0; j < factor; ++j)
+				for (int i = 0; i < factor; ++i)
+					numBurning += tile.state[(localY + j) * size + localX + i] == Burning;
+			if (numBurning == 0)
+				return 0.0f;
+			fraction = static_cast<float>(numBurning) / static_cast<float>(factor * factor);
+		}
+		elevation = _landscape.GetRefinedElevation(1 << level, x, y);
+		return fraction;
+	}
+
+	uint64_t AdaptiveFireSpread::UpdateWindow(int index)
+	{
+		//! Row ranges rather than one window, the strips along the edges of the neighbors stay thin.
+		Tile& tile = _tiles[index];
+		const int level = _tileLevel[index];
+		const int size = TILE_SIZE << level;
+		const int tileX = index % _tilesX, tileY = index / _tilesX;
+		tile.rowMinX.assign(size, size);
+		tile.rowMaxX.assign(size, -1);
+		for (int y = std::max(0, tileY - 1); y <= std::min(_tilesY - 1, tileY + 1); ++y)
+		{
+			for (int x = std::max(0, tileX - 1); x <= std::min(_tilesX - 1, tileX + 1); ++x)
+			{
+				const int neighborIndex = y * _tilesX + x;
+				const Tile& neighbor = _tiles[neighborIndex];
+				if (neighbor.numBurning == 0)
+					continue;
+
+				//! Burning window of the neighbor in cells of this tile, relative to its origin
+				const int neighborLevel = _tileLevel[neighborIndex];
+				const int offsetX = (x - tileX) * (TILE_SIZE << neighborLevel), offsetY = (y - tileY) * (TILE_SIZE << neighborLevel);
+				int minX = offsetX + neighbor.burningMinX, maxX = offsetX + neighbor.burningMaxX;
+				int minY = offsetY + neighbor.burningMinY, maxY = offsetY + neighbor.burningMaxY;
+				if (neighborLevel >= level)
+				{
+					const int shift = neighborLevel - level;
+					minX >>= shift;
+					maxX >>= shift;
+					minY >>= shift;
+					maxY >>= shift;
+				}
+				else
+				{
+					const int factor = 1 << (level - neighborLevel);
+					minX *= factor;
+					maxX = (maxX + 1) * factor - 1;
+					minY *= factor;
+					maxY = (maxY + 1) * factor - 1;
+				}
+				minX = std::max(0, minX - 1);
+				maxX = std::min(size - 1, maxX + 1);
+				for (int row = std::max(0, minY - 1); row <= std::min(size - 1, maxY + 1) && minX <= maxX; ++row)
+				{
+					tile.rowMinX[row] = std::min(tile.rowMinX[row], minX);
+					tile.rowMaxX[row] = std::max(tile.rowMaxX[row], maxX);
+				}
+			}
+		}
+
+		uint64_t numCells = 0;
+		for (int row = 0; row < size; ++row)
+			numCells += std::max(0, tile.rowMaxX[row] - tile.rowMinX[row] + 1);
+		return numCells;
+	}
+
+	void AdaptiveFireSpread::AdvanceTile(int index, float dt)
+	{
+		Tile& tile = _tiles[index];
+		const int level = _tileLevel[index];
+		const int size = TILE_SIZE << level;
+		const int originX = ((index % _tilesX) * TILE_SIZE) << level, originY = ((index / _tilesX) * TILE_SIZE) << level;
+
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = tile.rowMinX[y]; x <= tile.rowMaxX[y]; ++x)
+			{
+				const int local = y * size + x;
+				if (tile.state[local] == Unburned)
+				{
+					tile.ignition[local] += GetSummedRate(index, x, y) * dt;
+				}
+				else if (tile.state[local] == Burning)
+				{
+					const FuelModel& model = GetFuelModel(_landscape.fuel[static_cast<size_t>((originY + y) >> level) * _landscape.width + ((originX + x) >> level)]);
+					tile.fuelLoad[local] -= model.load / model.burnTime * dt;
+				}
+			}
+		}
+	}
+
+	void AdaptiveFireSpread::CommitTile(int index)
+	{
+		//! The burning cells all lie in the row ranges, they cover the previous burning window.
+		Tile& tile = _tiles[index];
+		const int size = TILE_SIZE << _tileLevel[index];
+		tile.numBurning = 0;
+		tile.burningMinX = tile.burningMinY = size;
+		tile.burningMaxX = tile.burningMaxY = -1;
+		tile.coarsestLevel = -1;
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = tile.rowMinX[y]; x <= tile.rowMaxX[y]; ++x)
+			{
+				const int local = y * size + x;
+				if (tile.state[local] == Unburned && tile.ignition[local] >= 1.0f)
+				{
+					tile.state[local] = Burning;
+					tile.ignition[local] = 1.0f;
+				}
+				else if (tile.state[local] == Burning && tile.fuelLoad[local] <= 0.0f)
+				{
+					tile.state[local] = Burned;
+					tile.fuelLoad[local] = 0.0f;
+				}
+
+				if (tile.state[local] == Burning)
+				{
+					++tile.numBurning;
+					tile.burningMinX = std::min(tile.burningMinX, x);
+					tile.burningMaxX = std::max(tile.burningMaxX, x);
+					tile.burningMinY = std::min(tile.burningMinY, y);
+					tile.burningMaxY = std::max(tile.burningMaxY, y);
+				}
+			}
+		}
+	}
+
+	void AdaptiveFireSpread::Step(float dt)
+	{
+		if (dt <= 0.0f)
+			return;
+		_time += dt;
+		if (_numBurning == 0)
+			return;
+
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		GL3::FrameStatistics::GetInstance().Increment(GL3::FrameStatistics::SimulationSteps);
+		Regrid();
+		auto& jobSystem = GL3::JobSystem::GetInstance();
+
+		//! Substeps per tile from the stable step of its front, the step runs in rounds of the shortest substep.
+		if (_bSubcycling)
+		{
+			jobSystem.ParallelFor(_activeTiles.size(), [&](size_t job)
+			{
+				UpdateWindow(_activeTiles[job]);
+				UpdateStableStep(_activeTiles[job]);
+			});
+		}
+		float stableTimeStep = std::numeric_limits<float>::infinity();
+		int maxSubstepLevel = 0;
+		for (int index : _activeTiles)
+		{
+			Tile& tile = _tiles[index];
+			tile.substepLevel = 0;
+			if (_bSubcycling)
+			{
+				stableTimeStep = std::min(stableTimeStep, tile.stableStep);
+				const float courant = dt / tile.stableStep;
+				if (courant > 1.0f)
+					tile.substepLevel = std::min(MAX_SUBSTEP_LEVEL, static_cast<int>(std::ceil(std::log2(courant))));
+			}
+			maxSubstepLevel = std::max(maxSubstepLevel, tile.substepLevel);
+
+			const float substep = dt / static_cast<float>(1 << tile.substepLevel);
+			++_statistics.numTileSteps;
+			++_statistics.numTileStepsBySubsteps[tile.substepLevel];
+			_statistics.numTileSubsteps += uint64_t(1) << tile.substepLevel;
+			_statistics.minSubstep = std::min(_statistics.minSubstep, substep);
+			_statistics.maxSubstep = std::max(_statistics.maxSubstep, substep);
+			_statistics.sumSubsteps += static_cast<double>(substep) * (1 << tile.substepLevel);
+		}
+		++_statistics.numSteps;
+		_stableTimeStep = stableTimeStep;
+
+		//! Every due tile reads the states its neighbors committed in the previous rounds, then all of
+		//! them commit. A tile of 2^k substeps is due in the middle round of each of them.
+		const int numRounds = 1 << maxSubstepLevel;
+		for (int round = 0; round < numRounds; ++round)
+		{
+			_dueTiles.clear();
+			uint64_t numCells = 0;
+			for (int tile : _activeTiles)
+			{
+				const int interval = numRounds >> _tiles[tile].substepLevel;
+				if (round % interval != interval / 2)
+					continue;
+				_dueTiles.push_back(tile);
+				numCells += UpdateWindow(tile);
+			}
+
+			GL3::ProfileScope scope("AdaptiveFireSpread::Step", numCells);
+			jobSystem.ParallelFor(_dueTiles.size(), [&](size_t job)
+			{
+				const int tile = _dueTiles[job];
+				AdvanceTile(tile, dt / static_cast<float>(1 << _tiles[tile].substepLevel));
+			});
+			jobSystem.ParallelFor(_dueTiles.size(), [&](size_t job)
+			{
+				CommitTile(_dueTiles[job]);
+			});
+			_numCellUpdates += numCells;
+		}
+
+		_numBurning = 0;
+		for (int tile : _activeTiles)
+			_numBurning += _tiles[tile].numBurning;
+	}
+
+	void AdaptiveFireSpread::GetBurnedFraction(std::vector<float>& fraction) const
+	{
+		const int width = _landscape.width;
+		fraction.resize(_landscape.GetNumCells());
+		GL3::JobSystem::GetInstance().ParallelFor(_landscape.height, [&](size_t row)
+		{
+			const int y = static_cast<int>(row);
+			for (int x = 0; x < width; ++x)
+			{
+				const int index = (y / TILE_SIZE) * _tilesX + x / TILE_SIZE;
+				const Tile& tile = _tiles[index];
+				const int level = _tileLevel[index], factor = 1 << level, size = TILE_SIZE << level;
+				const int localX = (x % TILE_SIZE) * factor, localY = (y % TILE_SIZE) * factor;
+				int numBurned = 0;
+				for (int j = 0; j < factor; ++j)
+				{
+					for (int i = 0; i < factor; ++i)
+					{
+						const uint8_t state = tile.state[(localY + j) * size + localX + i];
+						numBurned += state == Burning || state == Burned;
+					}
+				}
+				fraction[row * width + x] = static_cast<float>(numBurned) / static_cast<float>(factor * factor);
+			}
+		});
+	}
+
+	uint64_t AdaptiveFireSpread::GetDigest() const
+	{
+		uint64_t hash = HashBytes(_tileLevel.data(), _tileLevel.size());
+		for (const Tile& tile : _tiles)
+			hash = HashBytes(tile.state.data(), tile.state.size(), hash);
+		return hash;
+	}
+
+	uint64_t AdaptiveFireSpread::GetRefinedDigest() const
+	{
+		const int width = _landscape.width << MAX_LEVEL, height = _landscape.height << MAX_LEVEL;
+		std::vector<uint8_t> state(static_cast<size_t>(width) * height);
+		GL3::JobSystem::GetInstance().ParallelFor(height, [&](size_t row)
+		{
+			const int y = static_cast<int>(row);
+			for (int x = 0; x < width; ++x)
+			{
+				const int landscapeX = x >> MAX_LEVEL, landscapeY = y >> MAX_LEVEL;
+				const int index = (landscapeY / TILE_SIZE) * _tilesX + landscapeX / TILE_SIZE;
+				const int shift = MAX_LEVEL - _tileLevel[index], size = TILE_SIZE << _tileLevel[index];
+				const int localX = (x - ((landscapeX / TILE_SIZE) * TILE_SIZE << MAX_LEVEL)) >> shift;
+				const int localY = (y - ((landscapeY / TILE_SIZE) * TILE_SIZE << MAX_LEVEL)) >> shift;
+				state[row * width + x] = _tiles[index].state[localY * size + localX];
+			}
+		});
+		return HashBytes(state.data(), state.size());
+	}
+
+	size_t AdaptiveFireSpread::GetMemoryBytes() const
+	{
+		size_t numBytes = _landscape.fuel.capacity() + _landscape.elevation.capacity() * sizeof(float) +
+						  _tiles.capacity() * sizeof(Tile) + _tileLevel.capacity() + _targetLevel.capacity() +
+						  (_activeTiles.capacity() + _regridTiles.capacity() + _dueTiles.capacity()) * sizeof(int);
+		for (const Tile& tile : _tiles)
+			numBytes += tile.state.capacity() + (tile.fuelLoad.capacity() + tile.ignition.capacity() + tile.elevation.capacity()) * sizeof(float) +
+						(tile.rowMinX.capacity() + tile.rowMaxX.capacity()) * sizeof(int);
+		return numBytes;
+	}
+
+};
@@ -0,0 +1,343 @@
+#include <Simulation/CrownFire.hpp>
+#include <Simulation/FireSpread.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+	//! Voxels with lx = 0 and lx = 7 of a slice
+	constexpr uint64_t COLUMN_0 = 0x0101010101010101ull;
+	constexpr uint64_t COLUMN_7 = COLUMN_0 << 7;
+	constexpr uint8_t NO_CANOPY = 0xFF;
+
+	//! Van Wagner (1977) critical fireline intensity in kW/m for crown ignition
+	inline float GetCriticalIntensity(float baseHeight, float foliarMoisture)
+	{
+		return std::pow(0.010f * baseHeight * (460.0f + 25.9f * foliarMoisture), 1.5f);
+	}
+
+	//! Number of set bits, portable SWAR popcount
+	inline size_t CountBits(uint64_t bits)
+	{
+		bits = bits - ((bits >> 1) & 0x5555555555555555ull);
+		bits = (bits & 0x3333333333333333ull) + ((bits >> 2) & 0x3333333333333333ull);
+		bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return static_cast<size_t>((bits * 0x0101010101010101ull) >> 56);
+	}
+
+	//! Index of the lowest set bit, bits must not be zero
+	inline int GetLowestBit(uint64_t bits)
+	{
+		int index = 0;
+		while ((bits & 1) == 0)
+		{
+			bits >>= 1;
+			++index;
+		}
+		return index;
+	}
+};
+
+namespace Simulation {
+
+	CrownFire::CrownFire()
+		: _stepInterval(1.0f), _timer(0.0f), _width(0), _height(0), _bricksX(0), _bricksY(0), _bricksZ(0)
+	{
+		std::fill(_bSpread, _bSpread + 4, true);
+	}
+
+	CrownFire::~CrownFire()
+	{
+		//! Do nothing
+	}
+
+	bool CrownFire::Initialize(const Landscape& landscape, const Canopy& canopy)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		const size_t numCells = landscape.GetNumCells();
+		if (landscape.width <= 0 || landscape.height <= 0 || landscape.fuel.size() != numCells ||
+			canopy.baseHeight.size() != numCells || canopy.topHeight.size() != numCells)
+		{
+			std::cerr << "Invalid canopy for the " << landscape.width << "x" << landscape.height << " landscape" << std::endl;
+			return false;
+		}
+
+		_width = landscape.width;
+		_height = landscape.height;
+		_bricksX = (_width + BRICK_SIZE - 1) / BRICK_SIZE;
+		_bricksY = (_height + BRICK_SIZE - 1) / BRICK_SIZE;
+		_stepInterval = landscape.cellSize / CROWN_SPREAD_RATE;
+		_timer = 0.0f;
+		SetWind(landscape.wind);
+
+		//! Canopy levels of every cell, the torching intensity converts the critical fireline intensity
+		//! with the flame depth of the surface fuel, its spread rate times its residence time.
+		std::vector<uint8_t> topLevel(numCells, 0);
+		_baseLevel.assign(numCells, NO_CANOPY);
+		_torchingIntensity.assign(numCells, std::numeric_limits<float>::max());
+		int numLevels = 0;
+		for (size_t cell = 0; cell < numCells; ++cell)
+		{
+			const int base = std::max(0, static_cast<int>(canopy.baseHeight[cell] / VOXEL_HEIGHT));
+			const int top = std::min(MAX_LEVELS, static_cast<int>(std::ceil(canopy.topHeight[cell] / VOXEL_HEIGHT)));
+			if (top <= base)
+				continue;
+			_baseLevel[cell] = static_cast<uint8_t>(base);
+			topLevel[cell] = static_cast<uint8_t>(top);
+			numLevels = std::max(numLevels, top);
+
+			const FuelModel& model = GetFuelModel(landscape.fuel[cell]);
+			const float flameDepth = model.spreadRate * model.burnTime;
+			if (flameDepth > 0.0f)
+				_torchingIntensity[cell] = GetCriticalIntensity(std::max(canopy.baseHeight[cell], 0.0f), FOLIAR_MOISTURE) / flameDepth;
+		}
+		_bricksZ = std::max(1, (numLevels + BRICK_SIZE - 1) / BRICK_SIZE);
+
+		//! Allocate the bricks some cell of the column reaches into.
+		const size_t numColumns = static_cast<size_t>(_bricksX) * _bricksY;
+		_brickIndex.assign(numColumns * _bricksZ, -1);
+		_columnCanopy.assign(numColumns, 0);
+		int32_t numBricks = 0;
+		for (int brickY = 0; brickY < _bricksY; ++brickY)
+		{
+			for (int brickX = 0; brickX < _bricksX; ++brickX)
+			{
+				const size_t column = static_cast<size_t>(brickY) * _bricksX + brickX;
+				int columnMin = MAX_LEVELS, columnMax = 0;
+				for (int y = brickY * BRICK_SIZE; y < std::min(_height, (brickY + 1) * BRICK_SIZE); ++y)
+				{
+					for (int x = brickX * BRICK_SIZE; x < std::min(_width, (brickX + 1) * BRICK_SIZE); ++x)
+					{
+						const size_t cell = static_cast<size_t>(y) * _width + x;
+						if (_baseLevel[cell] == NO_CANOPY)
+							continue;
+						_columnCanopy[column] |= uint64_t(1) << ((y - brickY * BRICK_SIZE) * BRICK_SIZE + x - brickX * BRICK_SIZE);
+						columnMin = std::min(columnMin, static_cast<int>(_baseLevel[cell]));
+						columnMax = std::max(columnMax, static_cast<int>(topLevel[cell]));
+					}
+				}
+				for (int brickZ = columnMin / BRICK_SIZE; brickZ * BRICK_SIZE < columnMax; ++brickZ)
+					_brickIndex[static_cast<size_t>(brickZ) * numColumns + column] = (numBricks++) * BRICK_SIZE;
+			}
+		}
+
+		const size_t numSlices = static_cast<size_t>(numBricks) * BRICK_SIZE;
+		_fuel.assign(numSlices, 0);
+		_burning.assign(numSlices, 0);
+		_burned.assign(numSlices, 0);
+		_nextBurning.assign(numSlices, 0);
+		_columnBurning.assign(numColumns, 0);
+		_columnDrops.assign(numColumns, 0);
+		_activeColumns.clear();
+
+		GL3::JobSystem::GetInstance().ParallelFor(numColumns, [&](size_t column)
+		{
+			const int brickX = static_cast<int>(column % _bricksX), brickY = static_cast<int>(column / _bricksX);
+			for (uint64_t cells = _columnCanopy[column]; cells != 0; cells &= cells - 1)
+			{
+				const int bit = GetLowestBit(cells);
+				const size_t cell = static_cast<size_t>(brickY * BRICK_SIZE + bit / BRICK_SIZE) * _width + brickX * BRICK_SIZE + bit % BRICK_SIZE;
+				for (int level = _baseLevel[cell]; level < topLevel[cell]; ++level)
+					_fuel[GetBrick(brickX, brickY, level / BRICK_SIZE) + level % BRICK_SIZE] |= uint64_t(1) << bit;
+			}
+		});
+
+		return true;
+	}
+
+	void CrownFire::SetWind(const glm::vec2& wind)
+	{
+		_bSpread[0] = wind.x >= -UPWIND_LIMIT;
+		_bSpread[1] = -wind.x >= -UPWIND_LIMIT;
+		_bSpread[2] = wind.y >= -UPWIND_LIMIT;
+		_bSpread[3] = -wind.y >= -UPWIND_LIMIT;
+	}
+
+	void CrownFire::Step(FireSpread& fire, float dt)
+	{
+		if (dt <= 0.0f || _fuel.empty())
+			return;
+
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		Torch(fire);
+		for (_timer += dt; _timer >= _stepInterval; _timer -= _stepInterval)
+			SpreadCrowns(fire);
+	}
+
+	void CrownFire::Torch(const FireSpread& fire)
+	{
+		int minX, minY, maxX, maxY;
+		fire.GetActiveWindow(minX, minY, maxX, maxY);
+		if (maxX < minX || maxY < minY)
+			return;
+
+		const int brickMinX = minX / BRICK_SIZE, brickMaxX = maxX / BRICK_SIZE;
+		const int brickMinY = minY / BRICK_SIZE, brickMaxY = maxY / BRICK_SIZE;
+		const int numBrickColumns = brickMaxX - brickMinX + 1;
+		const std::vector<float>& intensity = fire.GetIntensity();
+		GL3::JobSystem::GetInstance().ParallelFor(static_cast<size_t>(brickMaxY - brickMinY + 1) * numBrickColumns, [&](size_t job)
+		{
+			const int brickX = brickMinX + static_cast<int>(job % numBrickColumns), brickY = brickMinY + static_cast<int>(job / numBrickColumns);
+			const size_t column = static_cast<size_t>(brickY) * _bricksX + brickX;
+			for (uint64_t cells = _columnCanopy[column]; cells != 0; cells &= cells - 1)
+			{
+				const int bit = GetLowestBit(cells);
+				const size_t cell = static_cast<size_t>(brickY * BRICK_SIZE + bit / BRICK_SIZE) * _width + brickX * BRICK_SIZE + bit % BRICK_SIZE;
+				if (intensity[cell] < _torchingIntensity[cell])
+					continue;
+				const size_t slice = GetBrick(brickX, brickY, _baseLevel[cell] / BRICK_SIZE) + _baseLevel[cell] % BRICK_SIZE;
+				const uint64_t voxel = uint64_t(1) << bit;
+				if ((_burned[slice] & voxel) == 0)
+				{
+					_burning[slice] |= voxel;
+					_columnBurning[column] = 1;
+				}
+			}
+		});
+	}
+
+	void CrownFire::SpreadCrowns(FireSpread& fire)
+	{
+		//! Columns with burning voxels and their four neighbors.
+		_activeColumns.clear();
+		for (int brickY = 0; brickY < _bricksY; ++brickY)
+		{
+			for (int brickX = 0; brickX < _bricksX; ++brickX)
+			{
+				const size_t column = static_cast<size_t>(brickY) * _bricksX + brickX;
+				if (_columnCanopy[column] == 0)
+					continue;
+				if (_columnBurning[column] || (brickX > 0 && _columnBurning[column - 1]) || (brickX + 1 < _bricksX && _columnBurning[column + 1]) ||
+					(brickY > 0 && _columnBurning[column - _bricksX]) || (brickY + 1 < _bricksY && _columnBurning[column + _bricksX]))
+					_activeColumns.push_back(static_cast<uint32_t>(column));
+			}
+		}
+		if (_activeColumns.empty())
+			return;
+
+		GL3::FrameStatistics::GetInstance().Increment(GL3::FrameStatistics::SimulationSteps);
+		GL3::ProfileScope scope("CrownFire::SpreadCrowns", _activeColumns.size());
+		auto& jobSystem = GL3::JobSystem::GetInstance();
+
+		//! Next burning voxels from the current planes only, bottom to top so flames climb the column.
+		jobSystem.ParallelFor(_activeColumns.size(), [&](size_t job)
+		{
+			const size_t column = _activeColumns[job];
+			const int brickX = static_cast<int>(column % _bricksX), brickY = static_cast<int>(column / _bricksX);
+			uint64_t below = 0;
+			for (int brickZ = 0; brickZ < _bricksZ; ++brickZ)
+			{
+				const int32_t brick = GetBrick(brickX, brickY, brickZ);
+				if (brick < 0)
+				{
+					below = 0;
+					continue;
+				}
+				const int32_t west = GetBrick(brickX - 1, brickY, brickZ), east = GetBrick(brickX + 1, brickY, brickZ);
+				const int32_t south = GetBrick(brickX, brickY - 1, brickZ), north = GetBrick(brickX, brickY + 1, brickZ);
+				for (int z = 0; z < BRICK_SIZE; ++z)
+				{
+					const uint64_t burning = _burning[brick + z];
+					uint64_t spread = 0;
+					if (_bSpread[0])
+						spread |= ((burning << 1) & ~COLUMN_0) | (west >= 0 ? (_burning[west + z] & COLUMN_7) >> 7 : 0);
+					if (_bSpread[1])
+						spread |= ((burning >> 1) & ~COLUMN_7) | (east >= 0 ? (_burning[east + z] & COLUMN_0) << 7 : 0);
+					if (_bSpread[2])
+						spread |= (burning << 8) | (south >= 0 ? _burning[south + z] >> 56 : 0);
+					if (_bSpread[3])
+						spread |= (burning >> 8) | (north >= 0 ? _burning[north + z] << 56 : 0);
+					const uint64_t ignited = (spread | below) & _fuel[brick + z] & ~_burned[brick + z] & ~burning;
+					_nextBurning[brick + z] = ignited;
+					below = burning | ignited;
+				}
+			}
+		});
+
+		//! Burn out the current voxels and collect the crown bases dropping embers on the surface.
+		jobSystem.ParallelFor(_activeColumns.size(), [&](size_t job)
+		{
+			const size_t column = _activeColumns[job];
+			const int brickX = static_cast<int>(column % _bricksX), brickY = static_cast<int>(column / _bricksX);
+			uint8_t bBurning = 0;
+			for (int brickZ = 0; brickZ < _bricksZ; ++brickZ)
+			{
+				const int32_t brick = GetBrick(brickX, brickY, brickZ);
+				if (brick < 0)
+					continue;
+				for (int z = 0; z < BRICK_SIZE; ++z)
+				{
+					_burned[brick + z] |= _burning[brick + z];
+					_burning[brick + z] = _nextBurning[brick + z];
+					bBurning |= _burning[brick + z] != 0;
+				}
+			}
+			_columnBurning[column] = bBurning;
+
+			uint64_t drops = 0;
+			for (uint64_t cells = bBurning ? _columnCanopy[column] : 0; cells != 0; cells &= cells - 1)
+			{
+				const int bit = GetLowestBit(cells);
+				const size_t cell = static_cast<size_t>(brickY * BRICK_SIZE + bit / BRICK_SIZE) * _width + brickX * BRICK_SIZE + bit % BRICK_SIZE;
+				const size_t slice = GetBrick(brickX, brickY, _baseLevel[cell] / BRICK_SIZE) + _baseLevel[cell] % BRICK_SIZE;
+				if (_burning[slice] & (uint64_t(1) << bit))
+					drops |= uint64_t(1) << bit;
+			}
+			_columnDrops[column] = drops;
+		});
+
+		for (uint32_t column : _activeColumns)
+		{
+			const int brickX = static_cast<int>(column % _bricksX), brickY = static_cast<int>(column / _bricksX);
+			for (uint64_t cells = _columnDrops[column]; cells != 0; cells &= cells - 1)
+			{
+				const int bit = GetLowestBit(cells);
+				fire.Ignite(brickX * BRICK_SIZE + bit % BRICK_SIZE, brickY * BRICK_SIZE + bit / BRICK_SIZE);
+			}
+		}
+	}
+
+	uint64_t CrownFire::GetDigest() const
+	{
+		return HashBytes(_burned.data(), _burned.size() * sizeof(uint64_t), HashBytes(_burning.data(), _burning.size() * sizeof(uint64_t)));
+	}
+
+	size_t CrownFire::GetNumBurningVoxels() const
+	{
+		size_t numVoxels = 0;
+		for (uint64_t slice : _burning)
+			numVoxels += CountBits(slice);
+		return numVoxels;
+	}
+
+	size_t CrownFire::GetNumBurnedVoxels() const
+	{
+		size_t numVoxels = 0;
+		for (uint64_t slice : _burned)
+			numVoxels += CountBits(slice);
+		return numVoxels;
+	}
+
+	bool CrownFire::IsBurning(int x, int y, int z) const
+	{
+		if (x < 0 || y < 0 || z < 0 || x >= _width || y >= _height || z >= _bricksZ * BRICK_SIZE)
+			return false;
+		const int32_t brick = GetBrick(x / BRICK_SIZE, y / BRICK_SIZE, z / BRICK_SIZE);
+		return brick >= 0 && (_burning[brick + z % BRICK_SIZE] >> ((y % BRICK_SIZE) * BRICK_SIZE + x % BRICK_SIZE) & 1) != 0;
+	}
+
+	size_t CrownFire::GetMemoryBytes() const
+	{
+		return (_fuel.capacity() + _burning.capacity() + _burned.capacity() + _nextBurning.capacity() +
+				_columnCanopy.capacity() + _columnDrops.capacity()) * sizeof(uint64_t) +
+			   _brickIndex.capacity() * sizeof(int32_t) + _columnBurning.capacity() + _activeColumns.capacity() * sizeof(uint32_t) +
+			   _baseLevel.capacity() + _torchingIntensity.capacity() * sizeof(float);
+	}
+
+};
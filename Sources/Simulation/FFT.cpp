@@ -0,0 +1,221 @@
+#include <Simulation/FFT.hpp>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+namespace
+{
+	//! Per-thread scratch so const transforms can run concurrently from the job system.
+	thread_local std::vector<Simulation::Complex> tRowScratch;
+	thread_local std::vector<Simulation::Complex> tColumnScratch;
+};
+
+namespace Simulation {
+
+	FFT::FFT()
+		: _size(0)
+	{
+		//! Do nothing
+	}
+
+	FFT::~FFT()
+	{
+		//! Do nothing
+	}
+
+	bool FFT::Initialize(size_t size)
+	{
+		if (!IsPowerOfTwo(size))
+		{
+			std::cerr << "FFT size must be a power of two, given " << size << std::endl;
+			return false;
+		}
+
+		_size = size;
+
+		unsigned int numBits = 0;
+		while ((size_t(1) << numBits) < size)
+			++numBits;
+
+		_bitReverse.resize(size);
+		for (size_t i = 0; i < size; ++i)
+		{
+			unsigned int reversed = 0;
+			for (unsigned int bit = 0; bit < numBits; ++bit)
+				if (i & (size_t(1) << bit))
+					reversed |= 1u << (numBits - 1 - bit);
+			_bitReverse[i] = reversed;
+		}
+
+		_twiddles.resize(std::max<size_t>(size / 2, 1));
+		for (size_t k = 0; k < _twiddles.size(); ++k)
+		{
+			const double angle = -2.0 * glm::pi<double>() * static_cast<double>(k) / static_cast<double>(size);
+			_twiddles[k] = Complex(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+		}
+
+		return true;
+	}
+
+	void FFT::Forward(Complex* data) const
+	{
+		Transform(data, false);
+	}
+
+	void FFT::Inverse(Complex* data) const
+	{
+		Transform(data, true);
+
+		const float scale = 1.0f / static_cast<float>(_size);
+		for (size_t i = 0; i < _size; ++i)
+			data[i] *= scale;
+	}
+
+	void FFT::Transform(Complex* data, bool inverse) const
+	{
+		for (size_t i = 0; i < _size; ++i)
+		{
+			const size_t j = _bitReverse[i];
+			if (i < j)
+				std::swap(data[i], data[j]);
+		}
+
+		for (size_t length = 2; length <= _size; length <<= 1)
+		{
+			const size_t half = length / 2;
+			const size_t step = _size / length;
+			for (size_t start = 0; start < _size; start += length)
+			{
+				for (size_t k = 0; k < half; ++k)
+				{
+					const Complex twiddle = inverse ? std::conj(_twiddles[k * step]) : _twiddles[k * step];
+					const Complex even = data[start + k];
+					const Complex odd = data[start + k + half] * twiddle;
+					data[start + k] = even + odd;
+					data[start + k + half] = even - odd;
+				}
+			}
+		}
+	}
+
+	RealFFT2D::RealFFT2D()
+		: _width(0), _height(0)
+	{
+		//! Do nothing
+	}
+
+	RealFFT2D::~RealFFT2D()
+	{
+		//! Do nothing
+	}
+
+	bool RealFFT2D::Initialize(size_t width, size_t height)
+	{
+		if (width < 2 || !IsPowerOfTwo(width) || !IsPowerOfTwo(height))
+		{
+			std::cerr << "RealFFT2D extents must be powers of two, given " << width << "x" << height << std::endl;
+			return false;
+		}
+
+		_width = width;
+		_height = height;
+
+		//! Rows are transformed as width / 2 packed complex values (even + i * odd).
+		if (!_rowFFT.Initialize(width / 2) || !_columnFFT.Initialize(height))
+			return false;
+
+		_realTwiddles.resize(width / 2 + 1);
+		for (size_t k = 0; k < _realTwiddles.size(); ++k)
+		{
+			const double angle = -2.0 * glm::pi<double>() * static_cast<double>(k) / static_cast<double>(width);
+			_realTwiddles[k] = Complex(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+		}
+
+		return true;
+	}
+
+	void RealFFT2D::Forward(const float* input, Complex* spectrum) const
+	{
+		const size_t half = _width / 2;
+		const size_t spectrumWidth = half + 1;
+		const Complex minusHalfI(0.0f, -0.5f);
+
+		tRowScratch.resize(half);
+		for (size_t y = 0; y < _height; ++y)
+		{
+			const float* row = input + y * _width;
+			for (size_t n = 0; n < half; ++n)
+				tRowScratch[n] = Complex(row[2 * n], row[2 * n + 1]);
+
+			_rowFFT.Forward(tRowScratch.data());
+
+			//! Split the packed transform into the spectra of the even and odd samples.
+			Complex* out = spectrum + y * spectrumWidth;
+			for (size_t k = 0; k <= half; ++k)
+			{
+				const Complex zk = tRowScratch[k % half];
+				const Complex zc = std::conj(tRowScratch[(half - k) % half]);
+				const Complex even = (zk + zc) * 0.5f;
+				const Complex odd = (zk - zc) * minusHalfI;
+				out[k] = even + _realTwiddles[k] * odd;
+			}
+		}
+
+		tColumnScratch.resize(_height);
+		for (size_t x = 0; x < spectrumWidth; ++x)
+		{
+			for (size_t y = 0; y < _height; ++y)
+				tColumnScratch[y] = spectrum[y * spectrumWidth + x];
+
+			_columnFFT.Forward(tColumnScratch.data());
+
+			for (size_t y = 0; y < _height; ++y)
+				spectrum[y * spectrumWidth + x] = tColumnScratch[y];
+		}
+	}
+
+	void RealFFT2D::Inverse(Complex* spectrum, float* output) const
+	{
+		const size_t half = _width / 2;
+		const size_t spectrumWidth = half + 1;
+		const Complex imaginary(0.0f, 1.0f);
+
+		tColumnScratch.resize(_height);
+		for (size_t x = 0; x < spectrumWidth; ++x)
+		{
+			for (size_t y = 0; y < _height; ++y)
+				tColumnScratch[y] = spectrum[y * spectrumWidth + x];
+
+			_columnFFT.Inverse(tColumnScratch.data());
+
+			for (size_t y = 0; y < _height; ++y)
+				spectrum[y * spectrumWidth + x] = tColumnScratch[y];
+		}
+
+		tRowScratch.resize(half);
+		for (size_t y = 0; y < _height; ++y)
+		{
+			const Complex* in = spectrum + y * spectrumWidth;
+			//! Recombine even and odd spectra into the packed half-length transform.
+			for (size_t k = 0; k < half; ++k)
+			{
+				const Complex xk = in[k];
+				const Complex xc = std::conj(in[half - k]);
+				const Complex even = (xk + xc) * 0.5f;
+				const Complex odd = (xk - xc) * 0.5f * std::conj(_realTwiddles[k]);
+				tRowScratch[k] = even + imaginary * odd;
+			}
+
+			_rowFFT.Inverse(tRowScratch.data());
+
+			float* row = output + y * _width;
+			for (size_t n = 0; n < half; ++n)
+			{
+				row[2 * n] = tRowScratch[n].real();
+				row[2 * n + 1] = tRowScratch[n].imag();
+			}
+		}
+	}
+
+};
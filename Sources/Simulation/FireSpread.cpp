@@ -0,0 +1,378 @@
+#include <Simulation/FireSpread.hpp>
+#include <Simulation/SpreadKernel.hpp>
+#include <Simulation/WeatherInput.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+	using Simulation::SpreadKernel::OFFSET_X;
+	using Simulation::SpreadKernel::OFFSET_Y;
+	using Simulation::SpreadKernel::DISTANCE;
+};
+
+namespace Simulation {
+
+	FireSpread::FireSpread()
+		: _courantNumber(0.0f), _stableTimeStep(std::numeric_limits<float>::infinity()), _cellSize(1.0f), _time(0.0),
+		  _numSubsteps(0), _numBurning(0), _width(0), _height(0),
+		  _activeMinX(0), _activeMinY(0), _activeMaxX(-1), _activeMaxY(-1)
+	{
+		std::fill(_windFactor, _windFactor + 8, 1.0f);
+	}
+
+	FireSpread::~FireSpread()
+	{
+		//! Do nothing
+	}
+
+	bool FireSpread::Initialize(const Landscape& landscape)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (landscape.width <= 0 || landscape.height <= 0 || landscape.fuel.size() != landscape.GetNumCells() ||
+			landscape.elevation.size() != landscape.GetNumCells())
+		{
+			std::cerr << "Invalid landscape " << landscape.width << "x" << landscape.height << " for the fire spread" << std::endl;
+			return false;
+		}
+
+		_width = landscape.width;
+		_height = landscape.height;
+		_cellSize = landscape.cellSize;
+		_fuel = landscape.fuel;
+		_elevation = landscape.elevation;
+
+		const size_t numCells = landscape.GetNumCells();
+		_state.resize(numCells);
+		for (size_t i = 0; i < numCells; ++i)
+			_state[i] = _fuel[i] == NonBurnable ? Unburnable : Unburned;
+		_ignition.assign(numCells, 0.0f);
+		_fuelLoad.assign(numCells, 0.0f);
+		_spreadFactor.assign(numCells, 1.0f);
+		_intensity.assign(numCells, 0.0f);
+		_rowBurning.assign(_height, 0);
+		_rowMinX.assign(_height, _width);
+		_rowMaxX.assign(_height, -1);
+
+		_time = 0.0;
+		_stableTimeStep = std::numeric_limits<float>::infinity();
+		_numSubsteps = 0;
+		_numBurning = 0;
+		_activeMinX = _activeMinY = 0;
+		_activeMaxX = _activeMaxY = -1;
+		SetWind(landscape.wind);
+
+		return true;
+	}
+
+	void FireSpread::SetWind(const glm::vec2& wind)
+	{
+		for (int direction = 0; direction < 8; ++direction)
+			_windFactor[direction] = SpreadKernel::GetWindFactor(wind, direction);
+	}
+
+	bool FireSpread::SetWeather(const WeatherInput& weather)
+	{
+		if (weather.GetWidth() != _width || weather.GetHeight() != _height)
+		{
+			std::cerr << "Weather grid " << weather.GetWidth() << "x" << weather.GetHeight() << " does not match the fire grid "
+					  << _width << "x" << _height << std::endl;
+			return false;
+		}
+
+		SetWind(weather.GetMeanSample().wind);
+		const std::vector<float>& humidity = weather.GetHumidity();
+		const std::vector<float>& temperature = weather.GetTemperature();
+		GL3::JobSystem::GetInstance().ParallelFor(_height, [&](size_t row)
+		{
+			for (size_t cell = row * _width; cell < (row + 1) * _width; ++cell)
+				_spreadFactor[cell] = GetMoistureFactor(GetFuelMoisture(humidity[cell], temperature[cell]));
+		});
+		return true;
+	}
+
+	bool FireSpread::Ignite(int x, int y)
+	{
+		if (x < 0 || y < 0 || x >= _width || y >= _height)
+			return false;
+
+		const size_t cell = static_cast<size_t>(y) * _width + x;
+		if (_state[cell] != Unburned)
+			return false;
+
+		const FuelModel& model = GetFuelModel(_fuel[cell]);
+		_state[cell] = Burning;
+		_fuelLoad[cell] = model.load;
+		_intensity[cell] = model.heatContent * model.load / model.burnTime;
+		++_numBurning;
+
+		++_rowBurning[y];
+		_rowMinX[y] = std::min(_rowMinX[y], x);
+		_rowMaxX[y] = std::max(_rowMaxX[y], x);
+		if (_activeMaxX < _activeMinX)
+		{
+			_activeMinX = _activeMaxX = x;
+			_activeMinY = _activeMaxY = y;
+		}
+		_activeMinX = std::max(0, std::min(_activeMinX, x - 1));
+		_activeMaxX = std::min(_width - 1, std::max(_activeMaxX, x + 1));
+		_activeMinY = std::max(0, std::min(_activeMinY, y - 1));
+		_activeMaxY = std::min(_height - 1, std::max(_activeMaxY, y + 1));
+
+		return true;
+	}
+
+	float FireSpread::GetIgnitionRate(size_t cell, size_t neighbor, int direction) const
+	{
+		return SpreadKernel::GetIgnitionRate(GetFuelModel(_fuel[cell]).spreadRate * _spreadFactor[cell], _windFactor[direction], _elevation[cell], _elevation[neighbor], _cellSize, direction);
+	}
+
+	void FireSpread::SetCourantNumber(float courant)
+	{
+		_courantNumber = std::max(0.0f, courant);
+		_stableTimeStep = std::numeric_limits<float>::infinity();
+	}
+
+	void FireSpread::Step(float dt)
+	{
+		if (dt <= 0.0f)
+			return;
+		_time += dt;
+		if (_numBurning == 0)
+			return;
+
+		GL3::FrameStatistics::GetInstance().Increment(GL3::FrameStatistics::SimulationSteps);
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (_courantNumber <= 0.0f)
+		{
+			Advance(dt);
+			++_numSubsteps;
+			return;
+		}
+
+		//! Equal substeps no longer than the stable step, recomputed from the rates of every substep.
+		_rate.resize(_state.size());
+		_rowStableStep.resize(_height);
+		float remaining = dt;
+		while (remaining > 0.0f && _numBurning > 0)
+		{
+			_stableTimeStep = UpdateRates();
+			const float numSubsteps = std::ceil(remaining / _stableTimeStep);
+			const float substep = numSubsteps > 1.0f ? remaining / numSubsteps : remaining;
+			AdvanceRates(substep);
+			remaining = numSubsteps > 1.0f ? remaining - substep : 0.0f;
+			++_numSubsteps;
+		}
+	}
+
+	void FireSpread::Advance(float dt)
+	{
+		const int minX = _activeMinX, maxX = _activeMaxX;
+		const int minY = _activeMinY, maxY = _activeMaxY;
+		const size_t numRows = static_cast<size_t>(maxY - minY + 1);
+		GL3::ProfileScope scope("FireSpread::Advance", numRows * (maxX - minX + 1));
+		auto& jobSystem = GL3::JobSystem::GetInstance();
+
+		//! Accumulate ignition progress and consume fuel from the previous states only.
+		jobSystem.ParallelFor(numRows, [&](size_t row)
+		{
+			const int y = minY + static_cast<int>(row);
+			for (int x = minX; x <= maxX; ++x)
+			{
+				const size_t cell = static_cast<size_t>(y) * _width + x;
+				if (_state[cell] == Unburned)
+					_ignition[cell] += GetSummedRate(x, y) * dt;
+				else if (_state[cell] == Burning)
+				{
+					const FuelModel& model = GetFuelModel(_fuel[cell]);
+					_fuelLoad[cell] -= model.load / model.burnTime * dt;
+				}
+			}
+		});
+
+		//! Apply the transitions and collect the burning rows for the next window.
+		jobSystem.ParallelFor(numRows, [&](size_t row)
+		{
+			CommitRow(minY + static_cast<int>(row), minX, maxX);
+		});
+		UpdateActiveWindow(minY, maxY);
+	}
+
+	float FireSpread::UpdateRates()
+	{
+		const int minX = _activeMinX, maxX = _activeMaxX;
+		const int minY = _activeMinY, maxY = _activeMaxY;
+		GL3::ProfileScope scope("FireSpread::UpdateRates", static_cast<size_t>(maxY - minY + 1) * (maxX - minX + 1));
+
+		//! The substep may neither give any cell more than the Courant number in progress nor burn more
+		//! than that fraction of the fuel of any burning cell.
+		GL3::JobSystem::GetInstance().ParallelFor(static_cast<size_t>(maxY - minY + 1), [&](size_t row)
+		{
+			const int y = minY + static_cast<int>(row);
+			float maxRate = 0.0f, minBurnTime = std::numeric_limits<float>::infinity();
+			for (int x = minX; x <= maxX; ++x)
+			{
+				const size_t cell = static_cast<size_t>(y) * _width + x;
+				if (_state[cell] == Unburned)
+				{
+					_rate[cell] = GetSummedRate(x, y);
+					maxRate = std::max(maxRate, _rate[cell]);
+				}
+				else if (_state[cell] == Burning)
+					minBurnTime = std::min(minBurnTime, GetFuelModel(_fuel[cell]).burnTime);
+			}
+			_rowStableStep[y] = _courantNumber * std::min(minBurnTime, maxRate > 0.0f ? 1.0f / maxRate : std::numeric_limits<float>::infinity());
+		});
+
+		float stableStep = std::numeric_limits<float>::infinity();
+		for (int y = minY; y <= maxY; ++y)
+			stableStep = std::min(stableStep, _rowStableStep[y]);
+		return stableStep;
+	}
+
+	void FireSpread::AdvanceRates(float dt)
+	{
+		const int minX = _activeMinX, maxX = _activeMaxX;
+		const int minY = _activeMinY, maxY = _activeMaxY;
+		const size_t numRows = static_cast<size_t>(maxY - minY + 1);
+		GL3::ProfileScope scope("FireSpread::AdvanceRates", numRows * (maxX - minX + 1));
+
+		//! The rates were taken from the previous states, so every cell advances and commits on its own.
+		GL3::JobSystem::GetInstance().ParallelFor(numRows, [&](size_t row)
+		{
+			const int y = minY + static_cast<int>(row);
+			for (int x = minX; x <= maxX; ++x)
+			{
+				const size_t cell = static_cast<size_t>(y) * _width + x;
+				if (_state[cell] == Unburned)
+					_ignition[cell] += _rate[cell] * dt;
+				else if (_state[cell] == Burning)
+				{
+					const FuelModel& model = GetFuelModel(_fuel[cell]);
+					_fuelLoad[cell] -= model.load / model.burnTime * dt;
+				}
+			}
+			CommitRow(y, minX, maxX);
+		});
+		UpdateActiveWindow(minY, maxY);
+	}
+
+	float FireSpread::GetSummedRate(int x, int y) const
+	{
+		const size_t cell = static_cast<size_t>(y) * _width + x;
+		float rate = 0.0f;
+		for (int direction = 0; direction < 8; ++direction)
+		{
+			const int neighborX = x + OFFSET_X[direction], neighborY = y + OFFSET_Y[direction];
+			if (neighborX < 0 || neighborY < 0 || neighborX >= _width || neighborY >= _height)
+				continue;
+			const size_t neighbor = static_cast<size_t>(neighborY) * _width + neighborX;
+			if (_state[neighbor] == Burning)
+				rate += GetIgnitionRate(cell, neighbor, direction);
+		}
+		return rate;
+	}
+
+	void FireSpread::CommitRow(int y, int minX, int maxX)
+	{
+		int numBurning = 0, rowMinX = _width, rowMaxX = -1;
+		for (int x = minX; x <= maxX; ++x)
+		{
+			const size_t cell = static_cast<size_t>(y) * _width + x;
+			const FuelModel& model = GetFuelModel(_fuel[cell]);
+			if (_state[cell] == Unburned && _ignition[cell] >= 1.0f)
+			{
+				_state[cell] = Burning;
+				_fuelLoad[cell] = model.load;
+			}
+			else if (_state[cell] == Burning && _fuelLoad[cell] <= 0.0f)
+			{
+				_state[cell] = Burned;
+				_fuelLoad[cell] = 0.0f;
+			}
+
+			if (_state[cell] == Burning)
+			{
+				_intensity[cell] = model.heatContent * model.load / model.burnTime;
+				++numBurning;
+				rowMinX = std::min(rowMinX, x);
+				rowMaxX = std::max(rowMaxX, x);
+			}
+			else
+			{
+				_intensity[cell] = 0.0f;
+			}
+		}
+		_rowBurning[y] = numBurning;
+		_rowMinX[y] = rowMinX;
+		_rowMaxX[y] = rowMaxX;
+	}
+
+	void FireSpread::UpdateActiveWindow(int minY, int maxY)
+	{
+		_numBurning = 0;
+		_activeMinX = _width;
+		_activeMinY = _height;
+		_activeMaxX = _activeMaxY = -1;
+		for (int y = minY; y <= maxY; ++y)
+		{
+			if (_rowBurning[y] == 0)
+				continue;
+			_numBurning += _rowBurning[y];
+			_activeMinX = std::min(_activeMinX, _rowMinX[y] - 1);
+			_activeMaxX = std::max(_activeMaxX, _rowMaxX[y] + 1);
+			_activeMinY = std::min(_activeMinY, y - 1);
+			_activeMaxY = std::max(_activeMaxY, y + 1);
+		}
+		if (_numBurning == 0)
+		{
+			_activeMinX = _activeMinY = 0;
+			_activeMaxX = _activeMaxY = -1;
+			return;
+		}
+		_activeMinX = std::max(0, _activeMinX);
+		_activeMinY = std::max(0, _activeMinY);
+		_activeMaxX = std::min(_width - 1, _activeMaxX);
+		_activeMaxY = std::min(_height - 1, _activeMaxY);
+	}
+
+	void FireSpread::ApplySuppression(const std::vector<Suppression>& actions)
+	{
+		for (const Suppression& action : actions)
+		{
+			if (action.cell >= _state.size())
+				continue;
+			const uint32_t cell = action.cell;
+			if (action.type == Wetting && _state[cell] == Unburned)
+				_ignition[cell] -= action.amount / WATER_PER_IGNITION;
+			else if (action.type == Wetting && _state[cell] == Burning)
+				_fuelLoad[cell] -= action.amount;
+			else if (action.type == Firebreak && _state[cell] == Unburned)
+			{
+				_state[cell] = Unburnable;
+				_fuel[cell] = NonBurnable;
+				_ignition[cell] = 0.0f;
+			}
+		}
+	}
+
+	uint64_t FireSpread::GetDigest() const
+	{
+		return HashBytes(_state.data(), _state.size());
+	}
+
+	size_t FireSpread::GetMemoryBytes() const
+	{
+		return _state.capacity() + _fuel.capacity() +
+			   (_elevation.capacity() + _ignition.capacity() + _fuelLoad.capacity() + _spreadFactor.capacity() + _intensity.capacity() +
+				_rate.capacity() + _rowStableStep.capacity()) * sizeof(float) +
+			   (_rowBurning.capacity() + _rowMinX.capacity() + _rowMaxX.capacity()) * sizeof(int);
+	}
+
+};
@@ -0,0 +1,133 @@
+#include <Simulation/Landscape.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	const Simulation::FuelModel FUEL_MODELS[Simulation::NumFuelTypes] =
+	{
+		{ "non-burnable", 0.0f, 0.0f, 0.0f, 0.0f },
+		{ "grass", 0.3f, 0.5f, 30.0f, 18000.0f },
+		{ "shrub", 1.5f, 0.25f, 120.0f, 19000.0f },
+		{ "timber litter", 2.5f, 0.1f, 300.0f, 20000.0f },
+		{ "slash", 6.0f, 0.15f, 600.0f, 20000.0f },
+	};
+	//! Fine dead fuel moisture in percent the spread rates of the fuel models hold at, and the one
+	//! from which on fuel no longer carries fire
+	constexpr float REFERENCE_FUEL_MOISTURE = 8.0f;
+	constexpr float EXTINCTION_FUEL_MOISTURE = 25.0f;
+
+	//! Rothermel's moisture damping coefficient of the moisture over the extinction moisture
+	inline float GetMoistureDamping(float moisture)
+	{
+		const float ratio = std::min(std::max(moisture / EXTINCTION_FUEL_MOISTURE, 0.0f), 1.0f);
+		return 1.0f - 2.59f * ratio + 5.11f * ratio * ratio - 3.52f * ratio * ratio * ratio;
+	}
+};
+
+namespace Simulation {
+
+	const FuelModel& GetFuelModel(uint8_t fuel)
+	{
+		return FUEL_MODELS[fuel < NumFuelTypes ? fuel : NonBurnable];
+	}
+
+	float GetFuelMoisture(float humidity, float temperature)
+	{
+		//! Simard's regressions are in degrees Fahrenheit.
+		const float fahrenheit = temperature * 1.8f + 32.0f;
+		humidity = std::min(std::max(humidity, 0.0f), 100.0f);
+		if (humidity < 10.0f)
+			return 0.03229f + 0.281073f * humidity - 0.000578f * humidity * fahrenheit;
+		if (humidity < 50.0f)
+			return 2.22749f + 0.160107f * humidity - 0.01478f * fahrenheit;
+		return 21.0606f + 0.005565f * humidity * humidity - 0.00035f * humidity * fahrenheit - 0.483199f * humidity;
+	}
+
+	float GetMoistureFactor(float moisture)
+	{
+		static const float referenceDamping = GetMoistureDamping(REFERENCE_FUEL_MOISTURE);
+		return std::max(GetMoistureDamping(moisture), 0.0f) / referenceDamping;
+	}
+
+	uint64_t HashBytes(const void* data, size_t numBytes, uint64_t hash)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < numBytes; ++i)
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		return hash;
+	}
+
+	bool Landscape::Initialize(int width, int height, float cellSize)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (width <= 0 || height <= 0 || cellSize <= 0.0f)
+		{
+			std::cerr << "Invalid landscape " << width << "x" << height << " cell size " << cellSize << std::endl;
+			return false;
+		}
+
+		this->width = width;
+		this->height = height;
+		this->cellSize = cellSize;
+		elevation.assign(GetNumCells(), 0.0f);
+		fuel.assign(GetNumCells(), NonBurnable);
+		wind = glm::vec2(0.0f);
+
+		return true;
+	}
+
+	float Landscape::GetRefinedElevation(int factor, int x, int y) const
+	{
+		//! Position in landscape cell centers, clamped to the outer centers
+		const float u = std::min(std::max((x + 0.5f) / factor - 0.5f, 0.0f), static_cast<float>(width - 1));
+		const float v = std::min(std::max((y + 0.5f) / factor - 0.5f, 0.0f), static_cast<float>(height - 1));
+		const int x0 = static_cast<int>(std::floor(u)), y0 = static_cast<int>(std::floor(v));
+		const int x1 = std::min(x0 + 1, width - 1), y1 = std::min(y0 + 1, height - 1);
+		const float tx = u - x0, ty = v - y0;
+
+		const float* row0 = elevation.data() + static_cast<size_t>(y0) * width;
+		const float* row1 = elevation.data() + static_cast<size_t>(y1) * width;
+		const float bottom = row0[x0] + (row0[x1] - row0[x0]) * tx;
+		const float top = row1[x0] + (row1[x1] - row1[x0]) * tx;
+		return bottom + (top - bottom) * ty;
+	}
+
+	bool Landscape::Refine(int factor, Landscape& refined) const
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (factor <= 0 || elevation.size() != GetNumCells() || fuel.size() != GetNumCells() ||
+			!refined.Initialize(width * factor, height * factor, cellSize / factor))
+		{
+			std::cerr << "Invalid refinement of a " << width << "x" << height << " landscape by " << factor << std::endl;
+			return false;
+		}
+
+		GL3::JobSystem::GetInstance().ParallelFor(refined.height, [&](size_t row)
+		{
+			const int y = static_cast<int>(row);
+			for (int x = 0; x < refined.width; ++x)
+			{
+				refined.elevation[row * refined.width + x] = GetRefinedElevation(factor, x, y);
+				refined.fuel[row * refined.width + x] = fuel[static_cast<size_t>(y / factor) * width + x / factor];
+			}
+		});
+		refined.wind = wind;
+
+		return true;
+	}
+
+	uint64_t Landscape::GetDigest() const
+	{
+		const int32_t extent[2] = { width, height };
+		uint64_t hash = HashBytes(extent, sizeof(extent));
+		hash = HashBytes(&cellSize, sizeof(cellSize), hash);
+		hash = HashBytes(elevation.data(), elevation.size() * sizeof(float), hash);
+		hash = HashBytes(fuel.data(), fuel.size(), hash);
+		return HashBytes(&wind, sizeof(wind), hash);
+	}
+
+};
@@ -0,0 +1,216 @@
+#include <Simulation/MeshFireSpread.hpp>
+#include <Simulation/FireSpread.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/MeshGraph.hpp>
+#include <GL3/Profiler.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+	//! RGBA8 with red in the lowest byte, the layout of GL3::VertexColorBuffer
+	inline uint32_t PackColor(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha)
+	{
+		return red | (green << 8) | (blue << 16) | (alpha << 24);
+	}
+
+	//! Spread rate multiplier of a climb given as rise over edge length, descents keep the flat rate
+	inline float GetSlopeFactor(float slope)
+	{
+		if (slope <= 0.0f)
+			return 1.0f;
+		const float run = std::sqrt(std::max(1.0f - slope * slope, 0.0f));
+		const float gradient = run * Simulation::MeshFireSpread::MAX_GRADIENT > slope ? slope / run : Simulation::MeshFireSpread::MAX_GRADIENT;
+		return 1.0f + Simulation::FireSpread::SLOPE_COEFFICIENT * gradient * gradient;
+	}
+};
+
+namespace Simulation {
+
+	MeshFireSpread::MeshFireSpread()
+		: _graph(nullptr), _numBurned(0), _burnTime(0.0f), _time(0.0f)
+	{
+		//! Do nothing
+	}
+
+	MeshFireSpread::~MeshFireSpread()
+	{
+		//! Do nothing
+	}
+
+	bool MeshFireSpread::Initialize(const GL3::MeshGraph& graph, const std::vector<float>& spreadRates, float burnTime)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+
+		const size_t numNodes = graph.GetNumNodes();
+		if (spreadRates.size() != numNodes || !(burnTime > 0.0f))
+		{
+			std::cerr << "Invalid mesh fire input, " << spreadRates.size() << " spread rates for " << numNodes
+					  << " nodes and burn time " << burnTime << std::endl;
+			return false;
+		}
+
+		_graph = &graph;
+		_spreadRate = spreadRates;
+		_state.resize(numNodes);
+		for (size_t node = 0; node < numNodes; ++node)
+			_state[node] = spreadRates[node] > 0.0f ? Unburned : Unburnable;
+		_arrival.assign(numNodes, std::numeric_limits<float>::infinity());
+		_burningNodes.clear();
+		_frontier.clear();
+		_numBurned = 0;
+		_burnTime = burnTime;
+		_time = 0.0f;
+		return true;
+	}
+
+	void MeshFireSpread::Ignite(uint32_t node)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (node >= _state.size() || _state[node] != Unburned)
+			return;
+		_state[node] = Burning;
+		_arrival[node] = _time;
+		_burningNodes.push_back(node);
+		UpdateFrontier();
+	}
+
+	void MeshFireSpread::Step(float dt)
+	{
+		GL3::FrameStatistics::GetInstance().Increment(GL3::FrameStatistics::SimulationSteps);
+		GL3::ProfileScope scope("MeshFireSpread::Step", _frontier.size() + _burningNodes.size());
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+
+		GL3::JobSystem& jobSystem = GL3::JobSystem::GetInstance();
+		const std::vector<uint32_t>& offsets = _graph->GetOffsets();
+		const std::vector<uint32_t>& neighbors = _graph->GetNeighbors();
+		const std::vector<float>& lengths = _graph->GetLengths();
+		const std::vector<float>& slopes = _graph->GetSlopes();
+		_time += dt;
+
+		//! Earliest arrival at every frontier node over the edges from burning neighbors. Only the
+		//! arrival of the job's own unburned nodes is written, which no other job reads.
+		const size_t numFrontierJobs = (_frontier.size() + NODES_PER_JOB - 1) / NODES_PER_JOB;
+		_jobNodes.resize(std::max(numFrontierJobs, (_burningNodes.size() + NODES_PER_JOB - 1) / NODES_PER_JOB));
+		jobSystem.ParallelFor(numFrontierJobs, [&](size_t job)
+		{
+			std::vector<uint32_t>& ignited = _jobNodes[job];
+			ignited.clear();
+			const size_t end = std::min(_frontier.size(), (job + 1) * NODES_PER_JOB);
+			for (size_t index = job * NODES_PER_JOB; index < end; ++index)
+			{
+				const uint32_t node = _frontier[index];
+				const float spreadRate = _spreadRate[node];
+				float arrival = _arrival[node];
+				for (uint32_t edge = offsets[node]; edge < offsets[node + 1]; ++edge)
+				{
+					const uint32_t neighbor = neighbors[edge];
+					if (_state[neighbor] != Burning)
+						continue;
+					//! The fire climbs the edge from the neighbor, against its stored direction.
+					const float travel = lengths[edge] / (spreadRate * GetSlopeFactor(-slopes[edge]));
+					if (travel <= _burnTime)
+						arrival = std::min(arrival, _arrival[neighbor] + travel);
+				}
+				_arrival[node] = arrival;
+				if (arrival <= _time)
+					ignited.push_back(node);
+			}
+		});
+		_scratch.clear();
+		for (size_t job = 0; job < numFrontierJobs; ++job)
+			_scratch.insert(_scratch.end(), _jobNodes[job].begin(), _jobNodes[job].end());
+
+		//! Burn out the nodes that burned during the whole step. Nodes ignited in this step keep
+		//! burning until the next frontier pass saw them, so no crossing within burnTime is lost.
+		const size_t numBurningJobs = (_burningNodes.size() + NODES_PER_JOB - 1) / NODES_PER_JOB;
+		jobSystem.ParallelFor(numBurningJobs, [&](size_t job)
+		{
+			std::vector<uint32_t>& burning = _jobNodes[job];
+			burning.clear();
+			const size_t end = std::min(_burningNodes.size(), (job + 1) * NODES_PER_JOB);
+			for (size_t index = job * NODES_PER_JOB; index < end; ++index)
+			{
+				const uint32_t node = _burningNodes[index];
+				if (_arrival[node] + _burnTime <= _time)
+					_state[node] = Burned;
+				else
+					burning.push_back(node);
+			}
+		});
+		const size_t numBurning = _burningNodes.size();
+		_burningNodes.clear();
+		for (size_t job = 0; job < numBurningJobs; ++job)
+			_burningNodes.insert(_burningNodes.end(), _jobNodes[job].begin(), _jobNodes[job].end());
+		_numBurned += numBurning - _burningNodes.size();
+
+		for (uint32_t node : _scratch)
+			_state[node] = Burning;
+		_burningNodes.insert(_burningNodes.end(), _scratch.begin(), _scratch.end());
+		UpdateFrontier();
+	}
+
+	void MeshFireSpread::UpdateFrontier()
+	{
+		const std::vector<uint32_t>& offsets = _graph->GetOffsets();
+		const std::vector<uint32_t>& neighbors = _graph->GetNeighbors();
+
+		//! Unburned neighbors of every burning node, sorted so the frontier is in node order.
+		const size_t numJobs = (_burningNodes.size() + NODES_PER_JOB - 1) / NODES_PER_JOB;
+		_jobNodes.resize(std::max(_jobNodes.size(), numJobs));
+		GL3::JobSystem::GetInstance().ParallelFor(numJobs, [&](size_t job)
+		{
+			std::vector<uint32_t>& frontier = _jobNodes[job];
+			frontier.clear();
+			const size_t end = std::min(_burningNodes.size(), (job + 1) * NODES_PER_JOB);
+			for (size_t index = job * NODES_PER_JOB; index < end; ++index)
+			{
+				const uint32_t node = _burningNodes[index];
+				for (uint32_t edge = offsets[node]; edge < offsets[node + 1]; ++edge)
+					if (_state[neighbors[edge]] == Unburned)
+						frontier.push_back(neighbors[edge]);
+			}
+		});
+		_frontier.clear();
+		for (size_t job = 0; job < numJobs; ++job)
+			_frontier.insert(_frontier.end(), _jobNodes[job].begin(), _jobNodes[job].end());
+		std::sort(_frontier.begin(), _frontier.end());
+		_frontier.erase(std::unique(_frontier.begin(), _frontier.end()), _frontier.end());
+	}
+
+	void MeshFireSpread::WriteColors(uint32_t* colors) const
+	{
+		const std::vector<uint32_t>& vertexNodes = _graph->GetVertexNodes();
+		const size_t numJobs = (vertexNodes.size() + NODES_PER_JOB - 1) / NODES_PER_JOB;
+		GL3::JobSystem::GetInstance().ParallelFor(numJobs, [&](size_t job)
+		{
+			const size_t end = std::min(vertexNodes.size(), (job + 1) * NODES_PER_JOB);
+			for (size_t vertex = job * NODES_PER_JOB; vertex < end; ++vertex)
+			{
+				const uint32_t node = vertexNodes[vertex];
+				uint32_t color = 0;
+				if (_state[node] == Burning)
+				{
+					//! Yellow flames turning red as the node burns out.
+					const float burnt = std::min(std::max((_time - _arrival[node]) / _burnTime, 0.0f), 1.0f);
+					color = PackColor(255 - static_cast<uint32_t>(55.0f * burnt), 220 - static_cast<uint32_t>(190.0f * burnt), 64 - static_cast<uint32_t>(64.0f * burnt), 255);
+				}
+				else if (_state[node] == Burned)
+				{
+					color = PackColor(40, 36, 32, 255);
+				}
+				colors[vertex] = color;
+			}
+		});
+	}
+
+	uint64_t MeshFireSpread::GetDigest() const
+	{
+		return HashBytes(_state.data(), _state.size());
+	}
+
+};
@@ -0,0 +1,184 @@
+#include <Simulation/PathFinder.hpp>
+#include <Simulation/SpreadKernel.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+
+namespace
+{
+	//! Walking time multiplier per FuelType, bare ground and roads are the fastest
+	const float FUEL_TRAVEL_COST[Simulation::NumFuelTypes] = { 1.0f, 1.2f, 2.5f, 1.6f, 3.5f };
+	using Simulation::SpreadKernel::OFFSET_X;
+	using Simulation::SpreadKernel::OFFSET_Y;
+	using Simulation::SpreadKernel::DISTANCE;
+
+	//! Open list entry, ordered by estimated total cost then cell for a deterministic expansion order
+	struct OpenNode
+	{
+		float estimate;
+		uint32_t cell;
+		inline bool operator>(const OpenNode& other) const
+		{
+			return estimate > other.estimate || (estimate == other.estimate && cell > other.cell);
+		}
+	};
+
+	//! Per-thread search state, a cell is valid for the current search only if its stamp matches.
+	thread_local std::vector<float> tCostSoFar;
+	thread_local std::vector<uint32_t> tParent;
+	thread_local std::vector<uint32_t> tStamp;
+	thread_local std::vector<OpenNode> tOpen;
+	thread_local uint32_t tSearch = 0;
+
+	//! Octile distance in cells, the cost of the straight 8-connected path over the cheapest cells
+	inline float GetOctileDistance(int dx, int dy)
+	{
+		dx = std::abs(dx);
+		dy = std::abs(dy);
+		return static_cast<float>(std::max(dx, dy)) + 0.41421356f * static_cast<float>(std::min(dx, dy));
+	}
+};
+
+namespace Simulation {
+
+	PathFinder::PathFinder()
+		: _cellSize(1.0f), _width(0), _height(0)
+	{
+		//! Do nothing
+	}
+
+	PathFinder::~PathFinder()
+	{
+		//! Do nothing
+	}
+
+	bool PathFinder::Initialize(const Landscape& landscape)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (landscape.width <= 0 || landscape.height <= 0 || landscape.fuel.size() != landscape.GetNumCells() ||
+			landscape.elevation.size() != landscape.GetNumCells())
+		{
+			std::cerr << "Invalid landscape " << landscape.width << "x" << landscape.height << " for the path finder" << std::endl;
+			return false;
+		}
+
+		_width = landscape.width;
+		_height = landscape.height;
+		_cellSize = landscape.cellSize;
+		_cost.resize(landscape.GetNumCells());
+		GL3::JobSystem::GetInstance().ParallelFor(_height, [&](size_t row)
+		{
+			const int y = static_cast<int>(row);
+			const int y0 = std::max(0, y - 1), y1 = std::min(_height - 1, y + 1);
+			for (int x = 0; x < _width; ++x)
+			{
+				//! Central differences of the elevation, one sided at the border.
+				const int x0 = std::max(0, x - 1), x1 = std::min(_width - 1, x + 1);
+				const glm::vec2 gradient(
+					(landscape.elevation[static_cast<size_t>(y) * _width + x1] - landscape.elevation[static_cast<size_t>(y) * _width + x0]) / (std::max(1, x1 - x0) * _cellSize),
+					(landscape.elevation[static_cast<size_t>(y1) * _width + x] - landscape.elevation[static_cast<size_t>(y0) * _width + x]) / (std::max(1, y1 - y0) * _cellSize));
+				const size_t cell = static_cast<size_t>(y) * _width + x;
+				const uint8_t fuel = landscape.fuel[cell] < NumFuelTypes ? landscape.fuel[cell] : NonBurnable;
+				_cost[cell] = FUEL_TRAVEL_COST[fuel] * (1.0f + SLOPE_PENALTY * glm::length(gradient));
+			}
+		});
+
+		return true;
+	}
+
+	void PathFinder::FindPaths(const std::vector<PathQuery>& queries, std::vector<Path>& paths,
+							   const uint8_t* state, uint8_t blockedState) const
+	{
+		GL3::ProfileScope scope("PathFinder::FindPaths", queries.size());
+		paths.resize(queries.size());
+		GL3::JobSystem::GetInstance().ParallelFor(queries.size(), [&](size_t query)
+		{
+			FindPath(queries[query], paths[query], state, blockedState);
+		});
+	}
+
+	void PathFinder::FindPath(const PathQuery& query, Path& path, const uint8_t* state, uint8_t blockedState) const
+	{
+		path.cells.clear();
+		path.cost = 0.0f;
+		const size_t numCells = _cost.size();
+		if (query.start >= numCells || query.goal >= numCells)
+			return;
+
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (tStamp.size() != numCells || tSearch >= 0x7FFFFFFEu)
+		{
+			tCostSoFar.resize(numCells);
+			tParent.resize(numCells);
+			tStamp.assign(numCells, 0);
+			tSearch = 0;
+		}
+		const uint32_t search = ++tSearch;
+		tOpen.clear();
+
+		const int goalX = static_cast<int>(query.goal % _width), goalY = static_cast<int>(query.goal / _width);
+		auto isBlocked = [&](uint32_t cell)
+		{
+			return state && state[cell] == blockedState && cell != query.start && cell != query.goal;
+		};
+
+		//! The stamp is 2 * search while a cell is open and 2 * search + 1 once it is closed.
+		const uint32_t open = search * 2, closed = search * 2 + 1;
+		tStamp[query.start] = open;
+		tCostSoFar[query.start] = 0.0f;
+		tParent[query.start] = query.start;
+		tOpen.push_back({ 0.0f, query.start });
+
+		size_t numExpanded = 0;
+		while (!tOpen.empty() && numExpanded < MAX_EXPANDED_CELLS)
+		{
+			std::pop_heap(tOpen.begin(), tOpen.end(), std::greater<OpenNode>());
+			const uint32_t cell = tOpen.back().cell;
+			tOpen.pop_back();
+			if (tStamp[cell] == closed)
+				continue;
+			tStamp[cell] = closed;
+			++numExpanded;
+			if (cell == query.goal)
+				break;
+
+			const int x = static_cast<int>(cell % _width), y = static_cast<int>(cell / _width);
+			for (int direction = 0; direction < 8; ++direction)
+			{
+				const int neighborX = x + OFFSET_X[direction], neighborY = y + OFFSET_Y[direction];
+				if (neighborX < 0 || neighborY < 0 || neighborX >= _width || neighborY >= _height)
+					continue;
+				const uint32_t neighbor = static_cast<uint32_t>(neighborY * _width + neighborX);
+				if (tStamp[neighbor] == closed || isBlocked(neighbor))
+					continue;
+				//! No diagonal steps past a blocked corner.
+				if (OFFSET_X[direction] != 0 && OFFSET_Y[direction] != 0 &&
+					(isBlocked(static_cast<uint32_t>(y * _width + neighborX)) || isBlocked(static_cast<uint32_t>(neighborY * _width + x))))
+					continue;
+
+				const float costSoFar = tCostSoFar[cell] + _cellSize * DISTANCE[direction] * 0.5f * (_cost[cell] + _cost[neighbor]);
+				if (tStamp[neighbor] == open && costSoFar >= tCostSoFar[neighbor])
+					continue;
+				tStamp[neighbor] = open;
+				tCostSoFar[neighbor] = costSoFar;
+				tParent[neighbor] = cell;
+				tOpen.push_back({ costSoFar + _cellSize * GetOctileDistance(goalX - neighborX, goalY - neighborY), neighbor });
+				std::push_heap(tOpen.begin(), tOpen.end(), std::greater<OpenNode>());
+			}
+		}
+
+		if (tStamp[query.goal] != closed)
+			return;
+		path.cost = tCostSoFar[query.goal];
+		for (uint32_t cell = query.goal; cell != query.start; cell = tParent[cell])
+			path.cells.push_back(cell);
+		path.cells.push_back(query.start);
+		std::reverse(path.cells.begin(), path.cells.end());
+	}
+
+};
@@ -0,0 +1,203 @@
+#include <Simulation/RadiantHeat.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+namespace
+{
+	//! Per-thread tile buffers reused across ConvolveTile calls.
+	thread_local std::vector<float> tTileField;
+	thread_local std::vector<Simulation::Complex> tTileSpectrum;
+	thread_local std::vector<char> tRowActive;
+};
+
+namespace Simulation {
+
+	RadiantHeat::RadiantHeat()
+		: _width(0), _height(0), _radius(0), _fftSize(0), _tileSize(0), _numTilesX(0), _numTilesY(0)
+	{
+		//! Do nothing
+	}
+
+	RadiantHeat::~RadiantHeat()
+	{
+		//! Do nothing
+	}
+
+	bool RadiantHeat::Initialize(int width, int height, int radius, const Profile& profile)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (width <= 0 || height <= 0 || radius < 0)
+		{
+			std::cerr << "Invalid radiant heat configuration " << width << "x" << height << " radius " << radius << std::endl;
+			return false;
+		}
+
+		_width = width;
+		_height = height;
+		_radius = radius;
+
+		const int kernelExtent = 2 * radius + 1;
+		_kernel.assign(kernelExtent * kernelExtent, 0.0f);
+		for (int dy = -radius; dy <= radius; ++dy)
+			for (int dx = -radius; dx <= radius; ++dx)
+			{
+				const float distance = std::sqrt(static_cast<float>(dx * dx + dy * dy));
+				if (distance <= static_cast<float>(radius))
+					_kernel[(dy + radius) * kernelExtent + (dx + radius)] = profile(distance);
+			}
+
+		//! The tile footprint is T + 2R and tiles of the same parity must not overlap, so T >= 2R.
+		//! With N >= 4R the tile T = N - 2R satisfies both, 64 keeps small kernels from degenerating.
+		_fftSize = static_cast<int>(NextPowerOfTwo(std::max(64, 4 * radius)));
+		_tileSize = _fftSize - 2 * radius;
+		_numTilesX = (width + _tileSize - 1) / _tileSize;
+		_numTilesY = (height + _tileSize - 1) / _tileSize;
+
+		if (!_tileFFT.Initialize(_fftSize, _fftSize))
+			return false;
+
+		//! Kernel wrapped around the origin so the circular convolution is centered.
+		std::vector<float> wrappedKernel(_fftSize * _fftSize, 0.0f);
+		for (int dy = -radius; dy <= radius; ++dy)
+			for (int dx = -radius; dx <= radius; ++dx)
+			{
+				const int wx = (dx + _fftSize) % _fftSize;
+				const int wy = (dy + _fftSize) % _fftSize;
+				wrappedKernel[wy * _fftSize + wx] = _kernel[(dy + radius) * kernelExtent + (dx + radius)];
+			}
+
+		_kernelSpectrum.resize(_tileFFT.GetSpectrumSize());
+		_tileFFT.Forward(wrappedKernel.data(), _kernelSpectrum.data());
+
+		return true;
+	}
+
+	void RadiantHeat::Apply(const float* intensity, float* heat) const
+	{
+		GL3::ProfileScope scope("RadiantHeat::Apply", static_cast<uint64_t>(_width) * _height);
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (_radius >= FFT_CROSSOVER_RADIUS)
+			ApplyFFT(intensity, heat);
+		else
+			ApplyDirect(intensity, heat);
+	}
+
+	void RadiantHeat::ApplyDirect(const float* intensity, float* heat) const
+	{
+		const int kernelExtent = 2 * _radius + 1;
+
+		//! Rows without any burning cell contribute nothing, skip them in the gather.
+		std::vector<char>& rowActive = tRowActive;
+		rowActive.assign(_height, 0);
+		for (int y = 0; y < _height; ++y)
+		{
+			const float* row = intensity + y * _width;
+			rowActive[y] = std::any_of(row, row + _width, [](float value) { return value != 0.0f; });
+		}
+
+		GL3::JobSystem::GetInstance().ParallelFor(_height, [&](size_t rowIndex)
+		{
+			const int y = static_cast<int>(rowIndex);
+			float* out = heat + y * _width;
+			std::fill(out, out + _width, 0.0f);
+
+			const int minDY = std::max(-_radius, -y);
+			const int maxDY = std::min(_radius, _height - 1 - y);
+			for (int dy = minDY; dy <= maxDY; ++dy)
+			{
+				if (!rowActive[y + dy])
+					continue;
+
+				const float* source = intensity + (y + dy) * _width;
+				const float* weights = _kernel.data() + (dy + _radius) * kernelExtent + _radius;
+				for (int x = 0; x < _width; ++x)
+				{
+					const int minDX = std::max(-_radius, -x);
+					const int maxDX = std::min(_radius, _width - 1 - x);
+					float sum = 0.0f;
+					for (int dx = minDX; dx <= maxDX; ++dx)
+						sum += source[x + dx] * weights[dx];
+					out[x] += sum;
+				}
+			}
+		});
+	}
+
+	void RadiantHeat::ApplyFFT(const float* intensity, float* heat) const
+	{
+		std::fill(heat, heat + _width * _height, 0.0f);
+
+		//! Four parity phases, tiles inside a phase have disjoint footprints and accumulate without races.
+		std::vector<std::pair<int, int>> phaseTiles;
+		for (int phase = 0; phase < 4; ++phase)
+		{
+			phaseTiles.clear();
+			for (int tileY = phase >> 1; tileY < _numTilesY; tileY += 2)
+				for (int tileX = phase & 1; tileX < _numTilesX; tileX += 2)
+					phaseTiles.emplace_back(tileX, tileY);
+
+			GL3::JobSystem::GetInstance().ParallelFor(phaseTiles.size(), [&](size_t index)
+			{
+				ConvolveTile(phaseTiles[index].first, phaseTiles[index].second, intensity, heat);
+			});
+		}
+	}
+
+	void RadiantHeat::ConvolveTile(int tileX, int tileY, const float* intensity, float* heat) const
+	{
+		const int originX = tileX * _tileSize;
+		const int originY = tileY * _tileSize;
+		const int extentX = std::min(_tileSize, _width - originX);
+		const int extentY = std::min(_tileSize, _height - originY);
+
+		tTileField.assign(_fftSize * _fftSize, 0.0f);
+		bool bEmpty = true;
+		for (int y = 0; y < extentY; ++y)
+		{
+			const float* source = intensity + (originY + y) * _width + originX;
+			float* dest = tTileField.data() + y * _fftSize;
+			for (int x = 0; x < extentX; ++x)
+			{
+				dest[x] = source[x];
+				bEmpty &= (source[x] == 0.0f);
+			}
+		}
+
+		//! Tiles without burning cells radiate nothing.
+		if (bEmpty)
+			return;
+
+		tTileSpectrum.resize(_tileFFT.GetSpectrumSize());
+		_tileFFT.Forward(tTileField.data(), tTileSpectrum.data());
+		for (size_t i = 0; i < tTileSpectrum.size(); ++i)
+			tTileSpectrum[i] *= _kernelSpectrum[i];
+		_tileFFT.Inverse(tTileSpectrum.data(), tTileField.data());
+
+		//! The linear convolution of the tile spans [-R, extent + R), wrapped into the FFT buffer.
+		const int minY = std::max(-_radius, -originY);
+		const int maxY = std::min(extentY + _radius, _height - originY);
+		const int minX = std::max(-_radius, -originX);
+		const int maxX = std::min(extentX + _radius, _width - originX);
+		for (int y = minY; y < maxY; ++y)
+		{
+			const float* source = tTileField.data() + ((y + _fftSize) % _fftSize) * _fftSize;
+			float* dest = heat + (originY + y) * _width + originX;
+			for (int x = minX; x < maxX; ++x)
+				dest[x] += source[(x + _fftSize) % _fftSize];
+		}
+	}
+
+	RadiantHeat::Profile RadiantHeat::InverseSquareProfile(float flameHeight)
+	{
+		const float heightSquared = flameHeight * flameHeight;
+		return [heightSquared](float distance)
+		{
+			return 1.0f / (distance * distance + heightSquared);
+		};
+	}
+
+};
@@ -0,0 +1,533 @@
+#include <Simulation/ScenarioGenerator.hpp>
+#include <Simulation/AdaptiveFireSpread.hpp>
+#include <Simulation/CrownFire.hpp>
+#include <Simulation/FireSpread.hpp>
+#include <Simulation/MeshFireSpread.hpp>
+#include <Simulation/TiledFireSpread.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MeshGraph.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+	//! SplitMix64 finalizer
+	inline uint64_t Mix(uint64_t value)
+	{
+		value += 0x9E3779B97F4A7C15ull;
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+		return value ^ (value >> 31);
+	}
+
+	//! Random bits of a lattice point, independent per seed and channel
+	inline uint64_t Hash(uint64_t seed, int x, int y, uint32_t channel)
+	{
+		const uint64_t point = (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+		return Mix(seed ^ Mix(point ^ Mix(channel)));
+	}
+
+	//! Uniform float in [0, 1) from the top 24 bits, exact on every platform
+	inline float Uniform(uint64_t hash)
+	{
+		return static_cast<float>(hash >> 40) * (1.0f / 16777216.0f);
+	}
+
+	//! Bilinear value noise with smoothstep weights, lattice spacing period cells
+	float ValueNoise(uint64_t seed, uint32_t octave, int x, int y, int period)
+	{
+		const int latticeX = x / period, latticeY = y / period;
+		float tx = static_cast<float>(x - latticeX * period) / static_cast<float>(period);
+		float ty = static_cast<float>(y - latticeY * period) / static_cast<float>(period);
+		tx = tx * tx * (3.0f - 2.0f * tx);
+		ty = ty * ty * (3.0f - 2.0f * ty);
+
+		const float v00 = Uniform(Hash(seed, latticeX, latticeY, octave));
+		const float v10 = Uniform(Hash(seed, latticeX + 1, latticeY, octave));
+		const float v01 = Uniform(Hash(seed, latticeX, latticeY + 1, octave));
+		const float v11 = Uniform(Hash(seed, latticeX + 1, latticeY + 1, octave));
+		const float bottom = v00 + (v10 - v00) * tx;
+		const float top = v01 + (v11 - v01) * tx;
+		return bottom + (top - bottom) * ty;
+	}
+
+	//! Hash channels of the generators, keeps the streams of one seed independent
+	enum Channel : uint32_t
+	{
+		ForestChannel = 0x100,
+		MosaicChannel = 0x200,
+		TerrainChannel = 0x300,
+		CanopyChannel = 0x400
+	};
+
+	std::vector<Simulation::Scenario> MakeStandardScenarios()
+	{
+		using Simulation::WindPreset;
+		//! name, size, cell size, seed, forest density, relief, patch size, wind, west edge, steps, dt,
+		//! landscape and fire digests, then tiled, tiled focus, adaptive, subcycled, crown and mesh digests
+		return {
+			{ "percolation-critical-256", 256, 10.0f, 1, 0.42f, 0.0f, 0.0f, WindPreset::Calm, true, 1500, 10.0f, 0x371d714ad14ca8c9ull, 0x81236ff30f21e132ull,
+			  0xa81506292d811862ull, 0x3d83ce7abab71bc4ull, 0xa6927957c46930e1ull, 0x3ba13f8c28979f29ull, 0x0ull, 0x0efa66a594116ddcull },
+			{ "percolation-critical-1024", 1024, 10.0f, 1, 0.42f, 0.0f, 0.0f, WindPreset::Calm, true, 1500, 10.0f, 0xff0913a7e1821356ull, 0x0455f9c0fb2eff3cull,
+			  0xb1cba13856470541ull, 0x88132142987ac343ull, 0x0fcfd3ee2607447eull, 0x92d1c7aca25ea423ull, 0x0ull, 0x211beb0a64fe0df7ull },
+			{ "percolation-dense-256", 256, 10.0f, 2, 0.6f, 0.0f, 0.0f, WindPreset::Breeze, true, 1000, 10.0f, 0x2604af0b6bbb0456ull, 0xc7550619cded5d05ull,
+			  0x2838ed85f01882f1ull, 0x2838ed85f01882f1ull, 0xf4c8470949a5bf00ull, 0x904ad18d26471cfdull, 0x0ull, 0x64e57230d1fbf0fcull },
+			{ "percolation-dense-1024", 1024, 10.0f, 2, 0.6f, 0.0f, 0.0f, WindPreset::Breeze, true, 2000, 10.0f, 0xd9b3abad4ed0d407ull, 0x4339948aad3edeceull,
+			  0xc8ed27fca787539dull, 0xf3045a4dcbecebb4ull, 0x58c90a5c440398baull, 0xdd269826f7bb57a4ull, 0x0ull, 0x7c0155e11216c161ull },
+			{ "terrain-mosaic-256", 256, 10.0f, 3, 0.0f, 300.0f, 16.0f, WindPreset::Strong, false, 600, 1.0f, 0x556472176602aba7ull, 0xadf658b241b73ee3ull,
+			  0xd182f8b51abbefc6ull, 0x9f21ad07e3611968ull, 0xcf7034c7c964df46ull, 0x0033e8a1e686227cull, 0x40d86a6e780c7e73ull, 0x50847e2d46bc2286ull },
+			{ "terrain-mosaic-1024", 1024, 10.0f, 3, 0.0f, 1200.0f, 32.0f, WindPreset::Strong, false, 2000, 1.0f, 0x2d514f7b288e2258ull, 0x59a1ea4234e99c6cull,
+			  0x832aa7fb9aebcc96ull, 0x9c3a151639452d1aull, 0x70c91467bc125d35ull, 0x675e414568b463b8ull, 0xe06dbd8529365d68ull, 0xe620d55213f29062ull },
+			{ "terrain-mosaic-gale-512", 512, 10.0f, 4, 0.0f, 600.0f, 24.0f, WindPreset::Gale, false, 1500, 0.5f, 0xe89595227eb810c7ull, 0x225ef75e5ed122efull,
+			  0x6d28ccd8d99e385dull, 0x742320836c927b42ull, 0x3f25cac6b8734ef3ull, 0xdba37e0835e53daeull, 0xb9ccd09e982bf574ull, 0x66ac6149335b9c80ull },
+		};
+	}
+
+	//! Shared by the fire engines, which all have Initialize(landscape) and Ignite(x, y)
+	template <typename Fire>
+	bool IgniteScenario(const Simulation::Scenario& scenario, const Simulation::Landscape& landscape, Fire& fire)
+	{
+		if (!fire.Initialize(landscape))
+			return false;
+
+		bool bIgnited = false;
+		if (scenario.bIgniteWestEdge)
+		{
+			for (int y = 0; y < landscape.height; ++y)
+				bIgnited |= fire.Ignite(0, y);
+		}
+		else
+		{
+			//! Search rings around the center for the closest fuel and ignite the 3x3 cells around it.
+			const int centerX = landscape.width / 2, centerY = landscape.height / 2;
+			const int maxRadius = std::max(landscape.width, landscape.height) / 2;
+			for (int radius = 0; radius <= maxRadius && !bIgnited; ++radius)
+			{
+				for (int y = centerY - radius; y <= centerY + radius && !bIgnited; ++y)
+				{
+					for (int x = centerX - radius; x <= centerX + radius && !bIgnited; ++x)
+					{
+						const bool bOnRing = std::abs(x - centerX) == radius || std::abs(y - centerY) == radius;
+						if (!bOnRing || x < 0 || y < 0 || x >= landscape.width || y >= landscape.height ||
+							landscape.fuel[static_cast<size_t>(y) * landscape.width + x] == Simulation::NonBurnable)
+							continue;
+						for (int j = -1; j <= 1; ++j)
+							for (int i = -1; i <= 1; ++i)
+								bIgnited |= fire.Ignite(x + i, y + j);
+					}
+				}
+			}
+		}
+
+		if (!bIgnited)
+			std::cerr << "Scenario " << scenario.name << " has no fuel at its ignition" << std::endl;
+		return bIgnited;
+	}
+
+	//! Lights the nodes of the terrain mesh in place of the cells of a grid engine
+	struct MeshIgnition
+	{
+		const GL3::MeshGraph& graph;
+		Simulation::MeshFireSpread& fire;
+		const Simulation::Landscape* landscape;
+
+		bool Initialize(const Simulation::Landscape& source)
+		{
+			landscape = &source;
+			const std::vector<uint32_t>& vertexNodes = graph.GetVertexNodes();
+			if (vertexNodes.size() != source.GetNumCells())
+				return false;
+			std::vector<float> spreadRates(graph.GetNumNodes(), 0.0f);
+			float burnTime = 0.0f;
+			for (size_t cell = 0; cell < vertexNodes.size(); ++cell)
+			{
+				const Simulation::FuelModel& model = Simulation::GetFuelModel(source.fuel[cell]);
+				spreadRates[vertexNodes[cell]] = model.spreadRate;
+				if (source.fuel[cell] != Simulation::NonBurnable)
+					burnTime = std::max(burnTime, model.burnTime);
+			}
+			return fire.Initialize(graph, spreadRates, burnTime);
+		}
+
+		bool Ignite(int x, int y)
+		{
+			if (x < 0 || y < 0 || x >= landscape->width || y >= landscape->height)
+				return false;
+			const size_t cell = static_cast<size_t>(y) * landscape->width + x;
+			if (landscape->fuel[cell] == Simulation::NonBurnable)
+				return false;
+			fire.Ignite(graph.GetVertexNodes()[cell]);
+			return true;
+		}
+	};
+
+	//! Lights the cells of the refined landscape under a landscape cell, like AdaptiveFireSpread::Ignite()
+	struct RefinedIgnition
+	{
+		Simulation::FireSpread& fire;
+		const Simulation::Landscape& refined;
+		int factor;
+
+		bool Initialize(const Simulation::Landscape&)
+		{
+			return fire.Initialize(refined);
+		}
+
+		bool Ignite(int x, int y)
+		{
+			bool bIgnited = false;
+			for (int j = 0; j < factor; ++j)
+				for (int i = 0; i < factor; ++i)
+					bIgnited |= fire.Ignite(x * factor + i, y * factor + j);
+			return bIgnited;
+		}
+	};
+
+	//! The tiled engine integrates in continuous time, so its burned area is checked against FireSpread
+	//! in steps this many times shorter, within the tolerance as a fraction of the reference area
+	constexpr int TILED_REFERENCE_SUBSTEPS = 16;
+	constexpr double TILED_AREA_TOLERANCE = 0.025;
+
+	//! Returns the cells burning or burned in exactly one of the two state grids, both sharing the
+	//! FireSpread::CellState values
+	size_t CountAreaDifference(const std::vector<uint8_t>& state, const std::vector<uint8_t>& reference)
+	{
+		size_t count = 0;
+		for (size_t cell = 0; cell < state.size(); ++cell)
+			count += (state[cell] >= Simulation::FireSpread::Burning) != (reference[cell] >= Simulation::FireSpread::Burning);
+		return count;
+	}
+
+	//! Print one burned area check of Verify(), returns whether the difference is within the tolerance
+	bool PrintAreaError(std::ostream& stream, const std::string& name, size_t difference, size_t area, double tolerance, const std::string& note)
+	{
+		const double error = area > 0 ? static_cast<double>(difference) / static_cast<double>(area) : 0.0;
+		const bool bMatches = error <= tolerance;
+		stream << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(2) << std::setw(17) << 100.0 * error
+			   << "%" << (bMatches ? " ok" : " MISMATCH") << note << std::endl;
+		stream.unsetf(std::ios::fixed);
+		return bMatches;
+	}
+
+	//! Print one digest of Verify(), returns whether it matches the expected one
+	bool PrintDigest(std::ostream& stream, const std::string& name, uint64_t digest, uint64_t expected, const std::string& note = std::string())
+	{
+		const bool bMatches = digest == expected;
+		stream << "  " << std::left << std::setw(28) << name << std::right << std::hex << std::setfill('0') << " 0x" << std::setw(16) << digest
+			   << std::dec << std::setfill(' ') << (bMatches ? " ok" : " MISMATCH") << note << std::endl;
+		return bMatches;
+	}
+};
+
+namespace Simulation {
+
+	void ScenarioGenerator::GeneratePercolationForest(Landscape& landscape, float density, uint64_t seed, uint8_t fuel)
+	{
+		GL3::JobSystem::GetInstance().ParallelFor(landscape.height, [&](size_t row)
+		{
+			const int y = static_cast<int>(row);
+			for (int x = 0; x < landscape.width; ++x)
+			{
+				const bool bTree = Uniform(Hash(seed, x, y, ForestChannel)) < density;
+				landscape.fuel[row * landscape.width + x] = bTree ? fuel : NonBurnable;
+			}
+		});
+	}
+
+	void ScenarioGenerator::GenerateFractalTerrain(Landscape& landscape, float relief, float roughness, uint64_t seed)
+	{
+		//! Octaves from a quarter of the landscape down to two cells
+		std::vector<int> periods;
+		float amplitudeSum = 0.0f, amplitude = 1.0f;
+		for (int period = std::max(2, std::max(landscape.width, landscape.height) / 4); period >= 2; period /= 2)
+		{
+			periods.push_back(period);
+			amplitudeSum += amplitude;
+			amplitude *= roughness;
+		}
+		const float scale = relief / amplitudeSum;
+
+		GL3::JobSystem::GetInstance().ParallelFor(landscape.height, [&](size_t row)
+		{
+			const int y = static_cast<int>(row);
+			for (int x = 0; x < landscape.width; ++x)
+			{
+				float height = 0.0f, octaveAmplitude = 1.0f;
+				for (size_t octave = 0; octave < periods.size(); ++octave)
+				{
+					height += octaveAmplitude * ValueNoise(seed, TerrainChannel + static_cast<uint32_t>(octave), x, y, periods[octave]);
+					octaveAmplitude *= roughness;
+				}
+				landscape.elevation[row * landscape.width + x] = height * scale;
+			}
+		});
+	}
+
+	void ScenarioGenerator::GenerateFuelMosaic(Landscape& landscape, float patchSize, uint64_t seed)
+	{
+		//! One jittered Voronoi site per patch cell, the nearest site is always within the 3x3 patch cells around.
+		const float size = std::max(1.0f, patchSize);
+		GL3::JobSystem::GetInstance().ParallelFor(landscape.height, [&](size_t row)
+		{
+			const int y = static_cast<int>(row);
+			const int patchY = static_cast<int>(std::floor((y + 0.5f) / size));
+			for (int x = 0; x < landscape.width; ++x)
+			{
+				const int patchX = static_cast<int>(std::floor((x + 0.5f) / size));
+				const glm::vec2 point(x + 0.5f, y + 0.5f);
+				float nearestDistance = std::numeric_limits<float>::max();
+				uint64_t nearestHash = 0;
+				for (int j = -1; j <= 1; ++j)
+				{
+					for (int i = -1; i <= 1; ++i)
+					{
+						const uint64_t hash = Hash(seed, patchX + i, patchY + j, MosaicChannel);
+						const glm::vec2 site = (glm::vec2(patchX + i, patchY + j) + glm::vec2(Uniform(hash), Uniform(Mix(hash)))) * size;
+						const float distance = glm::dot(point - site, point - site);
+						if (distance < nearestDistance)
+						{
+							nearestDistance = distance;
+							nearestHash = hash;
+						}
+					}
+				}
+
+				//! One patch in ten is non-burnable, the rest picks a fuel type uniformly.
+				const uint64_t fuelHash = Mix(Mix(nearestHash));
+				uint8_t fuel = NonBurnable;
+				if (Uniform(fuelHash) >= 0.1f)
+					fuel = static_cast<uint8_t>(std::min<int>(NumFuelTypes - 1, 1 + static_cast<int>(Uniform(Mix(fuelHash)) * (NumFuelTypes - 1))));
+				landscape.fuel[row * landscape.width + x] = fuel;
+			}
+		});
+	}
+
+	void ScenarioGenerator::GenerateCanopy(const Landscape& landscape, uint64_t seed, Canopy& canopy)
+	{
+		canopy.baseHeight.assign(landscape.GetNumCells(), 0.0f);
+		canopy.topHeight.assign(landscape.GetNumCells(), 0.0f);
+		GL3::JobSystem::GetInstance().ParallelFor(landscape.height, [&](size_t row)
+		{
+			const int y = static_cast<int>(row);
+			for (int x = 0; x < landscape.width; ++x)
+			{
+				const size_t cell = row * landscape.width + x;
+				if (landscape.fuel[cell] != TimberLitter)
+					continue;
+				canopy.topHeight[cell] = 12.0f + 16.0f * ValueNoise(seed, CanopyChannel, x, y, 16);
+				canopy.baseHeight[cell] = 1.0f + 6.0f * ValueNoise(seed, CanopyChannel + 1, x, y, 8);
+			}
+		});
+	}
+
+	glm::vec2 ScenarioGenerator::GetWind(WindPreset preset)
+	{
+		switch (preset)
+		{
+		case WindPreset::Breeze:
+			return glm::vec2(3.0f, 0.0f);
+		case WindPreset::Strong:
+			return glm::vec2(8.0f, 0.0f);
+		case WindPreset::Gale:
+			return glm::vec2(15.0f, 0.0f);
+		default:
+			return glm::vec2(0.0f);
+		}
+	}
+
+	void ScenarioGenerator::GenerateTerrainMesh(const Landscape& landscape, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices)
+	{
+		const int width = landscape.width, height = landscape.height;
+		positions.resize(landscape.GetNumCells());
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const size_t cell = static_cast<size_t>(y) * width + x;
+				positions[cell] = glm::vec3((x + 0.5f) * landscape.cellSize, landscape.elevation[cell], (y + 0.5f) * landscape.cellSize);
+			}
+		}
+
+		indices.clear();
+		indices.reserve(static_cast<size_t>(std::max(0, width - 1)) * std::max(0, height - 1) * 6);
+		for (int y = 0; y + 1 < height; ++y)
+		{
+			for (int x = 0; x + 1 < width; ++x)
+			{
+				const unsigned int corner = static_cast<unsigned int>(y * width + x);
+				const unsigned int right = corner + 1, below = corner + width, diagonal = below + 1;
+				indices.insert(indices.end(), { corner, below, right, right, below, diagonal });
+			}
+		}
+	}
+
+	glm::vec2 ScenarioGenerator::GetFocusCenter(const Landscape& landscape)
+	{
+		return glm::vec2(landscape.width, landscape.height) * (0.5f * landscape.cellSize);
+	}
+
+	float ScenarioGenerator::GetFocusRadius(const Landscape& landscape)
+	{
+		return std::max(landscape.width, landscape.height) * landscape.cellSize / 8.0f;
+	}
+
+	const std::vector<Scenario>& ScenarioGenerator::GetStandardScenarios()
+	{
+		static const std::vector<Scenario> scenarios = MakeStandardScenarios();
+		return scenarios;
+	}
+
+	bool ScenarioGenerator::Generate(const Scenario& scenario, Landscape& landscape)
+	{
+		GL3::ProfileScope scope("ScenarioGenerator::Generate", static_cast<uint64_t>(scenario.size) * scenario.size);
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (!landscape.Initialize(scenario.size, scenario.size, scenario.cellSize))
+			return false;
+
+		if (scenario.terrainRelief > 0.0f)
+			GenerateFractalTerrain(landscape, scenario.terrainRelief, 0.5f, scenario.seed);
+		if (scenario.forestDensity > 0.0f)
+			GeneratePercolationForest(landscape, scenario.forestDensity, scenario.seed);
+		else
+			GenerateFuelMosaic(landscape, scenario.patchSize, scenario.seed);
+		landscape.wind = GetWind(scenario.wind);
+
+		return true;
+	}
+
+	bool ScenarioGenerator::Ignite(const Scenario& scenario, const Landscape& landscape, FireSpread& fire)
+	{
+		return IgniteScenario(scenario, landscape, fire);
+	}
+
+	bool ScenarioGenerator::Ignite(const Scenario& scenario, const Landscape& landscape, TiledFireSpread& fire)
+	{
+		return IgniteScenario(scenario, landscape, fire);
+	}
+
+	bool ScenarioGenerator::Ignite(const Scenario& scenario, const Landscape& landscape, AdaptiveFireSpread& fire)
+	{
+		return IgniteScenario(scenario, landscape, fire);
+	}
+
+	bool ScenarioGenerator::Ignite(const Scenario& scenario, const Landscape& landscape, const GL3::MeshGraph& graph, MeshFireSpread& fire)
+	{
+		MeshIgnition ignition = { graph, fire, nullptr };
+		return IgniteScenario(scenario, landscape, ignition);
+	}
+
+	bool ScenarioGenerator::Verify(const Scenario& scenario, std::ostream& stream)
+	{
+		Landscape landscape;
+		if (!Generate(scenario, landscape))
+			return false;
+		stream << scenario.name << std::endl;
+		bool bVerified = PrintDigest(stream, "Landscape", landscape.GetDigest(), scenario.landscapeDigest);
+
+		FireSpread fire;
+		if (!Ignite(scenario, landscape, fire))
+			return false;
+		for (int step = 0; step < scenario.numSteps; ++step)
+			fire.Step(scenario.dt);
+		const size_t numBurned = std::count(fire.GetState().begin(), fire.GetState().end(), FireSpread::Burned);
+		bVerified &= PrintDigest(stream, "FireSpread", fire.GetDigest(), scenario.fireDigest,
+								 " (" + std::to_string(numBurned) + " burned, " + std::to_string(fire.GetNumBurning()) + " burning)");
+
+		//! Both tiled runs have to burn the area of the surface engine once its steps are short enough,
+		//! which also catches fire lost at tile boundaries.
+		FireSpread referenceFire;
+		if (!Ignite(scenario, landscape, referenceFire))
+			return false;
+		for (int step = 0; step < scenario.numSteps * TILED_REFERENCE_SUBSTEPS; ++step)
+			referenceFire.Step(scenario.dt / TILED_REFERENCE_SUBSTEPS);
+		const size_t referenceArea = std::count_if(referenceFire.GetState().begin(), referenceFire.GetState().end(),
+												   [](uint8_t state) { return state >= FireSpread::Burning; });
+		const std::string referenceNote = " against FireSpread in dt / " + std::to_string(TILED_REFERENCE_SUBSTEPS);
+
+		for (bool bFocus : { false, true })
+		{
+			TiledFireSpread tiled;
+			if (!Ignite(scenario, landscape, tiled))
+				return false;
+			if (bFocus)
+				tiled.SetFocus(GetFocusCenter(landscape), GetFocusRadius(landscape));
+			for (int step = 0; step < scenario.numSteps; ++step)
+				tiled.Step(scenario.dt);
+			const std::string name = bFocus ? "TiledFireSpread focus" : "TiledFireSpread";
+			bVerified &= PrintDigest(stream, name, tiled.GetDigest(), bFocus ? scenario.tiledFocusDigest : scenario.tiledDigest);
+			bVerified &= PrintAreaError(stream, name + " area", CountAreaDifference(tiled.GetState(), referenceFire.GetState()), referenceArea,
+										TILED_AREA_TOLERANCE, referenceNote);
+		}
+
+		//! In fixed steps the adaptive grid burns cell for cell like the landscape it refines to.
+		{
+			const int factor = 1 << AdaptiveFireSpread::MAX_LEVEL;
+			AdaptiveFireSpread adaptive;
+			Landscape refined;
+			FireSpread refinedFire;
+			RefinedIgnition ignition = { refinedFire, refined, factor };
+			if (!Ignite(scenario, landscape, adaptive) || !landscape.Refine(factor, refined) || !IgniteScenario(scenario, landscape, ignition))
+				return false;
+			for (int step = 0; step < scenario.numSteps; ++step)
+			{
+				adaptive.Step(scenario.dt);
+				refinedFire.Step(scenario.dt);
+			}
+			bVerified &= PrintDigest(stream, "AdaptiveFireSpread", adaptive.GetDigest(), scenario.adaptiveDigest);
+			bVerified &= PrintDigest(stream, "AdaptiveFireSpread refined", adaptive.GetRefinedDigest(), refinedFire.GetDigest(), " against FireSpread");
+		}
+
+		//! Subcycled tiles take substeps of their own, which only the run itself reproduces.
+		{
+			AdaptiveFireSpread subcycled;
+			if (!Ignite(scenario, landscape, subcycled))
+				return false;
+			subcycled.SetSubcycling(true);
+			for (int step = 0; step < scenario.numSteps; ++step)
+				subcycled.Step(scenario.dt);
+			const AdaptiveFireSpread::StepStatistics& statistics = subcycled.GetStepStatistics();
+			bVerified &= PrintDigest(stream, "AdaptiveFireSpread subcycled", subcycled.GetDigest(), scenario.subcycledDigest,
+									 " (" + std::to_string(statistics.numTileSteps) + " tile steps in " + std::to_string(statistics.numTileSubsteps) + " substeps)");
+		}
+
+		//! The canopy layer only grows on the timber stands of the fuel mosaics.
+		if (scenario.forestDensity <= 0.0f)
+		{
+			Canopy canopy;
+			CrownFire crownFire;
+			FireSpread surfaceFire;
+			GenerateCanopy(landscape, scenario.seed, canopy);
+			if (!crownFire.Initialize(landscape, canopy) || !Ignite(scenario, landscape, surfaceFire))
+				return false;
+			for (int step = 0; step < scenario.numSteps; ++step)
+			{
+				surfaceFire.Step(scenario.dt);
+				crownFire.Step(surfaceFire, scenario.dt);
+			}
+			bVerified &= PrintDigest(stream, "CrownFire", crownFire.GetDigest(), scenario.crownDigest);
+		}
+
+		{
+			std::vector<glm::vec3> positions;
+			std::vector<unsigned int> indices;
+			GL3::MeshGraph graph;
+			MeshFireSpread meshFire;
+			GenerateTerrainMesh(landscape, positions, indices);
+			if (!graph.Build(positions, indices) || !Ignite(scenario, landscape, graph, meshFire))
+				return false;
+			for (int step = 0; step < scenario.numSteps; ++step)
+				meshFire.Step(scenario.dt);
+			bVerified &= PrintDigest(stream, "MeshFireSpread", meshFire.GetDigest(), scenario.meshDigest,
+									 " (" + std::to_string(meshFire.GetNumBurned()) + " burned, " + std::to_string(meshFire.GetNumBurning()) + " burning)");
+		}
+
+		return bVerified;
+	}
+
+};
@@ -0,0 +1,320 @@
+#include <Simulation/SmokeTransport.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <GL3/Texture.hpp>
+#include <glad/glad.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cmath>
+
+namespace
+{
+	//! Lines advected by a single job, keeps the per-job overhead small on thin grids.
+	constexpr int LINES_PER_JOB = 64;
+	//! Courant number each advection sweep is kept under.
+	constexpr float MAX_COURANT = 0.9f;
+
+	//! Per-thread line buffers for the advection sweeps.
+	thread_local std::vector<float> tLine;
+	thread_local std::vector<float> tLineVelocity;
+	thread_local std::vector<float> tFlux;
+	thread_local std::vector<float> tOutflowScale;
+
+	//! van Leer limited slope of the two one-sided differences, zero at extrema.
+	inline float VanLeerSlope(float upwindDelta, float delta)
+	{
+		const float product = upwindDelta * delta;
+		return product > 0.0f ? 2.0f * product / (upwindDelta + delta) : 0.0f;
+	}
+};
+
+namespace Simulation {
+
+	SmokeTransport::SmokeTransport()
+		: _cellSize(1.0f), _diffusivity(0.0f), _maxWindComponent(0.0f),
+		  _width(0), _height(0), _depth(0), _numSubSteps(0), _sweepParity(0)
+	{
+		//! Do nothing
+	}
+
+	SmokeTransport::~SmokeTransport()
+	{
+		//! Do nothing
+	}
+
+	bool SmokeTransport::Initialize(int width, int height, int depth, float cellSize)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (width <= 0 || height <= 0 || depth <= 0 || cellSize <= 0.0f)
+		{
+			std::cerr << "Invalid smoke grid " << width << "x" << height << "x" << depth << " cell size " << cellSize << std::endl;
+			return false;
+		}
+
+		_width = width;
+		_height = height;
+		_depth = depth;
+		_cellSize = cellSize;
+
+		const size_t numCells = static_cast<size_t>(width) * height * depth;
+		_concentration.assign(numCells, 0.0f);
+		_scratch.assign(numCells, 0.0f);
+		_wind.assign(numCells, glm::vec3(0.0f));
+		_emission.assign(static_cast<size_t>(width) * height, 0.0f);
+		_maxWindComponent = 0.0f;
+
+		return true;
+	}
+
+	void SmokeTransport::SetWind(const glm::vec3& wind)
+	{
+		std::fill(_wind.begin(), _wind.end(), wind);
+		_maxWindComponent = std::max({ std::fabs(wind.x), std::fabs(wind.y), std::fabs(wind.z) });
+	}
+
+	bool SmokeTransport::SetWindField(const std::vector<glm::vec3>& wind)
+	{
+		if (wind.size() != _wind.size())
+		{
+			std::cerr << "Wind field has " << wind.size() << " values, expected " << _wind.size() << std::endl;
+			return false;
+		}
+
+		_wind = wind;
+		_maxWindComponent = 0.0f;
+		for (const auto& velocity : _wind)
+			_maxWindComponent = std::max({ _maxWindComponent, std::fabs(velocity.x), std::fabs(velocity.y), std::fabs(velocity.z) });
+
+		return true;
+	}
+
+	void SmokeTransport::SetDiffusivity(float diffusivity)
+	{
+		_diffusivity = std::max(0.0f, diffusivity);
+	}
+
+	void SmokeTransport::SetEmission(const float* emission)
+	{
+		std::copy(emission, emission + _emission.size(), _emission.begin());
+	}
+
+	void SmokeTransport::Reset()
+	{
+		std::fill(_concentration.begin(), _concentration.end(), 0.0f);
+	}
+
+	void SmokeTransport::Step(float dt)
+	{
+		if (dt <= 0.0f || _concentration.empty())
+			return;
+		GL3::FrameStatistics::GetInstance().Increment(GL3::FrameStatistics::SimulationSteps);
+		GL3::ProfileScope scope("SmokeTransport::Step", _concentration.size());
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+
+		//! Sub-step until every sweep is under the Courant limit and explicit diffusion is stable.
+		const int numAxes = (_width > 1) + (_height > 1) + (_depth > 1);
+		const float courant = _maxWindComponent * dt / _cellSize;
+		const float diffusionNumber = _diffusivity * dt / (_cellSize * _cellSize);
+		const float maxDiffusionNumber = 0.9f / (2.0f * std::max(1, numAxes));
+		_numSubSteps = std::max({ 1,
+								  static_cast<int>(std::ceil(courant / MAX_COURANT)),
+								  static_cast<int>(std::ceil(diffusionNumber / maxDiffusionNumber)) });
+
+		const float subDt = dt / static_cast<float>(_numSubSteps);
+		const size_t groundCells = _emission.size();
+		for (int step = 0; step < _numSubSteps; ++step)
+		{
+			for (size_t i = 0; i < groundCells; ++i)
+				_concentration[i] += _emission[i] * subDt;
+
+			//! Alternate the sweep order to cancel the first order splitting bias.
+			if (_sweepParity == 0)
+			{
+				Advect(0, subDt);
+				Advect(1, subDt);
+				Advect(2, subDt);
+			}
+			else
+			{
+				Advect(2, subDt);
+				Advect(1, subDt);
+				Advect(0, subDt);
+			}
+			_sweepParity ^= 1;
+
+			if (_diffusivity > 0.0f)
+				Diffuse(subDt);
+		}
+	}
+
+	void SmokeTransport::Advect(int axis, float dt)
+	{
+		const int extents[3] = { _width, _height, _depth };
+		const int length = extents[axis];
+		if (length <= 1 || _maxWindComponent == 0.0f)
+			return;
+
+		const size_t strides[3] = { 1, static_cast<size_t>(_width), static_cast<size_t>(_width) * _height };
+		const size_t stride = strides[axis];
+		//! Lines are enumerated by the two remaining axes.
+		const int innerAxis = axis == 0 ? 1 : 0;
+		const int outerAxis = axis == 2 ? 1 : 2;
+		const int numLines = extents[innerAxis] * extents[outerAxis];
+		const int numJobs = (numLines + LINES_PER_JOB - 1) / LINES_PER_JOB;
+		const float courantScale = dt / _cellSize;
+
+		GL3::JobSystem::GetInstance().ParallelFor(numJobs, [&](size_t job)
+		{
+			tLine.resize(length);
+			tLineVelocity.resize(length);
+			tFlux.resize(length + 1);
+			tOutflowScale.resize(length);
+
+			const int lineEnd = std::min(numLines, static_cast<int>(job + 1) * LINES_PER_JOB);
+			for (int line = static_cast<int>(job) * LINES_PER_JOB; line < lineEnd; ++line)
+			{
+				const size_t inner = line % extents[innerAxis];
+				const size_t outer = line / extents[innerAxis];
+				const size_t start = inner * strides[innerAxis] + outer * strides[outerAxis];
+
+				for (int i = 0; i < length; ++i)
+				{
+					tLine[i] = _concentration[start + i * stride];
+					tLineVelocity[i] = _wind[start + i * stride][axis];
+				}
+
+				//! Boundary faces bring clean air in and let smoke out with the boundary cell value,
+				//! the ground face of the vertical axis is closed.
+				const float firstVelocity = (axis == 2) ? 0.0f : tLineVelocity[0];
+				tFlux[0] = firstVelocity < 0.0f ? firstVelocity * courantScale * tLine[0] : 0.0f;
+				const float lastVelocity = tLineVelocity[length - 1];
+				tFlux[length] = lastVelocity > 0.0f ? lastVelocity * courantScale * tLine[length - 1] : 0.0f;
+
+				for (int face = 1; face < length; ++face)
+				{
+					const int left = face - 1;
+					const int right = face;
+					const float courant = 0.5f * (tLineVelocity[left] + tLineVelocity[right]) * courantScale;
+					const float delta = tLine[right] - tLine[left];
+					float faceValue;
+					if (courant >= 0.0f)
+					{
+						const float upwindDelta = left > 0 ? tLine[left] - tLine[left - 1] : 0.0f;
+						faceValue = tLine[left] + 0.5f * (1.0f - courant) * VanLeerSlope(upwindDelta, delta);
+					}
+					else
+					{
+						const float upwindDelta = right + 1 < length ? tLine[right + 1] - tLine[right] : 0.0f;
+						faceValue = tLine[right] - 0.5f * (1.0f + courant) * VanLeerSlope(upwindDelta, delta);
+					}
+					tFlux[face] = courant * faceValue;
+				}
+
+				//! Converging and diverging wind can let a cell lose more than it holds. Every face flux has
+				//! a single donor cell, so scaling the outgoing fluxes of each cell down to its content keeps
+				//! the field non-negative and the mass exact, where clamping the result would add smoke.
+				bool bLimited = false;
+				for (int i = 0; i < length; ++i)
+					bLimited |= std::max(tFlux[i + 1], 0.0f) - std::min(tFlux[i], 0.0f) > tLine[i];
+				if (bLimited)
+				{
+					for (int i = 0; i < length; ++i)
+					{
+						const float outflow = std::max(tFlux[i + 1], 0.0f) - std::min(tFlux[i], 0.0f);
+						const float content = std::max(tLine[i], 0.0f);
+						tOutflowScale[i] = outflow > content ? content / outflow : 1.0f;
+					}
+					for (int face = 0; face <= length; ++face)
+					{
+						if (tFlux[face] > 0.0f && face > 0)
+							tFlux[face] *= tOutflowScale[face - 1];
+						else if (tFlux[face] < 0.0f && face < length)
+							tFlux[face] *= tOutflowScale[face];
+					}
+				}
+
+				for (int i = 0; i < length; ++i)
+					_concentration[start + i * stride] = tLine[i] - (tFlux[i + 1] - tFlux[i]);
+			}
+		});
+	}
+
+	void SmokeTransport::Diffuse(float dt)
+	{
+		const float diffusionNumber = _diffusivity * dt / (_cellSize * _cellSize);
+		const size_t sliceSize = static_cast<size_t>(_width) * _height;
+
+		//! Zero-flux boundaries, each row of the output is written by a single job.
+		GL3::JobSystem::GetInstance().ParallelFor(static_cast<size_t>(_height) * _depth, [&](size_t row)
+		{
+			const int y = static_cast<int>(row % _height);
+			const int z = static_cast<int>(row / _height);
+			const size_t rowStart = z * sliceSize + y * static_cast<size_t>(_width);
+			for (int x = 0; x < _width; ++x)
+			{
+				const size_t index = rowStart + x;
+				const float center = _concentration[index];
+				float laplacian = 0.0f;
+				if (x > 0) laplacian += _concentration[index - 1] - center;
+				if (x + 1 < _width) laplacian += _concentration[index + 1] - center;
+				if (y > 0) laplacian += _concentration[index - _width] - center;
+				if (y + 1 < _height) laplacian += _concentration[index + _width] - center;
+				if (z > 0) laplacian += _concentration[index - sliceSize] - center;
+				if (z + 1 < _depth) laplacian += _concentration[index + sliceSize] - center;
+				_scratch[index] = center + diffusionNumber * laplacian;
+			}
+		});
+
+		_concentration.swap(_scratch);
+	}
+
+	void SmokeTransport::UploadTexture(GL3::Texture& texture) const
+	{
+		if (_depth > 1)
+			texture.UploadTexture3D(_concentration.data(), _width, _height, _depth, GL_RED, GL_R32F, GL_FLOAT);
+		else
+			texture.UploadTexture(const_cast<float*>(_concentration.data()), _width, _height, GL_RED, GL_R32F, GL_FLOAT);
+	}
+
+	bool SmokeTransport::WriteRaster(const std::string& path, bool columnIntegrated) const
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			std::cerr << "Failed to open smoke raster " << path << std::endl;
+			return false;
+		}
+
+		file << "ncols " << _width << '\n'
+			 << "nrows " << _height << '\n'
+			 << "xllcorner 0\n"
+			 << "yllcorner 0\n"
+			 << "cellsize " << _cellSize << '\n'
+			 << "NODATA_value -9999\n";
+
+		//! ESRI grids store the northernmost row first.
+		const size_t sliceSize = static_cast<size_t>(_width) * _height;
+		for (int y = _height - 1; y >= 0; --y)
+		{
+			for (int x = 0; x < _width; ++x)
+			{
+				const size_t index = static_cast<size_t>(y) * _width + x;
+				float value = _concentration[index];
+				if (columnIntegrated)
+				{
+					value = 0.0f;
+					for (int z = 0; z < _depth; ++z)
+						value += _concentration[index + z * sliceSize];
+					value *= _cellSize;
+				}
+				file << value << (x + 1 < _width ? ' ' : '\n');
+			}
+		}
+
+		return true;
+	}
+
+};
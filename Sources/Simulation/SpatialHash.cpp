@@ -0,0 +1,187 @@
+#include <Simulation/SpatialHash.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	//! Buckets scanned by one job of the offset pass
+	constexpr size_t BUCKETS_PER_JOB = 4096;
+};
+
+namespace Simulation {
+
+	SpatialHash::SpatialHash()
+		: _lowerCorner(0.0f), _bucketSize(1.0f), _inverseBucketSize(1.0f), _width(0), _height(0)
+	{
+		//! Do nothing
+	}
+
+	SpatialHash::~SpatialHash()
+	{
+		//! Do nothing
+	}
+
+	bool SpatialHash::Initialize(const glm::vec2& lowerCorner, const glm::vec2& upperCorner, float bucketSize)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (bucketSize <= 0.0f || upperCorner.x <= lowerCorner.x || upperCorner.y <= lowerCorner.y)
+		{
+			std::cerr << "Invalid spatial hash bucket size " << bucketSize << std::endl;
+			return false;
+		}
+
+		_lowerCorner = lowerCorner;
+		_bucketSize = bucketSize;
+		_inverseBucketSize = 1.0f / bucketSize;
+		_width = std::max(1, static_cast<int>(std::ceil((upperCorner.x - lowerCorner.x) / bucketSize)));
+		_height = std::max(1, static_cast<int>(std::ceil((upperCorner.y - lowerCorner.y) / bucketSize)));
+		_bucketBegin.assign(static_cast<size_t>(_width) * _height + 1, 0);
+		_indices.clear();
+		_points.clear();
+
+		return true;
+	}
+
+	void SpatialHash::Build(const float* x, const float* y, size_t count)
+	{
+		GL3::ProfileScope scope("SpatialHash::Build", count);
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		auto& jobSystem = GL3::JobSystem::GetInstance();
+
+		//! One histogram per thread at most, the (bucket, job) scan grows with their number.
+		const size_t numBuckets = static_cast<size_t>(_width) * _height;
+		const size_t numJobs = std::max<size_t>(1, std::min((count + POINTS_PER_JOB - 1) / POINTS_PER_JOB, jobSystem.GetNumThreads()));
+		const size_t pointsPerJob = (count + numJobs - 1) / numJobs;
+		_pointBuckets.resize(count);
+		_jobOffsets.assign(numJobs * numBuckets, 0);
+		_indices.resize(count);
+		_points.resize(count);
+
+		jobSystem.ParallelFor(numJobs, [&](size_t job)
+		{
+			uint32_t* histogram = _jobOffsets.data() + job * numBuckets;
+			const size_t end = std::min(count, (job + 1) * pointsPerJob);
+			for (size_t point = job * pointsPerJob; point < end; ++point)
+			{
+				const uint32_t bucket = static_cast<uint32_t>(GetBucketY(y[point]) * _width + GetBucketX(x[point]));
+				_pointBuckets[point] = bucket;
+				++histogram[bucket];
+			}
+		});
+
+		//! Bucket sizes, their exclusive scan, then the offset of every job within its buckets.
+		const size_t numBucketJobs = (numBuckets + BUCKETS_PER_JOB - 1) / BUCKETS_PER_JOB;
+		jobSystem.ParallelFor(numBucketJobs, [&](size_t bucketJob)
+		{
+			const size_t end = std::min(numBuckets, (bucketJob + 1) * BUCKETS_PER_JOB);
+			for (size_t bucket = bucketJob * BUCKETS_PER_JOB; bucket < end; ++bucket)
+			{
+				uint32_t size = 0;
+				for (size_t job = 0; job < numJobs; ++job)
+					size += _jobOffsets[job * numBuckets + bucket];
+				_bucketBegin[bucket + 1] = size;
+			}
+		});
+		_bucketBegin[0] = 0;
+		for (size_t bucket = 0; bucket < numBuckets; ++bucket)
+			_bucketBegin[bucket + 1] += _bucketBegin[bucket];
+		jobSystem.ParallelFor(numBucketJobs, [&](size_t bucketJob)
+		{
+			const size_t end = std::min(numBuckets, (bucketJob + 1) * BUCKETS_PER_JOB);
+			for (size_t bucket = bucketJob * BUCKETS_PER_JOB; bucket < end; ++bucket)
+			{
+				uint32_t offset = _bucketBegin[bucket];
+				for (size_t job = 0; job < numJobs; ++job)
+				{
+					const uint32_t size = _jobOffsets[job * numBuckets + bucket];
+					_jobOffsets[job * numBuckets + bucket] = offset;
+					offset += size;
+				}
+			}
+		});
+
+		jobSystem.ParallelFor(numJobs, [&](size_t job)
+		{
+			uint32_t* offsets = _jobOffsets.data() + job * numBuckets;
+			const size_t end = std::min(count, (job + 1) * pointsPerJob);
+			for (size_t point = job * pointsPerJob; point < end; ++point)
+			{
+				const uint32_t target = offsets[_pointBuckets[point]]++;
+				_indices[target] = static_cast<uint32_t>(point);
+				_points[target] = glm::vec2(x[point], y[point]);
+			}
+		});
+	}
+
+	void SpatialHash::QueryRadius(const glm::vec2& center, float radius, std::vector<uint32_t>& indices) const
+	{
+		if (_indices.empty() || radius < 0.0f)
+			return;
+
+		const float radiusSquared = radius * radius;
+		const int minX = GetBucketX(center.x - radius), maxX = GetBucketX(center.x + radius);
+		const int minY = GetBucketY(center.y - radius), maxY = GetBucketY(center.y + radius);
+		for (int bucketY = minY; bucketY <= maxY; ++bucketY)
+		{
+			for (int bucketX = minX; bucketX <= maxX; ++bucketX)
+			{
+				const size_t bucket = static_cast<size_t>(bucketY) * _width + bucketX;
+				for (uint32_t sorted = _bucketBegin[bucket]; sorted < _bucketBegin[bucket + 1]; ++sorted)
+				{
+					const glm::vec2 offset = _points[sorted] - center;
+					if (glm::dot(offset, offset) <= radiusSquared)
+						indices.push_back(_indices[sorted]);
+				}
+			}
+		}
+	}
+
+	uint32_t SpatialHash::FindNearest(const glm::vec2& center, float maxRadius) const
+	{
+		if (_indices.empty() || maxRadius < 0.0f)
+			return NO_POINT;
+
+		//! Visit rings of buckets around the center bucket. Buckets of ring r + 1 are at least
+		//! r buckets away, so the search ends once the best distance is within that bound.
+		const int centerX = GetBucketX(center.x), centerY = GetBucketY(center.y);
+		const int maxRing = std::max(std::max(centerX, _width - 1 - centerX), std::max(centerY, _height - 1 - centerY));
+		uint32_t nearest = NO_POINT;
+		float nearestSquared = maxRadius * maxRadius;
+		for (int ring = 0; ring <= maxRing; ++ring)
+		{
+			const float bound = (ring - 1) * _bucketSize;
+			if (bound > 0.0f && bound * bound > nearestSquared)
+				break;
+
+			for (int bucketY = std::max(0, centerY - ring); bucketY <= std::min(_height - 1, centerY + ring); ++bucketY)
+			{
+				const bool bEdgeRow = bucketY == centerY - ring || bucketY == centerY + ring;
+				for (int bucketX = std::max(0, centerX - ring); bucketX <= std::min(_width - 1, centerX + ring); ++bucketX)
+				{
+					//! Inner rows of the ring only have their two end buckets.
+					if (!bEdgeRow && bucketX != centerX - ring && bucketX != centerX + ring)
+						continue;
+					const size_t bucket = static_cast<size_t>(bucketY) * _width + bucketX;
+					for (uint32_t sorted = _bucketBegin[bucket]; sorted < _bucketBegin[bucket + 1]; ++sorted)
+					{
+						const glm::vec2 offset = _points[sorted] - center;
+						const float distanceSquared = glm::dot(offset, offset);
+						if (distanceSquared < nearestSquared || (distanceSquared == nearestSquared && _indices[sorted] < nearest))
+						{
+							nearest = _indices[sorted];
+							nearestSquared = distanceSquared;
+						}
+					}
+				}
+			}
+		}
+
+		return nearest;
+	}
+
+};
@@ -0,0 +1,411 @@
+#include <Simulation/SuppressionAgents.hpp>
+#include <Simulation/SpreadKernel.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+	//! name, speed, work time, capacity, work radius, reload time
+	const Simulation::AgentModel AGENT_MODELS[Simulation::NumAgentTypes] = {
+		{ "Hand crew", 1.0f, 60.0f, 0.0f, 0, 0.0f },
+		{ "Engine", 8.0f, 120.0f, 3000.0f, 1, 600.0f },
+		{ "Aircraft", 60.0f, 0.0f, 12000.0f, 3, 900.0f },
+	};
+	using Simulation::SpreadKernel::OFFSET_X;
+	using Simulation::SpreadKernel::OFFSET_Y;
+
+	//! Agents found by the drop zone checks of the calling thread
+	thread_local std::vector<uint32_t> tNeighbors;
+};
+
+namespace Simulation {
+
+	const AgentModel& GetAgentModel(uint8_t type)
+	{
+		return AGENT_MODELS[type < NumAgentTypes ? type : HandCrew];
+	}
+
+	SuppressionAgents::SuppressionAgents()
+		: _frontTimer(0.0f), _cellSize(1.0f), _width(0), _height(0)
+	{
+		//! Do nothing
+	}
+
+	SuppressionAgents::~SuppressionAgents()
+	{
+		//! Do nothing
+	}
+
+	bool SuppressionAgents::Initialize(const Landscape& landscape)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (!_pathFinder.Initialize(landscape))
+			return false;
+
+		_width = landscape.width;
+		_height = landscape.height;
+		_cellSize = landscape.cellSize;
+		const glm::vec2 upperCorner = glm::vec2(_width, _height) * _cellSize;
+		if (!_agentHash.Initialize(glm::vec2(0.0f), upperCorner, BUCKET_CELLS * _cellSize) ||
+			!_frontHash.Initialize(glm::vec2(0.0f), upperCorner, BUCKET_CELLS * _cellSize))
+			return false;
+
+		_positionX.clear();
+		_positionY.clear();
+		_baseX.clear();
+		_baseY.clear();
+		_type.clear();
+		_task.clear();
+		_load.clear();
+		_timer.clear();
+		_goal.clear();
+		_paths.clear();
+		_pathStep.clear();
+		_frontCells.clear();
+		_frontX.clear();
+		_frontY.clear();
+		_frontTimer = 0.0f;
+
+		return true;
+	}
+
+	uint32_t SuppressionAgents::Add(AgentType type, const glm::vec2& position)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		const uint32_t agent = static_cast<uint32_t>(_type.size());
+		_positionX.push_back(position.x);
+		_positionY.push_back(position.y);
+		_baseX.push_back(position.x);
+		_baseY.push_back(position.y);
+		_type.push_back(type);
+		_task.push_back(Idle);
+		_load.push_back(GetAgentModel(type).capacity);
+		_timer.push_back(0.0f);
+		_goal.push_back(0);
+		_paths.emplace_back();
+		_pathStep.push_back(0);
+		return agent;
+	}
+
+	uint32_t SuppressionAgents::GetCell(float x, float y) const
+	{
+		const int cellX = std::min(_width - 1, std::max(0, static_cast<int>(x / _cellSize)));
+		const int cellY = std::min(_height - 1, std::max(0, static_cast<int>(y / _cellSize)));
+		return static_cast<uint32_t>(cellY * _width + cellX);
+	}
+
+	glm::vec2 SuppressionAgents::GetCellCenter(uint32_t cell) const
+	{
+		return (glm::vec2(cell % _width, cell / _width) + 0.5f) * _cellSize;
+	}
+
+	void SuppressionAgents::FindNeighbors(const glm::vec2& center, float radius, std::vector<uint32_t>& agents) const
+	{
+		_agentHash.QueryRadius(center, radius, agents);
+	}
+
+	void SuppressionAgents::UpdateFront(const FireSpread& fire)
+	{
+		int minX, minY, maxX, maxY;
+		fire.GetActiveWindow(minX, minY, maxX, maxY);
+		const std::vector<uint8_t>& state = fire.GetState();
+		const size_t numRows = maxY >= minY ? static_cast<size_t>(maxY - minY + 1) : 0;
+		_frontRows.resize(numRows);
+
+		//! Every row collects its own front cells, concatenated in row order below.
+		GL3::JobSystem::GetInstance().ParallelFor(numRows, [&](size_t row)
+		{
+			std::vector<uint32_t>& frontRow = _frontRows[row];
+			frontRow.clear();
+			const int y = minY + static_cast<int>(row);
+			for (int x = minX; x <= maxX; ++x)
+			{
+				const size_t cell = static_cast<size_t>(y) * _width + x;
+				if (state[cell] != FireSpread::Unburned)
+					continue;
+				for (int direction = 0; direction < 8; ++direction)
+				{
+					const int neighborX = x + OFFSET_X[direction], neighborY = y + OFFSET_Y[direction];
+					if (neighborX < 0 || neighborY < 0 || neighborX >= _width || neighborY >= _height)
+						continue;
+					if (state[static_cast<size_t>(neighborY) * _width + neighborX] == FireSpread::Burning)
+					{
+						frontRow.push_back(static_cast<uint32_t>(cell));
+						break;
+					}
+				}
+			}
+		});
+
+		_frontCells.clear();
+		for (const std::vector<uint32_t>& frontRow : _frontRows)
+			_frontCells.insert(_frontCells.end(), frontRow.begin(), frontRow.end());
+		_frontX.resize(_frontCells.size());
+		_frontY.resize(_frontCells.size());
+		for (size_t front = 0; front < _frontCells.size(); ++front)
+		{
+			const glm::vec2 center = GetCellCenter(_frontCells[front]);
+			_frontX[front] = center.x;
+			_frontY[front] = center.y;
+		}
+		_frontHash.Build(_frontX.data(), _frontY.data(), _frontCells.size());
+	}
+
+	void SuppressionAgents::Step(FireSpread& fire, float dt)
+	{
+		if (dt <= 0.0f || _type.empty())
+			return;
+
+		GL3::ProfileScope scope("SuppressionAgents::Step", _type.size());
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		auto& jobSystem = GL3::JobSystem::GetInstance();
+
+		_frontTimer -= dt;
+		if (_frontTimer <= 0.0f)
+		{
+			UpdateFront(fire);
+			_frontTimer = FRONT_INTERVAL;
+		}
+		_agentHash.Build(_positionX.data(), _positionY.data(), _type.size());
+
+		const size_t numJobs = (_type.size() + AGENTS_PER_JOB - 1) / AGENTS_PER_JOB;
+		_jobQueries.resize(numJobs);
+		_jobQueryAgents.resize(numJobs);
+		_jobActions.resize(numJobs);
+		jobSystem.ParallelFor(numJobs, [&](size_t job)
+		{
+			_jobQueries[job].clear();
+			_jobQueryAgents[job].clear();
+			_jobActions[job].clear();
+			const size_t end = std::min(_type.size(), (job + 1) * AGENTS_PER_JOB);
+			for (size_t agent = job * AGENTS_PER_JOB; agent < end; ++agent)
+				StepAgent(static_cast<uint32_t>(agent), fire, dt, _jobQueries[job], _jobQueryAgents[job], _jobActions[job]);
+		});
+
+		//! One batch for the path queries of every job, around the burning cells.
+		_queries.clear();
+		_queryAgents.clear();
+		_actions.clear();
+		for (size_t job = 0; job < numJobs; ++job)
+		{
+			_queries.insert(_queries.end(), _jobQueries[job].begin(), _jobQueries[job].end());
+			_queryAgents.insert(_queryAgents.end(), _jobQueryAgents[job].begin(), _jobQueryAgents[job].end());
+			_actions.insert(_actions.end(), _jobActions[job].begin(), _jobActions[job].end());
+		}
+		if (!_queries.empty())
+		{
+			_pathFinder.FindPaths(_queries, _queryPaths, fire.GetState().data(), FireSpread::Burning);
+			for (size_t query = 0; query < _queries.size(); ++query)
+			{
+				const uint32_t agent = _queryAgents[query];
+				_paths[agent].cells.swap(_queryPaths[query].cells);
+				_paths[agent].cost = _queryPaths[query].cost;
+				_pathStep[agent] = 0;
+				if (_paths[agent].cells.empty())
+				{
+					_task[agent] = Idle;
+					_timer[agent] = FRONT_INTERVAL;
+				}
+			}
+		}
+
+		fire.ApplySuppression(_actions);
+	}
+
+	void SuppressionAgents::RetargetNearby(uint32_t agent, const FireSpread& fire, const glm::vec2& position)
+	{
+		//! A straight two cell path, the front hash may still list cells that burned since the last scan.
+		const uint32_t front = _frontHash.FindNearest(position, RETARGET_CELLS * _cellSize);
+		if (front == SpatialHash::NO_POINT || fire.GetState()[_frontCells[front]] != FireSpread::Unburned)
+		{
+			_task[agent] = Idle;
+			return;
+		}
+		_goal[agent] = _frontCells[front];
+		_paths[agent].cells = { GetCell(position.x, position.y), _goal[agent] };
+		_pathStep[agent] = 0;
+		_task[agent] = Travel;
+	}
+
+	void SuppressionAgents::StepAgent(uint32_t agent, const FireSpread& fire, float dt, std::vector<PathQuery>& queries,
+									  std::vector<uint32_t>& queryAgents, std::vector<Suppression>& actions)
+	{
+		const AgentModel& model = GetAgentModel(_type[agent]);
+		const std::vector<uint8_t>& state = fire.GetState();
+		glm::vec2 position(_positionX[agent], _positionY[agent]);
+		const bool bAircraft = _type[agent] == Aircraft;
+
+		switch (_task[agent])
+		{
+		case Reload:
+			_timer[agent] -= dt;
+			if (_timer[agent] <= 0.0f)
+			{
+				_load[agent] = model.capacity;
+				_task[agent] = Idle;
+				_timer[agent] = 0.0f;
+			}
+			break;
+		case Idle:
+		{
+			if (_timer[agent] > 0.0f)
+			{
+				_timer[agent] -= dt;
+				break;
+			}
+			const uint32_t front = _frontHash.FindNearest(position, std::numeric_limits<float>::max());
+			if (front == SpatialHash::NO_POINT || state[_frontCells[front]] != FireSpread::Unburned)
+				break;
+			_goal[agent] = _frontCells[front];
+			_paths[agent].cells.clear();
+			_task[agent] = Travel;
+			if (!bAircraft)
+			{
+				queries.push_back({ GetCell(position.x, position.y), _goal[agent] });
+				queryAgents.push_back(agent);
+			}
+			break;
+		}
+		case Travel:
+		{
+			//! Ground agents keep walking to a goal the fire took and look around once there.
+			if (bAircraft && state[_goal[agent]] != FireSpread::Unburned)
+			{
+				_task[agent] = Idle;
+				break;
+			}
+			if (bAircraft)
+			{
+				const glm::vec2 offset = GetCellCenter(_goal[agent]) - position;
+				const float distance = glm::length(offset);
+				if (distance <= model.speed * dt)
+				{
+					position += offset;
+					_task[agent] = Work;
+					_timer[agent] = 0.0f;
+				}
+				else
+					position += offset * (model.speed * dt / distance);
+				break;
+			}
+
+			//! The travel budget is spent at the cost weighted distance along the path.
+			const std::vector<uint32_t>& cells = _paths[agent].cells;
+			float budget = model.speed * dt;
+			while (budget > 0.0f && _pathStep[agent] + 1 < cells.size())
+			{
+				const uint32_t next = cells[_pathStep[agent] + 1];
+				if (state[next] == FireSpread::Burning)
+				{
+					_task[agent] = Idle;
+					break;
+				}
+				const glm::vec2 offset = GetCellCenter(next) - position;
+				const float cost = glm::length(offset) * _pathFinder.GetCost(next);
+				if (cost <= budget)
+				{
+					position += offset;
+					budget -= cost;
+					++_pathStep[agent];
+				}
+				else
+				{
+					position += offset * (budget / cost);
+					budget = 0.0f;
+				}
+			}
+			if (_task[agent] == Travel && !cells.empty() && _pathStep[agent] + 1 >= cells.size())
+			{
+				_task[agent] = Work;
+				_timer[agent] = 0.0f;
+			}
+			break;
+		}
+		case Work:
+		{
+			const uint32_t goal = _goal[agent];
+			if (!bAircraft && state[goal] != FireSpread::Unburned && (_type[agent] != Engine || state[goal] != FireSpread::Burning))
+			{
+				RetargetNearby(agent, fire, position);
+				break;
+			}
+			if (_type[agent] == HandCrew)
+			{
+				_timer[agent] += dt;
+				if (_timer[agent] < model.workTime)
+					break;
+				_timer[agent] -= model.workTime;
+				actions.push_back({ goal, Firebreak, 0.0f });
+
+				//! Walk on along the front to the first unburned neighbor touching a burning cell.
+				const int goalX = static_cast<int>(goal % _width), goalY = static_cast<int>(goal / _width);
+				_task[agent] = Idle;
+				for (int direction = 0; direction < 8 && _task[agent] == Idle; ++direction)
+				{
+					const int x = goalX + OFFSET_X[direction], y = goalY + OFFSET_Y[direction];
+					if (x < 0 || y < 0 || x >= _width || y >= _height || state[static_cast<size_t>(y) * _width + x] != FireSpread::Unburned)
+						continue;
+					for (int side = 0; side < 8; ++side)
+					{
+						const int sideX = x + OFFSET_X[side], sideY = y + OFFSET_Y[side];
+						if (sideX >= 0 && sideY >= 0 && sideX < _width && sideY < _height &&
+							state[static_cast<size_t>(sideY) * _width + sideX] == FireSpread::Burning)
+						{
+							_goal[agent] = static_cast<uint32_t>(y * _width + x);
+							_task[agent] = Work;
+							position = GetCellCenter(_goal[agent]);
+							break;
+						}
+					}
+				}
+				break;
+			}
+
+			//! Aircraft hold the drop while ground agents are inside the drop zone.
+			const glm::vec2 center = GetCellCenter(goal);
+			const float radius = (model.workRadius + 0.5f) * _cellSize;
+			if (bAircraft)
+			{
+				tNeighbors.clear();
+				_agentHash.QueryRadius(center, radius + _cellSize, tNeighbors);
+				if (std::any_of(tNeighbors.begin(), tNeighbors.end(), [this](uint32_t other) { return _type[other] != Aircraft; }))
+					break;
+			}
+
+			//! Discharge over the disk of work radius cells, aircraft all at once, engines at a steady rate.
+			const float discharge = bAircraft ? _load[agent] : std::min(_load[agent], model.capacity * dt / model.workTime);
+			const int goalX = static_cast<int>(goal % _width), goalY = static_cast<int>(goal / _width);
+			int numCells = 0;
+			for (int y = std::max(0, goalY - model.workRadius); y <= std::min(_height - 1, goalY + model.workRadius); ++y)
+				for (int x = std::max(0, goalX - model.workRadius); x <= std::min(_width - 1, goalX + model.workRadius); ++x)
+					if ((x - goalX) * (x - goalX) + (y - goalY) * (y - goalY) <= model.workRadius * model.workRadius)
+						++numCells;
+			const float amount = discharge / (numCells * _cellSize * _cellSize);
+			for (int y = std::max(0, goalY - model.workRadius); y <= std::min(_height - 1, goalY + model.workRadius); ++y)
+				for (int x = std::max(0, goalX - model.workRadius); x <= std::min(_width - 1, goalX + model.workRadius); ++x)
+					if ((x - goalX) * (x - goalX) + (y - goalY) * (y - goalY) <= model.workRadius * model.workRadius)
+						actions.push_back({ static_cast<uint32_t>(y * _width + x), Wetting, amount });
+
+			_load[agent] -= discharge;
+			if (_load[agent] <= 0.0f)
+			{
+				_load[agent] = 0.0f;
+				_task[agent] = Reload;
+				_timer[agent] = model.reloadTime;
+				if (bAircraft)
+					position = glm::vec2(_baseX[agent], _baseY[agent]);
+			}
+			break;
+		}
+		}
+
+		_positionX[agent] = position.x;
+		_positionY[agent] = position.y;
+	}
+
+};
@@ -0,0 +1,486 @@
+#include <Simulation/TiledFireSpread.hpp>
+#include <Simulation/FireSpread.hpp>
+#include <Simulation/SpreadKernel.hpp>
+#include <GL3/FrameStatistics.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+	using Simulation::SpreadKernel::OFFSET_X;
+	using Simulation::SpreadKernel::OFFSET_Y;
+	using Simulation::SpreadKernel::DISTANCE;
+	constexpr float NEVER = std::numeric_limits<float>::infinity();
+	//! Earlier arrivals found within a tile update replace a local ignition time only when they gain
+	//! more than this many seconds, which bounds the label correcting passes
+	constexpr float TIME_TOLERANCE = 1e-3f;
+	constexpr int TILE_CELLS = Simulation::TiledFireSpread::TILE_SIZE * Simulation::TiledFireSpread::TILE_SIZE;
+
+	//! Per thread scratch of UpdateTile(), indexed by the cell within the tile
+	thread_local std::vector<float> tLocalTimes;
+	thread_local std::vector<uint8_t> tQueued, tFront;
+	thread_local std::vector<uint16_t> tQueue;
+
+	//! Returns the progress base + sum rate * overlap of the contributions at time
+	template <typename Contribution>
+	inline float GetProgress(float base, const Contribution* contributions, int count, float time)
+	{
+		float progress = base;
+		for (int index = 0; index < count; ++index)
+		{
+			const Contribution& contribution = contributions[index];
+			progress += contribution.rate * std::min(std::max(time - contribution.begin, 0.0f), contribution.end - contribution.begin);
+		}
+		return progress;
+	}
+
+	//! Earliest time after epoch the piecewise linear progress reaches 1, or NEVER
+	template <typename Contribution>
+	float SolveIgnitionTime(float base, const Contribution* contributions, int count, float epoch)
+	{
+		float points[16];
+		int numPoints = 0;
+		for (int index = 0; index < count; ++index)
+		{
+			points[numPoints++] = contributions[index].begin;
+			points[numPoints++] = contributions[index].end;
+		}
+		if (numPoints == 0)
+			return base >= 1.0f ? epoch : NEVER;
+		std::sort(points, points + numPoints);
+
+		float previousPoint = points[0];
+		float previousProgress = GetProgress(base, contributions, count, previousPoint);
+		if (previousProgress >= 1.0f)
+			return previousPoint;
+		for (int index = 1; index < numPoints; ++index)
+		{
+			const float point = points[index];
+			if (point <= previousPoint)
+				continue;
+			const float progress = GetProgress(base, contributions, count, point);
+			if (progress >= 1.0f)
+				return previousPoint + (1.0f - previousProgress) * (point - previousPoint) / (progress - previousProgress);
+			previousPoint = point;
+			previousProgress = progress;
+		}
+		return NEVER;
+	}
+};
+
+namespace Simulation {
+
+	TiledFireSpread::TiledFireSpread()
+		: _focusCenter(0.0f), _focusRadius(0.0f), _bFocus(false), _bLevelsDirty(false), _cellSize(1.0f), _epoch(0.0f),
+		  _time(0.0), _step(0), _numTileUpdates(0), _numCellUpdates(0), _numBurning(0), _numActiveTiles(0), _width(0), _height(0), _tilesX(0), _tilesY(0)
+	{
+		std::fill(_windFactor, _windFactor + 8, 1.0f);
+	}
+
+	TiledFireSpread::~TiledFireSpread()
+	{
+		//! Do nothing
+	}
+
+	bool TiledFireSpread::Initialize(const Landscape& landscape)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (landscape.width <= 0 || landscape.height <= 0 || landscape.fuel.size() != landscape.GetNumCells() ||
+			landscape.elevation.size() != landscape.GetNumCells())
+		{
+			std::cerr << "Invalid landscape " << landscape.width << "x" << landscape.height << " for the tiled fire spread" << std::endl;
+			return false;
+		}
+
+		_width = landscape.width;
+		_height = landscape.height;
+		_cellSize = landscape.cellSize;
+		_fuel = landscape.fuel;
+		_elevation = landscape.elevation;
+
+		const size_t numCells = landscape.GetNumCells();
+		_state.resize(numCells);
+		for (size_t i = 0; i < numCells; ++i)
+			_state[i] = _fuel[i] == NonBurnable ? Unburnable : Unburned;
+		_ignition.assign(numCells, 0.0f);
+		_ignitionTime.assign(numCells, NEVER);
+		_burnoutTime.assign(numCells, NEVER);
+		_intensity.assign(numCells, 0.0f);
+
+		_tilesX = (_width + TILE_SIZE - 1) / TILE_SIZE;
+		_tilesY = (_height + TILE_SIZE - 1) / TILE_SIZE;
+		const size_t numTiles = static_cast<size_t>(_tilesX) * _tilesY;
+		_tileLevel.assign(numTiles, INACTIVE_LEVEL);
+		_tileBurning.assign(numTiles, 0);
+		_tileFront.assign(numTiles, 0);
+		_tileLastStep.assign(numTiles, 0);
+		_tileIgnitionStep.assign(numTiles, 0);
+
+		_time = 0.0;
+		_epoch = 0.0f;
+		_step = 0;
+		_numTileUpdates = _numCellUpdates = 0;
+		_numBurning = 0;
+		_numActiveTiles = 0;
+		_bLevelsDirty = false;
+		SetWind(landscape.wind);
+
+		return true;
+	}
+
+	void TiledFireSpread::SetWind(const glm::vec2& wind)
+	{
+		//! The closed form progress assumes constant rates, so fold the progress gained so far into
+		//! the base and restart the integrals now.
+		if (_numBurning > 0)
+		{
+			GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+			const float time = static_cast<float>(_time);
+			GL3::JobSystem::GetInstance().ParallelFor(_tileLevel.size(), [&](size_t tile)
+			{
+				const int tileX = static_cast<int>(tile % _tilesX) * TILE_SIZE, tileY = static_cast<int>(tile / _tilesX) * TILE_SIZE;
+				for (int y = tileY; y < std::min(tileY + TILE_SIZE, _height); ++y)
+				{
+					for (int x = tileX; x < std::min(tileX + TILE_SIZE, _width); ++x)
+					{
+						const size_t cell = static_cast<size_t>(y) * _width + x;
+						if (_state[cell] != Unburned)
+							continue;
+						Contribution contributions[8];
+						const int count = GatherContributions(x, y, time, nullptr, tileX, tileY, contributions);
+						_ignition[cell] = GetProgress(_ignition[cell], contributions, count, time);
+					}
+				}
+			});
+			_epoch = time;
+		}
+
+		for (int direction = 0; direction < 8; ++direction)
+			_windFactor[direction] = SpreadKernel::GetWindFactor(wind, direction);
+	}
+
+	bool TiledFireSpread::Ignite(int x, int y)
+	{
+		if (x < 0 || y < 0 || x >= _width || y >= _height)
+			return false;
+
+		const size_t cell = static_cast<size_t>(y) * _width + x;
+		if (_state[cell] != Unburned)
+			return false;
+
+		const FuelModel& model = GetFuelModel(_fuel[cell]);
+		_state[cell] = Burning;
+		_ignitionTime[cell] = static_cast<float>(_time);
+		_burnoutTime[cell] = static_cast<float>(_time) + model.burnTime;
+		_intensity[cell] = model.heatContent * model.load / model.burnTime;
+		const int tile = (y / TILE_SIZE) * _tilesX + x / TILE_SIZE;
+		++_tileBurning[tile];
+		_tileIgnitionStep[tile] = _step + 1;
+		++_numBurning;
+		_bLevelsDirty = true;
+		return true;
+	}
+
+	void TiledFireSpread::SetFocus(const glm::vec2& center, float radius)
+	{
+		_focusCenter = center;
+		_focusRadius = radius;
+		_bFocus = true;
+		_bLevelsDirty = true;
+	}
+
+	void TiledFireSpread::ClearFocus()
+	{
+		_bFocus = false;
+		_bLevelsDirty = true;
+	}
+
+	float TiledFireSpread::GetIgnitionRate(size_t cell, size_t neighbor, int direction) const
+	{
+		return SpreadKernel::GetIgnitionRate(GetFuelModel(_fuel[cell]).spreadRate, _windFactor[direction], _elevation[cell], _elevation[neighbor], _cellSize, direction);
+	}
+
+	int TiledFireSpread::GatherContributions(int x, int y, float time, const float* localTimes, int tileX, int tileY, Contribution* contributions) const
+	{
+		const size_t cell = static_cast<size_t>(y) * _width + x;
+		int count = 0;
+		for (int direction = 0; direction < 8; ++direction)
+		{
+			const int neighborX = x + OFFSET_X[direction], neighborY = y + OFFSET_Y[direction];
+			if (neighborX < 0 || neighborY < 0 || neighborX >= _width || neighborY >= _height)
+				continue;
+			const size_t neighbor = static_cast<size_t>(neighborY) * _width + neighborX;
+			float begin = NEVER, end = NEVER;
+			const int localX = neighborX - tileX, localY = neighborY - tileY;
+			if (localTimes && localX >= 0 && localY >= 0 && localX < TILE_SIZE && localY < TILE_SIZE &&
+				localTimes[localY * TILE_SIZE + localX] != NEVER)
+			{
+				begin = localTimes[localY * TILE_SIZE + localX];
+				end = begin + GetFuelModel(_fuel[neighbor]).burnTime;
+			}
+			else if (_state[neighbor] == Burning || _state[neighbor] == Burned)
+			{
+				begin = _ignitionTime[neighbor];
+				end = _burnoutTime[neighbor];
+			}
+			else
+			{
+				continue;
+			}
+			begin = std::max(begin, _epoch);
+			end = std::min(end, time);
+			if (end > begin)
+				contributions[count++] = { begin, end, GetIgnitionRate(cell, neighbor, direction) };
+		}
+		return count;
+	}
+
+	void TiledFireSpread::UpdateTile(int tile, float time, TileResult& result) const
+	{
+		const int tileX = (tile % _tilesX) * TILE_SIZE, tileY = (tile / _tilesX) * TILE_SIZE;
+		const int endX = std::min(tileX + TILE_SIZE, _width), endY = std::min(tileY + TILE_SIZE, _height);
+		tLocalTimes.assign(TILE_CELLS, NEVER);
+		tQueued.assign(TILE_CELLS, 0);
+		tFront.assign(TILE_CELLS, 0);
+		tQueue.clear();
+		result.cells.clear();
+		result.times.clear();
+		result.burnouts.clear();
+		result.numFront = 0;
+
+		//! Burnouts of the committed fire, then every unburned cell is evaluated at least once.
+		for (int y = tileY; y < endY; ++y)
+		{
+			for (int x = tileX; x < endX; ++x)
+			{
+				const size_t cell = static_cast<size_t>(y) * _width + x;
+				if (_state[cell] == Burning && _burnoutTime[cell] <= time)
+					result.burnouts.push_back(static_cast<uint32_t>(cell));
+				else if (_state[cell] == Unburned)
+				{
+					const int local = (y - tileY) * TILE_SIZE + (x - tileX);
+					tQueue.push_back(static_cast<uint16_t>(local));
+					tQueued[local] = 1;
+				}
+			}
+		}
+
+		//! Label correcting within the tile: an ignition or an earlier one re-evaluates the unburned
+		//! neighbors, so fire crosses the whole tile in one update and in arrival order.
+		for (size_t head = 0; head < tQueue.size(); ++head)
+		{
+			const int local = tQueue[head];
+			tQueued[local] = 0;
+			const int x = tileX + local % TILE_SIZE, y = tileY + local / TILE_SIZE;
+			const size_t cell = static_cast<size_t>(y) * _width + x;
+
+			Contribution contributions[8];
+			const int count = GatherContributions(x, y, time, tLocalTimes.data(), tileX, tileY, contributions);
+			tFront[local] = count > 0;
+			const float ignitionTime = SolveIgnitionTime(_ignition[cell], contributions, count, _epoch);
+			if (ignitionTime > time || ignitionTime >= tLocalTimes[local] - TIME_TOLERANCE)
+				continue;
+			tLocalTimes[local] = ignitionTime;
+
+			for (int direction = 0; direction < 8; ++direction)
+			{
+				const int neighborX = x + OFFSET_X[direction], neighborY = y + OFFSET_Y[direction];
+				if (neighborX < tileX || neighborY < tileY || neighborX >= endX || neighborY >= endY)
+					continue;
+				const int neighborLocal = (neighborY - tileY) * TILE_SIZE + (neighborX - tileX);
+				if (tQueued[neighborLocal] || _state[static_cast<size_t>(neighborY) * _width + neighborX] != Unburned)
+					continue;
+				tQueue.push_back(static_cast<uint16_t>(neighborLocal));
+				tQueued[neighborLocal] = 1;
+			}
+		}
+
+		for (int y = tileY; y < endY; ++y)
+		{
+			for (int x = tileX; x < endX; ++x)
+			{
+				const int local = (y - tileY) * TILE_SIZE + (x - tileX);
+				if (tLocalTimes[local] != NEVER)
+				{
+					result.cells.push_back(static_cast<uint32_t>(static_cast<size_t>(y) * _width + x));
+					result.times.push_back(tLocalTimes[local]);
+				}
+				else
+				{
+					result.numFront += tFront[local];
+				}
+			}
+		}
+	}
+
+	void TiledFireSpread::CommitTile(int tile, float time, const TileResult& result)
+	{
+		for (size_t index = 0; index < result.cells.size(); ++index)
+		{
+			const uint32_t cell = result.cells[index];
+			const FuelModel& model = GetFuelModel(_fuel[cell]);
+			_ignitionTime[cell] = result.times[index];
+			_burnoutTime[cell] = result.times[index] + model.burnTime;
+			if (_burnoutTime[cell] <= time)
+			{
+				_state[cell] = Burned;
+			}
+			else
+			{
+				_state[cell] = Burning;
+				_intensity[cell] = model.heatContent * model.load / model.burnTime;
+				++_tileBurning[tile];
+			}
+		}
+		for (uint32_t cell : result.burnouts)
+		{
+			_state[cell] = Burned;
+			_intensity[cell] = 0.0f;
+			--_tileBurning[tile];
+		}
+		if (!result.cells.empty())
+			_tileIgnitionStep[tile] = _step + 1;
+		_tileFront[tile] = result.numFront;
+		_tileLastStep[tile] = _step;
+	}
+
+	void TiledFireSpread::Step(float dt)
+	{
+		if (dt <= 0.0f)
+			return;
+		_time += dt;
+		++_step;
+		if (_bLevelsDirty)
+			UpdateLevels();
+		if (_numActiveTiles == 0)
+			return;
+
+		_dueTiles.clear();
+		for (size_t tile = 0; tile < _tileLevel.size(); ++tile)
+		{
+			const uint8_t level = _tileLevel[tile];
+			if (level == INACTIVE_LEVEL)
+				continue;
+			const uint64_t interval = uint64_t(1) << level;
+			if (_step % interval == 0 || _step - _tileLastStep[tile] >= interval)
+				_dueTiles.push_back(static_cast<int>(tile));
+		}
+
+		GL3::FrameStatistics::GetInstance().Increment(GL3::FrameStatistics::SimulationSteps);
+		GL3::ProfileScope scope("TiledFireSpread::Step", _dueTiles.size() * TILE_CELLS);
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		auto& jobSystem = GL3::JobSystem::GetInstance();
+
+		//! Every due tile reads the states committed before this step, then all of them commit.
+		const float time = static_cast<float>(_time);
+		if (_results.size() < _dueTiles.size())
+			_results.resize(_dueTiles.size());
+		jobSystem.ParallelFor(_dueTiles.size(), [&](size_t job)
+		{
+			UpdateTile(_dueTiles[job], time, _results[job]);
+		});
+		jobSystem.ParallelFor(_dueTiles.size(), [&](size_t job)
+		{
+			CommitTile(_dueTiles[job], time, _results[job]);
+		});
+
+		_numTileUpdates += _dueTiles.size();
+		_numBurning = 0;
+		for (size_t tile = 0; tile < _tileBurning.size(); ++tile)
+			_numBurning += _tileBurning[tile];
+		for (int tile : _dueTiles)
+		{
+			const int tileX = (tile % _tilesX) * TILE_SIZE, tileY = (tile / _tilesX) * TILE_SIZE;
+			_numCellUpdates += static_cast<uint64_t>(std::min(TILE_SIZE, _width - tileX)) * std::min(TILE_SIZE, _height - tileY);
+		}
+		UpdateLevels();
+	}
+
+	void TiledFireSpread::UpdateLevels()
+	{
+		_bLevelsDirty = false;
+		_numActiveTiles = 0;
+		const float tileExtent = TILE_SIZE * _cellSize;
+		for (int tileY = 0; tileY < _tilesY; ++tileY)
+		{
+			for (int tileX = 0; tileX < _tilesX; ++tileX)
+			{
+				const size_t tile = static_cast<size_t>(tileY) * _tilesX + tileX;
+				//! Fire in or next to the tile, or neighbor ignitions it has not read yet, which may have
+				//! burned out already.
+				bool bActive = false;
+				for (int y = std::max(0, tileY - 1); y <= std::min(_tilesY - 1, tileY + 1) && !bActive; ++y)
+					for (int x = std::max(0, tileX - 1); x <= std::min(_tilesX - 1, tileX + 1) && !bActive; ++x)
+					{
+						const size_t neighbor = static_cast<size_t>(y) * _tilesX + x;
+						bActive = _tileBurning[neighbor] > 0 || (neighbor != tile && _tileIgnitionStep[neighbor] > _tileLastStep[tile]);
+					}
+				_numActiveTiles += bActive;
+
+				if (!bActive)
+				{
+					_tileLevel[tile] = INACTIVE_LEVEL;
+				}
+				else if (!_bFocus)
+				{
+					_tileLevel[tile] = 0;
+				}
+				else if (_tileFront[tile] == 0)
+				{
+					//! Only burning out or waiting for the fire, the balance below pulls it down next to the front.
+					_tileLevel[tile] = MAX_LEVEL;
+				}
+				else
+				{
+					const glm::vec2 lower = glm::vec2(tileX, tileY) * tileExtent;
+					const glm::vec2 closest = glm::clamp(_focusCenter, lower, lower + tileExtent);
+					const float distance = glm::length(closest - _focusCenter);
+					int level = 0;
+					if (distance > _focusRadius)
+						level = _focusRadius > 0.0f ? 1 + static_cast<int>(std::floor(std::log2(distance / _focusRadius))) : MAX_LEVEL;
+					_tileLevel[tile] = static_cast<uint8_t>(std::min(level, MAX_LEVEL));
+				}
+			}
+		}
+
+		//! Neighbor tiles at most one level apart, a tile next to the full rate front trails it by one.
+		for (int pass = 0; pass < MAX_LEVEL; ++pass)
+		{
+			for (int tileY = 0; tileY < _tilesY; ++tileY)
+			{
+				for (int tileX = 0; tileX < _tilesX; ++tileX)
+				{
+					uint8_t& level = _tileLevel[static_cast<size_t>(tileY) * _tilesX + tileX];
+					if (level == INACTIVE_LEVEL)
+						continue;
+					for (int y = std::max(0, tileY - 1); y <= std::min(_tilesY - 1, tileY + 1); ++y)
+						for (int x = std::max(0, tileX - 1); x <= std::min(_tilesX - 1, tileX + 1); ++x)
+						{
+							const uint8_t neighborLevel = _tileLevel[static_cast<size_t>(y) * _tilesX + x];
+							if (neighborLevel != INACTIVE_LEVEL)
+								level = std::min<uint8_t>(level, neighborLevel + 1);
+						}
+				}
+			}
+		}
+	}
+
+	uint64_t TiledFireSpread::GetDigest() const
+	{
+		return HashBytes(_state.data(), _state.size());
+	}
+
+	size_t TiledFireSpread::GetMemoryBytes() const
+	{
+		return _state.capacity() + _fuel.capacity() + _tileLevel.capacity() +
+			   (_elevation.capacity() + _ignition.capacity() + _ignitionTime.capacity() + _burnoutTime.capacity() + _intensity.capacity()) * sizeof(float) +
+			   (_tileBurning.capacity() + _tileFront.capacity()) * sizeof(int) + (_tileLastStep.capacity() + _tileIgnitionStep.capacity()) * sizeof(uint64_t);
+	}
+
+};
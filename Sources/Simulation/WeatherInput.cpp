@@ -0,0 +1,628 @@
+#include <Simulation/WeatherInput.hpp>
+#include <GL3/JobSystem.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Profiler.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+	//! Squared distance below which a cell center sits on a station and takes its value
+	constexpr float COINCIDENT_DISTANCE = 1e-6f;
+	//! Deepest k-d tree the neighbor search keeps a stack for, enough for 2^32 stations
+	constexpr int MAX_TREE_DEPTH = 64;
+
+	//! Run function(begin, end) on the cell range of every row of every tile, one job per tile
+	template <typename Function>
+	void ForEachTileRow(int width, int height, int tilesX, int tilesY, const Function& function)
+	{
+		const int tileSize = Simulation::WeatherInput::TILE_SIZE;
+		GL3::JobSystem::GetInstance().ParallelFor(static_cast<size_t>(tilesX) * tilesY, [&](size_t tile)
+		{
+			const int tileX = static_cast<int>(tile % tilesX) * tileSize, tileY = static_cast<int>(tile / tilesX) * tileSize;
+			const int endX = std::min(width, tileX + tileSize), endY = std::min(height, tileY + tileSize);
+			for (int y = tileY; y < endY; ++y)
+				function(static_cast<size_t>(y) * width + tileX, static_cast<size_t>(y) * width + endX);
+		});
+	}
+
+	//! Parse a number filling the whole field
+	bool ParseNumber(const std::string& field, double& value)
+	{
+		char* end = nullptr;
+		value = std::strtod(field.c_str(), &end);
+		return !field.empty() && end == field.c_str() + field.size();
+	}
+
+	//! Split a CSV line of station,x,y,time,wind_x,wind_y,humidity,temperature
+	bool ParseCSVLine(const std::string& line, std::string& name, glm::vec2& position, double& time, Simulation::WeatherSample& sample)
+	{
+		std::string fields[8];
+		size_t numFields = 0, begin = 0;
+		while (numFields < 8)
+		{
+			const size_t end = line.find(',', begin);
+			fields[numFields++] = line.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+			if (end == std::string::npos)
+				break;
+			begin = end + 1;
+		}
+		if (numFields != 8 || line.find(',', begin) != std::string::npos || fields[0].empty())
+			return false;
+
+		double values[7];
+		for (int value = 0; value < 7; ++value)
+			if (!ParseNumber(fields[value + 1], values[value]))
+				return false;
+		name = fields[0];
+		position = glm::vec2(static_cast<float>(values[0]), static_cast<float>(values[1]));
+		time = values[2];
+		sample = { glm::vec2(static_cast<float>(values[3]), static_cast<float>(values[4])), static_cast<float>(values[5]), static_cast<float>(values[6]) };
+		return true;
+	}
+
+	template <typename T>
+	bool ReadValue(std::ifstream& file, T& value)
+	{
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+
+	template <typename T>
+	void WriteValue(std::ofstream& file, const T& value)
+	{
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+};
+
+namespace Simulation {
+
+	WeatherInput::WeatherInput()
+		: _bBinary(false), _bEndOfFile(true), _bFailed(false), _bCaching(true), _bSlicesValid(false), _lastTime(0.0),
+		  _meanSlices(), _meanSample(), _windowBegin(0.0), _windowEnd(0.0), _time(0.0),
+		  _numRecords(0), _numSliceUpdates(0), _numWeightUpdates(0), _cellSize(1.0f), _width(0), _height(0), _tilesX(0), _tilesY(0)
+	{
+		//! Do nothing
+	}
+
+	WeatherInput::~WeatherInput()
+	{
+		//! Do nothing
+	}
+
+	bool WeatherInput::Initialize(int width, int height, float cellSize)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (width <= 0 || height <= 0 || cellSize <= 0.0f)
+		{
+			std::cerr << "Invalid weather grid " << width << "x" << height << " cell size " << cellSize << std::endl;
+			return false;
+		}
+
+		_width = width;
+		_height = height;
+		_cellSize = cellSize;
+		_tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+		_tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+		const size_t numCells = static_cast<size_t>(width) * height;
+		_neighbors.assign(numCells * NUM_NEIGHBORS, 0);
+		_weights.assign(numCells * NUM_NEIGHBORS, 0.0f);
+		for (Field* field : { &_slices[0], &_slices[1], &_field })
+		{
+			field->wind.assign(numCells, glm::vec2(0.0f));
+			field->humidity.assign(numCells, 0.0f);
+			field->temperature.assign(numCells, 0.0f);
+		}
+		//! The neighbors are searched again for the new grid
+		_treeStations.clear();
+		_bSlicesValid = false;
+
+		return true;
+	}
+
+	bool WeatherInput::Open(const std::string& path)
+	{
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		_file.close();
+		_file.clear();
+		_stations.clear();
+		_stationIndices.clear();
+		_history.clear();
+		_knots.clear();
+		_treeStations.clear();
+		_bSlicesValid = false;
+		_bEndOfFile = true;
+		_bFailed = false;
+		_lastTime = -std::numeric_limits<double>::infinity();
+		_numRecords = _numSliceUpdates = _numWeightUpdates = 0;
+
+		_bBinary = path.size() < 4 || path.compare(path.size() - 4, 4, ".csv") != 0;
+		_file.open(path, _bBinary ? std::ios::in | std::ios::binary : std::ios::in);
+		if (!_file.is_open())
+		{
+			std::cerr << "Failed to open " << path << std::endl;
+			return false;
+		}
+
+		if (_bBinary)
+		{
+			uint32_t magic = 0, version = 0, numStations = 0;
+			if (!ReadValue(_file, magic) || !ReadValue(_file, version) || !ReadValue(_file, numStations) || magic != BINARY_MAGIC)
+			{
+				std::cerr << path << " is not a weather file" << std::endl;
+				return false;
+			}
+			if (version != BINARY_VERSION)
+			{
+				std::cerr << path << " is a version " << version << " weather file, expected version " << BINARY_VERSION << std::endl;
+				return false;
+			}
+			for (uint32_t station = 0; station < numStations; ++station)
+			{
+				WeatherStation weatherStation = { std::string(), glm::vec2(0.0f) };
+				uint32_t nameLength = 0;
+				if (!ReadValue(_file, weatherStation.position.x) || !ReadValue(_file, weatherStation.position.y) || !ReadValue(_file, nameLength))
+				{
+					std::cerr << path << " has a truncated station list" << std::endl;
+					return false;
+				}
+				if (nameLength > MAX_NAME_LENGTH)
+				{
+					std::cerr << path << " has a station name of " << nameLength << " bytes, at most " << MAX_NAME_LENGTH << " are allowed" << std::endl;
+					return false;
+				}
+				weatherStation.name.resize(nameLength);
+				if (nameLength > 0 && !_file.read(&weatherStation.name[0], nameLength))
+				{
+					std::cerr << path << " has a truncated station list" << std::endl;
+					return false;
+				}
+				_stationIndices.emplace(weatherStation.name, station);
+				_stations.push_back(std::move(weatherStation));
+			}
+			_history.resize(_stations.size());
+		}
+		else
+		{
+			std::string header;
+			if (!std::getline(_file, header) || header.compare(0, 8, "station,") != 0)
+			{
+				std::cerr << path << " has no station,x,y,time,wind_x,wind_y,humidity,temperature header" << std::endl;
+				return false;
+			}
+		}
+
+		_bEndOfFile = false;
+		if (!ReadRecord())
+		{
+			if (!_bFailed)
+				std::cerr << path << " has no weather records" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool WeatherInput::ReadRecord()
+	{
+		if (_bEndOfFile)
+			return false;
+
+		WeatherRecord record = {};
+		if (_bBinary)
+		{
+			if (!ReadValue(_file, record.time))
+			{
+				_bEndOfFile = true;
+				_bFailed = _file.gcount() != 0;
+				if (_bFailed)
+					std::cerr << "Truncated weather record after time " << _lastTime << std::endl;
+				return false;
+			}
+			if (!ReadValue(_file, record.station) || !ReadValue(_file, record.sample.wind.x) || !ReadValue(_file, record.sample.wind.y) ||
+				!ReadValue(_file, record.sample.humidity) || !ReadValue(_file, record.sample.temperature) || record.station >= _stations.size())
+			{
+				std::cerr << "Malformed weather record at time " << record.time << std::endl;
+				_bEndOfFile = _bFailed = true;
+				return false;
+			}
+		}
+		else
+		{
+			std::string line, name;
+			glm::vec2 position;
+			do
+			{
+				if (!std::getline(_file, line))
+				{
+					_bEndOfFile = true;
+					return false;
+				}
+				if (!line.empty() && line.back() == '\r')
+					line.pop_back();
+			} while (line.empty());
+
+			if (!ParseCSVLine(line, name, position, record.time, record.sample))
+			{
+				std::cerr << "Malformed weather record \"" << line << "\"" << std::endl;
+				_bEndOfFile = _bFailed = true;
+				return false;
+			}
+			auto found = _stationIndices.find(name);
+			if (found == _stationIndices.end())
+			{
+				found = _stationIndices.emplace(name, static_cast<uint32_t>(_stations.size())).first;
+				_stations.push_back({ name, position });
+				_history.emplace_back();
+			}
+			record.station = found->second;
+		}
+
+		if (!std::isfinite(record.time) || record.time < _lastTime)
+		{
+			std::cerr << "Weather record at time " << record.time << " out of order after time " << _lastTime << std::endl;
+			_bEndOfFile = _bFailed = true;
+			return false;
+		}
+		if (_knots.empty() || record.time > _knots.back())
+			_knots.push_back(record.time);
+		_history[record.station].push_back(record);
+		_lastTime = record.time;
+		++_numRecords;
+
+		return true;
+	}
+
+	bool WeatherInput::ReadPast(double time)
+	{
+		while (_lastTime <= time && ReadRecord())
+			;
+		return !_bFailed;
+	}
+
+	WeatherSample WeatherInput::EvaluateStation(uint32_t station, double time) const
+	{
+		const std::deque<WeatherRecord>& history = _history[station];
+		auto next = std::upper_bound(history.begin(), history.end(), time, [](double value, const WeatherRecord& record) { return value < record.time; });
+		if (next == history.begin())
+			return next->sample;
+		const WeatherRecord& previous = *std::prev(next);
+		if (next == history.end())
+			return previous.sample;
+
+		const float factor = static_cast<float>((time - previous.time) / (next->time - previous.time));
+		return { glm::mix(previous.sample.wind, next->sample.wind, factor),
+				 previous.sample.humidity + (next->sample.humidity - previous.sample.humidity) * factor,
+				 previous.sample.temperature + (next->sample.temperature - previous.sample.temperature) * factor };
+	}
+
+	void WeatherInput::BuildTree(size_t begin, size_t end, int depth)
+	{
+		if (end - begin <= 1)
+			return;
+
+		//! Ties go by station index so the tree only depends on the stations.
+		const int axis = depth % 2;
+		const size_t median = (begin + end) / 2;
+		std::nth_element(_treeStations.begin() + begin, _treeStations.begin() + median, _treeStations.begin() + end, [this, axis](uint32_t lhs, uint32_t rhs)
+		{
+			const float left = _stations[lhs].position[axis], right = _stations[rhs].position[axis];
+			return left < right || (left == right && lhs < rhs);
+		});
+		BuildTree(begin, median, depth + 1);
+		BuildTree(median + 1, end, depth + 1);
+	}
+
+	int WeatherInput::FindNeighbors(const glm::vec2& point, uint32_t* neighbors, float* distances) const
+	{
+		//! Subtrees still to visit with the squared distance of their splitting line, the far side of
+		//! every split is pushed first so the near side is searched first.
+		struct Node
+		{
+			size_t begin, end;
+			int depth;
+			float bound;
+		};
+		Node stack[MAX_TREE_DEPTH + 2];
+		int numNodes = 0, numNeighbors = 0;
+		stack[numNodes++] = { 0, _treePositions.size(), 0, 0.0f };
+
+		while (numNodes > 0)
+		{
+			const Node node = stack[--numNodes];
+			if (node.begin >= node.end || (numNeighbors == NUM_NEIGHBORS && node.bound >= distances[NUM_NEIGHBORS - 1]))
+				continue;
+
+			const size_t median = (node.begin + node.end) / 2;
+			const glm::vec2 offset = point - _treePositions[median];
+			const float distance = glm::dot(offset, offset);
+			if (numNeighbors < NUM_NEIGHBORS || distance < distances[numNeighbors - 1])
+			{
+				int slot = numNeighbors < NUM_NEIGHBORS ? numNeighbors++ : NUM_NEIGHBORS - 1;
+				for (; slot > 0 && distances[slot - 1] > distance; --slot)
+				{
+					distances[slot] = distances[slot - 1];
+					neighbors[slot] = neighbors[slot - 1];
+				}
+				distances[slot] = distance;
+				neighbors[slot] = static_cast<uint32_t>(median);
+			}
+
+			const float split = offset[node.depth % 2];
+			const Node lower = { node.begin, median, node.depth + 1, split * split }, upper = { median + 1, node.end, node.depth + 1, split * split };
+			stack[numNodes++] = split < 0.0f ? upper : lower;
+			stack[numNodes++] = split < 0.0f ? Node{ lower.begin, lower.end, lower.depth, node.bound } : Node{ upper.begin, upper.end, upper.depth, node.bound };
+		}
+		return numNeighbors;
+	}
+
+	void WeatherInput::UpdateWeights()
+	{
+		GL3::ProfileScope scope("WeatherInput::UpdateWeights", static_cast<uint64_t>(_width) * _height);
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+
+		_treePositions.resize(_treeStations.size());
+		for (size_t node = 0; node < _treeStations.size(); ++node)
+			_treePositions[node] = _stations[_treeStations[node]].position;
+
+		ForEachTileRow(_width, _height, _tilesX, _tilesY, [this](size_t begin, size_t end)
+		{
+			for (size_t cell = begin; cell < end; ++cell)
+			{
+				const glm::vec2 center = (glm::vec2(static_cast<float>(cell % _width), static_cast<float>(cell / _width)) + 0.5f) * _cellSize;
+				uint32_t* neighbors = _neighbors.data() + cell * NUM_NEIGHBORS;
+				float* weights = _weights.data() + cell * NUM_NEIGHBORS;
+				float distances[NUM_NEIGHBORS];
+				const int numNeighbors = FindNeighbors(center, neighbors, distances);
+
+				float sum = 0.0f;
+				for (int neighbor = 0; neighbor < numNeighbors; ++neighbor)
+				{
+					weights[neighbor] = distances[0] < COINCIDENT_DISTANCE ? (neighbor == 0 ? 1.0f : 0.0f) : 1.0f / distances[neighbor];
+					sum += weights[neighbor];
+				}
+				for (int neighbor = 0; neighbor < NUM_NEIGHBORS; ++neighbor)
+				{
+					if (neighbor >= numNeighbors)
+					{
+						neighbors[neighbor] = 0;
+						weights[neighbor] = 0.0f;
+					}
+					else
+						weights[neighbor] /= sum;
+				}
+			}
+		});
+
+		//! The mean of a slice is the station values weighted by the grid share they cover.
+		std::vector<double> coverage(_treeStations.size(), 0.0);
+		for (size_t entry = 0; entry < _weights.size(); ++entry)
+			coverage[_neighbors[entry]] += _weights[entry];
+		_stationCoverage.resize(coverage.size());
+		for (size_t node = 0; node < coverage.size(); ++node)
+			_stationCoverage[node] = static_cast<float>(coverage[node] / (static_cast<double>(_width) * _height));
+		++_numWeightUpdates;
+	}
+
+	WeatherSample WeatherInput::UpdateSlice(double time, Field& field)
+	{
+		GL3::ProfileScope scope("WeatherInput::UpdateSlice", static_cast<uint64_t>(_width) * _height);
+
+		WeatherSample mean = { glm::vec2(0.0f), 0.0f, 0.0f };
+		_stationSamples.resize(_treeStations.size());
+		for (size_t node = 0; node < _treeStations.size(); ++node)
+		{
+			_stationSamples[node] = EvaluateStation(_treeStations[node], time);
+			mean.wind += _stationSamples[node].wind * _stationCoverage[node];
+			mean.humidity += _stationSamples[node].humidity * _stationCoverage[node];
+			mean.temperature += _stationSamples[node].temperature * _stationCoverage[node];
+		}
+
+		ForEachTileRow(_width, _height, _tilesX, _tilesY, [this, &field](size_t begin, size_t end)
+		{
+			for (size_t cell = begin; cell < end; ++cell)
+			{
+				const uint32_t* neighbors = _neighbors.data() + cell * NUM_NEIGHBORS;
+				const float* weights = _weights.data() + cell * NUM_NEIGHBORS;
+				WeatherSample sample = { glm::vec2(0.0f), 0.0f, 0.0f };
+				for (int neighbor = 0; neighbor < NUM_NEIGHBORS; ++neighbor)
+				{
+					const WeatherSample& station = _stationSamples[neighbors[neighbor]];
+					sample.wind += station.wind * weights[neighbor];
+					sample.humidity += station.humidity * weights[neighbor];
+					sample.temperature += station.temperature * weights[neighbor];
+				}
+				field.wind[cell] = sample.wind;
+				field.humidity[cell] = sample.humidity;
+				field.temperature[cell] = sample.temperature;
+			}
+		});
+		++_numSliceUpdates;
+		return mean;
+	}
+
+	void WeatherInput::BlendSlices(float factor)
+	{
+		GL3::ProfileScope scope("WeatherInput::BlendSlices", static_cast<uint64_t>(_width) * _height);
+		ForEachTileRow(_width, _height, _tilesX, _tilesY, [this, factor](size_t begin, size_t end)
+		{
+			for (size_t cell = begin; cell < end; ++cell)
+			{
+				_field.wind[cell] = glm::mix(_slices[0].wind[cell], _slices[1].wind[cell], factor);
+				_field.humidity[cell] = _slices[0].humidity[cell] + (_slices[1].humidity[cell] - _slices[0].humidity[cell]) * factor;
+				_field.temperature[cell] = _slices[0].temperature[cell] + (_slices[1].temperature[cell] - _slices[0].temperature[cell]) * factor;
+			}
+		});
+		_meanSample = { glm::mix(_meanSlices[0].wind, _meanSlices[1].wind, factor),
+						_meanSlices[0].humidity + (_meanSlices[1].humidity - _meanSlices[0].humidity) * factor,
+						_meanSlices[0].temperature + (_meanSlices[1].temperature - _meanSlices[0].temperature) * factor };
+	}
+
+	bool WeatherInput::Update(double time)
+	{
+		GL3::ProfileScope scope("WeatherInput::Update", static_cast<uint64_t>(_width) * _height);
+		GL3::MemoryScope memoryScope(GL3::MemoryTracker::Simulation);
+		if (_knots.empty() || _width == 0 || _bFailed)
+		{
+			std::cerr << "No weather file open on an initialized grid" << std::endl;
+			return false;
+		}
+
+		//! Before the first record the fields hold their values at it, and time never goes back.
+		time = std::max(time, _knots.front());
+		_time = time;
+		if (!_bSlicesValid || time >= _windowEnd)
+		{
+			if (!ReadPast(time))
+				return false;
+			auto next = std::upper_bound(_knots.begin(), _knots.end(), time);
+			const double begin = *std::prev(next);
+			const double end = next == _knots.end() ? std::numeric_limits<double>::infinity() : *next;
+			_knots.erase(_knots.begin(), std::prev(next));
+
+			//! Keep the last record at or before the window begin, stations that have one are active.
+			size_t numActive = 0;
+			for (std::deque<WeatherRecord>& history : _history)
+			{
+				while (history.size() > 1 && history[1].time <= begin)
+					history.pop_front();
+				numActive += !history.empty() && history.front().time <= begin;
+			}
+
+			//! Read ahead until every active station can be evaluated at the window end.
+			auto isWaiting = [this, begin, end]()
+			{
+				for (const std::deque<WeatherRecord>& history : _history)
+					if (!history.empty() && history.front().time <= begin && history.back().time <= end)
+						return true;
+				return false;
+			};
+			while (!_bEndOfFile && _lastTime <= end + MAX_LOOKAHEAD && isWaiting())
+				ReadRecord();
+			if (_bFailed)
+				return false;
+
+			//! Stations only ever join, a new count means new stations.
+			const bool bStationsJoined = numActive != _treeStations.size();
+			if (bStationsJoined)
+			{
+				_treeStations.clear();
+				for (uint32_t station = 0; station < _history.size(); ++station)
+					if (!_history[station].empty() && _history[station].front().time <= begin)
+						_treeStations.push_back(station);
+				BuildTree(0, _treeStations.size(), 0);
+			}
+
+			if (_bCaching)
+			{
+				if (bStationsJoined)
+					UpdateWeights();
+				if (!bStationsJoined && _bSlicesValid && begin == _windowEnd)
+				{
+					std::swap(_slices[0], _slices[1]);
+					_meanSlices[0] = _meanSlices[1];
+				}
+				else
+					_meanSlices[0] = UpdateSlice(begin, _slices[0]);
+				//! After the last record the fields hold the begin slice.
+				if (std::isfinite(end))
+					_meanSlices[1] = UpdateSlice(end, _slices[1]);
+			}
+			_windowBegin = begin;
+			_windowEnd = end;
+			_bSlicesValid = true;
+		}
+
+		if (_bCaching)
+		{
+			BlendSlices(std::isfinite(_windowEnd) ? static_cast<float>((time - _windowBegin) / (_windowEnd - _windowBegin)) : 0.0f);
+		}
+		else
+		{
+			UpdateWeights();
+			_meanSample = UpdateSlice(time, _field);
+		}
+
+		return true;
+	}
+
+	void WeatherInput::SetCaching(bool bEnabled)
+	{
+		_bCaching = bEnabled;
+		//! The slices and weights are rebuilt at the next Update()
+		_treeStations.clear();
+		_bSlicesValid = false;
+	}
+
+	bool WeatherInput::WriteCSV(const std::string& path, const std::vector<WeatherStation>& stations, const std::vector<WeatherRecord>& records)
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			std::cerr << "Failed to open " << path << std::endl;
+			return false;
+		}
+
+		file << "station,x,y,time,wind_x,wind_y,humidity,temperature\n";
+		for (const WeatherRecord& record : records)
+		{
+			if (record.station >= stations.size() || stations[record.station].name.empty() || stations[record.station].name.find(',') != std::string::npos)
+			{
+				std::cerr << "Station " << record.station << " can not be written to " << path << std::endl;
+				return false;
+			}
+			const WeatherStation& station = stations[record.station];
+			file << station.name << ',' << std::setprecision(9) << station.position.x << ',' << station.position.y << ','
+				 << std::setprecision(17) << record.time << ',' << std::setprecision(9) << record.sample.wind.x << ',' << record.sample.wind.y << ','
+				 << record.sample.humidity << ',' << record.sample.temperature << '\n';
+		}
+
+		return static_cast<bool>(file);
+	}
+
+	bool WeatherInput::WriteBinary(const std::string& path, const std::vector<WeatherStation>& stations, const std::vector<WeatherRecord>& records)
+	{
+		for (const WeatherStation& station : stations)
+		{
+			if (station.name.size() > MAX_NAME_LENGTH)
+			{
+				std::cerr << "Station name of " << station.name.size() << " bytes is longer than " << MAX_NAME_LENGTH << " bytes" << std::endl;
+				return false;
+			}
+		}
+
+		std::ofstream file(path, std::ios::out | std::ios::binary);
+		if (!file.is_open())
+		{
+			std::cerr << "Failed to open " << path << std::endl;
+			return false;
+		}
+
+		WriteValue(file, BINARY_MAGIC);
+		WriteValue(file, BINARY_VERSION);
+		WriteValue(file, static_cast<uint32_t>(stations.size()));
+		for (const WeatherStation& station : stations)
+		{
+			WriteValue(file, station.position.x);
+			WriteValue(file, station.position.y);
+			WriteValue(file, static_cast<uint32_t>(station.name.size()));
+			file.write(station.name.data(), station.name.size());
+		}
+		for (const WeatherRecord& record : records)
+		{
+			WriteValue(file, record.time);
+			WriteValue(file, record.station);
+			WriteValue(file, record.sample.wind.x);
+			WriteValue(file, record.sample.wind.y);
+			WriteValue(file, record.sample.humidity);
+			WriteValue(file, record.sample.temperature);
+		}
+
+		return static_cast<bool>(file);
+	}
+
+};
@@ -1,28 +1,69 @@
 #include <iostream>
 #include <cxxopts/cxxopts.hpp>
 
+#include <SampleApp.hpp>
 #include <SampleRenderer.hpp>
+#include <GL3/ClusteredLighting.hpp>
+#include <GL3/MemoryTracker.hpp>
+#include <GL3/Mesh.hpp>
+#include <GL3/PerspectiveCamera.hpp>
+#include <GL3/Profiler.hpp>
+#include <GL3/SoftwareRasterizer.hpp>
 #include <GL3/Window.hpp>
 #include <glfw/glfw3.h>
 #include <chrono>
 
-int main(int argc, char* argv[])
+//! Draw the mesh lit by the lights of the culler through either back end.
+void DrawScene(GL3::DrawBackend& backend, const GL3::Mesh& mesh, const glm::mat4& view, const glm::mat4& projection, const GL3::ClusteredLightCuller& lights)
 {
-	cxxopts::Options options("modern-opengl-template", "simple description");
+	backend.SetCamera(view, projection);
+	backend.SetLighting(&lights);
+	backend.Clear(glm::vec4(0.0f, 0.0f, 0.8f, 1.0f));
+	backend.DrawMesh(mesh, glm::mat4(1.0f));
+	backend.Flush();
+}
 
-	options.add_options()
-		("t,title", "Window Title(default is 'modern-opengl-template')", cxxopts::value<std::string>()->default_value("modern-opengl-template"))
-		("w,width", "Window width(default is 1200)", cxxopts::value<int>()->default_value("1200"))
-		("h,height", "Window height(default is 900)", cxxopts::value<int>()->default_value("900"));
+//! Render the mesh on the CPU into an image, no window or GL context is created.
+int RenderHeadless(const cxxopts::ParseResult& result)
+{
+	const int width = result["width"].as<int>();
+	const int height = result["height"].as<int>();
+	constexpr float zNear = 0.1f, zFar = 100.0f;
 
-	auto result = options.parse(argc, argv);
+	GL3::Mesh mesh;
+	if (!mesh.LoadObj(result["mesh"].as<std::string>().c_str(), true, false))
+		return EXIT_FAILURE;
 
-	if (result.count("help"))
-	{
-		std::cout << options.help() << std::endl;
-		exit(0);
-	}
+	GL3::PerspectiveCamera camera;
+	camera.SetupCamera(glm::vec3(0.0f, 0.0f, -5.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	camera.SetProperties(static_cast<float>(width) / static_cast<float>(height), 60.0f, zNear, zFar);
+	camera.UpdateMatrix();
+
+	GL3::SoftwareRasterizer rasterizer;
+	if (!rasterizer.Initialize(width, height))
+		return EXIT_FAILURE;
+
+	//! The light rig of SampleApp, culled without GL buffers.
+	std::vector<GL3::PointLight> lights;
+	SampleApp::CreateLights(lights);
+	GL3::ClusteredLightCuller lightCuller;
+	lightCuller.SetLights(lights);
 
+	auto startTime = std::chrono::steady_clock::now();
+	lightCuller.Cull(camera.GetViewMatrix(), camera.GetProjectionMatrix(), zNear, zFar);
+	DrawScene(rasterizer, mesh, camera.GetViewMatrix(), camera.GetProjectionMatrix(), lightCuller);
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+	std::clog << "Software rasterized " << rasterizer.GetNumShadedFragments() << " fragments with " << lights.size() << " lights in " << elapsed / 1000.0 << "(ms)" << std::endl;
+	//! Reported while the assets are alive, the high-water marks cover the whole run.
+	if (result["memory"].as<bool>())
+		GL3::MemoryTracker::GetInstance().Report(std::clog);
+
+	return rasterizer.WriteImage(result["headless"].as<std::string>()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//! Run the windowed renderer until the window closes.
+int RunWindowed(const cxxopts::ParseResult& result)
+{
 	auto renderer = std::make_unique<SampleRenderer>();
 	if (!renderer->Initialize(result))
 	{
@@ -35,7 +76,7 @@ int main(int argc, char* argv[])
 	while (!renderer->GetRendererShouldExit())
 	{
 		auto nowTime = std::chrono::steady_clock::now();
-		double dt = std::chrono::duration_cast<std::chrono::microseconds>(nowTime - startTime).count() / 1e-6;
+		double dt = std::chrono::duration_cast<std::chrono::microseconds>(nowTime - startTime).count() * 1e-6;
 		startTime = nowTime;
 
 		renderer->UpdateFrame(dt);
@@ -45,7 +86,56 @@ int main(int argc, char* argv[])
 		glfwPollEvents();
 	}
 
+	if (result["memory"].as<bool>())
+		GL3::MemoryTracker::GetInstance().Report(std::clog);
 	renderer->CleanUp();
 
-	return 0;
-}
\ No newline at end of file
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+	cxxopts::Options options("modern-opengl-template", "simple description");
+
+	options.add_options()
+		("t,title", "Window Title(default is 'modern-opengl-template')", cxxopts::value<std::string>()->default_value("modern-opengl-template"))
+		("w,width", "Window width(default is 1200)", cxxopts::value<int>()->default_value("1200"))
+		("h,height", "Window height(default is 900)", cxxopts::value<int>()->default_value("900"))
+		("target-fps", "Frame rate the adaptive quality controller holds(default is 60)", cxxopts::value<double>()->default_value("60"))
+		("impostor-distance", "Largest distance before vegetation switches to impostors(default is 500)", cxxopts::value<float>()->default_value("500"))
+		("overlay", "Show the performance overlay at startup, F1 toggles it", cxxopts::value<bool>()->default_value("false"))
+		("fixed-quality", "Keep the maximum quality instead of adapting it to the frame time", cxxopts::value<bool>()->default_value("false"))
+		("clustered-lights", "Shade the sample scene with point lights through the clustered light culler", cxxopts::value<bool>()->default_value("false"))
+		("headless", "Render one frame with the CPU rasterizer into the given TGA file instead of opening a window", cxxopts::value<std::string>())
+		("m,mesh", "Mesh drawn by the headless renderer", cxxopts::value<std::string>()->default_value(RESOURCES_DIR "/objects/bunny.obj"))
+		("profile", "Print the profile scope statistics at exit", cxxopts::value<bool>()->default_value("false"))
+		("perf-counters", "Attach cycles, instructions, cache and branch misses to the profile scopes (Linux perf_event_open)", cxxopts::value<bool>()->default_value("false"))
+		("trace", "Write every profile scope with its counters into the given Chrome trace file at exit", cxxopts::value<std::string>())
+		("memory", "Print the CPU heap and GL memory by subsystem and asset with their high-water marks at exit", cxxopts::value<bool>()->default_value("false"));
+
+	auto result = options.parse(argc, argv);
+
+	if (result.count("help"))
+	{
+		std::cout << options.help() << std::endl;
+		exit(0);
+	}
+
+	auto& profiler = GL3::Profiler::GetInstance();
+	if (result["perf-counters"].as<bool>())
+		profiler.EnableHardwareCounters();
+	profiler.SetTracing(result.count("trace") > 0);
+
+	int exitCode = EXIT_SUCCESS;
+	if (result.count("headless"))
+		exitCode = RenderHeadless(result);
+	else
+		exitCode = RunWindowed(result);
+
+	if (result["profile"].as<bool>() || result["perf-counters"].as<bool>())
+		profiler.Report(std::clog);
+	if (result.count("trace") && !profiler.WriteTrace(result["trace"].as<std::string>()))
+		return EXIT_FAILURE;
+
+	return exitCode;
+}